@@ -1,21 +1,92 @@
 #include "gast_manager.h"
 
+#include <algorithm>
+#include <cmath>
 #include <core/Godot.hpp>
+#include <core/Math.hpp>
 #include <core/NodePath.hpp>
+#include <core/Rect2.hpp>
+#include <core/Transform.hpp>
 #include <core/Vector2.hpp>
 #include <core/Vector3.hpp>
+#include <gen/Camera.hpp>
 #include <gen/Engine.hpp>
 #include <gen/Input.hpp>
 #include <gen/InputEventAction.hpp>
 #include <gen/InputMap.hpp>
 #include <gen/MainLoop.hpp>
+#include <gen/OS.hpp>
 #include <gen/Object.hpp>
+#include <gen/RayCast.hpp>
 #include <gen/Viewport.hpp>
 
+#include "gdn/projection_mesh/mesh_build_queue.h"
+
 namespace gast {
 
 namespace {
 const char *kGastNodeGroupName = "gast_node_group";
+
+// Bounds for the recommended texture dimensions, in pixels.
+const float kMinRecommendedTextureDimension = 64;
+const float kMaxRecommendedTextureDimension = 4096;
+const int64_t kDefaultTexturePixelBudget = 4096 * 4096;
+
+// Alpha value below which a node is considered transparent.
+const float kVisibilityAlphaThreshold = 0.01f;
+// Margin added to the node bounds before the frustum test, to account for billboarding.
+const float kVisibilityFrustumMargin = 0.1f;
+// Minimum cosine of the angle between an occluder's normal and the direction to the camera.
+const float kOccluderFacingThreshold = 0.98f;
+
+// Returns true if the given bounds are fully behind one of the frustum planes.
+bool is_outside_frustum(const AABB &aabb, const std::vector<Plane> &frustum) {
+    Vector3 aabb_end = aabb.position + aabb.size;
+    for (const Plane &plane : frustum) {
+        // Test the corner furthest along the inward direction of the plane.
+        Vector3 corner = Vector3(plane.normal.x > 0 ? aabb.position.x : aabb_end.x,
+                                 plane.normal.y > 0 ? aabb.position.y : aabb_end.y,
+                                 plane.normal.z > 0 ? aabb.position.z : aabb_end.z);
+        if (plane.is_point_over(corner)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Computes the screen bounds of the given global bounds.
+// Returns false if part of the bounds is behind the camera.
+bool get_screen_rect(const Camera *camera, const AABB &aabb, Rect2 *screen_rect) {
+    for (int i = 0; i < 8; i++) {
+        Vector3 corner = aabb.get_endpoint(i);
+        if (camera->is_position_behind(corner)) {
+            return false;
+        }
+
+        Vector2 screen_point = camera->unproject_position(corner);
+        if (i == 0) {
+            *screen_rect = Rect2(screen_point, Vector2());
+        } else {
+            screen_rect->expand_to(screen_point);
+        }
+    }
+    return true;
+}
+
+inline void add_node_to_list(std::vector<GastNode *> &nodes, GastNode *gast_node) {
+    if (gast_node && std::find(nodes.begin(), nodes.end(), gast_node) == nodes.end()) {
+        nodes.push_back(gast_node);
+    }
+}
+
+inline void remove_node_from_list(std::vector<GastNode *> &nodes, GastNode *gast_node) {
+    auto it = std::find(nodes.begin(), nodes.end(), gast_node);
+    if (it != nodes.end()) {
+        // Order doesn't matter, so swap with the last element to keep the removal cheap.
+        *it = nodes.back();
+        nodes.pop_back();
+    }
+}
 } // namespace
 
 GastManager *GastManager::singleton_instance_ = nullptr;
@@ -24,16 +95,32 @@ bool GastManager::gdn_initialized_ = false;
 bool GastManager::jni_initialized_ = false;
 
 jobject GastManager::callback_instance_ = nullptr;
+jclass GastManager::string_class_ = nullptr;
 jmethodID GastManager::on_render_input_action_ = nullptr;
 jmethodID GastManager::on_render_input_hover_ = nullptr;
 jmethodID GastManager::on_render_input_press_ = nullptr;
 jmethodID GastManager::on_render_input_release_ = nullptr;
 jmethodID GastManager::on_render_input_scroll_ = nullptr;
-
-GastManager::GastManager() = default;
+jmethodID GastManager::on_render_multi_pointer_input_ = nullptr;
+jmethodID GastManager::on_render_recommended_texture_size_update_ = nullptr;
+jmethodID GastManager::on_render_visibility_state_update_ = nullptr;
+jmethodID GastManager::on_render_panel_input_hover_ = nullptr;
+jmethodID GastManager::on_render_panel_input_press_ = nullptr;
+jmethodID GastManager::on_render_panel_input_release_ = nullptr;
+jmethodID GastManager::on_render_panel_input_scroll_ = nullptr;
+
+GastManager::GastManager()
+        : single_pointer_input_enabled_(true),
+          texture_pixel_budget_(kDefaultTexturePixelBudget) {}
 
 GastManager::~GastManager() {
     reusable_pool_.clear();
+    active_nodes_.clear();
+    gaze_tracking_nodes_.clear();
+    texture_size_tracking_nodes_.clear();
+    panel_arrays_.clear();
+    texture_latch_pump_.clear();
+    hand_gesture_recognizers_.clear();
 }
 
 GastManager *GastManager::get_singleton_instance() {
@@ -44,6 +131,13 @@ GastManager *GastManager::get_singleton_instance() {
     return singleton_instance_;
 }
 
+GastManager *GastManager::get_singleton_instance_if_initialized() {
+    if (!gdn_initialized_) {
+        return nullptr;
+    }
+    return get_singleton_instance();
+}
+
 void GastManager::delete_singleton_instance() {
     if (!gdn_initialized_ && !jni_initialized_) {
         delete singleton_instance_;
@@ -58,11 +152,26 @@ void GastManager::gdn_initialize(GastLoader *gast_loader) {
 }
 
 void GastManager::gdn_shutdown() {
+    MeshBuildQueue::shutdown();
     gdn_initialized_ = false;
     gast_loader_ = nullptr;
+    if (singleton_instance_) {
+        // The instance outlives the shutdown while the JNI side is initialized.
+        singleton_instance_->clear_node_references();
+    }
     delete_singleton_instance();
 }
 
+void GastManager::clear_node_references() {
+    reusable_pool_.clear();
+    active_nodes_.clear();
+    gaze_tracking_nodes_.clear();
+    texture_size_tracking_nodes_.clear();
+    panel_arrays_.clear();
+    colliding_raycast_paths.clear();
+    texture_latch_pump_.clear_owners();
+}
+
 void GastManager::jni_initialize(JNIEnv *env, jobject callback) {
     jni_initialized_ = true;
     register_callback(env, callback);
@@ -81,6 +190,12 @@ void GastManager::register_callback(JNIEnv *env, jobject callback) {
     jclass callback_class = env->GetObjectClass(callback_instance_);
     ALOG_ASSERT(callback_class != nullptr, "Invalid value for callback.");
 
+    // Cached for the pointer id arrays of the multi-pointer input events.
+    jclass string_class = env->FindClass("java/lang/String");
+    ALOG_ASSERT(string_class != nullptr, "Unable to find java/lang/String");
+    string_class_ = (jclass) env->NewGlobalRef(string_class);
+    env->DeleteLocalRef(string_class);
+
     on_render_input_action_ = env->GetMethodID(callback_class, "onRenderInputAction",
                                                "(Ljava/lang/String;IF)V");
     ALOG_ASSERT(on_render_input_action_ != nullptr, "Unable to find onRenderInputAction");
@@ -100,17 +215,62 @@ void GastManager::register_callback(JNIEnv *env, jobject callback) {
     on_render_input_scroll_ = env->GetMethodID(callback_class, "onRenderInputScroll",
                                                "(Ljava/lang/String;Ljava/lang/String;FFFF)V");
     ALOG_ASSERT(on_render_input_scroll_ != nullptr, "Unable to find onRenderInputScroll");
+
+    on_render_multi_pointer_input_ = env->GetMethodID(
+            callback_class, "onRenderMultiPointerInput",
+            "(Ljava/lang/String;[I[Ljava/lang/String;[I[F)V");
+    ALOG_ASSERT(on_render_multi_pointer_input_ != nullptr,
+                "Unable to find onRenderMultiPointerInput");
+
+    on_render_recommended_texture_size_update_ = env->GetMethodID(
+            callback_class, "onRenderRecommendedTextureSizeUpdate", "(JII)V");
+    ALOG_ASSERT(on_render_recommended_texture_size_update_ != nullptr,
+                "Unable to find onRenderRecommendedTextureSizeUpdate");
+
+    on_render_visibility_state_update_ = env->GetMethodID(callback_class,
+                                                          "onRenderVisibilityStateUpdate", "(JI)V");
+    ALOG_ASSERT(on_render_visibility_state_update_ != nullptr,
+                "Unable to find onRenderVisibilityStateUpdate");
+
+    on_render_panel_input_hover_ = env->GetMethodID(callback_class, "onRenderPanelInputHover",
+                                                    "(JILjava/lang/String;FF)V");
+    ALOG_ASSERT(on_render_panel_input_hover_ != nullptr,
+                "Unable to find onRenderPanelInputHover");
+
+    on_render_panel_input_press_ = env->GetMethodID(callback_class, "onRenderPanelInputPress",
+                                                    "(JILjava/lang/String;FF)V");
+    ALOG_ASSERT(on_render_panel_input_press_ != nullptr,
+                "Unable to find onRenderPanelInputPress");
+
+    on_render_panel_input_release_ = env->GetMethodID(callback_class, "onRenderPanelInputRelease",
+                                                      "(JILjava/lang/String;FF)V");
+    ALOG_ASSERT(on_render_panel_input_release_ != nullptr,
+                "Unable to find onRenderPanelInputRelease");
+
+    on_render_panel_input_scroll_ = env->GetMethodID(callback_class, "onRenderPanelInputScroll",
+                                                     "(JILjava/lang/String;FFFF)V");
+    ALOG_ASSERT(on_render_panel_input_scroll_ != nullptr,
+                "Unable to find onRenderPanelInputScroll");
 }
 
 void GastManager::unregister_callback(JNIEnv *env) {
     if (callback_instance_) {
         env->DeleteGlobalRef(callback_instance_);
         callback_instance_ = nullptr;
+        env->DeleteGlobalRef(string_class_);
+        string_class_ = nullptr;
         on_render_input_action_ = nullptr;
         on_render_input_hover_ = nullptr;
         on_render_input_press_ = nullptr;
         on_render_input_release_ = nullptr;
         on_render_input_scroll_ = nullptr;
+        on_render_multi_pointer_input_ = nullptr;
+        on_render_recommended_texture_size_update_ = nullptr;
+        on_render_visibility_state_update_ = nullptr;
+        on_render_panel_input_hover_ = nullptr;
+        on_render_panel_input_press_ = nullptr;
+        on_render_panel_input_release_ = nullptr;
+        on_render_panel_input_scroll_ = nullptr;
     }
 }
 
@@ -134,6 +294,30 @@ GastNode *GastManager::get_gast_node(const godot::String &node_path) {
     return gast_node;
 }
 
+GastPanelArray *GastManager::create_panel_array(const String &parent_node_path) {
+    Node *parent_node = get_node(parent_node_path);
+    if (!parent_node) {
+        ALOGE("Unable to retrieve parent node with path %s", get_node_tag(parent_node_path));
+        return nullptr;
+    }
+
+    GastPanelArray *panel_array = GastPanelArray::_new();
+    parent_node->add_child(panel_array);
+    panel_array->set_owner(parent_node);
+    return panel_array;
+}
+
+void GastManager::release_panel_array(GastPanelArray *panel_array) {
+    if (!panel_array) {
+        return;
+    }
+
+    if (panel_array->get_parent() != nullptr) {
+        panel_array->get_parent()->remove_child(panel_array);
+    }
+    panel_array->queue_free();
+}
+
 SceneTree *GastManager::get_scene_tree() {
     MainLoop *main_loop = Engine::get_singleton()->get_main_loop();
     auto *scene_tree = Object::cast_to<SceneTree>(main_loop);
@@ -257,19 +441,101 @@ void GastManager::check_for_monitored_input_actions() {
     }
 }
 
+GastNode *GastManager::get_analytic_collider(const Vector3 &ray_from, const Vector3 &ray_to,
+                                             float max_distance, Vector3 *collision_point) {
+    GastNode *collider = nullptr;
+    for (GastNode *gast_node : active_nodes_) {
+        Vector3 intersection;
+        if (!gast_node->is_analytic_collision()
+            || !gast_node->intersects_ray_analytic(ray_from, ray_to, &intersection)) {
+            continue;
+        }
+
+        float distance = ray_from.distance_to(intersection);
+        if (distance < max_distance) {
+            max_distance = distance;
+            collider = gast_node;
+            *collision_point = intersection;
+        }
+    }
+    return collider;
+}
+
+GastPanelArray *GastManager::get_panel_array_collider(const Vector3 &ray_from,
+                                                      const Vector3 &ray_to, float max_distance,
+                                                      int *panel_index,
+                                                      Vector3 *collision_point) {
+    GastPanelArray *collider = nullptr;
+    for (GastPanelArray *panel_array : panel_arrays_) {
+        Vector3 intersection;
+        int index = panel_array->intersects_ray(ray_from, ray_to, max_distance, &intersection);
+        if (index < 0) {
+            continue;
+        }
+
+        max_distance = ray_from.distance_to(intersection);
+        collider = panel_array;
+        *panel_index = index;
+        *collision_point = intersection;
+    }
+    return collider;
+}
+
 bool GastManager::get_raycast_collision_info(const RayCast &ray_cast, CollisionInfo *collision_info) {
     auto *collider = Object::cast_to<GastNode>(ray_cast.get_collider());
-    bool collides_with_gast_node = collider != nullptr;
+    Vector3 collision_point = ray_cast.get_collision_point();
+
+    // The nodes using the analytic collision mode aren't seen by the physics engine, check
+    // whether one of them is hit before the physics collision point.
+    Vector3 ray_from = ray_cast.get_global_transform().origin;
+    Vector3 ray_to = ray_cast.to_global(ray_cast.get_cast_to());
+    float max_distance = ray_cast.is_colliding() ? ray_from.distance_to(collision_point)
+                                                 : ray_from.distance_to(ray_to);
+    GastNode *analytic_collider = get_analytic_collider(ray_from, ray_to, max_distance,
+                                                        &collision_point);
+    if (analytic_collider) {
+        collider = analytic_collider;
+    }
+
+    // The panel arrays are also intersected analytically, in front of the closest node hit.
+    if (collider) {
+        max_distance = ray_from.distance_to(collision_point);
+    }
+    int panel_index = -1;
+    GastPanelArray *panel_array = get_panel_array_collider(ray_from, ray_to, max_distance,
+                                                           &panel_index, &collision_point);
+    if (panel_array) {
+        collider = nullptr;
+    }
+    bool collides_with_gast_node = collider != nullptr || panel_array != nullptr;
 
     if (collision_info != nullptr) {
-        if (!collision_info->press_in_progress || collision_info->collider == collider) {
+        if (!collision_info->press_in_progress
+            || (collision_info->collider == collider
+                && collision_info->panel_array == panel_array
+                && collision_info->panel_index == panel_index)) {
             collision_info->collider = collider;
-            collision_info->collision_point = ray_cast.get_collision_point();
+            collision_info->panel_array = panel_array;
+            collision_info->panel_index = panel_index;
+            collision_info->collision_point = collision_point;
+        } else if (collision_info->panel_array) {
+            // Keep tracking the pressed panel while the press is dragged past its edges.
+            collides_with_gast_node = collision_info->panel_array->intersects_panel_plane(
+                    collision_info->panel_index, ray_from, ray_to,
+                    &collision_info->collision_point);
+            if (!collides_with_gast_node) {
+                collision_info->panel_array = nullptr;
+                collision_info->panel_index = -1;
+            }
+        } else if (collision_info->collider->is_analytic_collision()) {
+            collides_with_gast_node = collision_info->collider->intersects_ray_analytic(
+                    ray_from, ray_to, &collision_info->collision_point);
+            if (!collides_with_gast_node) {
+                collision_info->collider = nullptr;
+            }
         } else {
             collides_with_gast_node = collision_info->collider->intersects_ray(
-                    ray_cast.get_global_transform().origin,
-                    ray_cast.to_global(ray_cast.get_cast_to()),
-                    &collision_info->collision_point);
+                    ray_from, ray_to, &collision_info->collision_point);
             if (!collides_with_gast_node) {
                 collision_info->collider = nullptr;
             }
@@ -309,13 +575,21 @@ void GastManager::process_raycast_input() {
 
         // Check if the previous collider is different from the current one. If that's the case,
         // we need to send a exit event to the previous one.
-        if (previous_collision_info.collider != nullptr &&
-            previous_collision_info.collider != collision_info->collider) {
+        if (previous_collision_info.has_target() &&
+            !previous_collision_info.has_same_target(*collision_info)) {
             cleanup_collision_info(previous_collision_info, ray_cast->get_name());
             colliding_raycast_paths.erase(ray_cast_path);
         }
 
-        if (collides_with_gast_node) {
+        if (collides_with_gast_node && collision_info->panel_array) {
+            GastPanelArray *panel_array = collision_info->panel_array;
+            Vector2 relative_collision_point = panel_array->get_relative_collision_point(
+                    collision_info->panel_index, collision_info->collision_point);
+            collision_info->press_in_progress = panel_array->handle_ray_cast_input(
+                    ray_cast->get_name(), collision_info->panel_index, relative_collision_point);
+
+            colliding_raycast_paths[ray_cast_path] = collision_info;
+        } else if (collides_with_gast_node) {
             // Calculate the 2D collision point of the raycast on the Gast node.
             Vector2 relative_collision_point = collision_info->collider->get_relative_collision_point(
                     collision_info->collision_point);
@@ -331,11 +605,383 @@ void GastManager::process_raycast_input() {
 
 void GastManager::on_physics_process() {
     check_for_monitored_input_actions();
+    process_hand_gestures();
     process_raycast_input();
+    dispatch_multi_pointer_inputs();
+}
+
+void GastManager::process_hand_gestures() {
+    for (auto it = hand_gesture_recognizers_.begin(); it != hand_gesture_recognizers_.end();) {
+        // The recognizers of the hands no longer tracked are removed once their last input tick
+        // has been processed, so the ray casts go back to their input map actions.
+        if (it->second->is_idle()) {
+            it = hand_gesture_recognizers_.erase(it);
+            continue;
+        }
+
+        it->second->advance_tick();
+        ++it;
+    }
+}
+
+void GastManager::update_hand_pose(const String &ray_cast_path,
+                                   const PoolVector3Array &joint_positions,
+                                   const Transform &aim_transform) {
+    auto *ray_cast = Object::cast_to<RayCast>(get_node(ray_cast_path));
+    if (!ray_cast) {
+        ALOGW("Unable to find ray cast %s", get_node_tag(ray_cast_path));
+        return;
+    }
+
+    if (joint_positions.size() < kHandJointCount) {
+        ALOGW("Missing hand joints for ray cast %s", get_node_tag(ray_cast_path));
+        return;
+    }
+
+    std::unique_ptr<HandGestureRecognizer> &recognizer =
+            hand_gesture_recognizers_[ray_cast->get_name()];
+    if (!recognizer) {
+        recognizer.reset(new HandGestureRecognizer());
+    }
+
+    PoolVector3Array::Read joints_read = joint_positions.read();
+    recognizer->update(joints_read.ptr(), aim_transform,
+                       OS::get_singleton()->get_ticks_usec() * 1000);
+    ray_cast->set_global_transform(recognizer->get_stabilized_aim());
+}
+
+void GastManager::clear_hand_pose(const String &ray_cast_path) {
+    Node *ray_cast = get_node(ray_cast_path);
+    if (!ray_cast) {
+        return;
+    }
+
+    auto it = hand_gesture_recognizers_.find(ray_cast->get_name());
+    if (it != hand_gesture_recognizers_.end()) {
+        it->second->reset();
+    }
+}
+
+float GastManager::get_hand_pinch_strength(const String &ray_cast_path) {
+    Node *ray_cast = get_node(ray_cast_path);
+    if (!ray_cast) {
+        return 0;
+    }
+
+    auto it = hand_gesture_recognizers_.find(ray_cast->get_name());
+    return it == hand_gesture_recognizers_.end() ? 0 : it->second->get_pinch_strength();
+}
+
+bool GastManager::get_hand_ray_cast_input(const String &ray_cast_name,
+                                          GastNode::RayCastInput *input) {
+    auto it = hand_gesture_recognizers_.find(ray_cast_name);
+    if (it == hand_gesture_recognizers_.end()) {
+        return false;
+    }
+
+    *input = it->second->get_tick_input();
+    return true;
+}
+
+void GastManager::on_process() {
+    // The camera state is shared by the per-frame passes, and only queried when the viewport
+    // changes, which in practice means once per frame since the nodes usually share the root
+    // viewport.
+    CameraInfo camera_info;
+    // Swap in the meshes built asynchronously first, so the other passes see the new meshes.
+    process_mesh_builds();
+    process_gaze_tracking_nodes(&camera_info);
+    // Runs after the gaze tracking pass so the visibility reflects the updated node positions.
+    process_visibility_states(&camera_info);
+    process_level_of_detail(&camera_info);
+    process_texture_size_tracking_nodes(&camera_info);
+    // Runs last so the throttling of the latches reflects the updated visibility states.
+    texture_latch_pump_.latch_frames();
+}
+
+void GastManager::register_active_node(GastNode *gast_node) {
+    add_node_to_list(active_nodes_, gast_node);
+}
+
+void GastManager::unregister_active_node(GastNode *gast_node) {
+    remove_node_from_list(active_nodes_, gast_node);
+    if (gast_node && gast_node->update_visibility_state(GastNode::VisibilityState::HIDDEN)) {
+        on_render_visibility_state_update(gast_node);
+    }
+}
+
+void GastManager::register_panel_array(GastPanelArray *panel_array) {
+    if (panel_array
+        && std::find(panel_arrays_.begin(), panel_arrays_.end(), panel_array)
+           == panel_arrays_.end()) {
+        panel_arrays_.push_back(panel_array);
+    }
+}
+
+void GastManager::unregister_panel_array(GastPanelArray *panel_array) {
+    auto it = std::find(panel_arrays_.begin(), panel_arrays_.end(), panel_array);
+    if (it != panel_arrays_.end()) {
+        *it = panel_arrays_.back();
+        panel_arrays_.pop_back();
+    }
+
+    // Drop the ray casts' references to the panel array, which may be freed next.
+    for (auto it = colliding_raycast_paths.begin(); it != colliding_raycast_paths.end();) {
+        if (it->second->panel_array == panel_array) {
+            it = colliding_raycast_paths.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void GastManager::register_gaze_tracking_node(GastNode *gast_node) {
+    add_node_to_list(gaze_tracking_nodes_, gast_node);
+}
+
+void GastManager::unregister_gaze_tracking_node(GastNode *gast_node) {
+    remove_node_from_list(gaze_tracking_nodes_, gast_node);
+}
+
+void GastManager::register_texture_size_tracking_node(GastNode *gast_node) {
+    add_node_to_list(texture_size_tracking_nodes_, gast_node);
+}
+
+void GastManager::unregister_texture_size_tracking_node(GastNode *gast_node) {
+    remove_node_from_list(texture_size_tracking_nodes_, gast_node);
+}
+
+bool GastManager::update_camera_info(Viewport *viewport, CameraInfo *camera_info) {
+    if (camera_info->viewport == viewport) {
+        return camera_info->camera != nullptr;
+    }
+
+    *camera_info = CameraInfo();
+    camera_info->viewport = viewport;
+    camera_info->camera = viewport ? viewport->get_camera() : nullptr;
+    Camera *camera = camera_info->camera;
+    if (!camera) {
+        return false;
+    }
+
+    camera_info->delta = viewport->get_process_delta_time();
+
+    Rect2 gaze_area = viewport->get_visible_rect();
+    Vector2 gaze_center_point = Vector2(gaze_area.position.x + gaze_area.size.x / 2.0,
+                                        gaze_area.position.y + gaze_area.size.y / 2.0);
+
+    Transform camera_transform = camera->get_global_transform();
+    camera_info->origin = camera_transform.origin;
+    camera_info->forward = -camera_transform.basis.get_axis(2).normalized();
+    camera_info->gaze_direction = camera->project_ray_normal(gaze_center_point);
+    camera_info->gaze_direction_depth = camera_info->gaze_direction.dot(camera_info->forward);
+
+    Array frustum = camera->get_frustum();
+    camera_info->frustum.reserve(frustum.size());
+    for (int i = 0; i < frustum.size(); i++) {
+        camera_info->frustum.push_back(frustum[i]);
+    }
+
+    float half_fov = Math::deg2rad(camera->get_fov()) / 2.0f;
+    if (half_fov > CMP_EPSILON) {
+        camera_info->focal_length = (gaze_area.size.y / 2.0f) / std::tan(half_fov);
+    }
+    return true;
+}
+
+void GastManager::process_gaze_tracking_nodes(CameraInfo *camera_info) {
+    for (GastNode *gast_node : gaze_tracking_nodes_) {
+        if (!gast_node->is_inside_tree()) {
+            continue;
+        }
+
+        if (!update_camera_info(gast_node->get_viewport(), camera_info)
+            || camera_info->gaze_direction_depth <= 0) {
+            continue;
+        }
+
+        gast_node->follow_gaze(camera_info->origin, camera_info->gaze_direction,
+                               camera_info->gaze_direction_depth, camera_info->delta);
+    }
+}
+
+void GastManager::process_visibility_states(CameraInfo *camera_info) {
+    if (active_nodes_.empty()) {
+        return;
+    }
+
+    // First pass: classify the nodes that are trivially not visible, and collect the occluders.
+    std::vector<GastNode::VisibilityState> states(active_nodes_.size(),
+                                                  GastNode::VisibilityState::VISIBLE);
+    std::vector<OccluderInfo> occluders;
+    for (size_t i = 0; i < active_nodes_.size(); i++) {
+        GastNode *gast_node = active_nodes_[i];
+        if (!gast_node->is_visible_in_tree()) {
+            states[i] = GastNode::VisibilityState::HIDDEN;
+            continue;
+        }
+
+        if (gast_node->get_alpha() < kVisibilityAlphaThreshold) {
+            states[i] = GastNode::VisibilityState::TRANSPARENT;
+            continue;
+        }
+
+        if (!update_camera_info(gast_node->get_viewport(), camera_info)) {
+            continue;
+        }
+
+        AABB aabb = gast_node->get_global_aabb().grow(kVisibilityFrustumMargin);
+        if (is_outside_frustum(aabb, camera_info->frustum)) {
+            states[i] = GastNode::VisibilityState::OUT_OF_FRUSTUM;
+            continue;
+        }
+
+        if (gast_node->is_occluder()) {
+            Vector3 normal = gast_node->get_global_transform().basis.get_axis(2).normalized();
+            Vector3 to_camera = (camera_info->origin - aabb.position - aabb.size / 2).normalized();
+            OccluderInfo occluder;
+            if (normal.dot(to_camera) >= kOccluderFacingThreshold
+                && get_screen_rect(camera_info->camera, gast_node->get_global_aabb(),
+                                   &occluder.screen_rect)) {
+                occluder.viewport = camera_info->viewport;
+                occluder.gast_node = gast_node;
+                occluders.push_back(occluder);
+            }
+        }
+    }
+
+    // Second pass: check if the remaining nodes are fully covered by one of the occluders.
+    // Nodes rendered on top are skipped since their relative draw order isn't tracked.
+    if (!occluders.empty()) {
+        for (size_t i = 0; i < active_nodes_.size(); i++) {
+            GastNode *gast_node = active_nodes_[i];
+            if (states[i] != GastNode::VisibilityState::VISIBLE || gast_node->is_render_on_top()
+                || !update_camera_info(gast_node->get_viewport(), camera_info)) {
+                continue;
+            }
+
+            Rect2 screen_rect;
+            if (!get_screen_rect(camera_info->camera,
+                                 gast_node->get_global_aabb().grow(kVisibilityFrustumMargin),
+                                 &screen_rect)) {
+                continue;
+            }
+
+            for (const OccluderInfo &occluder : occluders) {
+                if (occluder.viewport == camera_info->viewport
+                    && occluder.screen_rect.encloses(screen_rect)) {
+                    states[i] = GastNode::VisibilityState::OCCLUDED;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < active_nodes_.size(); i++) {
+        GastNode *gast_node = active_nodes_[i];
+        if (gast_node->update_visibility_state(states[i])) {
+            on_render_visibility_state_update(gast_node);
+        }
+    }
+}
+
+void GastManager::process_mesh_builds() {
+    for (GastNode *gast_node : active_nodes_) {
+        if (gast_node->apply_completed_mesh_builds() && gast_loader_) {
+            gast_loader_->emitProjectionMeshReady(gast_node->get_path());
+        }
+    }
+}
+
+void GastManager::process_level_of_detail(CameraInfo *camera_info) {
+    for (GastNode *gast_node : active_nodes_) {
+        // The hidden nodes keep their current level of detail.
+        if (gast_node->get_visibility_state() != GastNode::VisibilityState::VISIBLE
+            || !update_camera_info(gast_node->get_viewport(), camera_info)) {
+            continue;
+        }
+
+        gast_node->update_level_of_detail(camera_info->origin, camera_info->forward,
+                                          camera_info->focal_length);
+    }
+}
+
+void GastManager::process_texture_size_tracking_nodes(CameraInfo *camera_info) {
+    if (texture_size_tracking_nodes_.empty()) {
+        return;
+    }
+
+    // Compute the projected size of each node, in eye buffer pixels.
+    std::vector<Vector2> projected_sizes(texture_size_tracking_nodes_.size(), Vector2());
+    float total_pixels = 0;
+    for (size_t i = 0; i < texture_size_tracking_nodes_.size(); i++) {
+        GastNode *gast_node = texture_size_tracking_nodes_[i];
+        if (gast_node->get_visibility_state() != GastNode::VisibilityState::VISIBLE
+            || !update_camera_info(gast_node->get_viewport(), camera_info)
+            || camera_info->focal_length <= 0) {
+            continue;
+        }
+
+        Vector2 size = gast_node->get_projected_size(camera_info->origin,
+                                                     camera_info->focal_length);
+        // Nodes straddling the camera plane don't have a finite projected size. They keep their
+        // previous recommendation rather than taking over the pixel budget.
+        float max_dimension = std::max(size.x, size.y);
+        if (size.x <= 0 || size.y <= 0 || !std::isfinite(max_dimension)) {
+            continue;
+        }
+
+        // Clamp to the supported range while preserving the aspect ratio.
+        if (max_dimension > kMaxRecommendedTextureDimension) {
+            size *= kMaxRecommendedTextureDimension / max_dimension;
+        }
+        size.x = std::max(size.x, kMinRecommendedTextureDimension);
+        size.y = std::max(size.y, kMinRecommendedTextureDimension);
+
+        projected_sizes[i] = size;
+        total_pixels += size.x * size.y;
+    }
+
+    // Scale the sizes down uniformly if they don't fit within the pixel budget.
+    float budget_scale = 1.0f;
+    if (texture_pixel_budget_ > 0 && total_pixels > texture_pixel_budget_) {
+        budget_scale = std::sqrt(static_cast<float>(texture_pixel_budget_) / total_pixels);
+    }
+
+    for (size_t i = 0; i < texture_size_tracking_nodes_.size(); i++) {
+        Vector2 size = projected_sizes[i];
+        if (size.x <= 0 || size.y <= 0) {
+            continue;
+        }
+
+        GastNode *gast_node = texture_size_tracking_nodes_[i];
+        size *= budget_scale;
+        if (gast_node->update_recommended_texture_size(size)) {
+            Vector2 recommended_size = gast_node->get_recommended_texture_size();
+            on_render_recommended_texture_size_update(gast_node,
+                                                      static_cast<int>(recommended_size.x),
+                                                      static_cast<int>(recommended_size.y));
+        }
+    }
 }
 
 void GastManager::cleanup_collision_info(const CollisionInfo &collision_info,
                                          const String &ray_cast_name) {
+    if (collision_info.panel_array) {
+        GastPanelArray *panel_array = collision_info.panel_array;
+        int panel_index = collision_info.panel_index;
+        if (collision_info.press_in_progress) {
+            Vector2 last_coordinate = panel_array->get_relative_collision_point(
+                    panel_index, collision_info.collision_point);
+            on_render_panel_input_release(panel_array, panel_index, ray_cast_name,
+                                          last_coordinate.x, last_coordinate.y);
+        } else {
+            on_render_panel_input_hover(panel_array, panel_index, ray_cast_name,
+                                        kInvalidCoordinate.x, kInvalidCoordinate.y);
+        }
+        return;
+    }
+
     if (collision_info.press_in_progress) {
         Vector2 last_coordinate = collision_info.collider->get_relative_collision_point(
                 collision_info.collision_point);
@@ -350,6 +996,159 @@ void GastManager::cleanup_collision_info(const CollisionInfo &collision_info,
     }
 }
 
+void GastManager::track_node_pointer(const String &node_path, const String &pointer_id,
+                                     PointerState state, float x_percent, float y_percent) {
+    auto node_pointers_it = node_pointers_.find(node_path);
+    if (node_pointers_it == node_pointers_.end()) {
+        if (state == kPointerExited) {
+            return;
+        }
+        node_pointers_it = node_pointers_.emplace(node_path, NodePointers()).first;
+    }
+
+    std::vector<NodePointer> &pointers = node_pointers_it->second.pointers;
+    auto pointer = std::find_if(pointers.begin(), pointers.end(),
+                                [&pointer_id](const NodePointer &node_pointer) {
+                                    return node_pointer.pointer_id == pointer_id;
+                                });
+    if (pointer == pointers.end()) {
+        if (state == kPointerExited) {
+            return;
+        }
+
+        // Use the smallest index not taken by the node's other pointers.
+        int index = 0;
+        while (std::any_of(pointers.begin(), pointers.end(),
+                           [index](const NodePointer &node_pointer) {
+                               return node_pointer.index == index;
+                           })) {
+            index++;
+        }
+
+        NodePointer node_pointer;
+        node_pointer.pointer_id = pointer_id;
+        node_pointer.index = index;
+        pointers.push_back(node_pointer);
+        pointer = pointers.end() - 1;
+    }
+
+    if (state == kPointerHover) {
+        // Hover events are also fired while a press is dragged, so only the idle pointers are
+        // moved back to the hover state.
+        if (pointer->state == kPointerExited) {
+            pointer->state = kPointerHover;
+        }
+    } else {
+        pointer->state = state;
+    }
+
+    // Exit events don't carry a valid coordinate, so the last one is kept.
+    if (state != kPointerExited) {
+        pointer->position = Vector2(x_percent, y_percent);
+    }
+    pointer->updated = true;
+    node_pointers_it->second.changed = true;
+}
+
+void GastManager::dispatch_multi_pointer_inputs() {
+    for (auto it = node_pointers_.begin(); it != node_pointers_.end();) {
+        NodePointers &node_pointers = it->second;
+
+        // The pointers without events this tick no longer target the node (e.g: their ray cast
+        // was disabled or removed), so they're lifted.
+        for (NodePointer &pointer : node_pointers.pointers) {
+            if (!pointer.updated) {
+                pointer.state = pointer.state == kPointerJustPressed
+                                || pointer.state == kPointerPressed
+                                ? kPointerJustReleased : kPointerExited;
+                node_pointers.changed = true;
+            }
+        }
+
+        if (node_pointers.changed) {
+            on_render_multi_pointer_input(it->first, node_pointers);
+            node_pointers.changed = false;
+        }
+
+        // Settle the transient states for the next tick.
+        std::vector<NodePointer> &pointers = node_pointers.pointers;
+        pointers.erase(std::remove_if(pointers.begin(), pointers.end(),
+                                      [](const NodePointer &pointer) {
+                                          return pointer.state == kPointerExited;
+                                      }),
+                       pointers.end());
+        for (NodePointer &pointer : pointers) {
+            if (pointer.state == kPointerJustPressed) {
+                pointer.state = kPointerPressed;
+            } else if (pointer.state == kPointerJustReleased) {
+                pointer.state = kPointerHover;
+            }
+            pointer.updated = false;
+        }
+
+        if (pointers.empty()) {
+            it = node_pointers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void GastManager::on_render_multi_pointer_input(const String &node_path,
+                                                const NodePointers &node_pointers) {
+    const std::vector<NodePointer> &pointers = node_pointers.pointers;
+    if (gast_loader_) {
+        Array pointers_info;
+        for (const NodePointer &pointer : pointers) {
+            Dictionary pointer_info;
+            pointer_info["pointer_index"] = pointer.index;
+            pointer_info["event_origin_id"] = pointer.pointer_id;
+            pointer_info["state"] = pointer.state;
+            pointer_info["x_percent"] = pointer.position.x;
+            pointer_info["y_percent"] = pointer.position.y;
+            pointers_info.append(pointer_info);
+        }
+        gast_loader_->emitMultiPointerEvent(node_path, pointers_info);
+    }
+
+    if (callback_instance_ && on_render_multi_pointer_input_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        auto pointer_count = static_cast<jsize>(pointers.size());
+
+        std::vector<jint> indices(pointer_count);
+        std::vector<jint> states(pointer_count);
+        std::vector<jfloat> coordinates(pointer_count * 2);
+        jobjectArray pointer_ids = env->NewObjectArray(pointer_count, string_class_, nullptr);
+        for (jsize i = 0; i < pointer_count; i++) {
+            const NodePointer &pointer = pointers[i];
+            indices[i] = pointer.index;
+            states[i] = pointer.state;
+            coordinates[i * 2] = pointer.position.x;
+            coordinates[i * 2 + 1] = pointer.position.y;
+
+            jstring pointer_id = string_to_jstring(env, pointer.pointer_id);
+            env->SetObjectArrayElement(pointer_ids, i, pointer_id);
+            env->DeleteLocalRef(pointer_id);
+        }
+
+        jintArray indices_array = env->NewIntArray(pointer_count);
+        env->SetIntArrayRegion(indices_array, 0, pointer_count, indices.data());
+        jintArray states_array = env->NewIntArray(pointer_count);
+        env->SetIntArrayRegion(states_array, 0, pointer_count, states.data());
+        jfloatArray coordinates_array = env->NewFloatArray(pointer_count * 2);
+        env->SetFloatArrayRegion(coordinates_array, 0, pointer_count * 2, coordinates.data());
+
+        env->CallVoidMethod(callback_instance_, on_render_multi_pointer_input_,
+                            string_to_jstring(env, node_path), indices_array, pointer_ids,
+                            states_array, coordinates_array);
+
+        env->DeleteLocalRef(indices_array);
+        env->DeleteLocalRef(pointer_ids);
+        env->DeleteLocalRef(states_array);
+        env->DeleteLocalRef(coordinates_array);
+    }
+}
+
 void GastManager::on_render_input_action(const String &action, InputPressState press_state,
                                          float strength) {
     if (callback_instance_ && on_render_input_action_) {
@@ -362,11 +1161,16 @@ void GastManager::on_render_input_action(const String &action, InputPressState p
 void GastManager::on_render_input_hover(const String &node_path, const String &pointer_id,
                                         float x_percent,
                                         float y_percent) {
+    // Hover exit events are fired with the invalid coordinate.
+    bool exited = x_percent == kInvalidCoordinate.x && y_percent == kInvalidCoordinate.y;
+    track_node_pointer(node_path, pointer_id, exited ? kPointerExited : kPointerHover, x_percent,
+                       y_percent);
+
     if (gast_loader_) {
         gast_loader_->emitHoverEvent(node_path, pointer_id, x_percent, y_percent);
     }
 
-    if (callback_instance_ && on_render_input_hover_) {
+    if (single_pointer_input_enabled_ && callback_instance_ && on_render_input_hover_) {
         JNIEnv *env = godot::android_api->godot_android_get_env();
         env->CallVoidMethod(callback_instance_, on_render_input_hover_,
                             string_to_jstring(env, node_path), string_to_jstring(env, pointer_id),
@@ -377,11 +1181,13 @@ void GastManager::on_render_input_hover(const String &node_path, const String &p
 void GastManager::on_render_input_press(const String &node_path, const String &pointer_id,
                                         float x_percent,
                                         float y_percent) {
+    track_node_pointer(node_path, pointer_id, kPointerJustPressed, x_percent, y_percent);
+
     if (gast_loader_) {
         gast_loader_->emitPressEvent(node_path, pointer_id, x_percent, y_percent);
     }
 
-    if (callback_instance_ && on_render_input_press_) {
+    if (single_pointer_input_enabled_ && callback_instance_ && on_render_input_press_) {
         JNIEnv *env = godot::android_api->godot_android_get_env();
         env->CallVoidMethod(callback_instance_, on_render_input_press_,
                             string_to_jstring(env, node_path), string_to_jstring(env, pointer_id),
@@ -392,11 +1198,13 @@ void GastManager::on_render_input_press(const String &node_path, const String &p
 void GastManager::on_render_input_release(const String &node_path, const String &pointer_id,
                                           float x_percent,
                                           float y_percent) {
+    track_node_pointer(node_path, pointer_id, kPointerJustReleased, x_percent, y_percent);
+
     if (gast_loader_) {
         gast_loader_->emitReleaseEvent(node_path, pointer_id, x_percent, y_percent);
     }
 
-    if (callback_instance_ && on_render_input_release_) {
+    if (single_pointer_input_enabled_ && callback_instance_ && on_render_input_release_) {
         JNIEnv *env = godot::android_api->godot_android_get_env();
         env->CallVoidMethod(callback_instance_, on_render_input_release_,
                             string_to_jstring(env, node_path), string_to_jstring(env, pointer_id),
@@ -421,6 +1229,99 @@ void GastManager::on_render_input_scroll(const godot::String &node_path,
     }
 }
 
+void GastManager::on_render_panel_input_hover(GastPanelArray *panel_array, int panel_index,
+                                              const String &pointer_id, float x_percent,
+                                              float y_percent) {
+    if (gast_loader_) {
+        gast_loader_->emitPanelHoverEvent(panel_array->get_path(), panel_index, pointer_id,
+                                          x_percent, y_percent);
+    }
+
+    if (callback_instance_ && on_render_panel_input_hover_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->CallVoidMethod(callback_instance_, on_render_panel_input_hover_,
+                            reinterpret_cast<jlong>(panel_array), panel_index,
+                            string_to_jstring(env, pointer_id), x_percent, y_percent);
+    }
+}
+
+void GastManager::on_render_panel_input_press(GastPanelArray *panel_array, int panel_index,
+                                              const String &pointer_id, float x_percent,
+                                              float y_percent) {
+    if (gast_loader_) {
+        gast_loader_->emitPanelPressEvent(panel_array->get_path(), panel_index, pointer_id,
+                                          x_percent, y_percent);
+    }
+
+    if (callback_instance_ && on_render_panel_input_press_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->CallVoidMethod(callback_instance_, on_render_panel_input_press_,
+                            reinterpret_cast<jlong>(panel_array), panel_index,
+                            string_to_jstring(env, pointer_id), x_percent, y_percent);
+    }
+}
+
+void GastManager::on_render_panel_input_release(GastPanelArray *panel_array, int panel_index,
+                                                const String &pointer_id, float x_percent,
+                                                float y_percent) {
+    if (gast_loader_) {
+        gast_loader_->emitPanelReleaseEvent(panel_array->get_path(), panel_index, pointer_id,
+                                            x_percent, y_percent);
+    }
+
+    if (callback_instance_ && on_render_panel_input_release_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->CallVoidMethod(callback_instance_, on_render_panel_input_release_,
+                            reinterpret_cast<jlong>(panel_array), panel_index,
+                            string_to_jstring(env, pointer_id), x_percent, y_percent);
+    }
+}
+
+void GastManager::on_render_panel_input_scroll(GastPanelArray *panel_array, int panel_index,
+                                               const String &pointer_id, float x_percent,
+                                               float y_percent, float horizontal_delta,
+                                               float vertical_delta) {
+    if (gast_loader_) {
+        gast_loader_->emitPanelScrollEvent(panel_array->get_path(), panel_index, pointer_id,
+                                           x_percent, y_percent, horizontal_delta,
+                                           vertical_delta);
+    }
+
+    if (callback_instance_ && on_render_panel_input_scroll_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->CallVoidMethod(callback_instance_, on_render_panel_input_scroll_,
+                            reinterpret_cast<jlong>(panel_array), panel_index,
+                            string_to_jstring(env, pointer_id), x_percent, y_percent,
+                            horizontal_delta, vertical_delta);
+    }
+}
+
+void GastManager::on_render_recommended_texture_size_update(GastNode *gast_node, int width,
+                                                            int height) {
+    if (gast_loader_) {
+        gast_loader_->emitRecommendedTextureSizeUpdate(gast_node->get_path(), width, height);
+    }
+
+    if (callback_instance_ && on_render_recommended_texture_size_update_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->CallVoidMethod(callback_instance_, on_render_recommended_texture_size_update_,
+                            reinterpret_cast<jlong>(gast_node), width, height);
+    }
+}
+
+void GastManager::on_render_visibility_state_update(GastNode *gast_node) {
+    GastNode::VisibilityState visibility_state = gast_node->get_visibility_state();
+    if (gast_loader_) {
+        gast_loader_->emitVisibilityStateUpdate(gast_node->get_path(), visibility_state);
+    }
+
+    if (callback_instance_ && on_render_visibility_state_update_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->CallVoidMethod(callback_instance_, on_render_visibility_state_update_,
+                            reinterpret_cast<jlong>(gast_node), visibility_state);
+    }
+}
+
 bool GastManager::update_gast_node_parent(GastNode *node,
                                           const String &new_parent_node_path, bool empty_parent) {
     if (!node) {
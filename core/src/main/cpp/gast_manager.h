@@ -1,18 +1,30 @@
 #ifndef GAST_MANAGER_H
 #define GAST_MANAGER_H
 
+#include <core/AABB.hpp>
+#include <core/Plane.hpp>
+#include <core/PoolArrays.hpp>
+#include <core/Rect2.hpp>
 #include <core/String.hpp>
+#include <core/Transform.hpp>
 #include <core/Vector2.hpp>
 #include <core/Vector3.hpp>
+#include <gen/Camera.hpp>
 #include <gen/Node.hpp>
 #include <gen/SceneTree.hpp>
 #include <gen/Spatial.hpp>
+#include <gen/Viewport.hpp>
 #include <jni.h>
 #include <list>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "gdn/gast_loader.h"
 #include "gdn/gast_node.h"
+#include "gdn/gast_panel_array.h"
+#include "gdn/hand_gesture_recognizer.h"
+#include "gdn/texture_latch_pump.h"
 #include "utils.h"
 
 namespace gast {
@@ -30,12 +42,25 @@ enum InputPressState {
     kPressed = 1,
     kJustReleased = 2
 };
+
+/// Mirrors src/main/java/org/godotengine/plugin/gast/input/GastInputListener#PointerState
+enum PointerState {
+    kPointerHover = 0,
+    kPointerJustPressed = 1,
+    kPointerPressed = 2,
+    kPointerJustReleased = 3,
+    kPointerExited = 4
+};
 }  // namespace
 
 class GastManager {
 public:
     static GastManager *get_singleton_instance();
 
+    /// Returns the singleton instance, or nullptr once Gast is shut down. Meant for the nodes,
+    /// which may be freed or leave the scene tree after the shutdown.
+    static GastManager *get_singleton_instance_if_initialized();
+
     static void gdn_initialize(GastLoader *gast_loader);
 
     static void gdn_shutdown();
@@ -46,6 +71,8 @@ public:
 
     void on_physics_process();
 
+    void on_process();
+
     void on_render_input_hover(const String &node_path, const String &pointer_id, float x_percent,
                                float y_percent);
 
@@ -58,6 +85,19 @@ public:
     void on_render_input_scroll(const String &node_path, const String &pointer_id, float x_percent,
                                 float y_percent, float horizontal_delta, float vertical_delta);
 
+    void on_render_panel_input_hover(GastPanelArray *panel_array, int panel_index,
+                                     const String &pointer_id, float x_percent, float y_percent);
+
+    void on_render_panel_input_press(GastPanelArray *panel_array, int panel_index,
+                                     const String &pointer_id, float x_percent, float y_percent);
+
+    void on_render_panel_input_release(GastPanelArray *panel_array, int panel_index,
+                                       const String &pointer_id, float x_percent, float y_percent);
+
+    void on_render_panel_input_scroll(GastPanelArray *panel_array, int panel_index,
+                                      const String &pointer_id, float x_percent, float y_percent,
+                                      float horizontal_delta, float vertical_delta);
+
     /// Create a Gast node with the given parent node and set it up.
     /// @return The newly created Gast node
     GastNode *acquire_and_bind_gast_node(const String &parent_node_path, bool empty_parent);
@@ -77,31 +117,198 @@ public:
         input_actions_to_monitor_.push_back(input_action);
     }
 
+    /// Enable or disable the dispatch of the single pointer hover, press and release events to
+    /// the Java callback. The multi-pointer events cover them, so they're only needed by the
+    /// listeners not migrated to the multi-pointer callback.
+    void set_single_pointer_input_enabled(bool enabled) {
+        single_pointer_input_enabled_ = enabled;
+    }
+
     void update_node_visibility(const String &node_path, bool visible);
 
     GastNode *get_gast_node(const String &node_path);
 
+    /// Create a panel array as a child of the given parent node.
+    /// @return The newly created panel array, or nullptr if the parent node doesn't exist
+    GastPanelArray *create_panel_array(const String &parent_node_path);
+
+    /// Remove the given panel array from the scene tree and free it.
+    void release_panel_array(GastPanelArray *panel_array);
+
+    /// Add the given panel array to the list of panel arrays intersected by the ray casts.
+    void register_panel_array(GastPanelArray *panel_array);
+
+    /// Remove the given panel array from the list of panel arrays intersected by the ray casts.
+    void unregister_panel_array(GastPanelArray *panel_array);
+
+    /// Add the given node to the list of nodes whose visibility state is updated every frame.
+    void register_active_node(GastNode *gast_node);
+
+    /// Remove the given node from the list of nodes whose visibility state is updated every
+    /// frame. The node's visibility state is reset to hidden.
+    void unregister_active_node(GastNode *gast_node);
+
+    /// Add the given node to the list of nodes updated by the per-frame gaze tracking pass.
+    void register_gaze_tracking_node(GastNode *gast_node);
+
+    /// Remove the given node from the list of nodes updated by the per-frame gaze tracking pass.
+    void unregister_gaze_tracking_node(GastNode *gast_node);
+
+    /// Add the given node to the list of nodes whose recommended texture size is computed
+    /// every frame.
+    void register_texture_size_tracking_node(GastNode *gast_node);
+
+    /// Remove the given node from the list of nodes whose recommended texture size is computed
+    /// every frame.
+    void unregister_texture_size_tracking_node(GastNode *gast_node);
+
+    /// Update the total number of texture pixels the recommended texture sizes of all the
+    /// tracking nodes must fit in.
+    void set_texture_pixel_budget(int64_t pixel_budget) {
+        texture_pixel_budget_ = pixel_budget;
+    }
+
+    /// Feed the pose of the tracked hand driving the given ray cast to its gesture recognizer.
+    /// The ray cast is aimed along the stabilized hand aim, and its press, release and scroll
+    /// input is driven by the recognized pinches instead of the input map actions.
+    /// @param joint_positions Global positions of the hand joints, indexed by HandJoint
+    /// @param aim_transform Global transform of the hand's aim, pointing along its -z axis
+    void update_hand_pose(const String &ray_cast_path, const PoolVector3Array &joint_positions,
+                          const Transform &aim_transform);
+
+    /// Notify that the hand driving the given ray cast is no longer tracked. An ongoing pinch is
+    /// released, after which the ray cast goes back to its input map actions.
+    void clear_hand_pose(const String &ray_cast_path);
+
+    /// Returns the pinch strength of the hand driving the given ray cast, or 0 if none.
+    float get_hand_pinch_strength(const String &ray_cast_path);
+
+    /// Sets the input of the current tick for the given ray cast, if it's driven by a tracked
+    /// hand.
+    /// @return false if the ray cast is not driven by a tracked hand
+    bool get_hand_ray_cast_input(const String &ray_cast_name, GastNode::RayCastInput *input);
+
+    /// Returns the pump latching the frames of the nodes' textures once per rendered frame.
+    TextureLatchPump &get_texture_latch_pump() {
+        return texture_latch_pump_;
+    }
+
 private:
 
     // Tracks raycast collision info.
     struct CollisionInfo {
         GastNode *collider = nullptr;
+        // Set instead of the collider when the raycast targets a panel of a panel array.
+        GastPanelArray *panel_array = nullptr;
+        int panel_index = -1;
         // Tracks whether a press is in progress. If so, collision is faked via simulation
         // when the raycast no longer collides with the node.
         bool press_in_progress = false;
         Vector3 collision_point = Vector3::ZERO;
+
+        bool has_target() const {
+            return collider != nullptr || panel_array != nullptr;
+        }
+
+        bool has_same_target(const CollisionInfo &other) const {
+            return collider == other.collider && panel_array == other.panel_array
+                   && panel_index == other.panel_index;
+        }
+    };
+
+    // Ray cast pointer targeting a node.
+    struct NodePointer {
+        String pointer_id;
+        // Index of the pointer among the node's pointers. Stable while the pointer targets the
+        // node, and reused once it leaves.
+        int index = 0;
+        PointerState state = kPointerHover;
+        Vector2 position;
+        // Whether the pointer received an event during the current input tick.
+        bool updated = false;
     };
 
+    // Pointers targeting a node, aggregated into a single multi-pointer event per input tick.
+    struct NodePointers {
+        std::vector<NodePointer> pointers;
+        bool changed = false;
+    };
+
+    // Camera state shared by the per-frame passes.
+    struct CameraInfo {
+        Viewport *viewport = nullptr;
+        Camera *camera = nullptr;
+        Vector3 origin = Vector3::ZERO;
+        Vector3 forward = Vector3::ZERO;
+        // Normalized direction of the center of the gaze area.
+        Vector3 gaze_direction = Vector3::ZERO;
+        // Projection of the gaze direction onto the camera's forward axis.
+        float gaze_direction_depth = 0;
+        // Focal length of the camera, in viewport pixels.
+        float focal_length = 0;
+        float delta = 0;
+        // Planes of the camera's frustum, with their normals pointing outward.
+        std::vector<Plane> frustum;
+    };
+
+    // Screen bounds of an opaque node rendered on top of the other nodes.
+    struct OccluderInfo {
+        Viewport *viewport = nullptr;
+        GastNode *gast_node = nullptr;
+        Rect2 screen_rect;
+    };
+
+    // Updates the camera info for the given viewport.
+    // Returns false if the viewport doesn't have a usable camera.
+    bool update_camera_info(Viewport *viewport, CameraInfo *camera_info);
+
     void cleanup_collision_info(const CollisionInfo &collision_info, const String &ray_cast_name);
 
     bool get_raycast_collision_info(const RayCast &ray_cast, CollisionInfo *collision_info);
 
+    // Returns the closest node using the analytic collision mode intersected by the given ray
+    // segment, within the given distance of its start, or nullptr if none.
+    GastNode *get_analytic_collider(const Vector3 &ray_from, const Vector3 &ray_to,
+                                    float max_distance, Vector3 *collision_point);
+
+    // Returns the panel array with the closest panel intersected by the given ray segment,
+    // within the given distance of its start, or nullptr if none.
+    GastPanelArray *get_panel_array_collider(const Vector3 &ray_from, const Vector3 &ray_to,
+                                             float max_distance, int *panel_index,
+                                             Vector3 *collision_point);
+
     void check_for_monitored_input_actions();
 
     void process_raycast_input();
 
+    void process_hand_gestures();
+
+    // Update the state of the given pointer among the pointers targeting the given node.
+    void track_node_pointer(const String &node_path, const String &pointer_id, PointerState state,
+                            float x_percent, float y_percent);
+
+    // Dispatch the multi-pointer events of the nodes whose pointers changed during the input tick.
+    void dispatch_multi_pointer_inputs();
+
+    void process_mesh_builds();
+
+    void process_gaze_tracking_nodes(CameraInfo *camera_info);
+
+    void process_visibility_states(CameraInfo *camera_info);
+
+    void process_level_of_detail(CameraInfo *camera_info);
+
+    void process_texture_size_tracking_nodes(CameraInfo *camera_info);
+
+    void on_render_recommended_texture_size_update(GastNode *gast_node, int width, int height);
+
+    void on_render_visibility_state_update(GastNode *gast_node);
+
     static void delete_singleton_instance();
 
+    // Drop the references to the nodes, which are freed after the shutdown.
+    void clear_node_references();
+
     static void register_callback(JNIEnv *env, jobject callback);
 
     static void unregister_callback(JNIEnv *env);
@@ -122,6 +329,8 @@ private:
 
     void on_render_input_action(const String &action, InputPressState press_state, float strength);
 
+    void on_render_multi_pointer_input(const String &node_path, const NodePointers &node_pointers);
+
     SceneTree *get_scene_tree();
 
     Node *get_node(const String &node_path);
@@ -132,9 +341,23 @@ private:
 
     std::list<GastNode *> reusable_pool_;
     std::list<String> input_actions_to_monitor_;
+    bool single_pointer_input_enabled_;
+    // Compact list of the nodes inside the scene tree.
+    std::vector<GastNode *> active_nodes_;
+    // Compact list of the nodes following the user's gaze. Updated in a single pass each frame.
+    std::vector<GastNode *> gaze_tracking_nodes_;
+    std::vector<GastNode *> texture_size_tracking_nodes_;
+    // Panel arrays inside the scene tree.
+    std::vector<GastPanelArray *> panel_arrays_;
+    int64_t texture_pixel_budget_;
+    TextureLatchPump texture_latch_pump_;
+    // Gesture recognizers of the tracked hands, keyed by the name of the ray cast they drive.
+    std::map<String, std::unique_ptr<HandGestureRecognizer>> hand_gesture_recognizers_;
     // Map used to keep track of the raycasts colliding with this node.
     // The boolean specifies whether a `press` is currently in progress.
     std::map<String, std::shared_ptr<CollisionInfo>> colliding_raycast_paths;
+    // Pointers targeting the nodes, keyed by node path.
+    std::map<String, NodePointers> node_pointers_;
 
     static GastManager *singleton_instance_;
     static GastLoader *gast_loader_;
@@ -142,11 +365,19 @@ private:
     static bool jni_initialized_;
 
     static jobject callback_instance_;
+    static jclass string_class_;
     static jmethodID on_render_input_action_;
     static jmethodID on_render_input_hover_;
     static jmethodID on_render_input_press_;
     static jmethodID on_render_input_release_;
     static jmethodID on_render_input_scroll_;
+    static jmethodID on_render_multi_pointer_input_;
+    static jmethodID on_render_recommended_texture_size_update_;
+    static jmethodID on_render_visibility_state_update_;
+    static jmethodID on_render_panel_input_hover_;
+    static jmethodID on_render_panel_input_press_;
+    static jmethodID on_render_panel_input_release_;
+    static jmethodID on_render_panel_input_scroll_;
 };
 }  // namespace gast
 
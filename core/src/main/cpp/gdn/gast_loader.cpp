@@ -1,6 +1,10 @@
 #include "gast_loader.h"
 #include <gast_manager.h>
 
+#include <gen/Engine.hpp>
+#include <gen/MainLoop.hpp>
+#include <gen/SceneTree.hpp>
+
 namespace gast {
 
 namespace {
@@ -8,6 +12,20 @@ const char *kHoverInputEvent = "hover_input_event";
 const char *kPressInputEvent = "press_input_event";
 const char *kReleaseInputEvent = "release_input_event";
 const char *kScrollInputEvent = "scroll_input_event";
+const char *kPanelHoverInputEvent = "panel_hover_input_event";
+const char *kPanelPressInputEvent = "panel_press_input_event";
+const char *kPanelReleaseInputEvent = "panel_release_input_event";
+const char *kPanelScrollInputEvent = "panel_scroll_input_event";
+const char *kMultiPointerInputEvent = "multi_pointer_input_event";
+const char *kRecommendedTextureSizeUpdate = "recommended_texture_size_update";
+const char *kVisibilityStateUpdate = "visibility_state_update";
+const char *kProjectionMeshReady = "projection_mesh_ready";
+const char *kIdleFrameSignal = "idle_frame";
+const char *kOnProcessMethod = "on_process";
+
+SceneTree *get_scene_tree() {
+    return Object::cast_to<SceneTree>(Engine::get_singleton()->get_main_loop());
+}
 }
 
 GastLoader::GastLoader() {}
@@ -21,8 +39,15 @@ void GastLoader::_register_methods() {
     register_method("initialize", &GastLoader::initialize);
     register_method("shutdown", &GastLoader::shutdown);
     register_method("on_physics_process", &GastLoader::on_physics_process);
+    register_method(kOnProcessMethod, &GastLoader::on_process);
     register_method("get_external_texture", &GastLoader::get_external_texture);
     register_method("get_shader_materials", &GastLoader::get_shader_materials);
+    register_method("get_recommended_texture_size", &GastLoader::get_recommended_texture_size);
+    register_method("get_visibility_state", &GastLoader::get_visibility_state);
+    register_method("get_frame_stats", &GastLoader::get_frame_stats);
+    register_method("update_hand_pose", &GastLoader::update_hand_pose);
+    register_method("clear_hand_pose", &GastLoader::clear_hand_pose);
+    register_method("get_hand_pinch_strength", &GastLoader::get_hand_pinch_strength);
 
     // Register signals
     Dictionary common_event_args;
@@ -40,13 +65,60 @@ void GastLoader::_register_methods() {
     scroll_event_args[Variant("vertical_delta")] = Variant(Variant::REAL);
 
     register_signal<GastLoader>(kScrollInputEvent, scroll_event_args);
+
+    // Input events targeting a panel of a GastPanelArray.
+    Dictionary panel_event_args = Dictionary(common_event_args);
+    panel_event_args[Variant("panel_index")] = Variant(Variant::INT);
+
+    register_signal<GastLoader>(kPanelHoverInputEvent, panel_event_args);
+    register_signal<GastLoader>(kPanelPressInputEvent, panel_event_args);
+    register_signal<GastLoader>(kPanelReleaseInputEvent, panel_event_args);
+
+    Dictionary panel_scroll_event_args = Dictionary(panel_event_args);
+    panel_scroll_event_args[Variant("horizontal_delta")] = Variant(Variant::REAL);
+    panel_scroll_event_args[Variant("vertical_delta")] = Variant(Variant::REAL);
+
+    register_signal<GastLoader>(kPanelScrollInputEvent, panel_scroll_event_args);
+
+    // Pointers of all the ray casts targeting a node, aggregated once per input tick. Each pointer
+    // is a dictionary with the pointer_index, event_origin_id, state, x_percent and y_percent keys.
+    Dictionary multi_pointer_event_args;
+    multi_pointer_event_args[Variant("node_path")] = Variant(Variant::STRING);
+    multi_pointer_event_args[Variant("pointers")] = Variant(Variant::ARRAY);
+    register_signal<GastLoader>(kMultiPointerInputEvent, multi_pointer_event_args);
+
+    Dictionary texture_size_args;
+    texture_size_args[Variant("node_path")] = Variant(Variant::STRING);
+    texture_size_args[Variant("width")] = Variant(Variant::INT);
+    texture_size_args[Variant("height")] = Variant(Variant::INT);
+    register_signal<GastLoader>(kRecommendedTextureSizeUpdate, texture_size_args);
+
+    Dictionary visibility_state_args;
+    visibility_state_args[Variant("node_path")] = Variant(Variant::STRING);
+    visibility_state_args[Variant("visibility_state")] = Variant(Variant::INT);
+    register_signal<GastLoader>(kVisibilityStateUpdate, visibility_state_args);
+
+    // Emitted when the surfaces of a node's projection mesh built asynchronously are in place.
+    Dictionary projection_mesh_ready_args;
+    projection_mesh_ready_args[Variant("node_path")] = Variant(Variant::STRING);
+    register_signal<GastLoader>(kProjectionMeshReady, projection_mesh_ready_args);
 }
 
 void GastLoader::initialize() {
     GastManager::gdn_initialize(this);
+
+    SceneTree *scene_tree = get_scene_tree();
+    if (scene_tree && !scene_tree->is_connected(kIdleFrameSignal, this, kOnProcessMethod)) {
+        scene_tree->connect(kIdleFrameSignal, this, kOnProcessMethod);
+    }
 }
 
 void GastLoader::shutdown() {
+    SceneTree *scene_tree = get_scene_tree();
+    if (scene_tree && scene_tree->is_connected(kIdleFrameSignal, this, kOnProcessMethod)) {
+        scene_tree->disconnect(kIdleFrameSignal, this, kOnProcessMethod);
+    }
+
     GastManager::gdn_shutdown();
 }
 
@@ -54,6 +126,10 @@ void GastLoader::on_physics_process() {
     GastManager::get_singleton_instance()->on_physics_process();
 }
 
+void GastLoader::on_process() {
+    GastManager::get_singleton_instance()->on_process();
+}
+
 Ref<ExternalTexture> GastLoader::get_external_texture(const String gast_node_path) {
     GastNode* gast_node = GastManager::get_singleton_instance()->get_gast_node(gast_node_path);
     if (!gast_node) {
@@ -72,6 +148,60 @@ Array GastLoader::get_shader_materials(const String gast_node_path) {
     return gast_node->get_shader_materials();
 }
 
+Vector2 GastLoader::get_recommended_texture_size(const String gast_node_path) {
+    GastNode* gast_node = GastManager::get_singleton_instance()->get_gast_node(gast_node_path);
+    if (!gast_node) {
+        return Vector2();
+    }
+
+    return gast_node->get_recommended_texture_size();
+}
+
+int GastLoader::get_visibility_state(const String gast_node_path) {
+    GastNode* gast_node = GastManager::get_singleton_instance()->get_gast_node(gast_node_path);
+    if (!gast_node) {
+        return GastNode::VisibilityState::HIDDEN;
+    }
+
+    return gast_node->get_visibility_state();
+}
+
+Dictionary GastLoader::get_frame_stats(const String gast_node_path) {
+    Dictionary frame_stats;
+    GastManager *gast_manager = GastManager::get_singleton_instance();
+    GastNode *gast_node = gast_manager->get_gast_node(gast_node_path);
+    TextureFrameStats stats;
+    if (!gast_node || !gast_manager->get_texture_latch_pump().get_frame_stats(gast_node, &stats)) {
+        return frame_stats;
+    }
+
+    frame_stats["latency_sample_count"] = stats.latency_sample_count;
+    frame_stats["latency_p50_ms"] = stats.latency_p50_ms;
+    frame_stats["latency_p95_ms"] = stats.latency_p95_ms;
+    frame_stats["latency_p99_ms"] = stats.latency_p99_ms;
+    frame_stats["drop_rate"] = stats.drop_rate;
+    frame_stats["skip_rate"] = stats.skip_rate;
+    frame_stats["latched_frame_count"] = stats.latched_frame_count;
+    frame_stats["dropped_frame_count"] = stats.dropped_frame_count;
+    frame_stats["skipped_latch_count"] = stats.skipped_latch_count;
+    return frame_stats;
+}
+
+void GastLoader::update_hand_pose(const String ray_cast_path,
+                                  const PoolVector3Array joint_positions,
+                                  const Transform aim_transform) {
+    GastManager::get_singleton_instance()->update_hand_pose(ray_cast_path, joint_positions,
+                                                            aim_transform);
+}
+
+void GastLoader::clear_hand_pose(const String ray_cast_path) {
+    GastManager::get_singleton_instance()->clear_hand_pose(ray_cast_path);
+}
+
+float GastLoader::get_hand_pinch_strength(const String ray_cast_path) {
+    return GastManager::get_singleton_instance()->get_hand_pinch_strength(ray_cast_path);
+}
+
 void
 GastLoader::emitHoverEvent(const String &node_path, const String &event_origin_id, float x_percent,
                            float y_percent) {
@@ -95,4 +225,49 @@ GastLoader::emitScrollEvent(const String &node_path, const String &event_origin_
     emit_signal(kScrollInputEvent, node_path, event_origin_id, x_percent, y_percent,
                 horizontal_delta, vertical_delta);
 }
+
+void GastLoader::emitPanelHoverEvent(const String &node_path, int panel_index,
+                                     const String &event_origin_id, float x_percent,
+                                     float y_percent) {
+    emit_signal(kPanelHoverInputEvent, node_path, event_origin_id, x_percent, y_percent,
+                panel_index);
+}
+
+void GastLoader::emitPanelPressEvent(const String &node_path, int panel_index,
+                                     const String &event_origin_id, float x_percent,
+                                     float y_percent) {
+    emit_signal(kPanelPressInputEvent, node_path, event_origin_id, x_percent, y_percent,
+                panel_index);
+}
+
+void GastLoader::emitPanelReleaseEvent(const String &node_path, int panel_index,
+                                       const String &event_origin_id, float x_percent,
+                                       float y_percent) {
+    emit_signal(kPanelReleaseInputEvent, node_path, event_origin_id, x_percent, y_percent,
+                panel_index);
+}
+
+void GastLoader::emitPanelScrollEvent(const String &node_path, int panel_index,
+                                      const String &event_origin_id, float x_percent,
+                                      float y_percent, float horizontal_delta,
+                                      float vertical_delta) {
+    emit_signal(kPanelScrollInputEvent, node_path, event_origin_id, x_percent, y_percent,
+                panel_index, horizontal_delta, vertical_delta);
+}
+
+void GastLoader::emitMultiPointerEvent(const String &node_path, const Array &pointers) {
+    emit_signal(kMultiPointerInputEvent, node_path, pointers);
+}
+
+void GastLoader::emitRecommendedTextureSizeUpdate(const String &node_path, int width, int height) {
+    emit_signal(kRecommendedTextureSizeUpdate, node_path, width, height);
+}
+
+void GastLoader::emitVisibilityStateUpdate(const String &node_path, int visibility_state) {
+    emit_signal(kVisibilityStateUpdate, node_path, visibility_state);
+}
+
+void GastLoader::emitProjectionMeshReady(const String &node_path) {
+    emit_signal(kProjectionMeshReady, node_path);
+}
 }
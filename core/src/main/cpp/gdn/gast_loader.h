@@ -2,9 +2,13 @@
 #define GAST_LOADER_H
 
 #include <core/Array.hpp>
+#include <core/Dictionary.hpp>
 #include <core/Godot.hpp>
+#include <core/PoolArrays.hpp>
 #include <core/String.hpp>
 #include <core/Ref.hpp>
+#include <core/Transform.hpp>
+#include <core/Vector2.hpp>
 #include <gen/ExternalTexture.hpp>
 #include <gen/Reference.hpp>
 
@@ -36,10 +40,35 @@ public:
 
     void on_physics_process();
 
+    // Invoked once per frame (via the SceneTree 'idle_frame' signal) to drive the frame updates
+    // for the Gast nodes.
+    void on_process();
+
     Ref<ExternalTexture> get_external_texture(const String gast_node_path);
 
     Array get_shader_materials(const String gast_node_path);
 
+    Vector2 get_recommended_texture_size(const String gast_node_path);
+
+    // Returns the GastNode#VisibilityState value of the given node.
+    int get_visibility_state(const String gast_node_path);
+
+    // Returns the rolling latency and drop statistics of the frames latched into the given
+    // node's texture, or an empty dictionary if the node has no bound surface or renders from
+    // a texture atlas.
+    Dictionary get_frame_stats(const String gast_node_path);
+
+    // Feed the pose of a tracked hand to the gesture recognizer driving the given ray cast.
+    // The joint positions are global and ordered as the HandJoint enum: wrist, thumb tip, index
+    // knuckle, index tip and ring tip.
+    void update_hand_pose(const String ray_cast_path, const PoolVector3Array joint_positions,
+                          const Transform aim_transform);
+
+    // Notify that the hand driving the given ray cast is no longer tracked.
+    void clear_hand_pose(const String ray_cast_path);
+
+    float get_hand_pinch_strength(const String ray_cast_path);
+
     void emitHoverEvent(const String &node_path, const String &event_origin_id, float x_percent,
                         float y_percent);
 
@@ -53,6 +82,27 @@ public:
     void emitScrollEvent(const String &node_path, const String &event_origin_id, float x_percent,
                          float y_percent,
                          float horizontal_delta, float vertical_delta);
+
+    void emitPanelHoverEvent(const String &node_path, int panel_index,
+                             const String &event_origin_id, float x_percent, float y_percent);
+
+    void emitPanelPressEvent(const String &node_path, int panel_index,
+                             const String &event_origin_id, float x_percent, float y_percent);
+
+    void emitPanelReleaseEvent(const String &node_path, int panel_index,
+                               const String &event_origin_id, float x_percent, float y_percent);
+
+    void emitPanelScrollEvent(const String &node_path, int panel_index,
+                              const String &event_origin_id, float x_percent, float y_percent,
+                              float horizontal_delta, float vertical_delta);
+
+    void emitMultiPointerEvent(const String &node_path, const Array &pointers);
+
+    void emitRecommendedTextureSizeUpdate(const String &node_path, int width, int height);
+
+    void emitVisibilityStateUpdate(const String &node_path, int visibility_state);
+
+    void emitProjectionMeshReady(const String &node_path);
 };
 }  // namespace gast
 
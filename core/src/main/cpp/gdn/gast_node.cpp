@@ -1,14 +1,14 @@
 #include "gast_node.h"
 #include "gast_manager.h"
 #include "gdn/projection_mesh/rectangular_projection_mesh.h"
+#include "gdn/texture_atlas.h"
 #include <utils.h>
 
+#include <cmath>
 #include <core/Array.hpp>
 #include <core/String.hpp>
 #include <core/NodePath.hpp>
-#include <core/Rect2.hpp>
 #include <core/Transform.hpp>
-#include <gen/Camera.hpp>
 #include <gen/Input.hpp>
 #include <gen/InputEventScreenDrag.hpp>
 #include <gen/InputEventScreenTouch.hpp>
@@ -27,9 +27,28 @@
 
 namespace gast {
 
+namespace {
+// Angle (in radians) below which a lazily following node is considered settled.
+const float kGazeFollowSettleAngle = 0.001f;
+// Relative change required before the recommended texture size is updated.
+const float kRecommendedTextureSizeHysteresis = 0.2f;
+// The recommended texture dimensions are rounded up to a multiple of this value.
+const int kRecommendedTextureSizeAlignment = 16;
+}  // namespace
+
+bool is_texture_owner_visible(const GastNode *owner) {
+    return owner->get_visibility_state() == GastNode::VisibilityState::VISIBLE;
+}
+
 GastNode::GastNode() : projection_mesh_pool(ProjectionMeshPool()) {}
 
 GastNode::~GastNode() {
+    // The texture sources may outlive the node, until they're unregistered from the Java side.
+    // Once Gast is shut down, they were already detached from the nodes.
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (gast_manager) {
+        gast_manager->get_texture_latch_pump().clear_owner(this);
+    }
     reset();
 }
 
@@ -37,7 +56,6 @@ void GastNode::_register_methods() {
     register_method("_enter_tree", &GastNode::_enter_tree);
     register_method("_exit_tree", &GastNode::_exit_tree);
     register_method("_input_event", &GastNode::_input_event);
-    register_method("_process", &GastNode::_process);
     register_method("_notification", &GastNode::_notification);
 
     register_method("get_external_texture_id", &GastNode::get_external_texture_id);
@@ -53,20 +71,81 @@ void GastNode::_init() {
 
 void GastNode::_enter_tree() {
     update_collision_shape();
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (!gast_manager) {
+        return;
+    }
+
+    gast_manager->register_active_node(this);
+    update_gaze_tracking_registration();
+    if (texture_size_tracking) {
+        gast_manager->register_texture_size_tracking_node(this);
+    }
 }
 
 void GastNode::_exit_tree() {
     update_collision_shape();
+    // The node is still reported as inside the tree at this point.
+    set_gaze_tracking_registered(false);
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (!gast_manager) {
+        return;
+    }
+
+    if (texture_size_tracking) {
+        gast_manager->unregister_texture_size_tracking_node(this);
+    }
+    gast_manager->unregister_active_node(this);
 }
 
 void GastNode::reset() {
+    if (texture_atlas) {
+        texture_atlas->remove_node(this);
+    }
+
     remove_projection_mesh_collision_shapes();
     projection_mesh = nullptr;
     projection_mesh_pool.reset();
 
+    set_gaze_follow_mode(GazeFollowMode::STRICT);
+    set_gaze_follow_dead_zone(kDefaultGazeFollowDeadZoneDegrees);
+    set_gaze_follow_smoothing_time(kDefaultGazeFollowSmoothingTime);
+    set_texture_size_tracking(false);
+
     set_projection_mesh(ProjectionMesh::ProjectionMeshType::RECTANGULAR);
 }
 
+void GastNode::set_gaze_tracking(bool gaze_tracking) {
+    projection_mesh->set_gaze_tracking(gaze_tracking);
+    update_gaze_tracking_registration();
+}
+
+void GastNode::update_gaze_tracking_registration() {
+    set_gaze_tracking_registered(projection_mesh && is_gaze_tracking() && is_inside_tree());
+}
+
+void GastNode::set_gaze_tracking_registered(bool registered) {
+    if (gaze_tracking_registered == registered) {
+        return;
+    }
+    gaze_tracking_registered = registered;
+    gaze_follow_settling = false;
+    gaze_follow_velocity = Vector3::ZERO;
+
+    // Gaze tracking is driven by the GastManager in a single pass per frame, so this node never
+    // needs its own process callback.
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (!gast_manager) {
+        return;
+    }
+
+    if (registered) {
+        gast_manager->register_gaze_tracking_node(this);
+    } else {
+        gast_manager->unregister_gaze_tracking_node(this);
+    }
+}
+
 void GastNode::remove_projection_mesh_collision_shapes() {
     if (projection_mesh) {
         projection_mesh->reset_external_texture();
@@ -110,9 +189,16 @@ void GastNode::set_projection_mesh(ProjectionMesh::ProjectionMeshType projection
         case ProjectionMesh::ProjectionMeshType::MESH:
             projection_mesh = projection_mesh_pool.get_or_create_projection_mesh<CustomProjectionMesh>();
             break;
+        case ProjectionMesh::ProjectionMeshType::EAC:
+            projection_mesh = projection_mesh_pool.get_or_create_projection_mesh<EacProjectionMesh>();
+            break;
+        case ProjectionMesh::ProjectionMeshType::HEMISPHERE_180:
+            projection_mesh =
+                    projection_mesh_pool.get_or_create_projection_mesh<HemisphereProjectionMesh>();
+            break;
     }
 
-    projection_mesh->set_external_texture(external_texture);
+    update_projection_mesh_texture();
     for (int i = 0; i < projection_mesh->get_mesh_count(); i++) {
         CollisionShape *collision_shape = projection_mesh->get_collision_shape(i);
         if (collision_shape) {
@@ -126,9 +212,30 @@ void GastNode::set_projection_mesh(ProjectionMesh::ProjectionMeshType projection
     }
 
     update_collision_shape();
+    update_gaze_tracking_registration();
     projection_mesh->update_render_priority();
 }
 
+void GastNode::set_texture_atlas(TextureAtlas *texture_atlas, const Rect2 &region) {
+    this->texture_atlas = texture_atlas;
+    this->texture_atlas_region = region;
+    update_projection_mesh_texture();
+}
+
+void GastNode::update_projection_mesh_texture() {
+    if (!projection_mesh) {
+        return;
+    }
+
+    if (texture_atlas) {
+        projection_mesh->set_external_texture(texture_atlas->get_external_texture());
+        projection_mesh->set_texture_region(texture_atlas_region);
+    } else {
+        projection_mesh->set_external_texture(external_texture);
+        projection_mesh->set_texture_region(kFullTextureRegion);
+    }
+}
+
 void GastNode::update_collision_shape() {
     if (projection_mesh) {
         projection_mesh->update_collision_shapes();
@@ -206,66 +313,199 @@ void GastNode::_notification(const int64_t what) {
     }
 }
 
-void GastNode::_process(const real_t delta) {
-    if (is_gaze_tracking()) {
-        Rect2 gaze_area = get_viewport()->get_visible_rect();
-        Vector2 gaze_center_point = Vector2(gaze_area.position.x + gaze_area.size.x / 2.0,
-                                            gaze_area.position.y + gaze_area.size.y / 2.0);
+void GastNode::set_gaze_follow_mode(GazeFollowMode mode) {
+    if (gaze_follow_mode == mode) {
+        return;
+    }
+    gaze_follow_mode = mode;
+    gaze_follow_settling = false;
+    gaze_follow_velocity = Vector3::ZERO;
+}
+
+void GastNode::follow_gaze(const Vector3 &camera_origin, const Vector3 &gaze_direction,
+                           float gaze_direction_depth, float delta) {
+    Transform global_transform = get_global_transform();
+    Vector3 node_offset = global_transform.origin - camera_origin;
+    float distance = node_offset.length();
+
+    // Target position at the center of the gaze area, preserving the node's distance from the
+    // camera. This matches Camera::project_position(), whose depth is measured along the
+    // camera's forward axis.
+    Vector3 target_position = camera_origin + gaze_direction * (distance / gaze_direction_depth);
+
+    Vector3 updated_position = target_position;
+    if (gaze_follow_mode == GazeFollowMode::LAZY && distance > CMP_EPSILON) {
+        if (!gaze_follow_settling) {
+            // Leave the node (and its collision shape) untouched while it's within the dead zone.
+            if (node_offset.angle_to(gaze_direction) <= gaze_follow_dead_zone) {
+                return;
+            }
+            gaze_follow_settling = true;
+            gaze_follow_velocity = Vector3::ZERO;
+        }
 
-        // Get the distance between the camera and this node.
-        Camera* camera = get_viewport()->get_camera();
-        Transform global_transform = get_global_transform();
-        float distance = camera->get_global_transform().origin.distance_to(global_transform.origin);
+        if (gaze_follow_smoothing_time > CMP_EPSILON) {
+            // Critically damped spring towards the target position.
+            const float omega = 2.0f / gaze_follow_smoothing_time;
+            const float x = omega * delta;
+            const float decay = 1.0f / (1.0f + x + 0.48f * x * x + 0.235f * x * x * x);
+            Vector3 change = global_transform.origin - target_position;
+            Vector3 temp = (gaze_follow_velocity + change * omega) * delta;
+            gaze_follow_velocity = (gaze_follow_velocity - temp * omega) * decay;
+            updated_position = target_position + (change + temp) * decay;
+
+            // Keep the node at a constant distance from the camera while it's settling.
+            Vector3 updated_offset = updated_position - camera_origin;
+            if (updated_offset.length() > CMP_EPSILON) {
+                updated_position = camera_origin + updated_offset.normalized() * distance;
+            }
+        }
 
-        // Update the node's position to match the center of the gaze area.
-        Vector3 updated_position = camera->project_position(gaze_center_point, distance);
+        // Once close enough to the target, snap to it and stop updating until the gaze leaves
+        // the dead zone again.
+        const float settle_threshold = distance * kGazeFollowSettleAngle;
+        if (updated_position.distance_to(target_position) <= settle_threshold
+            && gaze_follow_velocity.length() <= settle_threshold) {
+            updated_position = target_position;
+            gaze_follow_settling = false;
+            gaze_follow_velocity = Vector3::ZERO;
+        }
+    }
+
+    if (global_transform.origin != updated_position) {
         global_transform.origin = updated_position;
         set_global_transform(global_transform);
     }
 }
 
-bool
-GastNode::handle_ray_cast_input(const String &ray_cast_name, Vector2 relative_collision_point) {
-    Input *input = Input::get_singleton();
-    InputMap *input_map = InputMap::get_singleton();
+void GastNode::set_texture_size_tracking(bool enable) {
+    if (texture_size_tracking == enable) {
+        return;
+    }
+    texture_size_tracking = enable;
+    recommended_texture_size = Vector2();
 
-    String node_path = get_path();
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (!is_inside_tree() || !gast_manager) {
+        return;
+    }
 
-    float x_percent = relative_collision_point.x;
-    float y_percent = relative_collision_point.y;
+    if (enable) {
+        gast_manager->register_texture_size_tracking_node(this);
+    } else {
+        gast_manager->unregister_texture_size_tracking_node(this);
+    }
+}
 
-    // Check for click actions
-    String ray_cast_click_action = get_click_action_from_node_name(ray_cast_name);
-    bool press_in_progress = false;
-    bool hovering = true;
+bool GastNode::is_occluder() {
+    if (!projection_mesh || !is_render_on_top() || !is_opaque() || is_gaze_tracking()
+        || !projection_mesh->is_rectangular_projection_mesh()) {
+        return false;
+    }
 
-    if (input_map->has_action(ray_cast_click_action)) {
-        press_in_progress = input->is_action_pressed(ray_cast_click_action);
-
-        if (input->is_action_just_pressed(ray_cast_click_action)) {
-            hovering = false;
-            GastManager::get_singleton_instance()->on_render_input_press(
-                    node_path, ray_cast_name,
-                    x_percent, y_percent);
-        } else if (input->is_action_just_released(ray_cast_click_action)) {
-            hovering = false;
-            GastManager::get_singleton_instance()->on_render_input_release(
-                    node_path, ray_cast_name,
-                    x_percent, y_percent);
+    // The screen bounds of a curved panel overestimate the area it covers.
+    auto *rectangular_mesh = static_cast<RectangularProjectionMesh *>(projection_mesh);
+    return !rectangular_mesh->get_curved();
+}
+
+AABB GastNode::get_global_aabb() {
+    AABB global_aabb;
+    if (!projection_mesh) {
+        return global_aabb;
+    }
+
+    bool has_aabb = false;
+    for (int i = 0; i < projection_mesh->get_mesh_count(); i++) {
+        MeshInstance *mesh_instance = projection_mesh->get_mesh_instance(i);
+        if (!mesh_instance || mesh_instance->get_mesh().is_null()) {
+            continue;
         }
+
+        AABB mesh_aabb = mesh_instance->get_global_transform().xform(mesh_instance->get_aabb());
+        global_aabb = has_aabb ? global_aabb.merge(mesh_aabb) : mesh_aabb;
+        has_aabb = true;
     }
-    if (hovering) {
-        GastManager::get_singleton_instance()->on_render_input_hover(
-                node_path,
-                ray_cast_name,
-                x_percent,
-                y_percent);
+    return global_aabb;
+}
+
+Vector2 GastNode::get_projected_size(const Vector3 &camera_origin, float focal_length) {
+    if (!projection_mesh || projection_mesh->get_mesh_count() <= 0) {
+        return Vector2();
     }
 
-    // Check for scrolling actions
-    bool did_scroll = false;
-    float horizontal_scroll_delta = 0;
-    float vertical_scroll_delta = 0;
+    MeshInstance *mesh_instance = projection_mesh->get_mesh_instance(0);
+    AABB mesh_aabb = mesh_instance->get_aabb();
+    Transform mesh_transform = mesh_instance->get_global_transform();
+    AABB global_aabb = mesh_transform.xform(mesh_aabb);
+
+    // Distance from the camera to the closest point of the mesh bounds.
+    Vector3 aabb_end = global_aabb.position + global_aabb.size;
+    Vector3 closest_point = Vector3(
+            CLAMP(camera_origin.x, global_aabb.position.x, aabb_end.x),
+            CLAMP(camera_origin.y, global_aabb.position.y, aabb_end.y),
+            CLAMP(camera_origin.z, global_aabb.position.z, aabb_end.z));
+    float distance = camera_origin.distance_to(closest_point);
+    if (distance <= CMP_EPSILON) {
+        // The camera is within the mesh bounds (e.g: equirectangular projection), so the mesh
+        // potentially covers the whole viewport.
+        return Vector2(INFINITY, INFINITY);
+    }
+
+    Vector3 scale = mesh_transform.basis.get_scale();
+    Vector2 world_size = Vector2(mesh_aabb.size.x * scale.x, mesh_aabb.size.y * scale.y);
+    return world_size * (focal_length / distance);
+}
+
+void GastNode::update_level_of_detail(const Vector3 &camera_origin,
+                                      const Vector3 &camera_forward, float focal_length) {
+    if (projection_mesh) {
+        projection_mesh->update_level_of_detail(camera_origin, camera_forward, focal_length);
+    }
+}
+
+bool GastNode::apply_completed_mesh_builds() {
+    return projection_mesh && projection_mesh->apply_completed_mesh_builds();
+}
+
+bool GastNode::update_recommended_texture_size(Vector2 size) {
+    Vector2 aligned_size = Vector2(
+            std::ceil(size.x / kRecommendedTextureSizeAlignment) * kRecommendedTextureSizeAlignment,
+            std::ceil(size.y / kRecommendedTextureSizeAlignment) * kRecommendedTextureSizeAlignment);
+    if (recommended_texture_size.x > 0 && recommended_texture_size.y > 0) {
+        float width_change = std::abs(aligned_size.x - recommended_texture_size.x);
+        float height_change = std::abs(aligned_size.y - recommended_texture_size.y);
+        if (width_change <= recommended_texture_size.x * kRecommendedTextureSizeHysteresis
+            && height_change <= recommended_texture_size.y * kRecommendedTextureSizeHysteresis) {
+            return false;
+        }
+    }
+
+    if (recommended_texture_size == aligned_size) {
+        return false;
+    }
+    recommended_texture_size = aligned_size;
+    return true;
+}
+
+GastNode::RayCastInput GastNode::get_ray_cast_input(const String &ray_cast_name) {
+    RayCastInput ray_cast_input;
+    // The ray casts driven by a tracked hand get their input from the recognized gestures.
+    if (GastManager::get_singleton_instance()->get_hand_ray_cast_input(ray_cast_name,
+                                                                       &ray_cast_input)) {
+        return ray_cast_input;
+    }
+
+    Input *input = Input::get_singleton();
+    InputMap *input_map = InputMap::get_singleton();
+
+    // Check for click actions
+    String ray_cast_click_action = get_click_action_from_node_name(ray_cast_name);
+    if (input_map->has_action(ray_cast_click_action)) {
+        ray_cast_input.press_in_progress = input->is_action_pressed(ray_cast_click_action);
+        ray_cast_input.just_pressed = input->is_action_just_pressed(ray_cast_click_action);
+        ray_cast_input.just_released = !ray_cast_input.just_pressed
+                                       && input->is_action_just_released(ray_cast_click_action);
+    }
 
     // Horizontal scrolls
     String ray_cast_horizontal_left_scroll_action = get_horizontal_left_scroll_action_from_node_name(
@@ -274,13 +514,13 @@ GastNode::handle_ray_cast_input(const String &ray_cast_name, Vector2 relative_co
             ray_cast_name);
     if (input_map->has_action(ray_cast_horizontal_left_scroll_action) && input->is_action_pressed
             (ray_cast_horizontal_left_scroll_action)) {
-        did_scroll = true;
-        horizontal_scroll_delta = -input->get_action_strength(
+        ray_cast_input.did_scroll = true;
+        ray_cast_input.horizontal_scroll_delta = -input->get_action_strength(
                 ray_cast_horizontal_left_scroll_action);
     } else if (input_map->has_action(ray_cast_horizontal_right_scroll_action) &&
             input->is_action_pressed(ray_cast_horizontal_right_scroll_action)) {
-        did_scroll = true;
-        horizontal_scroll_delta = input->get_action_strength(
+        ray_cast_input.did_scroll = true;
+        ray_cast_input.horizontal_scroll_delta = input->get_action_strength(
                 ray_cast_horizontal_right_scroll_action);
     }
 
@@ -291,22 +531,50 @@ GastNode::handle_ray_cast_input(const String &ray_cast_name, Vector2 relative_co
             ray_cast_name);
     if (input_map->has_action(ray_cast_vertical_down_scroll_action) && input->is_action_pressed
             (ray_cast_vertical_down_scroll_action)) {
-        did_scroll = true;
-        vertical_scroll_delta = -input->get_action_strength(ray_cast_vertical_down_scroll_action);
+        ray_cast_input.did_scroll = true;
+        ray_cast_input.vertical_scroll_delta = -input->get_action_strength(
+                ray_cast_vertical_down_scroll_action);
     } else if (input_map->has_action(ray_cast_vertical_up_scroll_action) && input->is_action_pressed
             (ray_cast_vertical_up_scroll_action)) {
-        did_scroll = true;
-        vertical_scroll_delta = input->get_action_strength(ray_cast_vertical_up_scroll_action);
+        ray_cast_input.did_scroll = true;
+        ray_cast_input.vertical_scroll_delta = input->get_action_strength(
+                ray_cast_vertical_up_scroll_action);
+    }
+
+    return ray_cast_input;
+}
+
+bool
+GastNode::handle_ray_cast_input(const String &ray_cast_name, Vector2 relative_collision_point) {
+    String node_path = get_path();
+
+    float x_percent = relative_collision_point.x;
+    float y_percent = relative_collision_point.y;
+
+    RayCastInput ray_cast_input = get_ray_cast_input(ray_cast_name);
+    if (ray_cast_input.just_pressed) {
+        GastManager::get_singleton_instance()->on_render_input_press(
+                node_path, ray_cast_name,
+                x_percent, y_percent);
+    } else if (ray_cast_input.just_released) {
+        GastManager::get_singleton_instance()->on_render_input_release(
+                node_path, ray_cast_name,
+                x_percent, y_percent);
+    } else {
+        GastManager::get_singleton_instance()->on_render_input_hover(
+                node_path,
+                ray_cast_name,
+                x_percent,
+                y_percent);
     }
 
-    if (did_scroll) {
-        GastManager::get_singleton_instance()->on_render_input_scroll(node_path, ray_cast_name,
-                                                                      x_percent, y_percent,
-                                                                      horizontal_scroll_delta,
-                                                                      vertical_scroll_delta);
+    if (ray_cast_input.did_scroll) {
+        GastManager::get_singleton_instance()->on_render_input_scroll(
+                node_path, ray_cast_name, x_percent, y_percent,
+                ray_cast_input.horizontal_scroll_delta, ray_cast_input.vertical_scroll_delta);
     }
 
-    return press_in_progress;
+    return ray_cast_input.press_in_progress;
 }
 
 bool GastNode::intersects_ray(Vector3 ray_origin, Vector3 ray_direction, Vector3 *intersection) {
@@ -337,16 +605,29 @@ bool GastNode::intersects_ray(Vector3 ray_origin, Vector3 ray_direction, Vector3
     return plane.intersects_ray(ray_origin, ray_direction, intersection);
 }
 
-Vector2 GastNode::get_relative_collision_point(Vector3 absolute_collision_point) {
-    Vector3 local_point = to_local(absolute_collision_point);
-    if (projection_mesh->is_rectangular_projection_mesh()) {
-        auto *rectangular_projection_mesh =
-                Object::cast_to<RectangularProjectionMesh>(projection_mesh);
-        return rectangular_projection_mesh->get_relative_collision_point(local_point);
-    } else {
-        // TODO: Implement for other projection mesh types.
-        return kInvalidCoordinate;
+bool GastNode::intersects_ray_analytic(const Vector3 &ray_from, const Vector3 &ray_to,
+                                       Vector3 *intersection) {
+    if (!projection_mesh || !projection_mesh->is_collidable() || !is_visible_in_tree()) {
+        return false;
+    }
+
+    // The intersection is computed in the node's local space, where the ray segment spans the
+    // [0, 1] parameter range.
+    Vector3 local_from = to_local(ray_from);
+    Vector3 local_direction = to_local(ray_to) - local_from;
+    Vector3 local_intersection;
+    if (!projection_mesh->intersects_ray(local_from, local_direction, &local_intersection)
+        || (local_intersection - local_from).length_squared()
+           > local_direction.length_squared()) {
+        return false;
     }
+
+    *intersection = to_global(local_intersection);
+    return true;
+}
+
+Vector2 GastNode::get_relative_collision_point(Vector3 absolute_collision_point) {
+    return projection_mesh->get_relative_collision_point(to_local(absolute_collision_point));
 }
 
 }  // namespace gast
@@ -1,8 +1,12 @@
 #ifndef GAST_NODE_H
 #define GAST_NODE_H
 
+#include <algorithm>
+#include <core/AABB.hpp>
 #include <core/Array.hpp>
 #include <core/Godot.hpp>
+#include <core/Math.hpp>
+#include <core/Rect2.hpp>
 #include <core/Ref.hpp>
 #include <core/Vector2.hpp>
 #include <core/Vector3.hpp>
@@ -27,9 +31,13 @@
 
 namespace gast {
 
+class TextureAtlas;
+
 namespace {
 using namespace godot;
 constexpr int kInvalidTexId = -1;
+constexpr float kDefaultGazeFollowDeadZoneDegrees = 15.0f;
+constexpr float kDefaultGazeFollowSmoothingTime = 0.3f;
 }  // namespace
 
 /// Script for a GAST node. Enables GAST specific logic and processing.
@@ -53,10 +61,31 @@ public:
     _input_event(const Object *camera, const Ref<InputEvent> event, const Vector3 click_position,
                  const Vector3 click_normal, const int64_t shape_idx);
 
-    void _process(const real_t delta);
-
     void _notification(const int64_t what);
 
+    // Mirrors src/main/java/org/godotengine/plugin/gast/GastNode#GazeFollowMode
+    enum GazeFollowMode {
+        // The node is re-positioned every frame to exactly follow the user's gaze.
+        STRICT = 0,
+        // The node only moves when the user's gaze leaves the angular dead zone around it, and
+        // then settles back to the center of the gaze using critically damped smoothing.
+        LAZY = 1,
+    };
+
+    // Mirrors src/main/java/org/godotengine/plugin/gast/GastNode#VisibilityState
+    enum VisibilityState {
+        // The node is potentially visible on screen.
+        VISIBLE = 0,
+        // The node is hidden, or not part of the scene tree.
+        HIDDEN = 1,
+        // The node's bounds are outside of the camera's frustum.
+        OUT_OF_FRUSTUM = 2,
+        // The node is fully covered by an opaque node rendered on top.
+        OCCLUDED = 3,
+        // The node's alpha is too low for its content to be seen.
+        TRANSPARENT = 4,
+    };
+
     void reset();
 
     Ref<ExternalTexture> get_external_texture();
@@ -91,27 +120,99 @@ public:
         return projection_mesh->is_render_on_top();
     }
 
-    inline void set_gaze_tracking(bool gaze_tracking) {
-        projection_mesh->set_gaze_tracking(gaze_tracking);
-    }
+    void set_gaze_tracking(bool gaze_tracking);
 
     inline bool is_gaze_tracking() {
         return projection_mesh->is_gaze_tracking();
     }
 
+    void set_gaze_follow_mode(GazeFollowMode mode);
+
+    inline GazeFollowMode get_gaze_follow_mode() const {
+        return gaze_follow_mode;
+    }
+
+    inline void set_gaze_follow_dead_zone(float dead_zone_degrees) {
+        gaze_follow_dead_zone = Math::deg2rad(std::max(0.0f, dead_zone_degrees));
+    }
+
+    inline float get_gaze_follow_dead_zone() const {
+        return Math::rad2deg(gaze_follow_dead_zone);
+    }
+
+    inline void set_gaze_follow_smoothing_time(float smoothing_time) {
+        gaze_follow_smoothing_time = std::max(0.0f, smoothing_time);
+    }
+
+    inline float get_gaze_follow_smoothing_time() const {
+        return gaze_follow_smoothing_time;
+    }
+
+    /// Update the node's position based on the user's gaze.
+    /// Invoked once per frame by the GastManager for gaze tracking nodes.
+    /// @param camera_origin Global position of the camera
+    /// @param gaze_direction Normalized global direction of the center of the gaze
+    /// @param gaze_direction_depth Projection of the gaze direction onto the camera's forward axis
+    /// @param delta Time elapsed since the previous frame, in seconds
+    void follow_gaze(const Vector3 &camera_origin, const Vector3 &gaze_direction,
+                     float gaze_direction_depth, float delta);
+
     inline void set_alpha(float alpha) {
         projection_mesh->set_alpha(alpha);
     }
 
+    inline float get_alpha() {
+        return projection_mesh->get_alpha();
+    }
+
     inline void set_has_transparency(bool has_transparency) {
         projection_mesh->set_has_transparency(has_transparency);
     }
 
+    inline bool is_opaque() {
+        return projection_mesh->is_opaque();
+    }
+
+    /// Returns true if the node is a flat opaque panel rendered on top of the other nodes, and
+    /// thus fully hides the content behind it.
+    bool is_occluder();
+
+    /// Returns the global bounds of the node's projection mesh.
+    AABB get_global_aabb();
+
+    inline VisibilityState get_visibility_state() const {
+        return visibility_state;
+    }
+
+    /// Update the node's visibility state.
+    /// Invoked once per frame by the GastManager.
+    /// @return true if the visibility state changed
+    inline bool update_visibility_state(VisibilityState state) {
+        if (visibility_state == state) {
+            return false;
+        }
+        visibility_state = state;
+        return true;
+    }
+
     static inline RayCast *get_ray_cast_from_variant(Variant variant) {
         RayCast *ray_cast = Object::cast_to<RayCast>(variant);
         return ray_cast;
     }
 
+    // State of the input actions mapped to a ray cast.
+    struct RayCastInput {
+        bool press_in_progress = false;
+        bool just_pressed = false;
+        bool just_released = false;
+        bool did_scroll = false;
+        float horizontal_scroll_delta = 0;
+        float vertical_scroll_delta = 0;
+    };
+
+    // Poll the click and scroll input actions mapped to the given ray cast.
+    static RayCastInput get_ray_cast_input(const String &ray_cast_name);
+
     Vector2 get_relative_collision_point(Vector3 absolute_collision_point);
 
     // Handle the raycast input. Returns true if a press is in progress.
@@ -120,6 +221,69 @@ public:
     // Returns true if the plane defined by this node intersects the given ray.
     bool intersects_ray(Vector3 ray_origin, Vector3 ray_direction, Vector3 *intersection);
 
+    // Returns true if the node's projection mesh doesn't use physics shapes, in which case its
+    // ray intersections are computed by intersects_ray_analytic.
+    bool is_analytic_collision() const {
+        return projection_mesh && projection_mesh->is_analytic_collision();
+    }
+
+    // Returns true if the given ray segment intersects the node's projection mesh.
+    // @param ray_from Global start of the ray segment
+    // @param ray_to Global end of the ray segment
+    // @param intersection Set to the global intersection point, if any
+    bool intersects_ray_analytic(const Vector3 &ray_from, const Vector3 &ray_to,
+                                 Vector3 *intersection);
+
+    /// Enable or disable the per-frame computation of the node's recommended texture size.
+    void set_texture_size_tracking(bool enable);
+
+    inline bool is_texture_size_tracking() const {
+        return texture_size_tracking;
+    }
+
+    /// Returns the size of this node when projected on the camera's viewport, in pixels.
+    /// @param camera_origin Global position of the camera
+    /// @param focal_length Focal length of the camera, in viewport pixels
+    Vector2 get_projected_size(const Vector3 &camera_origin, float focal_length);
+
+    /// Select the level of detail of the node's projection mesh for the given camera.
+    /// @param camera_origin Global position of the camera
+    /// @param camera_forward Global direction the camera is facing
+    /// @param focal_length Focal length of the camera, in viewport pixels
+    void update_level_of_detail(const Vector3 &camera_origin, const Vector3 &camera_forward,
+                                float focal_length);
+
+    /// Swap in the projection mesh surfaces built on the worker threads, if all of them are
+    /// ready.
+    /// @return true if the pending mesh builds were applied
+    bool apply_completed_mesh_builds();
+
+    /// Returns the last recommended size for the node's texture, or a zero vector if none
+    /// is available.
+    inline Vector2 get_recommended_texture_size() const {
+        return recommended_texture_size;
+    }
+
+    /// Update the recommended texture size with the given size.
+    /// Small variations are ignored to avoid thrashing the texture buffers.
+    /// @return true if the recommended texture size was updated
+    bool update_recommended_texture_size(Vector2 size);
+
+    /// Bind the node to the given texture atlas, or back to its own texture if null.
+    /// Invoked by the TextureAtlas when a region is allocated to or released from this node.
+    /// @param region Normalized region of the atlas texture sampled by the node
+    void set_texture_atlas(TextureAtlas *texture_atlas, const Rect2 &region);
+
+    inline TextureAtlas *get_texture_atlas() const {
+        return texture_atlas;
+    }
+
+    // Invoked when the gaze tracking state of the current projection mesh is updated
+    // directly (e.g: via the projection mesh JNI api).
+    void on_gaze_tracking_updated() {
+        update_gaze_tracking_registration();
+    }
+
 private:
 
     static inline String get_click_action_from_node_name(const String &node_name) {
@@ -150,11 +314,36 @@ private:
 
     void remove_projection_mesh_collision_shapes();
 
+    // Keeps the GastManager's list of gaze tracking nodes in sync with this node's state.
+    void update_gaze_tracking_registration();
+
+    void set_gaze_tracking_registered(bool registered);
+
     void update_collision_shape();
 
+    // Binds the texture sampled by the projection mesh, either the node's own external texture
+    // or its region of the texture atlas.
+    void update_projection_mesh_texture();
+
     ProjectionMeshPool projection_mesh_pool;
     ProjectionMesh *projection_mesh = nullptr;
     Ref<ExternalTexture> external_texture;
+    TextureAtlas *texture_atlas = nullptr;
+    Rect2 texture_atlas_region = Rect2();
+    bool gaze_tracking_registered = false;
+
+    GazeFollowMode gaze_follow_mode = GazeFollowMode::STRICT;
+    // Stored in radians.
+    float gaze_follow_dead_zone = Math::deg2rad(kDefaultGazeFollowDeadZoneDegrees);
+    float gaze_follow_smoothing_time = kDefaultGazeFollowSmoothingTime;
+    // Whether the node is moving back to the center of the gaze.
+    bool gaze_follow_settling = false;
+    Vector3 gaze_follow_velocity = Vector3::ZERO;
+
+    bool texture_size_tracking = false;
+    Vector2 recommended_texture_size = Vector2();
+
+    VisibilityState visibility_state = VisibilityState::HIDDEN;
 };
 
 }  // namespace gast
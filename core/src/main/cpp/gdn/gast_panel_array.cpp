@@ -0,0 +1,375 @@
+#include "gast_panel_array.h"
+#include "gast_manager.h"
+#include "gdn/gast_node.h"
+#include "gdn/projection_mesh/projection_mesh.h"
+#include "gdn/projection_mesh/projection_mesh_utils.h"
+#include <utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <core/Color.hpp>
+#include <core/Dictionary.hpp>
+#include <core/PoolArrays.hpp>
+
+namespace gast {
+
+namespace {
+// Shader shared by all the panels of an array. The region of the texture sampled by each panel
+// is stored as an offset (xy) and scale (zw) in the instance custom data.
+const char *kPanelArrayShaderCode = R"GAST_SHADER(
+shader_type spatial;
+render_mode unshaded, depth_draw_opaque, specular_disabled, shadows_disabled, ambient_light_disabled;
+uniform samplerExternalOES gast_texture;
+uniform float node_alpha = 1.0;
+varying vec2 panel_uv;
+void vertex() {
+	panel_uv = UV * INSTANCE_CUSTOM.zw + INSTANCE_CUSTOM.xy;
+}
+void fragment() {
+	vec4 texture_color = texture(gast_texture, panel_uv);
+	float target_alpha = texture_color.a * node_alpha;
+$alpha_code
+	ALBEDO = texture_color.rgb * target_alpha;
+}
+)GAST_SHADER";
+
+// Number of floats per instance in the MultiMesh bulk array: a 3x4 transform followed by the
+// custom data.
+const int kPanelBulkArrayStride = 16;
+
+inline Color get_texture_region_custom_data(const Rect2 &region) {
+    return Color(region.position.x, region.position.y, region.size.x, region.size.y);
+}
+
+// Returns the inverse of the given transform, or a zero transform if it's not invertible (e.g:
+// a panel hidden by a zero scale), which no ray intersects.
+Transform get_panel_inverse_transform(const Transform &transform) {
+    if (std::abs(transform.basis.determinant()) <= CMP_EPSILON) {
+        return Transform(Basis(Vector3(), Vector3(), Vector3()), Vector3());
+    }
+    return transform.affine_inverse();
+}
+}  // namespace
+
+GastPanelArray::GastPanelArray() {}
+
+GastPanelArray::~GastPanelArray() {}
+
+void GastPanelArray::_register_methods() {
+    register_method("_enter_tree", &GastPanelArray::_enter_tree);
+    register_method("_exit_tree", &GastPanelArray::_exit_tree);
+
+    register_method("get_external_texture", &GastPanelArray::get_external_texture);
+    register_method("get_external_texture_id", &GastPanelArray::get_external_texture_id);
+    register_method("set_texture_size", &GastPanelArray::set_texture_size);
+    register_method("set_panel_count", &GastPanelArray::set_panel_count);
+    register_method("get_panel_count", &GastPanelArray::get_panel_count);
+    register_method("set_panel_size", &GastPanelArray::set_panel_size);
+    register_method("get_panel_size", &GastPanelArray::get_panel_size);
+    register_method("set_panel_transform", &GastPanelArray::set_panel_transform);
+    register_method("get_panel_transform", &GastPanelArray::get_panel_transform);
+    register_method("set_panel_texture_region", &GastPanelArray::set_panel_texture_region);
+    register_method("get_panel_texture_region", &GastPanelArray::get_panel_texture_region);
+    register_method("set_alpha", &GastPanelArray::set_alpha);
+    register_method("get_alpha", &GastPanelArray::get_alpha);
+    register_method("set_has_transparency", &GastPanelArray::set_has_transparency);
+    register_method("has_transparency", &GastPanelArray::has_transparency);
+    register_method("set_collidable", &GastPanelArray::set_collidable);
+    register_method("is_collidable", &GastPanelArray::is_collidable);
+
+    register_property<GastPanelArray, int>("panel_count", &GastPanelArray::set_panel_count,
+                                           &GastPanelArray::get_panel_count, 0);
+    register_property<GastPanelArray, Vector2>("panel_size", &GastPanelArray::set_panel_size,
+                                               &GastPanelArray::get_panel_size,
+                                               kDefaultPanelSize);
+    register_property<GastPanelArray, float>("alpha", &GastPanelArray::set_alpha,
+                                             &GastPanelArray::get_alpha, 1.0f);
+    register_property<GastPanelArray, bool>("collidable", &GastPanelArray::set_collidable,
+                                            &GastPanelArray::is_collidable,
+                                            kDefaultPanelArrayCollidable);
+}
+
+void GastPanelArray::_init() {
+    external_texture = Ref<ExternalTexture>(ExternalTexture::_new());
+
+    shader = Ref<Shader>(Shader::_new());
+    shader->set_custom_defines(kShaderCustomDefines);
+    shader_material = Ref<ShaderMaterial>(ShaderMaterial::_new());
+    shader_material->set_shader(shader);
+    shader_material->set_shader_param(kGastTextureParamName, external_texture);
+    shader_material->set_shader_param(kGastNodeAlphaParamName, alpha);
+    update_shader_code();
+
+    panel_mesh = Ref<QuadMesh>(QuadMesh::_new());
+    panel_mesh->set_size(panel_size);
+    panel_mesh->set_material(shader_material);
+
+    // The formats must be set while the MultiMesh is empty.
+    multi_mesh = Ref<MultiMesh>(MultiMesh::_new());
+    multi_mesh->set_transform_format(MultiMesh::TRANSFORM_3D);
+    multi_mesh->set_color_format(MultiMesh::COLOR_NONE);
+    multi_mesh->set_custom_data_format(MultiMesh::CUSTOM_DATA_FLOAT);
+    multi_mesh->set_mesh(panel_mesh);
+
+    multi_mesh_instance = MultiMeshInstance::_new();
+    multi_mesh_instance->set_multimesh(multi_mesh);
+    add_child(multi_mesh_instance);
+}
+
+void GastPanelArray::_enter_tree() {
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (gast_manager) {
+        gast_manager->register_panel_array(this);
+    }
+}
+
+void GastPanelArray::_exit_tree() {
+    GastManager *gast_manager = GastManager::get_singleton_instance_if_initialized();
+    if (gast_manager) {
+        gast_manager->unregister_panel_array(this);
+    }
+}
+
+int GastPanelArray::get_external_texture_id() const {
+    return external_texture.is_null() ? kInvalidTexId
+                                      : external_texture->get_external_texture_id();
+}
+
+void GastPanelArray::set_texture_size(Vector2 size) {
+    external_texture->set_size(size);
+}
+
+void GastPanelArray::set_panel_count(int count) {
+    count = std::max(0, count);
+    if (count == get_panel_count()) {
+        return;
+    }
+
+    panel_transforms.resize(count, Transform());
+    panel_inverse_transforms.resize(count, Transform());
+    panel_texture_regions.resize(count, kFullTextureRegion);
+
+    // Resizing the MultiMesh discards its instances' data, so all of them are uploaded again.
+    multi_mesh->set_instance_count(count);
+    update_panel_instances();
+}
+
+void GastPanelArray::set_panel_size(Vector2 size) {
+    if (panel_size == size) {
+        return;
+    }
+    panel_size = size;
+    panel_mesh->set_size(size);
+}
+
+void GastPanelArray::set_panel_transform(int index, const Transform &transform) {
+    if (!is_valid_panel_index(index)) {
+        ALOGE("Invalid panel index %d.", index);
+        return;
+    }
+
+    panel_transforms[index] = transform;
+    panel_inverse_transforms[index] = get_panel_inverse_transform(transform);
+    multi_mesh->set_instance_transform(index, transform);
+}
+
+Transform GastPanelArray::get_panel_transform(int index) const {
+    return is_valid_panel_index(index) ? panel_transforms[index] : Transform();
+}
+
+void GastPanelArray::set_panel_positions(const float *positions, int count) {
+    count = std::min(count, get_panel_count());
+    for (int i = 0; i < count; i++) {
+        Transform &transform = panel_transforms[i];
+        transform.origin = Vector3(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+        panel_inverse_transforms[i] = get_panel_inverse_transform(transform);
+    }
+
+    // A single upload instead of one call per panel.
+    update_panel_instances();
+}
+
+void GastPanelArray::set_panel_texture_region(int index, const Rect2 &region) {
+    if (!is_valid_panel_index(index)) {
+        ALOGE("Invalid panel index %d.", index);
+        return;
+    }
+
+    panel_texture_regions[index] = region;
+    multi_mesh->set_instance_custom_data(index, get_texture_region_custom_data(region));
+}
+
+Rect2 GastPanelArray::get_panel_texture_region(int index) const {
+    return is_valid_panel_index(index) ? panel_texture_regions[index] : Rect2();
+}
+
+void GastPanelArray::set_alpha(float alpha) {
+    if (this->alpha == alpha) {
+        return;
+    }
+    this->alpha = alpha;
+    shader_material->set_shader_param(kGastNodeAlphaParamName, alpha);
+    update_shader_code();
+}
+
+void GastPanelArray::set_has_transparency(bool has_transparency) {
+    if (transparency == has_transparency) {
+        return;
+    }
+    transparency = has_transparency;
+    update_shader_code();
+}
+
+void GastPanelArray::update_shader_code() {
+    bool use_alpha = transparency || alpha < kAlphaThreshold;
+    if (use_alpha == use_alpha_shader_code && shader->get_code().length() > 0) {
+        return;
+    }
+    use_alpha_shader_code = use_alpha;
+
+    Dictionary dict;
+    dict["alpha_code"] = use_alpha ? kAlphaCode : "";
+    shader->set_code(String(kPanelArrayShaderCode).format(dict, "$_"));
+}
+
+void GastPanelArray::update_panel_instances() {
+    int count = get_panel_count();
+    if (count == 0) {
+        return;
+    }
+
+    PoolRealArray bulk_array;
+    bulk_array.resize(count * kPanelBulkArrayStride);
+    {
+        PoolRealArray::Write write = bulk_array.write();
+        real_t *data = write.ptr();
+        for (int i = 0; i < count; i++) {
+            const Transform &transform = panel_transforms[i];
+            const Rect2 &region = panel_texture_regions[i];
+            real_t *instance_data = data + i * kPanelBulkArrayStride;
+            for (int row = 0; row < 3; row++) {
+                instance_data[row * 4] = transform.basis.elements[row][0];
+                instance_data[row * 4 + 1] = transform.basis.elements[row][1];
+                instance_data[row * 4 + 2] = transform.basis.elements[row][2];
+                instance_data[row * 4 + 3] = transform.origin[row];
+            }
+            instance_data[12] = region.position.x;
+            instance_data[13] = region.position.y;
+            instance_data[14] = region.size.x;
+            instance_data[15] = region.size.y;
+        }
+    }
+    multi_mesh->set_as_bulk_array(bulk_array);
+}
+
+float GastPanelArray::intersect_panel_plane(int index, const Vector3 &local_from,
+                                            const Vector3 &local_direction,
+                                            Vector3 *panel_point) const {
+    const Transform &inverse_transform = panel_inverse_transforms[index];
+    Vector3 from = inverse_transform.xform(local_from);
+    Vector3 direction = inverse_transform.basis.xform(local_direction);
+    // The panels face +z and their back faces are culled, so only the rays heading towards -z
+    // hit their visible side.
+    if (direction.z >= -CMP_EPSILON) {
+        return -1;
+    }
+
+    // The panels lie in the z = 0 plane of their own space.
+    float t = -from.z / direction.z;
+    if (t < 0 || t > 1) {
+        return -1;
+    }
+    *panel_point = from + direction * t;
+    return t;
+}
+
+int GastPanelArray::intersects_ray(const Vector3 &ray_from, const Vector3 &ray_to,
+                                   float max_distance, Vector3 *intersection) {
+    float segment_length = ray_from.distance_to(ray_to);
+    if (!collidable || !is_visible_in_tree() || get_panel_count() == 0
+        || segment_length <= CMP_EPSILON) {
+        return -1;
+    }
+
+    // The ray parameter is the same in the node's and the panels' spaces, so the panels are
+    // compared by their intersection parameter.
+    Vector3 local_from = to_local(ray_from);
+    Vector3 local_direction = to_local(ray_to) - local_from;
+    Vector2 half_size = panel_size / 2;
+    float closest_t = std::min(1.0f, max_distance / segment_length);
+    int closest_index = -1;
+    for (int i = 0; i < get_panel_count(); i++) {
+        Vector3 panel_point;
+        float t = intersect_panel_plane(i, local_from, local_direction, &panel_point);
+        if (t < 0 || t > closest_t || std::abs(panel_point.x) > half_size.x
+            || std::abs(panel_point.y) > half_size.y) {
+            continue;
+        }
+
+        closest_t = t;
+        closest_index = i;
+    }
+
+    if (closest_index >= 0) {
+        *intersection = ray_from + (ray_to - ray_from) * closest_t;
+    }
+    return closest_index;
+}
+
+bool GastPanelArray::intersects_panel_plane(int index, const Vector3 &ray_from,
+                                            const Vector3 &ray_to, Vector3 *intersection) {
+    if (!is_valid_panel_index(index) || !is_visible_in_tree()) {
+        return false;
+    }
+
+    Vector3 local_from = to_local(ray_from);
+    Vector3 local_direction = to_local(ray_to) - local_from;
+    Vector3 panel_point;
+    float t = intersect_panel_plane(index, local_from, local_direction, &panel_point);
+    if (t < 0) {
+        return false;
+    }
+
+    *intersection = ray_from + (ray_to - ray_from) * t;
+    return true;
+}
+
+Vector2 GastPanelArray::get_relative_collision_point(int index, const Vector3 &global_point) {
+    if (!is_valid_panel_index(index) || panel_size.x <= 0 || panel_size.y <= 0) {
+        return kInvalidCoordinate;
+    }
+
+    Vector3 panel_point = panel_inverse_transforms[index].xform(to_local(global_point));
+    // The y coordinate matches the Android view coordinates system.
+    return Vector2(panel_point.x / panel_size.x + 0.5f, 0.5f - panel_point.y / panel_size.y);
+}
+
+bool GastPanelArray::handle_ray_cast_input(const String &ray_cast_name, int panel_index,
+                                           Vector2 relative_collision_point) {
+    GastManager *gast_manager = GastManager::get_singleton_instance();
+    float x_percent = relative_collision_point.x;
+    float y_percent = relative_collision_point.y;
+
+    GastNode::RayCastInput ray_cast_input = GastNode::get_ray_cast_input(ray_cast_name);
+    if (ray_cast_input.just_pressed) {
+        gast_manager->on_render_panel_input_press(this, panel_index, ray_cast_name, x_percent,
+                                                  y_percent);
+    } else if (ray_cast_input.just_released) {
+        gast_manager->on_render_panel_input_release(this, panel_index, ray_cast_name, x_percent,
+                                                    y_percent);
+    } else {
+        gast_manager->on_render_panel_input_hover(this, panel_index, ray_cast_name, x_percent,
+                                                  y_percent);
+    }
+
+    if (ray_cast_input.did_scroll) {
+        gast_manager->on_render_panel_input_scroll(this, panel_index, ray_cast_name, x_percent,
+                                                   y_percent,
+                                                   ray_cast_input.horizontal_scroll_delta,
+                                                   ray_cast_input.vertical_scroll_delta);
+    }
+
+    return ray_cast_input.press_in_progress;
+}
+
+}  // namespace gast
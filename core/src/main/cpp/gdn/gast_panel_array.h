@@ -0,0 +1,167 @@
+#ifndef GAST_PANEL_ARRAY_H
+#define GAST_PANEL_ARRAY_H
+
+#include <core/Godot.hpp>
+#include <core/Rect2.hpp>
+#include <core/Ref.hpp>
+#include <core/String.hpp>
+#include <core/Transform.hpp>
+#include <core/Vector2.hpp>
+#include <core/Vector3.hpp>
+#include <gen/ExternalTexture.hpp>
+#include <gen/MultiMesh.hpp>
+#include <gen/MultiMeshInstance.hpp>
+#include <gen/QuadMesh.hpp>
+#include <gen/Shader.hpp>
+#include <gen/ShaderMaterial.hpp>
+#include <gen/Spatial.hpp>
+#include <vector>
+
+namespace gast {
+
+namespace {
+using namespace godot;
+const Vector2 kDefaultPanelSize = Vector2(1.0, 1.0);
+const bool kDefaultPanelArrayCollidable = true;
+const bool kDefaultPanelArrayHasTransparency = true;
+}  // namespace
+
+/// Renders N identically shaped flat panels with a single draw call, via a MultiMesh.
+///
+/// The panels share a single external texture (e.g: an atlas of thumbnails), each sampling its
+/// own normalized region of it. Unlike Gast nodes, the panels have no physics body: the ray
+/// casts are intersected with them analytically by the GastManager, and the input events report
+/// the index of the panel they target.
+class GastPanelArray : public Spatial {
+GODOT_CLASS(GastPanelArray, Spatial)
+
+public:
+    GastPanelArray();
+
+    ~GastPanelArray();
+
+    static void _register_methods();
+
+    void _init();
+
+    void _enter_tree();
+
+    void _exit_tree();
+
+    Ref<ExternalTexture> get_external_texture() const {
+        return external_texture;
+    }
+
+    int get_external_texture_id() const;
+
+    /// Set the size of the panels' shared texture, in pixels.
+    void set_texture_size(Vector2 size);
+
+    /// Set the number of panels. The new panels are placed at the origin and sample the whole
+    /// texture.
+    void set_panel_count(int count);
+
+    inline int get_panel_count() const {
+        return static_cast<int>(panel_transforms.size());
+    }
+
+    /// Set the size of the panels, in the node's local space.
+    void set_panel_size(Vector2 size);
+
+    inline Vector2 get_panel_size() const {
+        return panel_size;
+    }
+
+    void set_panel_transform(int index, const Transform &transform);
+
+    Transform get_panel_transform(int index) const;
+
+    /// Move the panels to the given positions, keeping their orientation.
+    /// @param positions Panel positions [x1, y1, z1 ... xn, yn, zn], for the first n panels
+    void set_panel_positions(const float *positions, int count);
+
+    /// Set the normalized region of the shared texture sampled by the given panel.
+    void set_panel_texture_region(int index, const Rect2 &region);
+
+    Rect2 get_panel_texture_region(int index) const;
+
+    void set_alpha(float alpha);
+
+    inline float get_alpha() const {
+        return alpha;
+    }
+
+    void set_has_transparency(bool has_transparency);
+
+    inline bool has_transparency() const {
+        return transparency;
+    }
+
+    inline void set_collidable(bool collidable) {
+        this->collidable = collidable;
+    }
+
+    inline bool is_collidable() const {
+        return collidable;
+    }
+
+    /// Returns the index of the closest panel whose front side is intersected by the given ray
+    /// segment, or -1 if none.
+    /// @param ray_from Global start of the ray segment
+    /// @param ray_to Global end of the ray segment
+    /// @param max_distance Panels further than this distance from the start are ignored
+    /// @param intersection Set to the global intersection point, if any
+    int intersects_ray(const Vector3 &ray_from, const Vector3 &ray_to, float max_distance,
+                       Vector3 *intersection);
+
+    /// Returns true if the given ray segment intersects the plane of the given panel. Used to
+    /// keep tracking a press that is dragged past the panel's edges.
+    bool intersects_panel_plane(int index, const Vector3 &ray_from, const Vector3 &ray_to,
+                                Vector3 *intersection);
+
+    /// Returns the normalized position of the given global point on the given panel, with the
+    /// origin at the panel's top left corner.
+    Vector2 get_relative_collision_point(int index, const Vector3 &global_point);
+
+    /// Handle the ray cast input on the given panel.
+    /// @return true if a press is in progress
+    bool handle_ray_cast_input(const String &ray_cast_name, int panel_index,
+                               Vector2 relative_collision_point);
+
+private:
+    bool is_valid_panel_index(int index) const {
+        return index >= 0 && index < get_panel_count();
+    }
+
+    // Returns the ray parameter, in the [0, 1] range of the segment, at which the given local
+    // ray intersects the front side of the given panel's plane, or a negative value if none.
+    float intersect_panel_plane(int index, const Vector3 &local_from,
+                                const Vector3 &local_direction, Vector3 *panel_point) const;
+
+    void update_shader_code();
+
+    // Upload the transforms and texture regions of all the panels to the MultiMesh at once.
+    void update_panel_instances();
+
+    MultiMeshInstance *multi_mesh_instance = nullptr;
+    Ref<MultiMesh> multi_mesh;
+    Ref<QuadMesh> panel_mesh;
+    Ref<Shader> shader;
+    Ref<ShaderMaterial> shader_material;
+    Ref<ExternalTexture> external_texture;
+
+    Vector2 panel_size = kDefaultPanelSize;
+    // Transforms of the panels relative to the node, and their inverses for the hit tests.
+    std::vector<Transform> panel_transforms;
+    std::vector<Transform> panel_inverse_transforms;
+    std::vector<Rect2> panel_texture_regions;
+
+    float alpha = 1;
+    bool transparency = kDefaultPanelArrayHasTransparency;
+    bool use_alpha_shader_code = false;
+    bool collidable = kDefaultPanelArrayCollidable;
+};
+
+}  // namespace gast
+
+#endif // GAST_PANEL_ARRAY_H
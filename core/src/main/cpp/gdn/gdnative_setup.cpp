@@ -3,6 +3,8 @@
 #include "gdnative_setup.h"
 #include "gast_loader.h"
 #include "gast_node.h"
+#include "gast_panel_array.h"
+#include "projection_mesh/shader_cache.h"
 
 void GDN_EXPORT godot_gdnative_init(godot_gdnative_init_options *options) {
     godot::Godot::gdnative_init(options);
@@ -15,13 +17,18 @@ void GDN_EXPORT godot_nativescript_init(void *handle) {
 
     godot::register_class<gast::GastLoader>();
     godot::register_class<gast::GastNode>();
+    godot::register_class<gast::GastPanelArray>();
     godot::register_class<gast::ProjectionMesh>();
     godot::register_class<gast::RectangularProjectionMesh>();
     godot::register_class<gast::EquirectangularProjectionMesh>();
     godot::register_class<gast::CustomProjectionMesh>();
+    godot::register_class<gast::EacProjectionMesh>();
+    godot::register_class<gast::HemisphereProjectionMesh>();
 }
 
 void GDN_EXPORT godot_nativescript_terminate(void *handle) {
+    // Release the shared shaders while the engine is still available.
+    gast::ShaderCache::clear();
     godot::Godot::nativescript_terminate(handle);
 }
 
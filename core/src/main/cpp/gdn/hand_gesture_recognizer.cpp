@@ -0,0 +1,183 @@
+#include "hand_gesture_recognizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <core/Math.hpp>
+
+namespace gast {
+
+namespace {
+// Thumb to finger distances, relative to the size of the hand, at which the pinch strength is
+// respectively 0 and 1.
+const float kPinchOpenDistance = 0.6f;
+const float kPinchClosedDistance = 0.15f;
+// Pinch strengths past which a pinch starts and ends. The gap between the two prevents the
+// pinch from flickering while the strength hovers around a single threshold.
+const float kPinchDownStrength = 0.9f;
+const float kPinchUpStrength = 0.6f;
+// Guards against degenerate hand poses.
+const float kMinHandSize = 0.01f;
+
+// Distance the hand must move from where the scroll pinch started for the scroll to reach full
+// speed, relative to the size of the hand.
+const float kScrollRange = 0.5f;
+// Scroll deltas below this value are ignored, so the hand can rest while scrolling is engaged.
+const float kScrollDeadZone = 0.15f;
+
+const float kOriginMinCutoff = 1.0f;
+const float kOriginBeta = 4.0f;
+const float kDirectionMinCutoff = 1.0f;
+const float kDirectionBeta = 1.0f;
+const float kDerivativeCutoff = 1.0f;
+// Rate of change of the pinch strength (per second) past which the aim filter's cutoff is
+// lowered the most, and the ratio it's lowered by.
+const float kPinchTransitionRate = 4.0f;
+const float kPinchTransitionDamping = 0.8f;
+
+// Range of the interval between two hand poses, in seconds.
+const float kMinPoseDelta = 0.0001f;
+const float kMaxPoseDelta = 0.1f;
+const float kDefaultPoseDelta = 1.0f / 72.0f;
+
+float get_smoothing_factor(float cutoff, float delta) {
+    float time_constant = 1.0f / (2.0f * static_cast<float>(M_PI) * cutoff);
+    return 1.0f / (1.0f + time_constant / delta);
+}
+
+float apply_dead_zone(float value) {
+    return std::abs(value) < kScrollDeadZone ? 0.0f : value;
+}
+}  // namespace
+
+HandGestureRecognizer::HandGestureRecognizer()
+        : origin_filter_(kOriginMinCutoff, kOriginBeta),
+          direction_filter_(kDirectionMinCutoff, kDirectionBeta) {}
+
+bool HandGestureRecognizer::PinchState::update(float normalized_distance) {
+    strength = (kPinchOpenDistance - normalized_distance)
+               / (kPinchOpenDistance - kPinchClosedDistance);
+    strength = std::min(1.0f, std::max(0.0f, strength));
+
+    if (!pinching && strength >= kPinchDownStrength) {
+        pinching = true;
+        return true;
+    }
+    if (pinching && strength <= kPinchUpStrength) {
+        pinching = false;
+        return true;
+    }
+    return false;
+}
+
+Vector3 HandGestureRecognizer::OneEuroFilter::filter(const Vector3 &input, float delta,
+                                                     float cutoff_scale) {
+    if (!initialized) {
+        value = input;
+        derivative = Vector3();
+        initialized = true;
+        return value;
+    }
+
+    Vector3 input_derivative = (input - value) / delta;
+    derivative = derivative.linear_interpolate(
+            input_derivative, get_smoothing_factor(kDerivativeCutoff, delta));
+    float cutoff = (min_cutoff + beta * derivative.length()) * cutoff_scale;
+    value = value.linear_interpolate(input, get_smoothing_factor(cutoff, delta));
+    return value;
+}
+
+void HandGestureRecognizer::update(const Vector3 *joints, const Transform &aim_transform,
+                                   int64_t timestamp_ns) {
+    float delta = last_timestamp_ns_ > 0
+                  ? static_cast<float>(timestamp_ns - last_timestamp_ns_) / 1000000000.0f
+                  : kDefaultPoseDelta;
+    delta = std::min(kMaxPoseDelta, std::max(kMinPoseDelta, delta));
+    last_timestamp_ns_ = timestamp_ns;
+    tracked_ = true;
+
+    float hand_size = std::max(kMinHandSize,
+                               joints[kWrist].distance_to(joints[kIndexKnuckle]));
+    const Vector3 &thumb_tip = joints[kThumbTip];
+
+    // Index pinch.
+    float previous_pinch_strength = pinch_.strength;
+    if (pinch_.update(thumb_tip.distance_to(joints[kIndexTip]) / hand_size)) {
+        pending_press_transitions_.push_back(pinch_.pinching);
+    }
+
+    // Aim stabilization. The filters are tightened while the pinch strength changes, as the
+    // aim tends to follow the fingers.
+    float pinch_strength_rate = std::abs(pinch_.strength - previous_pinch_strength) / delta;
+    float cutoff_scale = 1.0f - kPinchTransitionDamping
+                                * std::min(1.0f, pinch_strength_rate / kPinchTransitionRate);
+    Vector3 aim_direction = -aim_transform.basis.get_axis(2).normalized();
+    Vector3 origin = origin_filter_.filter(aim_transform.origin, delta, cutoff_scale);
+    Vector3 direction = direction_filter_.filter(aim_direction, delta, cutoff_scale);
+    if (direction.length_squared() > CMP_EPSILON) {
+        stabilized_aim_ = Transform(aim_transform.basis, origin)
+                .looking_at(origin + direction, aim_transform.basis.get_axis(1));
+    } else {
+        stabilized_aim_ = Transform(aim_transform.basis, origin);
+    }
+
+    // Ring pinch scrolling.
+    Vector3 scroll_pinch_point = (thumb_tip + joints[kRingTip]) / 2.0f;
+    if (scroll_pinch_.update(thumb_tip.distance_to(joints[kRingTip]) / hand_size)
+        && scroll_pinch_.pinching) {
+        scroll_anchor_ = scroll_pinch_point;
+    }
+
+    if (scroll_pinch_.pinching && !pinch_.pinching) {
+        Vector3 offset = (scroll_pinch_point - scroll_anchor_) / (kScrollRange * hand_size);
+        float horizontal_offset = offset.dot(stabilized_aim_.basis.get_axis(0).normalized());
+        float vertical_offset = offset.dot(stabilized_aim_.basis.get_axis(1).normalized());
+        horizontal_scroll_delta_ = apply_dead_zone(
+                std::min(1.0f, std::max(-1.0f, horizontal_offset)) * scroll_pinch_.strength);
+        vertical_scroll_delta_ = apply_dead_zone(
+                std::min(1.0f, std::max(-1.0f, vertical_offset)) * scroll_pinch_.strength);
+    } else {
+        horizontal_scroll_delta_ = 0;
+        vertical_scroll_delta_ = 0;
+    }
+}
+
+void HandGestureRecognizer::reset() {
+    tracked_ = false;
+    if (pinch_.pinching) {
+        pending_press_transitions_.push_back(false);
+    }
+    pinch_ = PinchState();
+    scroll_pinch_ = PinchState();
+    horizontal_scroll_delta_ = 0;
+    vertical_scroll_delta_ = 0;
+
+    origin_filter_.initialized = false;
+    direction_filter_.initialized = false;
+    last_timestamp_ns_ = 0;
+}
+
+void HandGestureRecognizer::advance_tick() {
+    bool was_pressed = tick_input_.press_in_progress;
+    tick_input_ = GastNode::RayCastInput();
+    tick_input_.press_in_progress = was_pressed;
+
+    // Report at most one pinch transition per tick, so a pinch shorter than a tick still
+    // produces a press and a release.
+    if (!pending_press_transitions_.empty()) {
+        bool pressed = pending_press_transitions_.front();
+        pending_press_transitions_.pop_front();
+        if (pressed != was_pressed) {
+            tick_input_.press_in_progress = pressed;
+            tick_input_.just_pressed = pressed;
+            tick_input_.just_released = !pressed;
+        }
+    }
+
+    if (horizontal_scroll_delta_ != 0 || vertical_scroll_delta_ != 0) {
+        tick_input_.did_scroll = true;
+        tick_input_.horizontal_scroll_delta = horizontal_scroll_delta_;
+        tick_input_.vertical_scroll_delta = vertical_scroll_delta_;
+    }
+}
+
+}  // namespace gast
@@ -0,0 +1,125 @@
+#ifndef HAND_GESTURE_RECOGNIZER_H
+#define HAND_GESTURE_RECOGNIZER_H
+
+#include <core/Transform.hpp>
+#include <core/Vector3.hpp>
+#include <cstdint>
+#include <deque>
+
+#include "gdn/gast_node.h"
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}  // namespace
+
+/// Hand joints fed to the HandGestureRecognizer, in order.
+enum HandJoint {
+    kWrist,
+    kThumbTip,
+    // Base of the index finger, used with the wrist to measure the size of the hand.
+    kIndexKnuckle,
+    kIndexTip,
+    kRingTip,
+    kHandJointCount
+};
+
+/// Recognizes the pinch gestures of a tracked hand, and turns them into the press, release and
+/// scroll input of the ray cast bound to the hand.
+///
+/// - An index pinch presses the ray cast. The pinch is detected with hysteresis on the
+/// thumb to index distance, normalized by the size of the hand, so it doesn't flicker around
+/// the threshold.
+/// - A ring pinch engages scrolling: moving the pinched hand away from where the pinch started
+/// scrolls in that direction, at a speed scaled by the pinch strength.
+/// - The aim of the ray is stabilized with an adaptive (1€) low-pass filter, which is tightened
+/// while the pinch strength changes so pinching doesn't move the ray off its target.
+class HandGestureRecognizer {
+public:
+    HandGestureRecognizer();
+
+    /// Update the gestures state with the given hand pose.
+    /// @param joints Global positions of the hand joints, indexed by HandJoint
+    /// @param aim_transform Global transform of the hand's aim. The ray points along its -z axis
+    /// @param timestamp_ns Time of the pose, in nanoseconds
+    void update(const Vector3 *joints, const Transform &aim_transform, int64_t timestamp_ns);
+
+    /// Notify the recognizer that the hand is no longer tracked. An ongoing pinch is released.
+    void reset();
+
+    /// Returns the stabilized global transform of the hand's aim.
+    inline Transform get_stabilized_aim() const {
+        return stabilized_aim_;
+    }
+
+    inline float get_pinch_strength() const {
+        return pinch_.strength;
+    }
+
+    inline bool is_tracked() const {
+        return tracked_;
+    }
+
+    /// Compute the ray cast input for the upcoming input tick. The pinch transitions since the
+    /// previous tick are consumed.
+    void advance_tick();
+
+    /// Returns the ray cast input computed by the last advance_tick() call.
+    inline const GastNode::RayCastInput &get_tick_input() const {
+        return tick_input_;
+    }
+
+    /// Returns true if the recognizer no longer tracks a hand and has no pending input.
+    inline bool is_idle() const {
+        return !tracked_ && pending_press_transitions_.empty() && !tick_input_.press_in_progress;
+    }
+
+private:
+    struct PinchState {
+        float strength = 0;
+        bool pinching = false;
+
+        // Updates the pinch strength from the given normalized finger distance. Returns true if
+        // the pinching state changed.
+        bool update(float normalized_distance);
+    };
+
+    // Adaptive low-pass filter, see https://cristal.univ-lille.fr/~casiez/1euro/
+    struct OneEuroFilter {
+        OneEuroFilter(float min_cutoff, float beta) : min_cutoff(min_cutoff), beta(beta) {}
+
+        // Cutoff frequency at rest, in Hz.
+        float min_cutoff;
+        // Increase of the cutoff frequency with the speed of the filtered value.
+        float beta;
+        Vector3 value;
+        Vector3 derivative;
+        bool initialized = false;
+
+        // Returns the filtered value of the given input, sampled the given time (in seconds)
+        // after the previous one. The cutoff frequency is scaled by the given factor.
+        Vector3 filter(const Vector3 &input, float delta, float cutoff_scale);
+    };
+
+    PinchState pinch_;
+    PinchState scroll_pinch_;
+    // Global position of the ring pinch when scrolling was engaged.
+    Vector3 scroll_anchor_;
+    float horizontal_scroll_delta_ = 0;
+    float vertical_scroll_delta_ = 0;
+
+    bool tracked_ = false;
+    // Pinch transitions (true for a press) not yet reported by an input tick, oldest first.
+    std::deque<bool> pending_press_transitions_;
+    GastNode::RayCastInput tick_input_;
+
+    OneEuroFilter origin_filter_;
+    OneEuroFilter direction_filter_;
+    Transform stabilized_aim_;
+    int64_t last_timestamp_ns_ = 0;
+};
+
+}  // namespace gast
+
+#endif // HAND_GESTURE_RECOGNIZER_H
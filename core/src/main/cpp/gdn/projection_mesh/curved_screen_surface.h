@@ -0,0 +1,83 @@
+#ifndef CURVED_SCREEN_SURFACE_H
+#define CURVED_SCREEN_SURFACE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "surface_geometry.h"
+
+namespace gast {
+
+/// Generates a section of a cylinder of the given radius, spanning the given width and height.
+/// The surface is straight along the y axis, so it only needs two rows of vertices.
+static inline SurfaceGeometry generate_curved_screen_surface(float width, float height,
+                                                             float curved_screen_radius,
+                                                             size_t horizontal_segment_count) {
+    const float horizontal_angle = 2.0f * std::atan(width * 0.5f / curved_screen_radius);
+    const size_t vertical_resolution = 2;
+    const size_t horizontal_resolution =
+            std::max(static_cast<size_t>(1), horizontal_segment_count) + 1;
+
+    SurfaceGeometry surface;
+    surface.positions.reserve(vertical_resolution * horizontal_resolution * 3);
+    surface.uvs.reserve(vertical_resolution * horizontal_resolution * 2);
+    surface.indices.reserve((vertical_resolution - 1) * (horizontal_resolution - 1) * 6);
+
+    for (size_t row = 0; row < vertical_resolution; row++) {
+        for (size_t col = 0; col < horizontal_resolution; col++) {
+            const float x_percent = static_cast<float>(col) /
+                                    static_cast<float>(horizontal_resolution - 1U);
+            const float y_percent = static_cast<float>(row) /
+                                    static_cast<float>(vertical_resolution - 1U);
+            const float angle = x_percent * horizontal_angle - (horizontal_angle / 2.0f);
+            const float x_pos = std::sin(angle);
+            const float z_pos = -std::cos(angle) + std::cos(horizontal_angle / 4.0f);
+            surface.positions.push_back(x_pos * curved_screen_radius);
+            surface.positions.push_back((y_percent - 0.5f) * height);
+            surface.positions.push_back(z_pos * curved_screen_radius);
+            surface.uvs.push_back(x_percent);
+            surface.uvs.push_back(1 - y_percent);
+        }
+    }
+
+    for (size_t row = 0; row < vertical_resolution - 1; row++) {
+        for (size_t col = 0; col < horizontal_resolution - 1; col++) {
+            const int offset = static_cast<int>(col + row * horizontal_resolution);
+            const int row_offset = static_cast<int>(horizontal_resolution);
+
+            /*
+             Our vertex array contains the list of all vertices grouped by rows.
+             For example, for row_count = 2 (= col_count = horizontal_resolution):
+                [(A {index=0}, B {index=1}), (C {index=2}, D {index=3})]
+
+             To generate the triangles in clockwise winding order, we need the following sequence:
+
+             C ---- D
+             |\     |
+             |  \   |
+             |    \ |
+             A ---- B
+
+             vertices => [A,C,B], [B,C,D]
+             indices  => [0,2,1], [1,2,3]
+
+             ==> First triangle: offset, offset + horizontal_resolution, offset + 1
+             ==> Second triangle: offset + 1, offset + horizontal_resolution, offset + horizontal_resolution + 1
+             */
+            // Add the first triangle
+            surface.indices.insert(surface.indices.end(),
+                                   {offset, offset + row_offset, offset + 1});
+
+            // Add the second triangle
+            surface.indices.insert(surface.indices.end(),
+                                   {offset + 1, offset + row_offset, offset + row_offset + 1});
+        }
+    }
+
+    return surface;
+}
+
+}  // namespace gast
+
+#endif // CURVED_SCREEN_SURFACE_H
@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <core/Basis.hpp>
+#include <functional>
+#include <gen/Mesh.hpp>
+#include <memory>
+#include <vector>
+
 #include "custom_projection_mesh.h"
+#include "mesh_optimizer.h"
 #include "projection_mesh_utils.h"
 
 namespace gast {
@@ -11,11 +19,180 @@ const int kLeftMeshIndex = 0;
 const int kRightMeshIndex = 1;
 const int kMeshCount = 2;
 
-const char *kShaderViewIndexUniform = "shader_view_index";
+// Copy of the caller's vertex data, for the builds completing after the call returns.
+struct CustomMeshStorage {
+    std::vector<float> vertices;
+    std::vector<float> texture_coords;
+    std::vector<float> texture_coords2;
+    std::vector<int> indices;
+};
+
+// Create the surface arrays for the given vertex data, with its identical vertices merged and its
+// triangles reordered for the vertex cache.
+Array create_optimized_surface_array(const CustomMeshData &mesh_data,
+                                     const float *texture_coords2) {
+    Array arrays = create_custom_surface_array(
+            std::max(0, mesh_data.num_vertices), mesh_data.vertices, mesh_data.texture_coords,
+            texture_coords2, mesh_data.indices ? std::max(0, mesh_data.num_indices) : 0,
+            mesh_data.indices);
+    // The custom meshes usually duplicate the vertices shared by their primitives.
+    MeshOptimizer::weld_vertices(arrays);
+    if (get_primitive_type(mesh_data.draw_mode) == Mesh::PRIMITIVE_TRIANGLES) {
+        MeshOptimizer::optimize_surface_arrays(arrays);
+    }
+    return arrays;
+}
+
+// Returns the BVH of the given surface's triangles, used by the analytic collisions. Only the
+// triangle lists have one.
+std::shared_ptr<const MeshFile> create_collision_bvh(const SurfaceBuild &build) {
+    if (build.primitive != Mesh::PRIMITIVE_TRIANGLES || build.arrays.empty()) {
+        return nullptr;
+    }
+    return MeshFile::create(build.primitive, build.arrays);
+}
+
+// Returns a builder for the surface of the given vertex data. If copy_inputs is false, the
+// builder reads the caller's buffers directly, and must run before the call returns.
+std::function<SurfaceBuild()> get_custom_surface_builder(const CustomMeshData &mesh_data,
+                                                         const float *texture_coords2,
+                                                         int vertex_compression_texture_size,
+                                                         bool copy_inputs) {
+    CustomMeshData source = mesh_data;
+    source.num_vertices = std::max(0, source.num_vertices);
+    source.num_indices = source.indices ? std::max(0, source.num_indices) : 0;
+
+    std::shared_ptr<CustomMeshStorage> storage;
+    if (copy_inputs) {
+        storage = std::make_shared<CustomMeshStorage>();
+        storage->vertices.assign(source.vertices, source.vertices + source.num_vertices * 3);
+        storage->texture_coords.assign(source.texture_coords,
+                                       source.texture_coords + source.num_vertices * 2);
+        if (texture_coords2) {
+            storage->texture_coords2.assign(texture_coords2,
+                                            texture_coords2 + source.num_vertices * 2);
+            texture_coords2 = storage->texture_coords2.data();
+        }
+        if (source.indices) {
+            storage->indices.assign(source.indices, source.indices + source.num_indices);
+            source.indices = storage->indices.data();
+        }
+        source.vertices = storage->vertices.data();
+        source.texture_coords = storage->texture_coords.data();
+    }
+
+    return [source, texture_coords2, vertex_compression_texture_size, storage]() {
+        SurfaceBuild build;
+        build.primitive = get_primitive_type(source.draw_mode);
+        build.arrays = create_optimized_surface_array(source, texture_coords2);
+        build.compress_flags = get_surface_compress_flags(build.arrays,
+                                                          vertex_compression_texture_size);
+        build.collision_faces = get_collision_faces(build.primitive, build.arrays);
+        build.collision_bvh = create_collision_bvh(build);
+        return build;
+    };
+}
+
+// Returns a builder for the surface stored in the given mesh file. The surface was optimized
+// when the file was written.
+std::function<SurfaceBuild()> get_mesh_file_surface_builder(
+        const std::shared_ptr<const MeshFile> &mesh_file, int vertex_compression_texture_size) {
+    return [mesh_file, vertex_compression_texture_size]() {
+        SurfaceBuild build;
+        build.primitive = mesh_file->get_primitive();
+        build.arrays = mesh_file->get_surface_arrays();
+        build.compress_flags = get_surface_compress_flags(build.arrays,
+                                                          vertex_compression_texture_size);
+        build.collision_faces = get_collision_faces(build.primitive, build.arrays);
+        if (mesh_file->has_bvh()) {
+            build.collision_bvh = mesh_file;
+        }
+        return build;
+    };
+}
+
+// Returns the rotation from the projection's coordinates to the world's, for the given
+// 'prhd' pose. The yaw is counter-clockwise around the up axis, then the pitch is
+// counter-clockwise around the right axis, then the roll is clockwise around the forward axis.
+Basis get_spherical_video_pose(const SphericalVideoMetadata &metadata) {
+    return Basis(Vector3(0, 1, 0), Math::deg2rad(metadata.pose_yaw))
+           * Basis(Vector3(1, 0, 0), Math::deg2rad(metadata.pose_pitch))
+           * Basis(Vector3(0, 0, 1), Math::deg2rad(metadata.pose_roll));
+}
+
+// Returns a builder for the given surface arrays decoded from a spherical video, rotated by the
+// given pose.
+std::function<SurfaceBuild()> get_video_mesh_surface_builder(const Array &arrays,
+                                                             const Basis &pose,
+                                                             int vertex_compression_texture_size) {
+    return [arrays, pose, vertex_compression_texture_size]() {
+        SurfaceBuild build;
+        build.arrays = arrays;
+        if (pose != Basis()) {
+            PoolVector3Array positions = build.arrays[Mesh::ARRAY_VERTEX];
+            {
+                PoolVector3Array::Write write = positions.write();
+                for (int i = 0; i < positions.size(); i++) {
+                    write.ptr()[i] = pose.xform(write.ptr()[i]);
+                }
+            }
+            build.arrays[Mesh::ARRAY_VERTEX] = positions;
+        }
+        MeshOptimizer::optimize_surface_arrays(build.arrays);
+        build.compress_flags = get_surface_compress_flags(build.arrays,
+                                                          vertex_compression_texture_size);
+        build.collision_faces = get_collision_faces(build.primitive, build.arrays);
+        build.collision_bvh = create_collision_bvh(build);
+        return build;
+    };
+}
+
+// Returns true if the given pool arrays hold the same values.
+template<typename T>
+bool are_same_values(const T &a, const T &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    typename T::Read a_read = a.read();
+    typename T::Read b_read = b.read();
+    return std::equal(a_read.ptr(), a_read.ptr() + a.size(), b_read.ptr());
+}
+
+// If both views' surfaces share the same geometry, stores the right view's texture coordinates
+// in the UV2 channel of the left view's surface and returns true.
+bool merge_view_texture_coords(Array *left_arrays, const Array &right_arrays) {
+    PoolVector3Array left_positions = (*left_arrays)[Mesh::ARRAY_VERTEX];
+    PoolVector3Array right_positions = right_arrays[Mesh::ARRAY_VERTEX];
+    PoolIntArray left_indices = (*left_arrays)[Mesh::ARRAY_INDEX];
+    PoolIntArray right_indices = right_arrays[Mesh::ARRAY_INDEX];
+    if (!are_same_values(left_positions, right_positions)
+        || !are_same_values(left_indices, right_indices)) {
+        return false;
+    }
+
+    (*left_arrays)[Mesh::ARRAY_TEX_UV2] = right_arrays[Mesh::ARRAY_TEX_UV];
+    return true;
+}
+
+// Returns true if both views have the same geometry.
+bool is_same_geometry(const CustomMeshData &left, const CustomMeshData &right) {
+    return left.draw_mode == right.draw_mode
+           && left.num_vertices == right.num_vertices
+           && std::equal(left.vertices, left.vertices + left.num_vertices * 3, right.vertices)
+           && left.num_indices == right.num_indices
+           && (left.num_indices <= 0
+               || std::equal(left.indices, left.indices + left.num_indices, right.indices));
+}
 }  // namespace
 
 CustomProjectionMesh::CustomProjectionMesh() :
-        ProjectionMesh(ProjectionMeshType::MESH) {}
+        ProjectionMesh(ProjectionMeshType::MESH),
+        single_mesh(false),
+        per_view_uv(false),
+        pending_single_mesh(false),
+        pending_per_view_uv(false),
+        pending_stereo_mode(StereoMode::kMono),
+        pending_uv_origin_is_bottom_left(kDefaultUvOriginIsBottomLeft) {}
 
 CustomProjectionMesh::~CustomProjectionMesh() = default;
 
@@ -32,36 +209,179 @@ void CustomProjectionMesh::set_custom_mesh(int num_vertices_left, float *vertice
                                            int num_vertices_right, float *vertices_right,
                                            float *texture_coords_right, int draw_mode_int_right,
                                            int mesh_stereo_mode_int, bool uv_origin_is_bottom_left) {
-    // Common to all meshes
-    Shader *shader = Shader::_new();
-    shader->set_custom_defines(String(kShaderCustomDefines) + String(kShaderHighpFloatDefines));
-    shader->set_code(generate_shader_code());
-
-    set_uv_origin_is_bottom_left(uv_origin_is_bottom_left);
-    set_stereo_mode(static_cast<StereoMode>(mesh_stereo_mode_int));
-
-    // Left mesh specific setup
-    ArrayMesh *left_mesh = ArrayMesh::_new();
-    create_array_mesh(left_mesh, num_vertices_left, vertices_left, texture_coords_left, draw_mode_int_left);
-    set_mesh(kLeftMeshIndex, left_mesh);
-    set_collision_shape(kLeftMeshIndex, left_mesh->create_trimesh_shape());
-    set_shader(kLeftMeshIndex, shader);
-    update_shader_param(kLeftMeshIndex, kShaderViewIndexUniform, /* left view index */ 0);
-
-    // Right mesh specific setup
-    ArrayMesh *right_mesh = ArrayMesh::_new();
-    create_array_mesh(right_mesh, num_vertices_right, vertices_right, texture_coords_right, draw_mode_int_right);
-    set_mesh(kRightMeshIndex, right_mesh);
-    set_collision_shape(kRightMeshIndex, right_mesh->create_trimesh_shape());
-    set_shader(kRightMeshIndex, shader);
-    update_shader_param(kRightMeshIndex, kShaderViewIndexUniform, /* right view index */ 1);
-}
-
-String CustomProjectionMesh::generate_shader_code() {
-    String shader_code = ProjectionMesh::generate_shader_code();
+    CustomMeshData left_mesh_data;
+    left_mesh_data.num_vertices = num_vertices_left;
+    left_mesh_data.vertices = vertices_left;
+    left_mesh_data.texture_coords = texture_coords_left;
+    left_mesh_data.draw_mode = draw_mode_int_left;
+
+    CustomMeshData right_mesh_data;
+    right_mesh_data.num_vertices = num_vertices_right;
+    right_mesh_data.vertices = vertices_right;
+    right_mesh_data.texture_coords = texture_coords_right;
+    right_mesh_data.draw_mode = draw_mode_int_right;
+
+    set_custom_mesh(left_mesh_data, right_mesh_data, mesh_stereo_mode_int,
+                    uv_origin_is_bottom_left);
+}
+
+void CustomProjectionMesh::set_custom_mesh(const CustomMeshData &left_mesh_data,
+                                           const CustomMeshData &right_mesh_data,
+                                           int mesh_stereo_mode_int,
+                                           bool uv_origin_is_bottom_left) {
+    // The sampling and shader configuration is updated along with the surfaces, so the current
+    // surfaces keep rendering with their own configuration while the new ones are being built.
+    pending_uv_origin_is_bottom_left = uv_origin_is_bottom_left;
+    pending_stereo_mode = static_cast<StereoMode>(mesh_stereo_mode_int);
+
+    // The caller's buffers only need to be copied if the surfaces are built after this call.
+    bool copy_inputs = is_async_mesh_build();
+
+    // When both views share the same geometry, a single mesh renders both of them in one pass.
+    // If the texture coordinates differ, the right ones are carried in the UV2 channel and
+    // selected per view in the vertex stage.
+    if (is_same_geometry(left_mesh_data, right_mesh_data)) {
+        bool same_texture_coords = std::equal(
+                left_mesh_data.texture_coords,
+                left_mesh_data.texture_coords + left_mesh_data.num_vertices * 2,
+                right_mesh_data.texture_coords);
+        pending_single_mesh = true;
+        pending_per_view_uv = !same_texture_coords;
+
+        build_surface(kLeftMeshIndex, get_custom_surface_builder(
+                left_mesh_data, pending_per_view_uv ? right_mesh_data.texture_coords : nullptr,
+                get_vertex_compression_texture_size(), copy_inputs));
+        build_surface(kRightMeshIndex, [] { return SurfaceBuild(); });
+    } else {
+        pending_single_mesh = false;
+        pending_per_view_uv = false;
+
+        build_surface(kLeftMeshIndex, get_custom_surface_builder(
+                left_mesh_data, nullptr, get_vertex_compression_texture_size(), copy_inputs));
+        build_surface(kRightMeshIndex, get_custom_surface_builder(
+                right_mesh_data, nullptr, get_vertex_compression_texture_size(), copy_inputs));
+    }
+
+    if (!has_pending_mesh_builds()) {
+        on_surface_builds_applied();
+    }
+}
+
+bool CustomProjectionMesh::set_custom_mesh_files(const String &left_mesh_file_path,
+                                                 const String &right_mesh_file_path,
+                                                 int mesh_stereo_mode_int,
+                                                 bool uv_origin_is_bottom_left) {
+    std::shared_ptr<const MeshFile> left_mesh_file = MeshFile::open(left_mesh_file_path);
+    std::shared_ptr<const MeshFile> right_mesh_file = left_mesh_file;
+    if (!right_mesh_file_path.empty() && right_mesh_file_path != left_mesh_file_path) {
+        right_mesh_file = MeshFile::open(right_mesh_file_path);
+    }
+    if (!left_mesh_file || !right_mesh_file) {
+        ALOGE("Unable to load the custom mesh files.");
+        return false;
+    }
+
+    pending_uv_origin_is_bottom_left = uv_origin_is_bottom_left;
+    pending_stereo_mode = static_cast<StereoMode>(mesh_stereo_mode_int);
+
+    // The builders hold a reference to the mapped files, so they may run after this call.
+    int vertex_compression_texture_size = get_vertex_compression_texture_size();
+    if (left_mesh_file == right_mesh_file) {
+        pending_single_mesh = true;
+        pending_per_view_uv = left_mesh_file->has_texture_coords2();
+
+        build_surface(kLeftMeshIndex, get_mesh_file_surface_builder(
+                left_mesh_file, vertex_compression_texture_size));
+        build_surface(kRightMeshIndex, [] { return SurfaceBuild(); });
+    } else {
+        pending_single_mesh = false;
+        pending_per_view_uv = false;
+
+        build_surface(kLeftMeshIndex, get_mesh_file_surface_builder(
+                left_mesh_file, vertex_compression_texture_size));
+        build_surface(kRightMeshIndex, get_mesh_file_surface_builder(
+                right_mesh_file, vertex_compression_texture_size));
+    }
+
+    if (!has_pending_mesh_builds()) {
+        on_surface_builds_applied();
+    }
+    return true;
+}
+
+bool CustomProjectionMesh::set_spherical_video_mesh(const SphericalVideoMetadata &metadata) {
+    if (metadata.projection != SphericalProjection::kMesh || metadata.left_mesh_arrays.empty()) {
+        return false;
+    }
+
+    // The spherical video meshes' texture coordinates have a bottom left origin.
+    pending_uv_origin_is_bottom_left = true;
+    pending_stereo_mode = metadata.stereo_mode;
+
+    int vertex_compression_texture_size = get_vertex_compression_texture_size();
+    Basis pose = get_spherical_video_pose(metadata);
+    Array left_arrays = metadata.left_mesh_arrays.duplicate();
+    if (metadata.right_mesh_arrays.empty()
+        || merge_view_texture_coords(&left_arrays, metadata.right_mesh_arrays)) {
+        pending_single_mesh = true;
+        pending_per_view_uv = !metadata.right_mesh_arrays.empty();
+
+        build_surface(kLeftMeshIndex, get_video_mesh_surface_builder(
+                left_arrays, pose, vertex_compression_texture_size));
+        build_surface(kRightMeshIndex, [] { return SurfaceBuild(); });
+    } else {
+        pending_single_mesh = false;
+        pending_per_view_uv = false;
+
+        build_surface(kLeftMeshIndex, get_video_mesh_surface_builder(
+                left_arrays, pose, vertex_compression_texture_size));
+        build_surface(kRightMeshIndex, get_video_mesh_surface_builder(
+                metadata.right_mesh_arrays.duplicate(), pose, vertex_compression_texture_size));
+    }
+
+    if (!has_pending_mesh_builds()) {
+        on_surface_builds_applied();
+    }
+    return true;
+}
+
+bool CustomProjectionMesh::write_mesh_file(const String &path, const CustomMeshData &mesh_data) {
+    return MeshFile::write(path, get_primitive_type(mesh_data.draw_mode),
+                           create_optimized_surface_array(mesh_data, nullptr));
+}
+
+bool CustomProjectionMesh::intersects_ray(const Vector3 &ray_origin,
+                                          const Vector3 &ray_direction, Vector3 *intersection) {
+    if (has_collision_bvh()) {
+        return intersects_ray_with_bvh(ray_origin, ray_direction, intersection);
+    }
+    // Only the triangle lists have a BVH, the other primitives fall back to the bounding sphere.
+    return ProjectionMesh::intersects_ray(ray_origin, ray_direction, intersection);
+}
+
+void CustomProjectionMesh::on_surface_builds_applied() {
+    single_mesh = pending_single_mesh;
+    per_view_uv = pending_per_view_uv;
+    set_uv_origin_is_bottom_left(pending_uv_origin_is_bottom_left);
+    set_stereo_mode(pending_stereo_mode);
+    update_shader_code();
+}
+
+ShaderVariant CustomProjectionMesh::get_shader_variant(int mesh_index) {
+    ShaderVariant variant = ProjectionMesh::get_shader_variant(mesh_index);
     // TODO: Allow culling to be configurable.
-    shader_code += kCullFrontRenderMode;
-    return shader_code;
+    variant.cull_front = true;
+    variant.per_view_uv = single_mesh && per_view_uv;
+    return variant;
+}
+
+int CustomProjectionMesh::get_mesh_view_index(int mesh_index) const {
+    if (single_mesh) {
+        return -1;
+    }
+
+    // Each mesh only renders for its own view.
+    return mesh_index == kLeftMeshIndex ? /* left view index */ 0 : /* right view index */ 1;
 }
 
 void CustomProjectionMesh::_register_methods() {
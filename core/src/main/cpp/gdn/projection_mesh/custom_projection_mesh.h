@@ -1,8 +1,12 @@
 #ifndef CUSTOM_PROJECTION_MESH_H
 #define CUSTOM_PROJECTION_MESH_H
 
+#include <memory>
+
+#include "mesh_file.h"
 #include "projection_mesh.h"
 #include "projection_mesh_utils.h"
+#include "spherical_video_parser.h"
 
 namespace gast {
 
@@ -10,6 +14,20 @@ namespace {
 using namespace godot;
 }
 
+/// Vertex data of one view of a custom projection mesh.
+struct CustomMeshData {
+    int num_vertices = 0;
+    // Vertex positions [x1, y1, z1 ... xn, yn, zn]
+    const float *vertices = nullptr;
+    // Texture sampling coordinates [u1, v1 ... un, vn]
+    const float *texture_coords = nullptr;
+    // Optional indices of the vertices forming the primitives.
+    int num_indices = 0;
+    const int *indices = nullptr;
+    // GL mesh primitive
+    int draw_mode = GL_TRIANGLES;
+};
+
 class CustomProjectionMesh : public ProjectionMesh {
 GODOT_CLASS(CustomProjectionMesh, ProjectionMesh)
 
@@ -27,10 +45,54 @@ public:
                          float *texture_coords_right, int draw_mode_int_right,
                          int mesh_stereo_mode_int, bool uv_origin_is_bottom_left);
 
+    /// Set the custom mesh from the given vertex data, which is only read during the call.
+    void set_custom_mesh(const CustomMeshData &left_mesh_data,
+                         const CustomMeshData &right_mesh_data, int mesh_stereo_mode_int,
+                         bool uv_origin_is_bottom_left);
+
+    /// Set the custom mesh from the given mesh files (see MeshFile), which are memory-mapped.
+    /// A mesh file carrying a second set of texture coordinates renders both views, sampling the
+    /// right view with the second set.
+    /// @param right_mesh_file_path Mesh file of the right view, or empty to use the left view's
+    /// @return true if the mesh files are valid
+    bool set_custom_mesh_files(const String &left_mesh_file_path,
+                               const String &right_mesh_file_path, int mesh_stereo_mode_int,
+                               bool uv_origin_is_bottom_left);
+
+    /// Set the custom mesh from the 'mshp' projection meshes of a spherical video, and configure
+    /// the stereo mode and texture coordinates origin from its metadata. The meshes are rotated
+    /// by the metadata's 'prhd' pose.
+    /// @return true if the metadata holds a mesh projection
+    bool set_spherical_video_mesh(const SphericalVideoMetadata &metadata);
+
+    /// Write the given vertex data to a mesh file, processed (merged vertices and optimized
+    /// triangle order) as if it was set with set_custom_mesh.
+    /// @return true if the mesh file was written
+    static bool write_mesh_file(const String &path, const CustomMeshData &mesh_data);
+
     int get_mesh_count() const override;
 
+    bool intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                        Vector3 *intersection) override;
+
 protected:
-    String generate_shader_code() override;
+    ShaderVariant get_shader_variant(int mesh_index) override;
+
+    int get_mesh_view_index(int mesh_index) const override;
+
+    void on_surface_builds_applied() override;
+
+private:
+    // Whether a single mesh renders both views.
+    bool single_mesh;
+    // Whether the single mesh carries the right view's texture coordinates in its UV2 channel.
+    bool per_view_uv;
+
+    // Configuration of the surfaces being built, applied once they're swapped in.
+    bool pending_single_mesh;
+    bool pending_per_view_uv;
+    StereoMode pending_stereo_mode;
+    bool pending_uv_origin_is_bottom_left;
 };
 
 }  // namespace gast
@@ -0,0 +1,88 @@
+#include <gen/ArrayMesh.hpp>
+#include <gen/Shape.hpp>
+
+#include "eac_projection_mesh.h"
+#include "mesh_optimizer.h"
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+namespace {
+const float kEacCubeSize = 1.0f;
+// Number of segments along each edge of a face. The EAC mapping is non-linear within a face,
+// so the faces are subdivided for the interpolated texture coordinates to follow it.
+const size_t kEacFaceSegmentCount = 16;
+// The faces are flat, so the collision shape doesn't need any subdivision.
+const size_t kEacCollisionFaceSegmentCount = 1;
+const int kMeshIndex = 0;
+const int kMeshCount = 1;
+}  // namespace
+
+EacProjectionMesh::EacProjectionMesh() : ProjectionMesh(ProjectionMeshType::EAC) {}
+
+EacProjectionMesh::~EacProjectionMesh() = default;
+
+void EacProjectionMesh::update_projection_mesh() {
+    int vertex_compression_texture_size = get_vertex_compression_texture_size();
+    build_surface(kMeshIndex, [vertex_compression_texture_size] {
+        SurfaceBuild build;
+        build.arrays = create_eac_cube_surface_array(kEacCubeSize, kEacFaceSegmentCount);
+        MeshOptimizer::optimize_surface_arrays(build.arrays);
+        build.compress_flags = get_surface_compress_flags(build.arrays,
+                                                          vertex_compression_texture_size);
+        build.collision_faces = get_collision_faces(
+                build.primitive,
+                create_eac_cube_surface_array(kEacCubeSize, kEacCollisionFaceSegmentCount));
+        return build;
+    });
+    update_sampling_transforms();
+}
+
+int EacProjectionMesh::get_mesh_count() const {
+    return kMeshCount;
+}
+
+Vector2 EacProjectionMesh::get_relative_collision_point(Vector3 local_collision_point) {
+    Vector2 uv = get_eac_uv(local_collision_point);
+    if (uv == kInvalidCoordinate) {
+        return kInvalidCoordinate;
+    }
+
+    // Map the point to the left view's region of the texture.
+    StereoModeDisplayParameters stereo_mode_display_params =
+            get_stereo_mode_display_parameters(get_stereo_mode());
+    return uv * stereo_mode_display_params.texture_scale
+           + stereo_mode_display_params.left_texture_offset;
+}
+
+bool EacProjectionMesh::intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                                       Vector3 *intersection) {
+    float half_size = kEacCubeSize / 2.0f;
+    float t = intersect_ray_with_box(
+            ray_origin, ray_direction,
+            AABB(Vector3(-half_size, -half_size, -half_size),
+                 Vector3(kEacCubeSize, kEacCubeSize, kEacCubeSize)));
+    if (t < 0) {
+        return false;
+    }
+    *intersection = ray_origin + ray_direction * t;
+    return true;
+}
+
+ShaderVariant EacProjectionMesh::get_shader_variant(int mesh_index) {
+    ShaderVariant variant = ProjectionMesh::get_shader_variant(mesh_index);
+    // The cube is seen from the inside.
+    variant.cull_front = true;
+    return variant;
+}
+
+void EacProjectionMesh::_init() {
+    ProjectionMesh::_init();
+    update_projection_mesh();
+}
+
+void EacProjectionMesh::_register_methods() {
+    ProjectionMesh::_register_methods();
+}
+
+}  // namespace gast
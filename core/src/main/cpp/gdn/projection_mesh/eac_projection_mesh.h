@@ -0,0 +1,40 @@
+#ifndef EAC_PROJECTION_MESH_H
+#define EAC_PROJECTION_MESH_H
+
+#include "projection_mesh.h"
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}
+
+/// Cube textured with the equi-angular cubemap (EAC) layout used by 360 video streams.
+class EacProjectionMesh : public ProjectionMesh {
+GODOT_CLASS(EacProjectionMesh, ProjectionMesh)
+
+public:
+    EacProjectionMesh();
+    ~EacProjectionMesh();
+
+    void _init();
+
+    static void _register_methods();
+
+    int get_mesh_count() const override;
+
+    Vector2 get_relative_collision_point(Vector3 local_collision_point) override;
+
+    bool intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                        Vector3 *intersection) override;
+
+protected:
+    ShaderVariant get_shader_variant(int mesh_index) override;
+
+    void update_projection_mesh() override;
+};
+
+}  // namespace gast
+
+#endif //EAC_PROJECTION_MESH_H
@@ -1,52 +1,212 @@
+#include <cmath>
+
 #include <gen/ArrayMesh.hpp>
-#include <gen/Shader.hpp>
+#include <gen/MeshInstance.hpp>
 #include <gen/Shape.hpp>
 
 #include "equirectangular_projection_mesh.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
 #include "projection_mesh_utils.h"
 
 namespace gast {
 
 namespace {
 const float kEquirectSphereSize = 1.0f;
-const size_t kEquirectSphereMeshBandCount = 80;
-const size_t kEquirectSphereMeshSectorCount = 80;
+// Band and sector counts of the sphere mesh for each level of detail, from the coarsest to the
+// finest. The finest level matches the fixed resolution used before the levels of detail.
+const size_t kEquirectSphereLodSegmentCounts[] = {20, 40, 80};
+const int kEquirectSphereLodCount =
+        sizeof(kEquirectSphereLodSegmentCounts) / sizeof(kEquirectSphereLodSegmentCounts[0]);
+// Level used until the camera is known, and for the collision shape.
+const int kEquirectSphereDefaultLodLevel = 2;
+// Vertex density ratio between the center and the edges of the foveated tessellation is
+// (1 + foveation) / (1 - foveation).
+const float kFoveatedLatitudeFoveation = 0.5f;
+const float kFoveatedLongitudeFoveation = 0.5f;
+// The foveated meshes are centered on one of these evenly spaced longitudes, the one closest to
+// the view direction.
+const int kFoveationCenterCount = 8;
+// Extra angle the view direction must move past the midpoint between two centers before the
+// mesh is re-centered, to avoid switching back and forth.
+const float kFoveationCenterHysteresis = Math::deg2rad(10.0f);
 const int kMeshIndex = 0;
 const int kMeshCount = 1;
+
+// Returns the angular error, in radians, of a sphere segment spanning the given arc angle, seen
+// from a camera inside the sphere at the given distance from its center.
+//
+// The sagitta between the arc and its chord is radial, so it's only visible from off-center
+// camera positions, where it's seen at an angle of at most asin(camera_offset / radius). The
+// texture coordinates are interpolated linearly along the chord rather than angularly, which
+// shifts the sampled directions by up to ~0.016 * arc_angle^3 even from the center.
+float get_inside_sphere_angular_error(float radius, float arc_angle, float camera_offset) {
+    float sagitta_error = get_chord_error(radius, arc_angle) * (camera_offset / radius)
+                          / std::max(radius - camera_offset, static_cast<float>(CMP_EPSILON));
+    float interpolation_error = 0.016f * arc_angle * arc_angle * arc_angle;
+    return sagitta_error + interpolation_error;
+}
 }  // namespace
 
 EquirectangularProjectionMesh::EquirectangularProjectionMesh() :
-        ProjectionMesh(ProjectionMeshType::EQUIRECTANGULAR) {}
+        ProjectionMesh(ProjectionMeshType::EQUIRECTANGULAR),
+        lod_meshes(kEquirectSphereLodCount * kFoveationCenterCount),
+        lod_level(-1),
+        foveated_tessellation(kDefaultFoveatedTessellation),
+        foveation_center_index(0) {}
 
 EquirectangularProjectionMesh::~EquirectangularProjectionMesh() = default;
 
+Ref<ArrayMesh> EquirectangularProjectionMesh::get_lod_mesh(int level) {
+    int center_index = foveated_tessellation ? foveation_center_index : 0;
+    Ref<ArrayMesh> &lod_mesh = lod_meshes[level * kFoveationCenterCount + center_index];
+    if (lod_mesh.is_null()) {
+        SphericalTessellation tessellation;
+        if (foveated_tessellation) {
+            tessellation.latitude_foveation = kFoveatedLatitudeFoveation;
+            tessellation.longitude_foveation = kFoveatedLongitudeFoveation;
+            tessellation.center_longitude = get_foveation_center_longitude(center_index);
+        }
+
+        size_t segment_count = kEquirectSphereLodSegmentCounts[level];
+        uint64_t key = MeshCache::get_key(
+                "equirectangular_sphere",
+                {kEquirectSphereSize, static_cast<double>(segment_count),
+                 tessellation.latitude_foveation, tessellation.longitude_foveation,
+                 tessellation.center_longitude});
+        Array arrays = MeshCache::get_surface_arrays(key, [segment_count, &tessellation] {
+            Array arrays = create_spherical_surface_array(kEquirectSphereSize, segment_count,
+                                                          segment_count, 360.f, tessellation);
+            MeshOptimizer::optimize_surface_arrays(arrays);
+            return arrays;
+        });
+
+        ArrayMesh *mesh = ArrayMesh::_new();
+        mesh->add_surface_from_arrays(
+                Mesh::PRIMITIVE_TRIANGLES, arrays, Array(),
+                get_surface_compress_flags(arrays, get_vertex_compression_texture_size()));
+        lod_mesh = Ref<ArrayMesh>(mesh);
+    }
+    return lod_mesh;
+}
+
+Vector2 EquirectangularProjectionMesh::get_relative_collision_point(
+        Vector3 local_collision_point) {
+    if (local_collision_point == Vector3()) {
+        return kInvalidCoordinate;
+    }
+
+    // Inverse of the spherical surface mapping: the longitude is measured from the -z axis
+    // towards the +x axis.
+    Vector3 direction = local_collision_point.normalized();
+    float longitude = std::atan2(direction.x, -direction.z);
+    float latitude = std::asin(CLAMP(direction.y, -1.0f, 1.0f));
+    Vector2 uv = Vector2(0.5f + longitude / (2.0f * M_PI), 0.5f - latitude / M_PI);
+
+    // Map the point to the left view's region of the texture.
+    StereoModeDisplayParameters stereo_mode_display_params =
+            get_stereo_mode_display_parameters(get_stereo_mode());
+    return uv * stereo_mode_display_params.texture_scale
+           + stereo_mode_display_params.left_texture_offset;
+}
+
+float EquirectangularProjectionMesh::get_foveation_center_longitude(int center_index) {
+    float longitude = center_index * 2.0f * M_PI / kFoveationCenterCount;
+    return longitude > M_PI ? longitude - 2.0f * M_PI : longitude;
+}
+
+void EquirectangularProjectionMesh::set_foveated_tessellation(bool enable) {
+    if (this->foveated_tessellation == enable) {
+        return;
+    }
+    this->foveated_tessellation = enable;
+    update_projection_mesh();
+}
+
 void EquirectangularProjectionMesh::update_projection_mesh() {
-    ArrayMesh *mesh = ArrayMesh::_new();
-    mesh->add_surface_from_arrays(
-            Mesh::PRIMITIVE_TRIANGLES,
-            create_spherical_surface_array(
-                    kEquirectSphereSize,
-                    kEquirectSphereMeshBandCount,
-                    kEquirectSphereMeshSectorCount));
-    set_mesh(kMeshIndex, mesh);
-    set_collision_shape(kMeshIndex, mesh->create_trimesh_shape());
-
-    Shader *shader = Shader::_new();
-    shader->set_custom_defines(String(kShaderCustomDefines) + String(kShaderHighpFloatDefines));
-    shader->set_code(generate_shader_code());
-    set_shader(kMeshIndex, shader);
+    // The level of detail meshes are stale.
+    for (Ref<ArrayMesh> &lod_mesh : lod_meshes) {
+        lod_mesh.unref();
+    }
+
+    if (lod_level < 0) {
+        lod_level = kEquirectSphereDefaultLodLevel;
+    }
+    set_mesh(kMeshIndex, get_lod_mesh(lod_level));
+    // The collision shape doesn't change with the level of detail to avoid rebuilding it.
+    set_collision_shape(kMeshIndex,
+                        get_lod_mesh(kEquirectSphereDefaultLodLevel)->create_trimesh_shape());
     update_sampling_transforms();
 }
 
+void EquirectangularProjectionMesh::update_level_of_detail(const Vector3 &camera_origin,
+                                                           const Vector3 &camera_forward,
+                                                           float focal_length) {
+    MeshInstance *mesh_instance = get_mesh_instance(kMeshIndex);
+    if (!mesh_instance || !mesh_instance->is_inside_tree() || focal_length <= 0) {
+        return;
+    }
+
+    Transform mesh_transform = mesh_instance->get_global_transform();
+    Vector3 scale = mesh_transform.basis.get_scale();
+    float radius = 0.5f * kEquirectSphereSize * std::max(scale.x, std::max(scale.y, scale.z));
+
+    float camera_offset = camera_origin.distance_to(mesh_transform.origin);
+
+    std::vector<float> level_errors(kEquirectSphereLodCount, INFINITY);
+    for (int i = 0; i < kEquirectSphereLodCount; i++) {
+        // The sectors span the largest arc.
+        float sector_angle = 2.0f * M_PI / kEquirectSphereLodSegmentCounts[i];
+        if (camera_offset < radius) {
+            // Inside the sphere (the common case).
+            level_errors[i] = get_inside_sphere_angular_error(radius, sector_angle, camera_offset)
+                              * focal_length;
+        } else if (camera_offset - radius > CMP_EPSILON) {
+            level_errors[i] = get_chord_error(radius, sector_angle) * focal_length
+                              / (camera_offset - radius);
+        }
+    }
+
+    int level = select_level_of_detail(level_errors, lod_level);
+    bool recentered = foveated_tessellation
+            && update_foveation_center(mesh_transform.basis.inverse().xform(camera_forward));
+    if (level == lod_level && !recentered) {
+        return;
+    }
+    lod_level = level;
+    set_mesh(kMeshIndex, get_lod_mesh(lod_level));
+}
+
+bool EquirectangularProjectionMesh::update_foveation_center(const Vector3 &local_view_direction) {
+    if (local_view_direction.x == 0 && local_view_direction.z == 0) {
+        return false;
+    }
+
+    // Longitude of the view direction, measured like the spherical surface's.
+    float view_longitude = std::atan2(local_view_direction.x, -local_view_direction.z);
+    float center_spacing = 2.0f * M_PI / kFoveationCenterCount;
+    float offset = std::remainder(
+            view_longitude - get_foveation_center_longitude(foveation_center_index),
+            2.0f * M_PI);
+    if (std::abs(offset) <= center_spacing / 2.0f + kFoveationCenterHysteresis) {
+        return false;
+    }
+
+    int center_index = static_cast<int>(std::round(view_longitude / center_spacing));
+    foveation_center_index = (center_index % kFoveationCenterCount + kFoveationCenterCount)
+                             % kFoveationCenterCount;
+    return true;
+}
+
 int EquirectangularProjectionMesh::get_mesh_count() const {
     return kMeshCount;
 }
 
-String EquirectangularProjectionMesh::generate_shader_code() {
-    String shader_code = ProjectionMesh::generate_shader_code();
+ShaderVariant EquirectangularProjectionMesh::get_shader_variant(int mesh_index) {
+    ShaderVariant variant = ProjectionMesh::get_shader_variant(mesh_index);
     // TODO: Allow culling to be configurable.
-    shader_code += kCullFrontRenderMode;
-    return shader_code;
+    variant.cull_front = true;
+    return variant;
 }
 
 void EquirectangularProjectionMesh::_init() {
@@ -54,8 +214,28 @@ void EquirectangularProjectionMesh::_init() {
     update_projection_mesh();
 }
 
+void EquirectangularProjectionMesh::update_properties(ProjectionMesh *projection_mesh) {
+    ProjectionMesh::update_properties(projection_mesh);
+
+    if (projection_mesh->is_equirectangular_projection_mesh()) {
+        auto *equirectangular_projection_mesh = Object::cast_to<EquirectangularProjectionMesh>(
+                projection_mesh);
+        set_foveated_tessellation(equirectangular_projection_mesh->is_foveated_tessellation());
+    }
+}
+
 void EquirectangularProjectionMesh::_register_methods() {
     ProjectionMesh::_register_methods();
+    register_method("set_foveated_tessellation",
+                    &EquirectangularProjectionMesh::set_foveated_tessellation);
+    register_method("is_foveated_tessellation",
+                    &EquirectangularProjectionMesh::is_foveated_tessellation);
+
+    register_property<EquirectangularProjectionMesh, bool>(
+            "foveated_tessellation",
+            &EquirectangularProjectionMesh::set_foveated_tessellation,
+            &EquirectangularProjectionMesh::is_foveated_tessellation,
+            kDefaultFoveatedTessellation);
 }
 
 }  // namespace gast
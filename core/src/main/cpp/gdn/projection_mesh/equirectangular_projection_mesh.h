@@ -1,6 +1,10 @@
 #ifndef EQUIRECTANGULAR_PROJECTION_MESH_H
 #define EQUIRECTANGULAR_PROJECTION_MESH_H
 
+#include <core/Ref.hpp>
+#include <gen/ArrayMesh.hpp>
+#include <vector>
+
 #include "projection_mesh.h"
 #include "projection_mesh_utils.h"
 
@@ -8,6 +12,7 @@ namespace gast {
 
 namespace {
 using namespace godot;
+const bool kDefaultFoveatedTessellation = false;
 }
 
 class EquirectangularProjectionMesh : public ProjectionMesh {
@@ -23,10 +28,41 @@ public:
 
     int get_mesh_count() const override;
 
+    Vector2 get_relative_collision_point(Vector3 local_collision_point) override;
+
+    void update_level_of_detail(const Vector3 &camera_origin, const Vector3 &camera_forward,
+                                float focal_length) override;
+
+    /// Enable or disable the foveated tessellation, which concentrates the sphere's vertices
+    /// near the equator and the view direction, for the same triangle count.
+    void set_foveated_tessellation(bool enable);
+
+    inline bool is_foveated_tessellation() {
+        return foveated_tessellation;
+    }
+
+    void update_properties(ProjectionMesh *projection_mesh) override;
+
 protected:
-    String generate_shader_code() override;
+    ShaderVariant get_shader_variant(int mesh_index) override;
 
     void update_projection_mesh() override;
+
+private:
+    // Returns the sphere mesh for the given level of detail, generating it on first use.
+    Ref<ArrayMesh> get_lod_mesh(int level);
+
+    static float get_foveation_center_longitude(int center_index);
+
+    // Re-center the foveated tessellation on the given view direction if it moved far enough.
+    // Returns true if the center changed.
+    bool update_foveation_center(const Vector3 &local_view_direction);
+
+    // Sphere meshes, indexed by level of detail and foveation center.
+    std::vector<Ref<ArrayMesh>> lod_meshes;
+    int lod_level;
+    bool foveated_tessellation;
+    int foveation_center_index;
 };
 
 }  // namespace gast
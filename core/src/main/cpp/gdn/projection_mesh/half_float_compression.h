@@ -0,0 +1,109 @@
+#ifndef HALF_FLOAT_COMPRESSION_H
+#define HALF_FLOAT_COMPRESSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace gast {
+
+namespace {
+// Texture resolution used to evaluate whether the mesh vertices can be stored in compressed
+// (half-float) formats. 0 disables the compression.
+const int kDefaultVertexCompressionTextureSize = 4096;
+// Maximum error introduced by the compressed vertex formats, in texels.
+const float kMaxVertexCompressionErrorTexels = 0.5f;
+// Largest value representable as a half float.
+const float kMaxHalfFloatValue = 65504.0f;
+}  // namespace
+
+/// Vertex arrays of a surface that can be stored as half floats.
+struct HalfFloatCompression {
+    bool positions = false;
+    bool uvs = false;
+    bool uvs2 = false;
+};
+
+/// Returns the given value rounded to the nearest half float.
+static inline float round_to_half_float(float value) {
+    if (value == 0 || !std::isfinite(value)) {
+        return value;
+    }
+    if (std::abs(value) > kMaxHalfFloatValue) {
+        return std::copysign(INFINITY, value);
+    }
+
+    // Half floats have 11 significant bits, and their exponent is at least -14 (the subnormals
+    // share the precision of the smallest normal values).
+    int exponent;
+    std::frexp(value, &exponent);
+    float ulp = std::ldexp(1.0f, std::max(exponent, -13) - 11);
+    return std::nearbyint(value / ulp) * ulp;
+}
+
+/// Returns the max error, in texels, introduced by storing the given texture coordinates as half
+/// floats.
+/// @param uvs Texture coordinates [u1, v1 ... un, vn]
+static inline float get_half_float_uv_error(const float *uvs, size_t uv_count, int texture_size) {
+    float max_error = 0;
+    for (size_t i = 0; i < uv_count * 2; i++) {
+        max_error = std::max(max_error, std::abs(round_to_half_float(uvs[i]) - uvs[i]));
+    }
+    return max_error * texture_size;
+}
+
+/// Returns the max error, in texels, introduced by storing the given positions as half floats,
+/// assuming the texture spans the largest dimension of the mesh.
+/// @param positions Positions [x1, y1, z1 ... xn, yn, zn]
+static inline float get_half_float_position_error(const float *positions, size_t position_count,
+                                                  int texture_size) {
+    if (position_count == 0) {
+        return 0;
+    }
+
+    float bounds_min[3] = {positions[0], positions[1], positions[2]};
+    float bounds_max[3] = {positions[0], positions[1], positions[2]};
+    float max_error = 0;
+    for (size_t i = 0; i < position_count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            float value = positions[i * 3 + axis];
+            bounds_min[axis] = std::min(bounds_min[axis], value);
+            bounds_max[axis] = std::max(bounds_max[axis], value);
+            max_error = std::max(max_error, std::abs(round_to_half_float(value) - value));
+        }
+    }
+
+    float extent = std::max(bounds_max[0] - bounds_min[0],
+                            std::max(bounds_max[1] - bounds_min[1],
+                                     bounds_max[2] - bounds_min[2]));
+    return extent > 0 ? max_error / extent * texture_size : INFINITY;
+}
+
+/// Returns the vertex arrays that can be stored as half floats while keeping the error under a
+/// fraction of a texel at the given texture resolution.
+/// @param uvs2 Secondary texture coordinates, or nullptr if none
+/// @param texture_size Texture resolution the error is evaluated against, or 0 to disable the
+/// compression
+static inline HalfFloatCompression get_half_float_compression(const float *positions,
+                                                              const float *uvs,
+                                                              const float *uvs2,
+                                                              size_t vertex_count,
+                                                              int texture_size) {
+    HalfFloatCompression compression;
+    if (texture_size <= 0) {
+        return compression;
+    }
+
+    compression.positions = positions
+            && get_half_float_position_error(positions, vertex_count, texture_size)
+               <= kMaxVertexCompressionErrorTexels;
+    compression.uvs = uvs && get_half_float_uv_error(uvs, vertex_count, texture_size)
+                             <= kMaxVertexCompressionErrorTexels;
+    compression.uvs2 = uvs2 && get_half_float_uv_error(uvs2, vertex_count, texture_size)
+                               <= kMaxVertexCompressionErrorTexels;
+    return compression;
+}
+
+}  // namespace gast
+
+#endif // HALF_FLOAT_COMPRESSION_H
@@ -0,0 +1,164 @@
+#include <gen/ArrayMesh.hpp>
+#include <gen/Shape.hpp>
+
+#include "hemisphere_projection_mesh.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+namespace {
+const float kHemisphereSize = 1.0f;
+const float kHemisphereLongitudeRange = 180.0f;
+const int kMinHemisphereBandCount = 2;
+const int kMinHemisphereSectorCount = 3;
+const int kMeshIndex = 0;
+const int kMeshCount = 1;
+}  // namespace
+
+HemisphereProjectionMesh::HemisphereProjectionMesh() :
+        ProjectionMesh(ProjectionMeshType::HEMISPHERE_180),
+        band_count(kDefaultHemisphereBandCount),
+        sector_count(kDefaultHemisphereSectorCount) {}
+
+HemisphereProjectionMesh::~HemisphereProjectionMesh() = default;
+
+void HemisphereProjectionMesh::update_projection_mesh() {
+    // The builder gets its own copy of the parameters, as it may run on a worker thread.
+    size_t bands = band_count;
+    size_t sectors = sector_count;
+    int vertex_compression_texture_size = get_vertex_compression_texture_size();
+    build_surface(kMeshIndex, [bands, sectors, vertex_compression_texture_size] {
+        SurfaceBuild build;
+        uint64_t key = MeshCache::get_key(
+                "hemisphere", {kHemisphereSize, static_cast<double>(bands),
+                               static_cast<double>(sectors), kHemisphereLongitudeRange});
+        build.arrays = MeshCache::get_surface_arrays(key, [bands, sectors] {
+            Array arrays = create_spherical_surface_array(kHemisphereSize, bands, sectors,
+                                                          kHemisphereLongitudeRange);
+            MeshOptimizer::optimize_surface_arrays(arrays);
+            return arrays;
+        });
+        build.compress_flags = get_surface_compress_flags(build.arrays,
+                                                          vertex_compression_texture_size);
+        build.collision_faces = get_collision_faces(build.primitive, build.arrays);
+        return build;
+    });
+    update_sampling_transforms();
+}
+
+int HemisphereProjectionMesh::get_mesh_count() const {
+    return kMeshCount;
+}
+
+void HemisphereProjectionMesh::set_band_count(int band_count) {
+    set_resolution(band_count, sector_count);
+}
+
+void HemisphereProjectionMesh::set_sector_count(int sector_count) {
+    set_resolution(band_count, sector_count);
+}
+
+void HemisphereProjectionMesh::set_resolution(int band_count, int sector_count) {
+    band_count = std::max(kMinHemisphereBandCount, band_count);
+    sector_count = std::max(kMinHemisphereSectorCount, sector_count);
+    if (this->band_count == band_count && this->sector_count == sector_count) {
+        return;
+    }
+    this->band_count = band_count;
+    this->sector_count = sector_count;
+    update_projection_mesh();
+}
+
+Vector2 HemisphereProjectionMesh::get_relative_collision_point(Vector3 local_collision_point) {
+    if (local_collision_point == Vector3()) {
+        return kInvalidCoordinate;
+    }
+
+    // Inverse of the spherical surface mapping: the longitude is measured from the -z axis
+    // towards the +x axis.
+    Vector3 direction = local_collision_point.normalized();
+    float longitude = std::atan2(direction.x, -direction.z);
+    float latitude = std::asin(CLAMP(direction.y, -1.0f, 1.0f));
+    float half_longitude_range = Math::deg2rad(kHemisphereLongitudeRange) / 2.0f;
+    if (std::abs(longitude) > half_longitude_range) {
+        return kInvalidCoordinate;
+    }
+
+    Vector2 uv = Vector2(0.5f + longitude / (2.0f * half_longitude_range),
+                         0.5f - latitude / M_PI);
+
+    // Map the point to the left view's region of the texture.
+    StereoModeDisplayParameters stereo_mode_display_params =
+            get_stereo_mode_display_parameters(get_stereo_mode());
+    return uv * stereo_mode_display_params.texture_scale
+           + stereo_mode_display_params.left_texture_offset;
+}
+
+bool HemisphereProjectionMesh::intersects_ray(const Vector3 &ray_origin,
+                                              const Vector3 &ray_direction,
+                                              Vector3 *intersection) {
+    float roots[2];
+    if (!get_ray_sphere_intersections(ray_origin, ray_direction, kHemisphereSize / 2.0f,
+                                      &roots[0], &roots[1])) {
+        return false;
+    }
+
+    // The nearest intersection may fall on the missing back half of the sphere, in which case
+    // the ray can still hit the hemisphere at the far intersection.
+    for (float t : roots) {
+        if (t < 0) {
+            continue;
+        }
+        Vector3 sphere_intersection = ray_origin + ray_direction * t;
+        if (get_relative_collision_point(sphere_intersection) != kInvalidCoordinate) {
+            *intersection = sphere_intersection;
+            return true;
+        }
+    }
+    return false;
+}
+
+ShaderVariant HemisphereProjectionMesh::get_shader_variant(int mesh_index) {
+    ShaderVariant variant = ProjectionMesh::get_shader_variant(mesh_index);
+    // The hemisphere is seen from the inside.
+    variant.cull_front = true;
+    return variant;
+}
+
+void HemisphereProjectionMesh::update_properties(ProjectionMesh *projection_mesh) {
+    ProjectionMesh::update_properties(projection_mesh);
+
+    if (projection_mesh->is_hemisphere_projection_mesh()) {
+        auto *hemisphere_projection_mesh = Object::cast_to<HemisphereProjectionMesh>(
+                projection_mesh);
+        set_resolution(hemisphere_projection_mesh->get_band_count(),
+                       hemisphere_projection_mesh->get_sector_count());
+    }
+}
+
+void HemisphereProjectionMesh::_init() {
+    ProjectionMesh::_init();
+    // VR180 content is side by side stereo.
+    set_stereo_mode(StereoMode::kLeftRight);
+    update_projection_mesh();
+}
+
+void HemisphereProjectionMesh::_register_methods() {
+    ProjectionMesh::_register_methods();
+    register_method("set_band_count", &HemisphereProjectionMesh::set_band_count);
+    register_method("get_band_count", &HemisphereProjectionMesh::get_band_count);
+    register_method("set_sector_count", &HemisphereProjectionMesh::set_sector_count);
+    register_method("get_sector_count", &HemisphereProjectionMesh::get_sector_count);
+    register_method("set_resolution", &HemisphereProjectionMesh::set_resolution);
+
+    register_property<HemisphereProjectionMesh, int>("band_count",
+            &HemisphereProjectionMesh::set_band_count, &HemisphereProjectionMesh::get_band_count,
+            kDefaultHemisphereBandCount);
+    register_property<HemisphereProjectionMesh, int>("sector_count",
+            &HemisphereProjectionMesh::set_sector_count,
+            &HemisphereProjectionMesh::get_sector_count, kDefaultHemisphereSectorCount);
+}
+
+}  // namespace gast
@@ -0,0 +1,63 @@
+#ifndef HEMISPHERE_PROJECTION_MESH_H
+#define HEMISPHERE_PROJECTION_MESH_H
+
+#include "projection_mesh.h"
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+namespace {
+using namespace godot;
+const int kDefaultHemisphereBandCount = 80;
+const int kDefaultHemisphereSectorCount = 40;
+}
+
+/// Front half of a sphere, for 180 degrees (VR180) content. Defaults to side by side stereo.
+class HemisphereProjectionMesh : public ProjectionMesh {
+GODOT_CLASS(HemisphereProjectionMesh, ProjectionMesh)
+
+public:
+    HemisphereProjectionMesh();
+    ~HemisphereProjectionMesh();
+
+    void _init();
+
+    static void _register_methods();
+
+    int get_mesh_count() const override;
+
+    void set_band_count(int band_count);
+
+    inline int get_band_count() {
+        return band_count;
+    }
+
+    void set_sector_count(int sector_count);
+
+    inline int get_sector_count() {
+        return sector_count;
+    }
+
+    /// Update both the band and sector counts, rebuilding the mesh once.
+    void set_resolution(int band_count, int sector_count);
+
+    Vector2 get_relative_collision_point(Vector3 local_collision_point) override;
+
+    bool intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                        Vector3 *intersection) override;
+
+    void update_properties(ProjectionMesh *projection_mesh) override;
+
+protected:
+    ShaderVariant get_shader_variant(int mesh_index) override;
+
+    void update_projection_mesh() override;
+
+private:
+    int band_count;
+    int sector_count;
+};
+
+}  // namespace gast
+
+#endif //HEMISPHERE_PROJECTION_MESH_H
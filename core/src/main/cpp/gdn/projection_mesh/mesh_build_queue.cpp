@@ -0,0 +1,89 @@
+#include "mesh_build_queue.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace gast {
+
+namespace {
+// Mesh builds are infrequent, a couple of workers are enough to keep them off the Godot
+// thread without competing with the render and decoder threads.
+const unsigned int kMaxWorkerCount = 2;
+}  // namespace
+
+std::mutex MeshBuildQueue::mutex_;
+std::condition_variable MeshBuildQueue::condition_;
+std::deque<std::function<void()>> MeshBuildQueue::tasks_;
+std::vector<std::thread> MeshBuildQueue::workers_;
+bool MeshBuildQueue::stopping_ = false;
+
+std::future<SurfaceBuild> MeshBuildQueue::submit(std::function<SurfaceBuild()> build) {
+    // std::function requires a copyable target.
+    auto task = std::make_shared<std::packaged_task<SurfaceBuild()>>(std::move(build));
+    std::future<SurfaceBuild> result = task->get_future();
+    enqueue([task] { (*task)(); });
+    return result;
+}
+
+void MeshBuildQueue::post(std::function<void()> task) {
+    enqueue(std::move(task));
+}
+
+void MeshBuildQueue::enqueue(std::function<void()> task) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_) {
+            // Shutting down, run on the calling thread instead.
+            lock.unlock();
+            task();
+            return;
+        }
+
+        if (workers_.empty()) {
+            unsigned int hardware_thread_count = std::thread::hardware_concurrency();
+            unsigned int worker_count = std::max(
+                    1U, std::min(kMaxWorkerCount,
+                                 hardware_thread_count > 1 ? hardware_thread_count - 1 : 1));
+            for (unsigned int i = 0; i < worker_count; i++) {
+                workers_.emplace_back(&MeshBuildQueue::run_worker);
+            }
+        }
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+void MeshBuildQueue::shutdown() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        workers.swap(workers_);
+    }
+    condition_.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+}
+
+void MeshBuildQueue::run_worker() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [] { return stopping_ || !tasks_.empty(); });
+            // The queued tasks are completed before stopping so the builds' futures are fulfilled.
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+}  // namespace gast
@@ -0,0 +1,44 @@
+#ifndef MESH_BUILD_QUEUE_H
+#define MESH_BUILD_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+/// Pool of worker threads building the projection mesh surfaces off the Godot thread.
+/// The workers only generate the surface arrays and collision faces; the Godot resources are
+/// created from the results on the Godot thread.
+class MeshBuildQueue {
+public:
+    /// Queue the given surface build. The workers are started on first use.
+    static std::future<SurfaceBuild> submit(std::function<SurfaceBuild()> build);
+
+    /// Queue the given background task (e.g: a cache write), whose completion isn't reported.
+    static void post(std::function<void()> task);
+
+    /// Complete the queued builds and stop the workers.
+    static void shutdown();
+
+private:
+    static void enqueue(std::function<void()> task);
+
+    static void run_worker();
+
+    static std::mutex mutex_;
+    static std::condition_variable condition_;
+    static std::deque<std::function<void()>> tasks_;
+    static std::vector<std::thread> workers_;
+    static bool stopping_;
+};
+
+}  // namespace gast
+
+#endif // MESH_BUILD_QUEUE_H
@@ -0,0 +1,154 @@
+#include "mesh_cache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <gen/Mesh.hpp>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "mesh_build_queue.h"
+#include "mesh_file.h"
+#include "utils.h"
+
+namespace gast {
+
+namespace {
+// Bump when the procedural mesh generators or the mesh optimizer output change, to invalidate
+// the cached surfaces.
+const uint32_t kMeshGeneratorVersion = 1;
+const char *kMeshCacheFileExtension = ".gastmesh";
+// Size above which the least recently used cached surfaces are evicted.
+const off_t kMaxMeshCacheSize = 32 * 1024 * 1024;
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+bool has_mesh_cache_file_extension(const char *file_name) {
+    size_t length = strlen(file_name);
+    size_t extension_length = strlen(kMeshCacheFileExtension);
+    return length > extension_length
+           && strcmp(file_name + length - extension_length, kMeshCacheFileExtension) == 0;
+}
+
+// Delete the least recently used cached surfaces until the cache fits within its size cap.
+// The files' modification times are bumped on every cache hit.
+void evict_least_recently_used(const std::string &directory) {
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) {
+        return;
+    }
+
+    struct CacheFile {
+        std::string path;
+        off_t size;
+        timespec last_used;
+    };
+    std::vector<CacheFile> files;
+    off_t total_size = 0;
+    while (dirent *entry = readdir(dir)) {
+        if (!has_mesh_cache_file_extension(entry->d_name)) {
+            continue;
+        }
+        std::string path = directory + "/" + entry->d_name;
+        struct stat file_stat{};
+        if (stat(path.c_str(), &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+            continue;
+        }
+        files.push_back({path, file_stat.st_size, file_stat.st_mtim});
+        total_size += file_stat.st_size;
+    }
+    closedir(dir);
+
+    if (total_size <= kMaxMeshCacheSize) {
+        return;
+    }
+    std::sort(files.begin(), files.end(), [](const CacheFile &a, const CacheFile &b) {
+        return a.last_used.tv_sec != b.last_used.tv_sec
+               ? a.last_used.tv_sec < b.last_used.tv_sec
+               : a.last_used.tv_nsec < b.last_used.tv_nsec;
+    });
+    for (const CacheFile &file : files) {
+        if (total_size <= kMaxMeshCacheSize) {
+            break;
+        }
+        if (unlink(file.path.c_str()) == 0) {
+            total_size -= file.size;
+        }
+    }
+}
+}  // namespace
+
+std::mutex MeshCache::mutex_;
+std::string MeshCache::directory_;
+
+void MeshCache::set_directory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = directory;
+}
+
+bool MeshCache::is_enabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !directory_.empty();
+}
+
+uint64_t MeshCache::get_key(const char *generator, std::initializer_list<double> parameters) {
+    uint64_t hash = kFnvOffsetBasis;
+    uint32_t versions[] = {kMeshFileVersion, kMeshGeneratorVersion};
+    hash = hash_bytes(hash, versions, sizeof(versions));
+    hash = hash_bytes(hash, generator, strlen(generator) + 1);
+    for (double parameter : parameters) {
+        hash = hash_bytes(hash, &parameter, sizeof(parameter));
+    }
+    // 0 is reserved for the meshes without a key.
+    return hash == 0 ? 1 : hash;
+}
+
+Array MeshCache::get_surface_arrays(uint64_t key, const std::function<Array()> &generator) {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        directory = directory_;
+    }
+    if (directory.empty()) {
+        return generator();
+    }
+
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "%016" PRIx64 "%s", key, kMeshCacheFileExtension);
+    String path = String(directory.c_str()).plus_file(file_name);
+
+    std::shared_ptr<const MeshFile> mesh_file = MeshFile::open(path);
+    if (mesh_file && mesh_file->get_key() == key
+        && mesh_file->get_primitive() == Mesh::PRIMITIVE_TRIANGLES) {
+        // Mark the surface as recently used for the eviction.
+        utimensat(AT_FDCWD, path.utf8().get_data(), nullptr, 0);
+        return mesh_file->get_surface_arrays();
+    }
+
+    // Missing or stale, (re)generate it. The file is written on a mesh build worker, from a
+    // copy of the arrays as the caller may update them.
+    Array arrays = generator();
+    Array cached_arrays = arrays.duplicate();
+    MeshBuildQueue::post([path, cached_arrays, key, directory] {
+        if (MeshFile::write(path, Mesh::PRIMITIVE_TRIANGLES, cached_arrays, key)) {
+            evict_least_recently_used(directory);
+        }
+    });
+    return arrays;
+}
+
+}  // namespace gast
@@ -0,0 +1,49 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <core/Array.hpp>
+#include <core/String.hpp>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}  // namespace
+
+/// Opt-in on-disk cache of the procedural projection mesh surfaces (see MeshFile), keyed by
+/// their generator parameters, so the geometry isn't recomputed on every start.
+/// The cache is capped in size, evicting its least recently used surfaces.
+/// Thread safe, the surfaces may be generated on the mesh build workers.
+class MeshCache {
+public:
+    /// Set the directory the generated surfaces are cached in. The directory must exist.
+    /// An empty path disables the cache, which is the default.
+    /// May be invoked before the GDNative library is initialized.
+    static void set_directory(const std::string &directory);
+
+    static bool is_enabled();
+
+    /// Returns the cache key of the surface generated by the given generator with the given
+    /// parameters.
+    static uint64_t get_key(const char *generator, std::initializer_list<double> parameters);
+
+    /// Returns the cached surface arrays for the given key, or the arrays returned by the given
+    /// generator, which are then written to the cache on a mesh build worker.
+    /// The cached surfaces are triangle lists.
+    static Array get_surface_arrays(uint64_t key, const std::function<Array()> &generator);
+
+private:
+    static std::mutex mutex_;
+    // Not a godot::String, which can't be constructed before the GDNative library is
+    // initialized.
+    static std::string directory_;
+};
+
+}  // namespace gast
+
+#endif // MESH_CACHE_H
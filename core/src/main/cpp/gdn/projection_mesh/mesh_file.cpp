@@ -0,0 +1,506 @@
+#include "mesh_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <gen/Mesh.hpp>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "projection_mesh_utils.h"
+#include "utils.h"
+
+namespace gast {
+
+namespace {
+// Maximum number of triangles in a BVH leaf.
+const uint32_t kBvhLeafTriangleCount = 4;
+
+static_assert(sizeof(MeshFileHeader) == 40, "Unexpected mesh file header layout");
+static_assert(sizeof(MeshFileBvhNode) == 32, "Unexpected mesh file BVH node layout");
+
+// Suffix of the temporary files, unique per write.
+std::atomic<uint32_t> temporary_file_counter(0);
+
+struct BvhBuildTriangle {
+    AABB bounds;
+    Vector3 centroid;
+    uint32_t index;
+};
+
+struct BvhBuildRange {
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+};
+
+uint32_t get_vertex_stride(uint32_t flags) {
+    return (flags & kMeshFileHasTexUv2) ? 7 : 5;
+}
+
+void set_bounds(const AABB &bounds, float bounds_min[3], float bounds_max[3]) {
+    Vector3 end = bounds.position + bounds.size;
+    for (int axis = 0; axis < 3; axis++) {
+        bounds_min[axis] = bounds.position[axis];
+        bounds_max[axis] = end[axis];
+    }
+}
+
+// Builds the BVH of the given triangles, splitting each node at the median of its triangles'
+// centroids along its longest axis.
+void build_bvh(std::vector<BvhBuildTriangle> &triangles, std::vector<MeshFileBvhNode> *nodes,
+               std::vector<uint32_t> *bvh_triangles) {
+    if (triangles.empty()) {
+        return;
+    }
+
+    nodes->push_back(MeshFileBvhNode());
+    std::vector<BvhBuildRange> ranges = {{0, 0, static_cast<uint32_t>(triangles.size())}};
+    while (!ranges.empty()) {
+        BvhBuildRange range = ranges.back();
+        ranges.pop_back();
+
+        AABB bounds = triangles[range.begin].bounds;
+        AABB centroid_bounds = AABB(triangles[range.begin].centroid, Vector3());
+        for (uint32_t i = range.begin + 1; i < range.end; i++) {
+            bounds = bounds.merge(triangles[i].bounds);
+            centroid_bounds.expand_to(triangles[i].centroid);
+        }
+
+        MeshFileBvhNode &node = (*nodes)[range.node];
+        set_bounds(bounds, node.bounds_min, node.bounds_max);
+        uint32_t count = range.end - range.begin;
+        if (count <= kBvhLeafTriangleCount) {
+            node.offset = static_cast<uint32_t>(bvh_triangles->size());
+            node.triangle_count = count;
+            for (uint32_t i = range.begin; i < range.end; i++) {
+                bvh_triangles->push_back(triangles[i].index);
+            }
+            continue;
+        }
+
+        int axis = centroid_bounds.get_longest_axis_index();
+        uint32_t middle = range.begin + count / 2;
+        std::nth_element(triangles.begin() + range.begin, triangles.begin() + middle,
+                         triangles.begin() + range.end,
+                         [axis](const BvhBuildTriangle &a, const BvhBuildTriangle &b) {
+                             return a.centroid[axis] < b.centroid[axis];
+                         });
+
+        // The children are stored after their parent, which keeps the traversal of untrusted
+        // files finite.
+        uint32_t first_child = static_cast<uint32_t>(nodes->size());
+        node.offset = first_child;
+        node.triangle_count = 0;
+        nodes->push_back(MeshFileBvhNode());
+        nodes->push_back(MeshFileBvhNode());
+        ranges.push_back({first_child, range.begin, middle});
+        ranges.push_back({first_child + 1, middle, range.end});
+    }
+}
+
+void append_bytes(const void *bytes, size_t size, std::vector<uint8_t> *data) {
+    const auto *begin = static_cast<const uint8_t *>(bytes);
+    data->insert(data->end(), begin, begin + size);
+}
+
+// Returns true if the given ray enters the given box before max_t.
+bool intersects_box(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                    const float bounds_min[3], const float bounds_max[3], float max_t) {
+    float near_t = 0;
+    float far_t = max_t;
+    for (int axis = 0; axis < 3; axis++) {
+        if (ray_direction[axis] == 0) {
+            if (ray_origin[axis] < bounds_min[axis] || ray_origin[axis] > bounds_max[axis]) {
+                return false;
+            }
+            continue;
+        }
+
+        float t0 = (bounds_min[axis] - ray_origin[axis]) / ray_direction[axis];
+        float t1 = (bounds_max[axis] - ray_origin[axis]) / ray_direction[axis];
+        near_t = std::max(near_t, std::min(t0, t1));
+        far_t = std::min(far_t, std::max(t0, t1));
+        if (near_t > far_t) {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+MeshFile::MeshFile(void *address, size_t size) :
+        address_(address),
+        size_(size),
+        mapped_(true),
+        header_(static_cast<const MeshFileHeader *>(address)),
+        vertices_(nullptr),
+        indices_(nullptr),
+        bvh_nodes_(nullptr),
+        bvh_triangles_(nullptr) {}
+
+MeshFile::MeshFile(std::vector<uint8_t> &&data) :
+        data_(std::move(data)),
+        address_(data_.data()),
+        size_(data_.size()),
+        mapped_(false),
+        header_(static_cast<const MeshFileHeader *>(address_)),
+        vertices_(nullptr),
+        indices_(nullptr),
+        bvh_nodes_(nullptr),
+        bvh_triangles_(nullptr) {}
+
+MeshFile::~MeshFile() {
+    if (mapped_) {
+        munmap(address_, size_);
+    }
+}
+
+std::shared_ptr<const MeshFile> MeshFile::open(const String &path) {
+    std::string file_path = path.utf8().get_data();
+    int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0
+        || file_stat.st_size < static_cast<off_t>(sizeof(MeshFileHeader))) {
+        ALOGE("Invalid mesh file %s", file_path.c_str());
+        close(fd);
+        return nullptr;
+    }
+
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    if (address == MAP_FAILED) {
+        ALOGE("Unable to map mesh file %s", file_path.c_str());
+        return nullptr;
+    }
+    // The whole file is read when the surface is created.
+    madvise(address, size, MADV_WILLNEED);
+
+    std::shared_ptr<MeshFile> mesh_file(new MeshFile(address, size));
+    if (!mesh_file->is_valid()) {
+        ALOGE("Invalid mesh file %s", file_path.c_str());
+        return nullptr;
+    }
+    return mesh_file;
+}
+
+bool MeshFile::is_valid() {
+    const MeshFileHeader &header = *header_;
+    if (header.magic != kMeshFileMagic || header.version != kMeshFileVersion
+        || header.primitive > Mesh::PRIMITIVE_TRIANGLE_FAN) {
+        return false;
+    }
+
+    // 64 bits offsets, so the counts can't overflow them.
+    uint64_t vertices_offset = sizeof(MeshFileHeader);
+    uint64_t indices_offset = vertices_offset
+                              + uint64_t(header.vertex_count) * get_vertex_stride(header.flags)
+                                * sizeof(float);
+    uint64_t bvh_nodes_offset = indices_offset + uint64_t(header.index_count) * sizeof(int32_t);
+    uint64_t bvh_triangles_offset =
+            bvh_nodes_offset + uint64_t(header.bvh_node_count) * sizeof(MeshFileBvhNode);
+    uint64_t end_offset =
+            bvh_triangles_offset + uint64_t(header.bvh_triangle_count) * sizeof(uint32_t);
+    if (end_offset > size_) {
+        return false;
+    }
+
+    const auto *data = static_cast<const uint8_t *>(address_);
+    vertices_ = reinterpret_cast<const float *>(data + vertices_offset);
+    indices_ = reinterpret_cast<const int32_t *>(data + indices_offset);
+    bvh_nodes_ = reinterpret_cast<const MeshFileBvhNode *>(data + bvh_nodes_offset);
+    bvh_triangles_ = reinterpret_cast<const uint32_t *>(data + bvh_triangles_offset);
+
+    for (uint32_t i = 0; i < header.index_count; i++) {
+        if (indices_[i] < 0 || static_cast<uint32_t>(indices_[i]) >= header.vertex_count) {
+            return false;
+        }
+    }
+
+    if (header.bvh_node_count == 0) {
+        return true;
+    }
+    if (header.primitive != Mesh::PRIMITIVE_TRIANGLES) {
+        return false;
+    }
+
+    uint32_t element_count = header.index_count > 0 ? header.index_count : header.vertex_count;
+    uint32_t triangle_count = element_count / 3;
+    for (uint32_t i = 0; i < header.bvh_triangle_count; i++) {
+        if (bvh_triangles_[i] >= triangle_count) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header.bvh_node_count; i++) {
+        const MeshFileBvhNode &node = bvh_nodes_[i];
+        bool valid_node = node.triangle_count == 0
+                ? node.offset > i && uint64_t(node.offset) + 1 < header.bvh_node_count
+                : uint64_t(node.offset) + node.triangle_count <= header.bvh_triangle_count;
+        if (!valid_node) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MeshFile::serialize(int64_t primitive, const Array &arrays, uint64_t key,
+                         std::vector<uint8_t> *data) {
+    if (arrays.size() != Mesh::ARRAY_MAX
+        || arrays[Mesh::ARRAY_VERTEX].get_type() != Variant::POOL_VECTOR3_ARRAY
+        || arrays[Mesh::ARRAY_TEX_UV].get_type() != Variant::POOL_VECTOR2_ARRAY) {
+        ALOGE("Unsupported surface arrays for mesh file.");
+        return false;
+    }
+
+    PoolVector3Array positions = arrays[Mesh::ARRAY_VERTEX];
+    PoolVector2Array uvs = arrays[Mesh::ARRAY_TEX_UV];
+    PoolVector2Array uvs2;
+    if (arrays[Mesh::ARRAY_TEX_UV2].get_type() == Variant::POOL_VECTOR2_ARRAY) {
+        uvs2 = arrays[Mesh::ARRAY_TEX_UV2];
+    }
+    PoolIntArray indices;
+    if (arrays[Mesh::ARRAY_INDEX].get_type() == Variant::POOL_INT_ARRAY) {
+        indices = arrays[Mesh::ARRAY_INDEX];
+    }
+
+    int vertex_count = positions.size();
+    bool has_uv2 = uvs2.size() > 0;
+    if (uvs.size() != vertex_count || (has_uv2 && uvs2.size() != vertex_count)) {
+        ALOGE("Mismatched surface arrays sizes for mesh file.");
+        return false;
+    }
+
+    MeshFileHeader header = {};
+    header.magic = kMeshFileMagic;
+    header.version = kMeshFileVersion;
+    header.key = key;
+    header.primitive = static_cast<uint32_t>(primitive);
+    header.flags = has_uv2 ? kMeshFileHasTexUv2 : 0;
+    header.vertex_count = static_cast<uint32_t>(vertex_count);
+    header.index_count = static_cast<uint32_t>(indices.size());
+
+    std::vector<float> vertices;
+    std::vector<BvhBuildTriangle> triangles;
+    {
+        PoolVector3Array::Read positions_read = positions.read();
+        PoolVector2Array::Read uvs_read = uvs.read();
+        PoolVector2Array::Read uvs2_read = uvs2.read();
+        PoolIntArray::Read indices_read = indices.read();
+        const Vector3 *position_data = positions_read.ptr();
+
+        vertices.reserve(vertex_count * get_vertex_stride(header.flags));
+        for (int i = 0; i < vertex_count; i++) {
+            const Vector3 &position = position_data[i];
+            const Vector2 &uv = uvs_read.ptr()[i];
+            vertices.insert(vertices.end(), {position.x, position.y, position.z, uv.x, uv.y});
+            if (has_uv2) {
+                const Vector2 &uv2 = uvs2_read.ptr()[i];
+                vertices.insert(vertices.end(), {uv2.x, uv2.y});
+            }
+        }
+
+        if (primitive == Mesh::PRIMITIVE_TRIANGLES) {
+            int element_count = header.index_count > 0 ? indices.size() : vertex_count;
+            triangles.reserve(element_count / 3);
+            for (int t = 0; t < element_count / 3; t++) {
+                int corners[3];
+                bool valid = true;
+                for (int k = 0; k < 3 && valid; k++) {
+                    corners[k] = header.index_count > 0 ? indices_read.ptr()[t * 3 + k]
+                                                        : t * 3 + k;
+                    valid = corners[k] >= 0 && corners[k] < vertex_count;
+                }
+                if (!valid) {
+                    continue;
+                }
+
+                BvhBuildTriangle triangle;
+                triangle.bounds = AABB(position_data[corners[0]], Vector3());
+                triangle.bounds.expand_to(position_data[corners[1]]);
+                triangle.bounds.expand_to(position_data[corners[2]]);
+                triangle.centroid = triangle.bounds.position + triangle.bounds.size * 0.5f;
+                triangle.index = static_cast<uint32_t>(t);
+                triangles.push_back(triangle);
+            }
+        }
+    }
+
+    std::vector<MeshFileBvhNode> bvh_nodes;
+    std::vector<uint32_t> bvh_triangles;
+    build_bvh(triangles, &bvh_nodes, &bvh_triangles);
+    header.bvh_node_count = static_cast<uint32_t>(bvh_nodes.size());
+    header.bvh_triangle_count = static_cast<uint32_t>(bvh_triangles.size());
+
+    PoolIntArray::Read indices_read = indices.read();
+    data->clear();
+    data->reserve(sizeof(header) + vertices.size() * sizeof(float)
+                  + header.index_count * sizeof(int32_t)
+                  + bvh_nodes.size() * sizeof(MeshFileBvhNode)
+                  + bvh_triangles.size() * sizeof(uint32_t));
+    append_bytes(&header, sizeof(header), data);
+    append_bytes(vertices.data(), vertices.size() * sizeof(float), data);
+    append_bytes(indices_read.ptr(), header.index_count * sizeof(int32_t), data);
+    append_bytes(bvh_nodes.data(), bvh_nodes.size() * sizeof(MeshFileBvhNode), data);
+    append_bytes(bvh_triangles.data(), bvh_triangles.size() * sizeof(uint32_t), data);
+    return true;
+}
+
+bool MeshFile::write(const String &path, int64_t primitive, const Array &arrays, uint64_t key) {
+    std::vector<uint8_t> data;
+    if (!serialize(primitive, arrays, key, &data)) {
+        return false;
+    }
+
+    std::string file_path = path.utf8().get_data();
+    std::string temporary_path = file_path + ".tmp" + std::to_string(getpid()) + "_"
+                                 + std::to_string(temporary_file_counter++);
+    FILE *file = fopen(temporary_path.c_str(), "wb");
+    if (!file) {
+        ALOGE("Unable to create mesh file %s", file_path.c_str());
+        return false;
+    }
+
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporary_path.c_str(), file_path.c_str()) != 0) {
+        ALOGE("Unable to write mesh file %s", file_path.c_str());
+        unlink(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const MeshFile> MeshFile::create(int64_t primitive, const Array &arrays) {
+    std::vector<uint8_t> data;
+    if (!serialize(primitive, arrays, 0, &data)) {
+        return nullptr;
+    }
+
+    std::shared_ptr<MeshFile> mesh_file(new MeshFile(std::move(data)));
+    if (!mesh_file->is_valid()) {
+        ALOGE("Invalid mesh surface arrays.");
+        return nullptr;
+    }
+    return mesh_file;
+}
+
+Array MeshFile::get_surface_arrays() const {
+    // The vertex data is copied in bulk into the pool arrays.
+    static_assert(sizeof(Vector3) == 3 * sizeof(float), "Unexpected Vector3 layout");
+    static_assert(sizeof(Vector2) == 2 * sizeof(float), "Unexpected Vector2 layout");
+
+    Array arrays;
+    arrays.resize(Mesh::ARRAY_MAX);
+    uint32_t vertex_count = header_->vertex_count;
+    uint32_t stride = get_vertex_stride(header_->flags);
+
+    PoolVector3Array positions;
+    PoolVector2Array uvs;
+    PoolVector2Array uvs2;
+    positions.resize(vertex_count);
+    uvs.resize(vertex_count);
+    if (has_texture_coords2()) {
+        uvs2.resize(vertex_count);
+    }
+    {
+        PoolVector3Array::Write positions_write = positions.write();
+        PoolVector2Array::Write uvs_write = uvs.write();
+        PoolVector2Array::Write uvs2_write = uvs2.write();
+        const float *vertex = vertices_;
+        for (uint32_t i = 0; i < vertex_count; i++, vertex += stride) {
+            memcpy(positions_write.ptr() + i, vertex, sizeof(Vector3));
+            memcpy(uvs_write.ptr() + i, vertex + 3, sizeof(Vector2));
+            if (stride > 5) {
+                memcpy(uvs2_write.ptr() + i, vertex + 5, sizeof(Vector2));
+            }
+        }
+    }
+    arrays[Mesh::ARRAY_VERTEX] = positions;
+    arrays[Mesh::ARRAY_TEX_UV] = uvs;
+    if (has_texture_coords2()) {
+        arrays[Mesh::ARRAY_TEX_UV2] = uvs2;
+    }
+
+    if (header_->index_count > 0) {
+        PoolIntArray indices;
+        indices.resize(header_->index_count);
+        {
+            PoolIntArray::Write write = indices.write();
+            memcpy(write.ptr(), indices_, header_->index_count * sizeof(int32_t));
+        }
+        arrays[Mesh::ARRAY_INDEX] = indices;
+    }
+    return arrays;
+}
+
+bool MeshFile::has_texture_coords2() const {
+    return (header_->flags & kMeshFileHasTexUv2) != 0;
+}
+
+void MeshFile::get_triangle(uint32_t triangle, uint32_t vertex_indices[3]) const {
+    for (uint32_t k = 0; k < 3; k++) {
+        uint32_t element = triangle * 3 + k;
+        vertex_indices[k] = header_->index_count > 0 ? indices_[element] : element;
+    }
+}
+
+Vector3 MeshFile::get_position(uint32_t vertex_index) const {
+    const float *vertex = vertices_ + vertex_index * get_vertex_stride(header_->flags);
+    return Vector3(vertex[0], vertex[1], vertex[2]);
+}
+
+bool MeshFile::intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                              Vector3 *intersection) const {
+    if (header_->bvh_node_count == 0) {
+        return false;
+    }
+
+    float closest_t = INFINITY;
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty()) {
+        const MeshFileBvhNode &node = bvh_nodes_[stack.back()];
+        stack.pop_back();
+        if (!intersects_box(ray_origin, ray_direction, node.bounds_min, node.bounds_max,
+                            closest_t)) {
+            continue;
+        }
+
+        if (node.triangle_count == 0) {
+            stack.push_back(node.offset);
+            stack.push_back(node.offset + 1);
+            continue;
+        }
+
+        for (uint32_t i = 0; i < node.triangle_count; i++) {
+            uint32_t vertex_indices[3];
+            get_triangle(bvh_triangles_[node.offset + i], vertex_indices);
+            float t = intersect_ray_with_triangle(ray_origin, ray_direction,
+                                                  get_position(vertex_indices[0]),
+                                                  get_position(vertex_indices[1]),
+                                                  get_position(vertex_indices[2]));
+            if (t >= 0 && t < closest_t) {
+                closest_t = t;
+            }
+        }
+    }
+
+    if (closest_t == INFINITY) {
+        return false;
+    }
+    *intersection = ray_origin + ray_direction * closest_t;
+    return true;
+}
+
+}  // namespace gast
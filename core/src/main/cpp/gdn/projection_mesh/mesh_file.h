@@ -0,0 +1,134 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <core/AABB.hpp>
+#include <core/Array.hpp>
+#include <core/String.hpp>
+#include <core/Vector3.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gast {
+
+namespace {
+using namespace godot;
+
+// 'GSTM'
+const uint32_t kMeshFileMagic = 0x4D545347;
+const uint32_t kMeshFileVersion = 2;
+// Header flag set when the vertices carry a second set of texture coordinates.
+const uint32_t kMeshFileHasTexUv2 = 1;
+}  // namespace
+
+/// Binary projection mesh format, in native (little endian) byte order:
+/// - MeshFileHeader
+/// - Vertex block: vertex_count interleaved vertices [x, y, z, u, v] (or [x, y, z, u, v, u2, v2]
+///   with the kMeshFileHasTexUv2 flag)
+/// - Index block: index_count int32 vertex indices, absent for non-indexed meshes
+/// - BVH node block: bvh_node_count MeshFileBvhNode, starting with the root
+/// - BVH triangle block: bvh_triangle_count uint32 triangle indices, referenced by the leaves
+/// Only the triangle lists have a BVH.
+struct MeshFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    // Hash of the parameters the mesh was generated from (see MeshCache), 0 if none.
+    uint64_t key;
+    // Mesh::PrimitiveType of the surface.
+    uint32_t primitive;
+    uint32_t flags;
+    uint32_t vertex_count;
+    uint32_t index_count;
+    uint32_t bvh_node_count;
+    uint32_t bvh_triangle_count;
+};
+
+struct MeshFileBvhNode {
+    float bounds_min[3];
+    float bounds_max[3];
+    // Index of the first child for the inner nodes (the second child follows it), or of the
+    // first entry in the BVH triangle block for the leaves.
+    uint32_t offset;
+    // Number of triangles of a leaf, 0 for the inner nodes.
+    uint32_t triangle_count;
+};
+
+/// Projection mesh stored in the binary mesh format, memory-mapped for reading.
+/// The file stays mapped while the instance is alive; its pages are loaded by the kernel on
+/// first access and shared with the page cache.
+/// Meshes can also be serialized in memory (see create) to intersect them with their BVH.
+class MeshFile {
+public:
+    ~MeshFile();
+
+    /// Map and validate the mesh file at the given path.
+    /// @return The mapped mesh file, or nullptr if the file is missing or invalid
+    static std::shared_ptr<const MeshFile> open(const String &path);
+
+    /// Write the given surface arrays to the given path. The file is written next to its
+    /// destination then renamed, so readers never see a partial file.
+    /// @param key Hash of the parameters the surface was generated from, 0 if none
+    /// @return true if the file was written
+    static bool write(const String &path, int64_t primitive, const Array &arrays,
+                      uint64_t key = 0);
+
+    /// Serialize the given surface arrays in memory, building their BVH.
+    /// @return The in-memory mesh file, or nullptr if the arrays are unsupported
+    static std::shared_ptr<const MeshFile> create(int64_t primitive, const Array &arrays);
+
+    /// Returns the surface arrays, copied from the mapped pages.
+    Array get_surface_arrays() const;
+
+    int64_t get_primitive() const {
+        return header_->primitive;
+    }
+
+    uint64_t get_key() const {
+        return header_->key;
+    }
+
+    bool has_texture_coords2() const;
+
+    bool has_bvh() const {
+        return header_->bvh_node_count > 0;
+    }
+
+    /// Intersect the given ray with the mesh's triangles, using the BVH.
+    /// @param intersection Set to the closest intersection point ahead of the ray origin, if any
+    /// @return true if the ray intersects the mesh. Always false for meshes without a BVH.
+    bool intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                        Vector3 *intersection) const;
+
+private:
+    MeshFile(void *address, size_t size);
+
+    explicit MeshFile(std::vector<uint8_t> &&data);
+
+    // Serialize the given surface arrays and their BVH in the binary mesh format.
+    static bool serialize(int64_t primitive, const Array &arrays, uint64_t key,
+                          std::vector<uint8_t> *data);
+
+    // Validate the mapped file and locate its blocks.
+    bool is_valid();
+
+    // Returns the vertex indices of the given triangle.
+    void get_triangle(uint32_t triangle, uint32_t vertex_indices[3]) const;
+
+    Vector3 get_position(uint32_t vertex_index) const;
+
+    // Backing storage of the in-memory mesh files, empty for the mapped ones.
+    std::vector<uint8_t> data_;
+    void *address_;
+    size_t size_;
+    bool mapped_;
+    const MeshFileHeader *header_;
+    const float *vertices_;
+    const int32_t *indices_;
+    const MeshFileBvhNode *bvh_nodes_;
+    const uint32_t *bvh_triangles_;
+};
+
+}  // namespace gast
+
+#endif // MESH_FILE_H
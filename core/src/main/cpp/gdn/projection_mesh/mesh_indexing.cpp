@@ -0,0 +1,279 @@
+#include "mesh_indexing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace gast {
+
+namespace {
+// Size of the vertex cache modeled by the optimizer.
+const int kVertexCacheSize = 32;
+const float kCacheDecayPower = 1.5f;
+// Score of the vertices used by the last added triangle. Lower than the next most recent
+// vertices to avoid bouncing back and forth in strips.
+const float kLastTriangleScore = 0.75f;
+// Boosts the vertices with few remaining triangles so they're finished off quickly.
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+// Size of the FIFO vertex cache used to compute the ACMR.
+const int kAcmrCacheSize = 16;
+
+float get_vertex_score(int cache_position, int remaining_triangles) {
+    if (remaining_triangles <= 0) {
+        // The vertex isn't used by any of the remaining triangles.
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            score = kLastTriangleScore;
+        } else {
+            float scaler = 1.0f / (kVertexCacheSize - 3);
+            score = std::pow(1.0f - (cache_position - 3) * scaler, kCacheDecayPower);
+        }
+    }
+
+    score += kValenceBoostScale * std::pow(static_cast<float>(remaining_triangles),
+                                           -kValenceBoostPower);
+    return score;
+}
+
+// Bit pattern of a vertex's attributes, used to find the identical vertices.
+struct VertexKey {
+    uint32_t values[7] = {};
+
+    bool operator==(const VertexKey &other) const {
+        return memcmp(values, other.values, sizeof(values)) == 0;
+    }
+};
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey &key) const {
+        // FNV-1a over the attribute bits.
+        uint64_t hash = 14695981039346656037ULL;
+        for (uint32_t value : key.values) {
+            hash = (hash ^ value) * 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+inline uint32_t get_float_bits(float value) {
+    // Both zeros weld together.
+    if (value == 0.0f) {
+        return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+}  // namespace
+
+float compute_acmr(const int *indices, int index_count) {
+    if (index_count < 3) {
+        return 0;
+    }
+
+    std::vector<int> cache;
+    cache.reserve(kAcmrCacheSize);
+    size_t next_slot = 0;
+    int misses = 0;
+    for (int i = 0; i < index_count; i++) {
+        int index = indices[i];
+        bool hit = false;
+        for (int cached_index : cache) {
+            if (cached_index == index) {
+                hit = true;
+                break;
+            }
+        }
+        if (hit) {
+            continue;
+        }
+
+        misses++;
+        if (static_cast<int>(cache.size()) < kAcmrCacheSize) {
+            cache.push_back(index);
+        } else {
+            cache[next_slot] = index;
+            next_slot = (next_slot + 1) % kAcmrCacheSize;
+        }
+    }
+    return static_cast<float>(misses) / (index_count / 3);
+}
+
+std::vector<int> weld_vertices(const float *positions, const float *uvs, const float *uvs2,
+                               int vertex_count, std::vector<int> &indices) {
+    std::vector<int> new_to_old;
+    indices.resize(vertex_count);
+
+    std::unordered_map<VertexKey, int, VertexKeyHash> welded_vertices;
+    welded_vertices.reserve(vertex_count);
+    for (int i = 0; i < vertex_count; i++) {
+        VertexKey key;
+        key.values[0] = get_float_bits(positions[i * 3]);
+        key.values[1] = get_float_bits(positions[i * 3 + 1]);
+        key.values[2] = get_float_bits(positions[i * 3 + 2]);
+        if (uvs) {
+            key.values[3] = get_float_bits(uvs[i * 2]);
+            key.values[4] = get_float_bits(uvs[i * 2 + 1]);
+        }
+        if (uvs2) {
+            key.values[5] = get_float_bits(uvs2[i * 2]);
+            key.values[6] = get_float_bits(uvs2[i * 2 + 1]);
+        }
+
+        auto result = welded_vertices.emplace(key, static_cast<int>(new_to_old.size()));
+        if (result.second) {
+            new_to_old.push_back(i);
+        }
+        indices[i] = result.first->second;
+    }
+    return new_to_old;
+}
+
+std::vector<int> optimize_vertex_cache(const int *indices, int index_count, int vertex_count) {
+    const int triangle_count = index_count / 3;
+
+    // Triangles using each vertex, stored contiguously. The triangles still to be added are kept
+    // at the front of each vertex's range.
+    std::vector<int> adjacency_offsets(vertex_count + 1, 0);
+    for (int i = 0; i < index_count; i++) {
+        adjacency_offsets[indices[i] + 1]++;
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        adjacency_offsets[v + 1] += adjacency_offsets[v];
+    }
+
+    std::vector<int> remaining_triangles(vertex_count, 0);
+    std::vector<int> adjacency(index_count);
+    for (int i = 0; i < index_count; i++) {
+        int vertex = indices[i];
+        adjacency[adjacency_offsets[vertex] + remaining_triangles[vertex]++] = i / 3;
+    }
+
+    std::vector<float> vertex_scores(vertex_count);
+    for (int v = 0; v < vertex_count; v++) {
+        vertex_scores[v] = get_vertex_score(-1, remaining_triangles[v]);
+    }
+
+    std::vector<bool> triangle_added(triangle_count, false);
+    int best_triangle = -1;
+    float best_score = -1.0f;
+    for (int t = 0; t < triangle_count; t++) {
+        float score = vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]]
+                      + vertex_scores[indices[t * 3 + 2]];
+        if (score > best_score) {
+            best_score = score;
+            best_triangle = t;
+        }
+    }
+
+    std::vector<int> output;
+    output.reserve(index_count);
+    std::vector<int> cache;
+    cache.reserve(kVertexCacheSize);
+    std::vector<int> updated_cache;
+    updated_cache.reserve(kVertexCacheSize + 3);
+    int next_unadded_triangle = 0;
+
+    for (int added_count = 0; added_count < triangle_count; added_count++) {
+        if (best_triangle < 0) {
+            // None of the cached vertices has any triangle left, pick up the next one in order.
+            while (triangle_added[next_unadded_triangle]) {
+                next_unadded_triangle++;
+            }
+            best_triangle = next_unadded_triangle;
+        }
+
+        const int *triangle_vertices = indices + best_triangle * 3;
+        triangle_added[best_triangle] = true;
+
+        // Add the triangle's vertices to the front of the cache.
+        updated_cache.clear();
+        for (int k = 0; k < 3; k++) {
+            int vertex = triangle_vertices[k];
+            output.push_back(vertex);
+            updated_cache.push_back(vertex);
+
+            // Remove the triangle from the vertex's remaining triangles.
+            int start = adjacency_offsets[vertex];
+            int end = start + remaining_triangles[vertex];
+            for (int i = start; i < end; i++) {
+                if (adjacency[i] == best_triangle) {
+                    std::swap(adjacency[i], adjacency[end - 1]);
+                    remaining_triangles[vertex]--;
+                    break;
+                }
+            }
+        }
+        for (int vertex : cache) {
+            if (vertex != triangle_vertices[0] && vertex != triangle_vertices[1]
+                && vertex != triangle_vertices[2]) {
+                updated_cache.push_back(vertex);
+            }
+        }
+
+        // Update the scores of the vertices whose cache position changed, including the
+        // ones pushed out of the cache.
+        for (int i = 0; i < static_cast<int>(updated_cache.size()); i++) {
+            int vertex = updated_cache[i];
+            int cache_position = i < kVertexCacheSize ? i : -1;
+            vertex_scores[vertex] = get_vertex_score(cache_position,
+                                                     remaining_triangles[vertex]);
+        }
+
+        // Pick the best remaining triangle using the cached vertices.
+        best_triangle = -1;
+        best_score = -1.0f;
+        const int cached_count = std::min(static_cast<int>(updated_cache.size()),
+                                          kVertexCacheSize);
+        for (int i = 0; i < cached_count; i++) {
+            int vertex = updated_cache[i];
+            int start = adjacency_offsets[vertex];
+            int end = start + remaining_triangles[vertex];
+            for (int j = start; j < end; j++) {
+                int triangle = adjacency[j];
+                const int *vertices = indices + triangle * 3;
+                float score = vertex_scores[vertices[0]] + vertex_scores[vertices[1]]
+                              + vertex_scores[vertices[2]];
+                if (score > best_score) {
+                    best_score = score;
+                    best_triangle = triangle;
+                }
+            }
+        }
+
+        cache.assign(updated_cache.begin(), updated_cache.begin() + cached_count);
+    }
+
+    return output;
+}
+
+std::vector<int> optimize_vertex_fetch(std::vector<int> &indices, int vertex_count) {
+    // Number the vertices in the order they're first referenced. Unreferenced vertices are
+    // moved to the end.
+    std::vector<int> old_to_new(vertex_count, -1);
+    std::vector<int> new_to_old;
+    new_to_old.reserve(vertex_count);
+    for (int &index : indices) {
+        if (old_to_new[index] < 0) {
+            old_to_new[index] = static_cast<int>(new_to_old.size());
+            new_to_old.push_back(index);
+        }
+        index = old_to_new[index];
+    }
+    for (int v = 0; v < vertex_count; v++) {
+        if (old_to_new[v] < 0) {
+            old_to_new[v] = static_cast<int>(new_to_old.size());
+            new_to_old.push_back(v);
+        }
+    }
+    return new_to_old;
+}
+
+}  // namespace gast
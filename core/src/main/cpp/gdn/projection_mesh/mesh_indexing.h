@@ -0,0 +1,33 @@
+#ifndef MESH_INDEXING_H
+#define MESH_INDEXING_H
+
+#include <vector>
+
+namespace gast {
+
+/// Merge the identical vertices (same position and texture coordinates) of the given
+/// non-indexed vertices. Both zeros are identical.
+/// @param positions Positions [x1, y1, z1 ... xn, yn, zn]
+/// @param uvs Texture coordinates [u1, v1 ... un, vn], or nullptr if none
+/// @param uvs2 Secondary texture coordinates, or nullptr if none
+/// @param indices Set to the index of the merged vertex of each vertex
+/// @return The index of the first vertex merged into each merged vertex
+std::vector<int> weld_vertices(const float *positions, const float *uvs, const float *uvs2,
+                               int vertex_count, std::vector<int> &indices);
+
+/// Returns the given indexed triangle list reordered for vertex cache reuse (Forsyth's
+/// algorithm). The indices must be within [0, vertex_count).
+std::vector<int> optimize_vertex_cache(const int *indices, int index_count, int vertex_count);
+
+/// Renumber the vertices in the order they're first referenced by the given indices, which are
+/// updated in place. Unreferenced vertices are moved to the end.
+/// @return The previous index of each renumbered vertex
+std::vector<int> optimize_vertex_fetch(std::vector<int> &indices, int vertex_count);
+
+/// Returns the average cache miss ratio (transformed vertices per triangle) of the given
+/// indices, simulating a FIFO vertex cache typical of mobile GPUs.
+float compute_acmr(const int *indices, int index_count);
+
+}  // namespace gast
+
+#endif // MESH_INDEXING_H
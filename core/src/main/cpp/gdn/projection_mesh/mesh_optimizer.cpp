@@ -0,0 +1,188 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <gen/Mesh.hpp>
+
+#include "mesh_indexing.h"
+#include "utils.h"
+
+namespace gast {
+
+namespace {
+template<class T>
+void remap_vertex_array(Array &arrays, int array_type, const std::vector<int> &new_to_old) {
+    T source = arrays[array_type];
+    T remapped;
+    remapped.resize(new_to_old.size());
+    {
+        typename T::Read read = source.read();
+        typename T::Write write = remapped.write();
+        for (size_t i = 0; i < new_to_old.size(); i++) {
+            write.ptr()[i] = read.ptr()[new_to_old[i]];
+        }
+    }
+    arrays[array_type] = remapped;
+}
+}  // namespace
+
+void MeshOptimizer::optimize_surface_arrays(Array &arrays) {
+    if (arrays.size() != Mesh::ARRAY_MAX
+        || arrays[Mesh::ARRAY_INDEX].get_type() != Variant::POOL_INT_ARRAY
+        || arrays[Mesh::ARRAY_VERTEX].get_type() != Variant::POOL_VECTOR3_ARRAY) {
+        return;
+    }
+
+    PoolIntArray indices = arrays[Mesh::ARRAY_INDEX];
+    PoolVector3Array vertices = arrays[Mesh::ARRAY_VERTEX];
+    int index_count = indices.size();
+    int vertex_count = vertices.size();
+    if (index_count < 3 || index_count % 3 != 0) {
+        return;
+    }
+
+    std::vector<int> optimized_indices;
+    {
+        PoolIntArray::Read read = indices.read();
+        for (int i = 0; i < index_count; i++) {
+            if (read.ptr()[i] < 0 || read.ptr()[i] >= vertex_count) {
+                ALOGW("Skipping the optimization of a mesh with invalid indices.");
+                return;
+            }
+        }
+        optimized_indices = gast::optimize_vertex_cache(read.ptr(), index_count, vertex_count);
+    }
+
+    optimize_vertex_fetch(arrays, optimized_indices, vertex_count);
+
+    PoolIntArray updated_indices;
+    updated_indices.resize(index_count);
+    {
+        PoolIntArray::Write write = updated_indices.write();
+        for (int i = 0; i < index_count; i++) {
+            write.ptr()[i] = optimized_indices[i];
+        }
+    }
+    arrays[Mesh::ARRAY_INDEX] = updated_indices;
+
+#ifdef _DEBUG
+    // Simulating the vertex cache is about as costly as the optimization, so the ACMR is only
+    // reported by the debug builds. The mesh_optimizer_check host check covers the generated
+    // meshes.
+    ALOGV("Optimized mesh with %d vertices and %d triangles: ACMR %.3f -> %.3f", vertex_count,
+          index_count / 3, compute_acmr(indices), compute_acmr(updated_indices));
+#endif
+}
+
+void MeshOptimizer::weld_vertices(Array &arrays) {
+    if (arrays.size() != Mesh::ARRAY_MAX
+        || arrays[Mesh::ARRAY_INDEX].get_type() != Variant::NIL
+        || arrays[Mesh::ARRAY_VERTEX].get_type() != Variant::POOL_VECTOR3_ARRAY) {
+        return;
+    }
+
+    PoolVector3Array vertices = arrays[Mesh::ARRAY_VERTEX];
+    int vertex_count = vertices.size();
+    if (vertex_count == 0) {
+        return;
+    }
+
+    // Only the vertex arrays generated for the projection meshes are supported.
+    PoolVector2Array uvs;
+    PoolVector2Array uvs2;
+    for (int array_type = 0; array_type < Mesh::ARRAY_MAX; array_type++) {
+        Variant::Type type = arrays[array_type].get_type();
+        if (type == Variant::NIL || array_type == Mesh::ARRAY_VERTEX) {
+            continue;
+        }
+
+        if (array_type == Mesh::ARRAY_TEX_UV && type == Variant::POOL_VECTOR2_ARRAY) {
+            uvs = arrays[array_type];
+        } else if (array_type == Mesh::ARRAY_TEX_UV2 && type == Variant::POOL_VECTOR2_ARRAY) {
+            uvs2 = arrays[array_type];
+        } else {
+            return;
+        }
+    }
+    if ((arrays[Mesh::ARRAY_TEX_UV].get_type() != Variant::NIL && uvs.size() != vertex_count)
+        || (arrays[Mesh::ARRAY_TEX_UV2].get_type() != Variant::NIL
+            && uvs2.size() != vertex_count)) {
+        return;
+    }
+
+    std::vector<int> welded_indices;
+    std::vector<int> new_to_old;
+    {
+        // Vector2 and Vector3 are laid out as plain float components.
+        PoolVector3Array::Read vertices_read = vertices.read();
+        PoolVector2Array::Read uvs_read = uvs.read();
+        PoolVector2Array::Read uvs2_read = uvs2.read();
+        new_to_old = gast::weld_vertices(
+                reinterpret_cast<const float *>(vertices_read.ptr()),
+                uvs.size() > 0 ? reinterpret_cast<const float *>(uvs_read.ptr()) : nullptr,
+                uvs2.size() > 0 ? reinterpret_cast<const float *>(uvs2_read.ptr()) : nullptr,
+                vertex_count, welded_indices);
+    }
+
+    PoolIntArray indices;
+    indices.resize(vertex_count);
+    {
+        PoolIntArray::Write indices_write = indices.write();
+        std::copy(welded_indices.begin(), welded_indices.end(), indices_write.ptr());
+    }
+
+    remap_vertex_array<PoolVector3Array>(arrays, Mesh::ARRAY_VERTEX, new_to_old);
+    if (uvs.size() > 0) {
+        remap_vertex_array<PoolVector2Array>(arrays, Mesh::ARRAY_TEX_UV, new_to_old);
+    }
+    if (uvs2.size() > 0) {
+        remap_vertex_array<PoolVector2Array>(arrays, Mesh::ARRAY_TEX_UV2, new_to_old);
+    }
+    arrays[Mesh::ARRAY_INDEX] = indices;
+
+    ALOGV("Welded mesh vertices: %d -> %d (%.1f%%)", vertex_count,
+          static_cast<int>(new_to_old.size()), new_to_old.size() * 100.0f / vertex_count);
+}
+
+float MeshOptimizer::compute_acmr(const PoolIntArray &indices) {
+    PoolIntArray::Read read = indices.read();
+    return gast::compute_acmr(read.ptr(), indices.size());
+}
+
+bool MeshOptimizer::optimize_vertex_fetch(Array &arrays, std::vector<int> &indices,
+                                          int vertex_count) {
+    // Only the vertex arrays generated for the projection meshes are supported.
+    for (int array_type = 0; array_type < Mesh::ARRAY_MAX; array_type++) {
+        Variant::Type type = arrays[array_type].get_type();
+        if (type == Variant::NIL || array_type == Mesh::ARRAY_INDEX) {
+            continue;
+        }
+
+        int size = -1;
+        if ((array_type == Mesh::ARRAY_VERTEX || array_type == Mesh::ARRAY_NORMAL)
+            && type == Variant::POOL_VECTOR3_ARRAY) {
+            size = PoolVector3Array(arrays[array_type]).size();
+        } else if ((array_type == Mesh::ARRAY_TEX_UV || array_type == Mesh::ARRAY_TEX_UV2)
+                   && type == Variant::POOL_VECTOR2_ARRAY) {
+            size = PoolVector2Array(arrays[array_type]).size();
+        }
+
+        if (size != vertex_count) {
+            return false;
+        }
+    }
+
+    std::vector<int> new_to_old = gast::optimize_vertex_fetch(indices, vertex_count);
+    remap_vertex_array<PoolVector3Array>(arrays, Mesh::ARRAY_VERTEX, new_to_old);
+    if (arrays[Mesh::ARRAY_NORMAL].get_type() != Variant::NIL) {
+        remap_vertex_array<PoolVector3Array>(arrays, Mesh::ARRAY_NORMAL, new_to_old);
+    }
+    if (arrays[Mesh::ARRAY_TEX_UV].get_type() != Variant::NIL) {
+        remap_vertex_array<PoolVector2Array>(arrays, Mesh::ARRAY_TEX_UV, new_to_old);
+    }
+    if (arrays[Mesh::ARRAY_TEX_UV2].get_type() != Variant::NIL) {
+        remap_vertex_array<PoolVector2Array>(arrays, Mesh::ARRAY_TEX_UV2, new_to_old);
+    }
+    return true;
+}
+
+}  // namespace gast
@@ -0,0 +1,41 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <core/Array.hpp>
+#include <core/PoolArrays.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}  // namespace
+
+/// Reorders the indexed triangle lists generated for the projection meshes to make better use
+/// of the GPU's post-transform vertex cache and vertex fetch.
+class MeshOptimizer {
+public:
+    /// Reorder the triangles of the given surface arrays for vertex cache reuse (Forsyth's
+    /// algorithm), then reorder the vertices in the order they are first referenced.
+    /// The arrays are updated in place. Non-indexed arrays are left untouched.
+    static void optimize_surface_arrays(Array &arrays);
+
+    /// Merge the identical vertices (same position and texture coordinates) of the given
+    /// non-indexed surface arrays, and add the index array referencing the merged vertices.
+    /// The arrays are updated in place, and the merged vertex count is logged. Indexed arrays
+    /// are left untouched.
+    static void weld_vertices(Array &arrays);
+
+    /// Returns the average cache miss ratio (transformed vertices per triangle) of the given
+    /// indices, simulating a FIFO vertex cache typical of mobile GPUs.
+    /// Costly, only meant for diagnostics.
+    static float compute_acmr(const PoolIntArray &indices);
+
+private:
+    static bool optimize_vertex_fetch(Array &arrays, std::vector<int> &indices, int vertex_count);
+};
+
+}  // namespace gast
+
+#endif // MESH_OPTIMIZER_H
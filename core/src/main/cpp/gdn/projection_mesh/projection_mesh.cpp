@@ -1,15 +1,60 @@
+#include <algorithm>
+#include <chrono>
 #include <gen/ArrayMesh.hpp>
+#include <gen/ConcavePolygonShape.hpp>
+#include <gen/ConvexPolygonShape.hpp>
 #include <gen/Mesh.hpp>
 #include <gen/QuadMesh.hpp>
 #include <gen/Shader.hpp>
+#include <gen/SphereShape.hpp>
+#include <tuple>
 #include <utils.h>
 
+#include "mesh_build_queue.h"
 #include "projection_mesh.h"
+#include "shader_cache.h"
 
 namespace gast {
 
 namespace {
 const float kDefaultAlpha = 1;
+
+// Returns the points of the given collision shape.
+PoolVector3Array get_shape_points(const Ref<Shape> &shape) {
+    if (shape.is_null()) {
+        return PoolVector3Array();
+    }
+
+    if (auto *concave_shape = Object::cast_to<ConcavePolygonShape>(shape.ptr())) {
+        return concave_shape->get_faces();
+    }
+    if (auto *convex_shape = Object::cast_to<ConvexPolygonShape>(shape.ptr())) {
+        return convex_shape->get_points();
+    }
+    return PoolVector3Array();
+}
+
+// Returns the given points without their duplicates. The faces of a concave shape repeat the
+// vertices shared by adjacent triangles.
+PoolVector3Array get_unique_points(const PoolVector3Array &points) {
+    std::vector<Vector3> unique_points;
+    {
+        PoolVector3Array::Read read = points.read();
+        unique_points.assign(read.ptr(), read.ptr() + points.size());
+    }
+    auto is_less = [](const Vector3 &a, const Vector3 &b) {
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    };
+    std::sort(unique_points.begin(), unique_points.end(), is_less);
+    unique_points.erase(std::unique(unique_points.begin(), unique_points.end()),
+                        unique_points.end());
+
+    PoolVector3Array result;
+    result.resize(static_cast<int>(unique_points.size()));
+    PoolVector3Array::Write write = result.write();
+    std::copy(unique_points.begin(), unique_points.end(), write.ptr());
+    return result;
+}
 }  // namespace
 
 ProjectionMesh::~ProjectionMesh() {
@@ -25,8 +70,12 @@ ProjectionMesh::ProjectionMesh(ProjectionMesh::ProjectionMeshType projection_mes
         alpha(kDefaultAlpha),
         has_transparency(kDefaultHasTransparency),
         stereo_mode(StereoMode::kMono),
+        texture_region(kFullTextureRegion),
         collidable(kDefaultCollidable),
-        uv_origin_is_bottom_left(kDefaultUvOriginIsBottomLeft) {}
+        uv_origin_is_bottom_left(kDefaultUvOriginIsBottomLeft),
+        vertex_compression_texture_size(kDefaultVertexCompressionTextureSize),
+        async_mesh_build(kDefaultAsyncMeshBuild),
+        collision_mode(static_cast<CollisionMode>(kDefaultCollisionMode)) {}
 
 ProjectionMesh::ProjectionMesh() : ProjectionMesh(ProjectionMeshType::RECTANGULAR) {}
 
@@ -53,6 +102,14 @@ void ProjectionMesh::_register_methods() {
     register_method("is_render_on_top", &ProjectionMesh::is_render_on_top);
     register_method("set_collidable", &ProjectionMesh::set_collidable);
     register_method("is_collidable", &ProjectionMesh::is_collidable);
+    register_method("set_vertex_compression_texture_size",
+                    &ProjectionMesh::set_vertex_compression_texture_size);
+    register_method("get_vertex_compression_texture_size",
+                    &ProjectionMesh::get_vertex_compression_texture_size);
+    register_method("set_collision_mode", &ProjectionMesh::set_collision_mode);
+    register_method("get_collision_mode", &ProjectionMesh::get_collision_mode);
+    register_method("set_async_mesh_build", &ProjectionMesh::set_async_mesh_build);
+    register_method("is_async_mesh_build", &ProjectionMesh::is_async_mesh_build);
 
     register_property<ProjectionMesh, bool>("collidable", &ProjectionMesh::set_collidable,
                                             &ProjectionMesh::is_collidable, kDefaultCollidable);
@@ -64,6 +121,19 @@ void ProjectionMesh::_register_methods() {
             "render_on_top",
             &ProjectionMesh::set_render_on_top,
             &ProjectionMesh::is_render_on_top, kDefaultRenderOnTop);
+    register_property<ProjectionMesh, int>(
+            "vertex_compression_texture_size",
+            &ProjectionMesh::set_vertex_compression_texture_size,
+            &ProjectionMesh::get_vertex_compression_texture_size,
+            kDefaultVertexCompressionTextureSize);
+    register_property<ProjectionMesh, int>(
+            "collision_mode",
+            &ProjectionMesh::set_collision_mode,
+            &ProjectionMesh::get_collision_mode, kDefaultCollisionMode);
+    register_property<ProjectionMesh, bool>(
+            "async_mesh_build",
+            &ProjectionMesh::set_async_mesh_build,
+            &ProjectionMesh::is_async_mesh_build, kDefaultAsyncMeshBuild);
 }
 
 void ProjectionMesh::update_collision_shapes() const {
@@ -77,31 +147,183 @@ void ProjectionMesh::update_collision_shapes() const {
         CollisionShape * collision_shape = mesh_data->collision_shape;
         if (collidable && collision_shape->is_visible_in_tree() &&
             collision_shape->get_child_count() > 0) {
-            collision_shape->set_shape(mesh_data->shape);
+            collision_shape->set_shape(get_collision_mode_shape(i));
         } else {
             collision_shape->set_shape(Ref<Resource>());
         }
     }
 }
 
+void ProjectionMesh::set_collision_mode(int collision_mode) {
+    if (collision_mode < CollisionMode::TRIMESH || collision_mode > CollisionMode::ANALYTIC) {
+        ALOGE("Invalid collision mode %d.", collision_mode);
+        return;
+    }
+
+    if (this->collision_mode == collision_mode) {
+        return;
+    }
+    this->collision_mode = static_cast<CollisionMode>(collision_mode);
+    for (ProjectionMeshData *mesh_data : projection_mesh_data_list) {
+        mesh_data->collision_mode_shape = Ref<Shape>();
+        if (mesh_data->collision_faces.size() > 0) {
+            // Release the trimesh shape created from the collision faces.
+            mesh_data->shape = Ref<Shape>();
+        }
+    }
+    update_collision_shapes();
+}
+
+Ref<Shape> ProjectionMesh::get_collision_mode_shape(int index) const {
+    ProjectionMeshData *mesh_data = projection_mesh_data_list[index];
+    if (collision_mode == CollisionMode::TRIMESH) {
+        if (mesh_data->shape.is_null() && mesh_data->collision_faces.size() > 0) {
+            ConcavePolygonShape *trimesh_shape = ConcavePolygonShape::_new();
+            trimesh_shape->set_faces(mesh_data->collision_faces);
+            mesh_data->shape = Ref<Shape>(trimesh_shape);
+        }
+        return mesh_data->shape;
+    }
+
+    if (mesh_data->collision_faces.size() == 0 && mesh_data->shape.is_null()) {
+        return Ref<Shape>();
+    }
+
+    if (mesh_data->collision_mode_shape.is_null()) {
+        if (collision_mode == CollisionMode::CONVEX_HULL) {
+            ConvexPolygonShape *convex_shape = ConvexPolygonShape::_new();
+            convex_shape->set_points(get_unique_points(get_collision_points(index)));
+            mesh_data->collision_mode_shape = Ref<Shape>(convex_shape);
+        } else if (collision_mode == CollisionMode::BOUNDING_SPHERE) {
+            SphereShape *sphere_shape = SphereShape::_new();
+            sphere_shape->set_radius(get_bounding_radius(index));
+            mesh_data->collision_mode_shape = Ref<Shape>(sphere_shape);
+        }
+    }
+
+    // No physics shape for the analytic collision mode.
+    return mesh_data->collision_mode_shape;
+}
+
+PoolVector3Array ProjectionMesh::get_collision_points(int index) const {
+    ProjectionMeshData *mesh_data = projection_mesh_data_list[index];
+    if (mesh_data->collision_faces.size() > 0) {
+        return mesh_data->collision_faces;
+    }
+    return get_shape_points(mesh_data->shape);
+}
+
+float ProjectionMesh::get_bounding_radius(int index) const {
+    ProjectionMeshData *mesh_data = projection_mesh_data_list[index];
+    if (mesh_data->bounding_radius < 0) {
+        PoolVector3Array points = get_collision_points(index);
+        float squared_radius = 0;
+        PoolVector3Array::Read read = points.read();
+        for (int i = 0; i < points.size(); i++) {
+            squared_radius = std::max(squared_radius, read.ptr()[i].length_squared());
+        }
+        mesh_data->bounding_radius = std::sqrt(squared_radius);
+    }
+    return mesh_data->bounding_radius;
+}
+
+bool ProjectionMesh::intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                                    Vector3 *intersection) {
+    float radius = 0;
+    for (int i = 0; i < get_mesh_count(); i++) {
+        radius = std::max(radius, get_bounding_radius(i));
+    }
+    if (radius <= 0) {
+        return false;
+    }
+
+    float t = intersect_ray_with_sphere(ray_origin, ray_direction, radius);
+    if (t < 0) {
+        return false;
+    }
+    *intersection = ray_origin + ray_direction * t;
+    return true;
+}
+
+bool ProjectionMesh::has_collision_bvh() const {
+    if (get_mesh_count() <= 0) {
+        return false;
+    }
+
+    for (int i = 0; i < get_mesh_count(); i++) {
+        const ProjectionMeshData *mesh_data = projection_mesh_data_list[i];
+        if (mesh_data->collision_faces.size() > 0 && !mesh_data->collision_bvh) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ProjectionMesh::intersects_ray_with_bvh(const Vector3 &ray_origin,
+                                             const Vector3 &ray_direction,
+                                             Vector3 *intersection) const {
+    bool intersects = false;
+    float closest_distance_squared = INFINITY;
+    for (int i = 0; i < get_mesh_count(); i++) {
+        const std::shared_ptr<const MeshFile> &bvh = projection_mesh_data_list[i]->collision_bvh;
+        Vector3 mesh_intersection;
+        if (!bvh || !bvh->intersects_ray(ray_origin, ray_direction, &mesh_intersection)) {
+            continue;
+        }
+
+        float distance_squared = mesh_intersection.distance_squared_to(ray_origin);
+        if (distance_squared < closest_distance_squared) {
+            closest_distance_squared = distance_squared;
+            *intersection = mesh_intersection;
+            intersects = true;
+        }
+    }
+    return intersects;
+}
+
 bool ProjectionMesh::should_use_alpha_shader_code()  {
     return has_transparency || alpha < kAlphaThreshold || is_render_on_top();
 }
 
-inline String ProjectionMesh::generate_shader_code() {
-    String shader_code = get_base_shader_code(should_use_alpha_shader_code());
-    if (is_render_on_top()) {
-        shader_code += kDisableDepthTestRenderMode;
+bool ProjectionMesh::is_opaque() const {
+    return !has_transparency && alpha >= kAlphaThreshold;
+}
+
+ShaderVariant ProjectionMesh::get_shader_variant(int mesh_index) {
+    ShaderVariant variant;
+    variant.view_index = get_mesh_view_index(mesh_index);
+    variant.use_alpha = should_use_alpha_shader_code();
+    variant.billboard = is_gaze_tracking();
+    variant.render_on_top = is_render_on_top();
+    variant.use_highp_precision = true;
+
+    // Only keep the sampling paths actually needed by the mesh's view(s).
+    bool left_is_identity = sampling_transforms.left == Transform();
+    bool right_is_identity = sampling_transforms.right == Transform();
+    if (variant.view_index == 0) {
+        variant.sampling_mode = left_is_identity ? SamplingMode::kIdentity : SamplingMode::kLeftEye;
+    } else if (variant.view_index == 1) {
+        variant.sampling_mode =
+                right_is_identity ? SamplingMode::kIdentity : SamplingMode::kRightEye;
+    } else if (sampling_transforms.left == sampling_transforms.right) {
+        variant.sampling_mode = left_is_identity ? SamplingMode::kIdentity : SamplingMode::kLeftEye;
+    } else {
+        variant.sampling_mode = SamplingMode::kStereo;
     }
-    return shader_code;
+    return variant;
 }
 
-void ProjectionMesh::reset_meshes() const {
+void ProjectionMesh::reset_meshes() {
+    pending_surface_builds.clear();
     for (int i = 0; i < get_mesh_count(); i++) {
         ProjectionMeshData *mesh_data = projection_mesh_data_list[i];
         mesh_data->mesh_instance->set_mesh(Ref<Resource>());
         mesh_data->collision_shape->set_shape(Ref<Resource>());
+        mesh_data->collision_faces = PoolVector3Array();
         mesh_data->shape = Ref<Resource>();
+        mesh_data->collision_bvh = nullptr;
+        mesh_data->collision_mode_shape = Ref<Shape>();
+        mesh_data->bounding_radius = -1;
     }
 }
 
@@ -152,6 +374,56 @@ void ProjectionMesh::set_mesh(int index, const Ref<Mesh>& mesh) const {
 
     ProjectionMeshData *mesh_data = projection_mesh_data_list[index];
     mesh_data->mesh_instance->set_mesh(mesh);
+    if (mesh.is_valid() && mesh_data->shader_material.is_valid()) {
+        mesh_data->mesh_instance->set_surface_material(kDefaultSurfaceIndex,
+                                                       mesh_data->shader_material);
+    }
+}
+
+void ProjectionMesh::build_surface(int index, std::function<SurfaceBuild()> builder) {
+    if (0 > index || index >= get_mesh_count()) {
+        ALOGE("Cannot build surface, invalid MeshInstance index: %d.", index);
+        return;
+    }
+
+    pending_surface_builds.erase(index);
+    if (async_mesh_build) {
+        pending_surface_builds[index] = MeshBuildQueue::submit(std::move(builder));
+    } else {
+        apply_surface_build(index, builder());
+    }
+}
+
+bool ProjectionMesh::apply_completed_mesh_builds() {
+    if (pending_surface_builds.empty()) {
+        return false;
+    }
+
+    for (auto &entry : pending_surface_builds) {
+        if (entry.second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+    }
+
+    for (auto &entry : pending_surface_builds) {
+        apply_surface_build(entry.first, entry.second.get());
+    }
+    pending_surface_builds.clear();
+    on_surface_builds_applied();
+    return true;
+}
+
+void ProjectionMesh::apply_surface_build(int index, const SurfaceBuild &build) const {
+    if (build.arrays.empty()) {
+        set_mesh(index, Ref<Mesh>());
+        set_collision_faces(index, PoolVector3Array(), nullptr);
+        return;
+    }
+
+    ArrayMesh *mesh = ArrayMesh::_new();
+    mesh->add_surface_from_arrays(build.primitive, build.arrays, Array(), build.compress_flags);
+    set_mesh(index, mesh);
+    set_collision_faces(index, build.collision_faces, build.collision_bvh);
 }
 
 void ProjectionMesh::set_shader(int index, const Ref<Shader> &shader) const {
@@ -166,7 +438,10 @@ void ProjectionMesh::set_shader(int index, const Ref<Shader> &shader) const {
         return;
     }
     mesh_data->shader_material->set_shader(shader);
-    mesh_data->mesh_instance->set_surface_material(kDefaultSurfaceIndex, mesh_data->shader_material);
+    if (mesh_data->mesh_instance->get_mesh().is_valid()) {
+        mesh_data->mesh_instance->set_surface_material(kDefaultSurfaceIndex,
+                                                       mesh_data->shader_material);
+    }
 }
 
 void ProjectionMesh::set_collision_shape(int index, const Ref<Shape>& collision_shape) const {
@@ -176,7 +451,27 @@ void ProjectionMesh::set_collision_shape(int index, const Ref<Shape>& collision_
     }
 
     ProjectionMeshData *mesh_data = projection_mesh_data_list[index];
+    mesh_data->collision_faces = PoolVector3Array();
     mesh_data->shape = collision_shape;
+    mesh_data->collision_bvh = nullptr;
+    mesh_data->collision_mode_shape = Ref<Shape>();
+    mesh_data->bounding_radius = -1;
+    update_collision_shapes();
+}
+
+void ProjectionMesh::set_collision_faces(int index, const PoolVector3Array &collision_faces,
+                                         std::shared_ptr<const MeshFile> collision_bvh) const {
+    if (0 > index || index >= get_mesh_count()) {
+        ALOGE("Invalid index: %d.", index);
+        return;
+    }
+
+    ProjectionMeshData *mesh_data = projection_mesh_data_list[index];
+    mesh_data->collision_faces = collision_faces;
+    mesh_data->shape = Ref<Shape>();
+    mesh_data->collision_bvh = std::move(collision_bvh);
+    mesh_data->collision_mode_shape = Ref<Shape>();
+    mesh_data->bounding_radius = -1;
     update_collision_shapes();
 }
 
@@ -186,15 +481,17 @@ void ProjectionMesh::update_shader_code() {
         return;
     }
 
-    String shader_code = this->generate_shader_code();
     for (int i = 0; i < mesh_count; i++) {
         ProjectionMeshData *mesh_data = projection_mesh_data_list[i];
-
         Ref<ShaderMaterial> shader_material = mesh_data->shader_material;
-        if (shader_material.is_valid() && shader_material->get_shader().is_valid()) {
-            if (shader_material->get_shader()->get_code() != shader_code) {
-                shader_material->get_shader()->set_code(shader_code);
-            }
+        if (!shader_material.is_valid()) {
+            continue;
+        }
+
+        // Switch to the shader specialized for the mesh's current configuration.
+        Ref<Shader> shader = ShaderCache::get_shader(get_shader_variant(i));
+        if (shader_material->get_shader() != shader) {
+            set_shader(i, shader);
         }
     }
 }
@@ -205,19 +502,30 @@ void ProjectionMesh::update_sampling_transforms() {
         return;
     }
 
-    SamplingTransforms sampling_transforms = get_sampling_transforms(stereo_mode,
-                                                                     uv_origin_is_bottom_left);
+    sampling_transforms = get_sampling_transforms(stereo_mode, uv_origin_is_bottom_left);
+
+    // Map the sampled coordinates to the texture region.
+    Transform region_transform = Transform(
+            Basis().scaled(Vector3(texture_region.size.x, texture_region.size.y, 1)),
+            Vector3(texture_region.position.x, texture_region.position.y, 0));
+    sampling_transforms.left = region_transform * sampling_transforms.left;
+    sampling_transforms.right = region_transform * sampling_transforms.right;
     for (int i = 0; i < mesh_count; i++) {
         ProjectionMeshData *mesh_data = projection_mesh_data_list[i];
 
         Ref<ShaderMaterial> shader_material = mesh_data->shader_material;
         if (shader_material.is_valid()) {
             shader_material->set_shader_param(
-                    kGastLeftEyeSamplingTransformName, sampling_transforms.left);
+                    kGastLeftEyeSamplingScaleOffsetName,
+                    get_sampling_scale_offset(sampling_transforms.left));
             shader_material->set_shader_param(
-                    kGastRightEyeSamplingTransformName, sampling_transforms.right);
+                    kGastRightEyeSamplingScaleOffsetName,
+                    get_sampling_scale_offset(sampling_transforms.right));
         }
     }
+
+    // The sampling transforms determine which sampling path the shaders need.
+    update_shader_code();
 }
 
 void ProjectionMesh::update_properties(ProjectionMesh *projection_mesh) {
@@ -229,7 +537,10 @@ void ProjectionMesh::update_properties(ProjectionMesh *projection_mesh) {
     set_gaze_tracking(projection_mesh->is_gaze_tracking());
     set_alpha(projection_mesh->alpha);
     set_has_transparency(projection_mesh->has_transparency);
+    set_async_mesh_build(projection_mesh->is_async_mesh_build());
+    set_collision_mode(projection_mesh->get_collision_mode());
     set_collidable(projection_mesh->is_collidable());
+    set_vertex_compression_texture_size(projection_mesh->get_vertex_compression_texture_size());
 }
 
 void ProjectionMesh::update_render_priority() const {
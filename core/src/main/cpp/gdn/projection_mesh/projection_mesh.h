@@ -1,7 +1,9 @@
 #ifndef PROJECTION_MESH_H
 #define PROJECTION_MESH_H
 
+#include <algorithm>
 #include <core/Array.hpp>
+#include <core/Rect2.hpp>
 #include <core/Ref.hpp>
 #include <core/Vector2.hpp>
 #include <gen/CollisionShape.hpp>
@@ -11,6 +13,9 @@
 #include <gen/Shader.hpp>
 #include <gen/ShaderMaterial.hpp>
 #include <gen/Shape.hpp>
+#include <functional>
+#include <future>
+#include <map>
 #include <vector>
 
 #include "projection_mesh_utils.h"
@@ -21,7 +26,6 @@ namespace gast {
 namespace {
 using namespace godot;
 const char *kGastTextureParamName = "gast_texture";
-const char *kGastEnableBillBoardParamName = "enable_billboard";
 const char *kGastGradientHeightRatioParamName = "gradient_height_ratio";
 const char *kGastNodeAlphaParamName = "node_alpha";
 const int kDefaultSurfaceIndex = 0;
@@ -33,6 +37,11 @@ const bool kDefaultHasTransparency = true;
 // This threshold is used to help determine when we should enable transparency in the shader.
 const float kAlphaThreshold = 0.94f;
 const bool kDefaultUvOriginIsBottomLeft = false;
+const bool kDefaultAsyncMeshBuild = false;
+// Matches ProjectionMesh::CollisionMode::TRIMESH.
+const int kDefaultCollisionMode = 0;
+// Region covering the whole texture, in normalized coordinates.
+const Rect2 kFullTextureRegion = Rect2(0, 0, 1, 1);
 }
 
 class ProjectionMesh : public Resource {
@@ -51,6 +60,21 @@ public:
         RECTANGULAR = 0,
         EQUIRECTANGULAR = 1,
         MESH = 2,
+        EAC = 3,
+        HEMISPHERE_180 = 4,
+    };
+
+    // Mirrors enum class CollisionMode in
+    // src/main/java/org/godotengine/plugin/gast/projectionmesh/ProjectionMesh.kt
+    enum CollisionMode {
+        // Shape made of the mesh's triangles.
+        TRIMESH = 0,
+        // Convex hull of the mesh.
+        CONVEX_HULL = 1,
+        // Sphere bounding the mesh, centered on the mesh's origin.
+        BOUNDING_SPHERE = 2,
+        // No physics shape, the rays are intersected with the mesh natively.
+        ANALYTIC = 3,
     };
 
     ProjectionMeshType get_projection_mesh_type() const {
@@ -69,6 +93,14 @@ public:
         return get_projection_mesh_type() == ProjectionMeshType::EQUIRECTANGULAR;
     }
 
+    bool is_eac_projection_mesh() const {
+        return get_projection_mesh_type() == ProjectionMeshType::EAC;
+    }
+
+    bool is_hemisphere_projection_mesh() const {
+        return get_projection_mesh_type() == ProjectionMeshType::HEMISPHERE_180;
+    }
+
     void set_external_texture(Ref<ExternalTexture> external_texture) {
         update_shaders_param(kGastTextureParamName, external_texture);
     }
@@ -90,13 +122,32 @@ public:
         return this->collidable;
     }
 
+    void set_collision_mode(int collision_mode);
+
+    int get_collision_mode() const {
+        return collision_mode;
+    }
+
+    bool is_analytic_collision() const {
+        return collision_mode == CollisionMode::ANALYTIC;
+    }
+
+    // Intersect the given ray with the mesh, in the mesh's local space. Used by the ANALYTIC
+    // collision mode. Defaults to the mesh's bounding sphere.
+    // @param ray_origin Origin of the ray
+    // @param ray_direction Direction of the ray, not necessarily normalized
+    // @param intersection Set to the intersection point, if any
+    // @return true if the ray intersects the mesh ahead of its origin
+    virtual bool intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                                Vector3 *intersection);
+
     void set_gaze_tracking(bool gaze_tracking) {
         if (this->gaze_tracking == gaze_tracking) {
             return;
         }
         this->gaze_tracking = gaze_tracking;
         update_render_priority();
-        update_shaders_param(kGastEnableBillBoardParamName, gaze_tracking);
+        update_shader_code();
     }
 
     bool is_gaze_tracking() const {
@@ -114,6 +165,10 @@ public:
         update_shaders_param(kGastNodeAlphaParamName, alpha);
     }
 
+    float get_alpha() const {
+        return alpha;
+    }
+
     void set_has_transparency(bool has_transparency) {
         if (this->has_transparency == has_transparency) {
             return;
@@ -152,7 +207,54 @@ public:
         update_sampling_transforms();
     }
 
-    void reset_meshes() const;
+    // Set the texture resolution used to decide whether the mesh vertices can be stored in
+    // compressed formats without visible error. 0 disables the compression.
+    void set_vertex_compression_texture_size(int texture_size) {
+        texture_size = std::max(0, texture_size);
+        if (this->vertex_compression_texture_size == texture_size) {
+            return;
+        }
+        this->vertex_compression_texture_size = texture_size;
+        update_projection_mesh();
+    }
+
+    int get_vertex_compression_texture_size() const {
+        return vertex_compression_texture_size;
+    }
+
+    // When enabled, the mesh surfaces are built on a worker thread and swapped in at the next
+    // frame boundary once ready. The current surfaces keep rendering in the meantime.
+    void set_async_mesh_build(bool enable) {
+        this->async_mesh_build = enable;
+    }
+
+    bool is_async_mesh_build() const {
+        return async_mesh_build;
+    }
+
+    bool has_pending_mesh_builds() const {
+        return !pending_surface_builds.empty();
+    }
+
+    // Swap in the surfaces built on the worker threads, once all of them are ready so they
+    // are updated together.
+    // Returns true if the pending builds were applied.
+    bool apply_completed_mesh_builds();
+
+    // Returns true if the mesh fully hides the content rendered behind it.
+    virtual bool is_opaque() const;
+
+    // Restrict the sampling to the given normalized region of the texture (e.g: when the
+    // texture is shared via a texture atlas).
+    void set_texture_region(const Rect2 &texture_region) {
+        if (this->texture_region == texture_region) {
+            return;
+        }
+        this->texture_region = texture_region;
+        update_sampling_transforms();
+    }
+
+    void reset_meshes();
 
     void reset_external_texture() {
         set_external_texture(Ref<Resource>());
@@ -168,6 +270,14 @@ public:
 
     virtual void update_projection_mesh() {}
 
+    // Select the mesh's level of detail for the given camera. No-op for meshes without levels
+    // of detail.
+    // @param camera_origin Global position of the camera
+    // @param camera_forward Global direction the camera is facing
+    // @param focal_length Focal length of the camera, in viewport pixels
+    virtual void update_level_of_detail(const Vector3 &camera_origin,
+                                        const Vector3 &camera_forward, float focal_length) {}
+
     CollisionShape * get_collision_shape(int index) const;
 
     MeshInstance *get_mesh_instance(int index) const;
@@ -182,7 +292,18 @@ protected:
     struct ProjectionMeshData {
         CollisionShape *collision_shape;
         MeshInstance *mesh_instance;
+        // Triangles of the mesh's exact collision shape, set by the surface builds. The other
+        // collision modes' shapes are derived from them.
+        PoolVector3Array collision_faces;
+        // Exact collision shape of the mesh. Created from the collision faces only while the
+        // TRIMESH collision mode is in use, otherwise set directly (see set_collision_shape).
         Ref<Shape> shape;
+        // BVH of the collision faces, used by the analytic collisions if set.
+        std::shared_ptr<const MeshFile> collision_bvh;
+        // Shape used by the current collision mode, created on demand.
+        Ref<Shape> collision_mode_shape;
+        // Radius of the sphere bounding the collision shape, negative until computed.
+        float bounding_radius = -1;
         Ref<ShaderMaterial> shader_material;
     };
 
@@ -202,14 +323,55 @@ protected:
 
     void set_collision_shape(int index, const Ref<Shape>& collision_shape) const;
 
-    virtual String generate_shader_code();
+    // Set the triangles of the exact collision shape, and their BVH if any. The trimesh shape
+    // is only created once the TRIMESH collision mode attaches it.
+    void set_collision_faces(int index, const PoolVector3Array &collision_faces,
+                             std::shared_ptr<const MeshFile> collision_bvh) const;
+
+    // Returns the shader features needed by the mesh at the given index.
+    virtual ShaderVariant get_shader_variant(int mesh_index);
+
+    // Returns the view rendered by the mesh at the given index: -1 for both, 0 for left, 1 for
+    // right.
+    virtual int get_mesh_view_index(int mesh_index) const {
+        return -1;
+    }
 
     void update_sampling_transforms();
 
+    // Build the surface of the mesh at the given index, on a worker thread if the async mesh
+    // build is enabled, in which case the builder must only capture copies of its inputs.
+    // Supersedes the pending build for the same index, if any.
+    void build_surface(int index, std::function<SurfaceBuild()> builder);
+
+    // Returns true if the collision faces of all the meshes have a BVH.
+    bool has_collision_bvh() const;
+
+    // Intersect the given ray with the meshes' collision faces through their BVH, in the mesh's
+    // local space. Only meant for the meshes without a closed-form intersection.
+    bool intersects_ray_with_bvh(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                                 Vector3 *intersection) const;
+
+    // Invoked once the surfaces built on the worker threads have been swapped in.
+    virtual void on_surface_builds_applied() {}
+
 private:
+    void apply_surface_build(int index, const SurfaceBuild &build) const;
+
+    // Returns the shape to attach to the mesh at the given index for the current collision
+    // mode.
+    Ref<Shape> get_collision_mode_shape(int index) const;
+
+    // Returns the points of the exact collision shape of the mesh at the given index.
+    PoolVector3Array get_collision_points(int index) const;
+
+    float get_bounding_radius(int index) const;
+
     ProjectionMeshType projection_mesh_type;
     std::vector<ProjectionMeshData*> projection_mesh_data_list{};
     StereoMode stereo_mode;
+    Rect2 texture_region;
+    SamplingTransforms sampling_transforms;
 
     bool render_on_top;
     bool gaze_tracking;
@@ -217,6 +379,10 @@ private:
     float alpha;
     bool has_transparency;
     bool collidable;
+    int vertex_compression_texture_size;
+    bool async_mesh_build;
+    CollisionMode collision_mode;
+    std::map<int, std::future<SurfaceBuild>> pending_surface_builds;
 };
 
 }  // namespace gast
@@ -3,7 +3,9 @@
 
 #include <map>
 
+#include "eac_projection_mesh.h"
 #include "equirectangular_projection_mesh.h"
+#include "hemisphere_projection_mesh.h"
 #include "rectangular_projection_mesh.h"
 
 namespace gast {
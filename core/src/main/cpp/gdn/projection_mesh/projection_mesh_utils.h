@@ -2,10 +2,20 @@
 #define PROJECTION_MESH_UTILS_H
 
 #include <GLES3/gl3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
 
+#include "core/AABB.hpp"
 #include "core/Math.hpp"
+#include "core/Plane.hpp"
 #include "gen/ArrayMesh.hpp"
 #include "gen/Mesh.hpp"
+#include "curved_screen_surface.h"
+#include "half_float_compression.h"
+#include "mesh_file.h"
+#include "spherical_surface.h"
 
 namespace gast {
 
@@ -14,70 +24,74 @@ using namespace godot;
 
 const float kGradientHeightRatioThreshold = 0.05;
 
+// Maximum on-screen deviation, in pixels, between the tessellated procedural meshes and the
+// surfaces they approximate. Used to select the meshes' level of detail.
+const float kMaxTessellationErrorPixels = 2.0f;
+// A coarser level of detail is only selected once its error drops below this ratio of the max
+// error, to prevent popping when the error hovers around the threshold.
+const float kLevelOfDetailHysteresisRatio = 0.7f;
+
+// Template for the projection mesh shaders.
+// The '$' placeholders are replaced with the code paths needed by each shader variant, so that
+// the variants don't pay at runtime for the features they don't use.
 const char *kBaseShaderCode = R"GAST_SHADER(
 shader_type spatial;
 render_mode unshaded, depth_draw_opaque, specular_disabled, shadows_disabled, ambient_light_disabled;
-
+$render_modes
 uniform samplerExternalOES gast_texture;
-uniform mat4 left_eye_sampling_transform;
-uniform mat4 right_eye_sampling_transform;
-uniform bool enable_billboard;
-uniform float gradient_height_ratio;
 uniform float node_alpha = 1.0;
 // Used to simulate a scrim on the gast texture by lowering the brightness value
 uniform float scrim_brightness = 1.0;
-
-// Specifies which view index this shader should apply:
-// -1 for both
-// 0 for left
-// 1 for right
-uniform int shader_view_index = -1;
-
-void vertex() {
-	if (enable_billboard) {
-		MODELVIEW_MATRIX = INV_CAMERA_MATRIX * mat4(CAMERA_MATRIX[0],CAMERA_MATRIX[1],CAMERA_MATRIX[2],WORLD_MATRIX[3]);
-	}
-}
-
+$uniforms
+$vertex_function
 void fragment() {
-    vec2 new_uv = UV;
-    if (VIEW_INDEX == VIEW_RIGHT) {
-        // Right Eye
-        if (shader_view_index == 0) {
-            // Discarding since this shader should only render for the left (0) view index.
-            discard;
-        }
-        new_uv = (right_eye_sampling_transform * vec4(UV.x, UV.y, 0.0, 1.0)).xy;
-    } else {
-        // Left Eye
-        if (shader_view_index == 1) {
-            // Discarding since this shader should only render for the right (1) view index.
-            discard;
-        }
-        new_uv = (left_eye_sampling_transform * vec4(UV.x, UV.y, 0.0, 1.0)).xy;
-    }
-
+$view_mask_code
+$sampling_code
 	vec4 texture_color = texture(gast_texture, new_uv);
 	float target_alpha = COLOR.a * texture_color.a * node_alpha;
-
-    // $gradient_height_ratio_threshold is updated with the threshold value.
-	if (gradient_height_ratio >= $gradient_height_ratio_threshold) {
-		float gradient_mask = min((1.0 - UV.y) / gradient_height_ratio, 1.0);
-		target_alpha = target_alpha * gradient_mask;
-	}
-
-    // $alpha_variable is dynamically updated based on whether transparency is needed.
-    // - When transparency is off, it's set to `target_alpha`, turning into a no-op
-    // - When transparency is on, it's set to `ALPHA`
-	$alpha_variable = target_alpha;
+$gradient_code
+$alpha_code
 	ALBEDO = texture_color.rgb * scrim_brightness * target_alpha;
 }
 )GAST_SHADER";
 
-const char *kDisableDepthTestRenderMode = "render_mode depth_test_disable;";
-const char *kCullFrontRenderMode = "render_mode cull_front;";
-const char *kGastLeftEyeSamplingTransformName = "left_eye_sampling_transform";
-const char *kGastRightEyeSamplingTransformName = "right_eye_sampling_transform";
+const char *kBillboardVertexCode =
+        "\tMODELVIEW_MATRIX = INV_CAMERA_MATRIX * mat4(CAMERA_MATRIX[0],CAMERA_MATRIX[1],CAMERA_MATRIX[2],WORLD_MATRIX[3]);\n";
+// The right view's texture coordinates are carried in the UV2 channel.
+const char *kPerViewUvVertexCode = "\tif (VIEW_INDEX == VIEW_RIGHT) {\n\t\tUV = UV2;\n\t}\n";
+
+// The sampling transforms are axis aligned, so they're applied as a scale (xy) and offset (zw).
+const char *kLeftEyeSamplingUniform =
+        "uniform vec4 left_eye_sampling_scale_offset = vec4(1.0, 1.0, 0.0, 0.0);\n";
+const char *kRightEyeSamplingUniform =
+        "uniform vec4 right_eye_sampling_scale_offset = vec4(1.0, 1.0, 0.0, 0.0);\n";
+const char *kGradientHeightRatioUniform = "uniform float gradient_height_ratio;\n";
+
+const char *kIdentitySamplingCode = "\tvec2 new_uv = UV;";
+const char *kLeftEyeSamplingCode =
+        "\tvec2 new_uv = UV * left_eye_sampling_scale_offset.xy + left_eye_sampling_scale_offset.zw;";
+const char *kRightEyeSamplingCode =
+        "\tvec2 new_uv = UV * right_eye_sampling_scale_offset.xy + right_eye_sampling_scale_offset.zw;";
+const char *kStereoSamplingCode = R"GAST_SHADER(
+	vec4 scale_offset = VIEW_INDEX == VIEW_RIGHT ? right_eye_sampling_scale_offset : left_eye_sampling_scale_offset;
+	vec2 new_uv = UV * scale_offset.xy + scale_offset.zw;)GAST_SHADER";
+
+// Discarding since the shader should only render for the left view.
+const char *kLeftViewMaskCode = "\tif (VIEW_INDEX == VIEW_RIGHT) {\n\t\tdiscard;\n\t}";
+// Discarding since the shader should only render for the right view.
+const char *kRightViewMaskCode = "\tif (VIEW_INDEX != VIEW_RIGHT) {\n\t\tdiscard;\n\t}";
+
+const char *kGradientCode = R"GAST_SHADER(
+	float gradient_mask = min((1.0 - UV.y) / gradient_height_ratio, 1.0);
+	target_alpha = target_alpha * gradient_mask;)GAST_SHADER";
+
+// Only emitted when transparency is needed.
+const char *kAlphaCode = "\tALPHA = target_alpha;";
+
+const char *kDisableDepthTestRenderMode = "render_mode depth_test_disable;\n";
+const char *kCullFrontRenderMode = "render_mode cull_front;\n";
+const char *kGastLeftEyeSamplingScaleOffsetName = "left_eye_sampling_scale_offset";
+const char *kGastRightEyeSamplingScaleOffsetName = "right_eye_sampling_scale_offset";
 
 const char *kShaderCustomDefines = R"GAST_DEFINES(
 #ifdef ANDROID_ENABLED
@@ -111,6 +125,48 @@ struct SamplingTransforms {
     Transform right;
 };
 
+/// Specifies how the texture coordinates are sampled by a shader variant.
+enum class SamplingMode {
+    // The mesh UVs are used as is.
+    kIdentity,
+    // The left eye scale and offset are applied for all the views.
+    kLeftEye,
+    // The right eye scale and offset are applied for all the views.
+    kRightEye,
+    // The scale and offset are selected based on the view index.
+    kStereo,
+};
+
+/// Features of a projection mesh shader. Only the code paths needed by the enabled features are
+/// generated.
+struct ShaderVariant {
+    SamplingMode sampling_mode = SamplingMode::kIdentity;
+    // Which view the shader renders: -1 for both, 0 for left, 1 for right.
+    int view_index = -1;
+    bool use_alpha = false;
+    bool billboard = false;
+    bool gradient = false;
+    bool render_on_top = false;
+    bool cull_front = false;
+    bool use_highp_precision = false;
+    // Whether the UVs are selected per view in the vertex stage.
+    bool per_view_uv = false;
+
+    /// Returns a key uniquely identifying the variant.
+    int get_key() const {
+        int key = static_cast<int>(sampling_mode);
+        key |= (view_index + 1) << 2;
+        key |= use_alpha << 4;
+        key |= billboard << 5;
+        key |= gradient << 6;
+        key |= render_on_top << 7;
+        key |= cull_front << 8;
+        key |= use_highp_precision << 9;
+        key |= per_view_uv << 10;
+        return key;
+    }
+};
+
 Transform get_transform_from_translation(Vector2 translation) {
     auto transform = Transform();
     transform.translate(translation.x, translation.y, 0);
@@ -190,101 +246,254 @@ get_sampling_transforms(StereoMode stereo_mode, bool uv_origin_is_bottom_left =
     sampling_transforms.right = right_sampling_transform;
     return sampling_transforms;
 }
-}  // namespace
 
-static inline String get_base_shader_code(bool use_alpha) {
-    Dictionary dict;
-    dict["alpha_variable"] = use_alpha ? "ALPHA" : "target_alpha";
-    dict["gradient_height_ratio_threshold"] = String::num_real(kGradientHeightRatioThreshold);
-    return String(kBaseShaderCode).format(dict, "$_") ;
+/// Returns the scale (x, y) and offset (z, d) applied by the given axis aligned sampling
+/// transform.
+Plane get_sampling_scale_offset(const Transform &sampling_transform) {
+    return Plane(sampling_transform.basis.elements[0][0], sampling_transform.basis.elements[1][1],
+                 sampling_transform.origin.x, sampling_transform.origin.y);
 }
 
-static inline Array create_curved_screen_surface_array(
-        Vector2 mesh_size, float curved_screen_radius, size_t curved_screen_resolution) {
-    const float horizontal_angle =
-            2.0f * std::atan(mesh_size.x * 0.5f / curved_screen_radius);
-    const size_t vertical_resolution = curved_screen_resolution;
-    const size_t horizontal_resolution = curved_screen_resolution;
-    Array arr = Array();
-    arr.resize(Mesh::ARRAY_MAX);
-    PoolVector3Array vertices = PoolVector3Array();
-    PoolVector2Array uv = PoolVector2Array();
-    PoolIntArray indices = PoolIntArray();
+/// Returns the maximum distance between an arc of the given radius and angle, and its chord.
+float get_chord_error(float radius, float arc_angle) {
+    return radius * (1.0f - std::cos(arc_angle / 2.0f));
+}
+
+/// Select the level of detail of a procedural mesh.
+/// @param level_errors On-screen tessellation error of each level, in pixels, from the coarsest
+/// to the finest level
+/// @param current_level Currently selected level, or -1 if none
+/// @return The coarsest level within the error bound, or the current level if switching to it
+/// would be within the hysteresis band
+int select_level_of_detail(const std::vector<float> &level_errors, int current_level) {
+    if (level_errors.empty()) {
+        return -1;
+    }
 
-    for (size_t row = 0; row < vertical_resolution; row++) {
-        for (size_t col = 0; col < horizontal_resolution; col++) {
-            const float x_percent = static_cast<float>(col) /
-                                    static_cast<float>(horizontal_resolution - 1U);
-            const float y_percent = static_cast<float>(row) /
-                                    static_cast<float>(vertical_resolution - 1U);
-            const float angle = x_percent * horizontal_angle - (horizontal_angle / 2.0f);
-            const float x_pos = sin(angle);
-            const float z_pos = -cos(angle) + cos(horizontal_angle / 4.0f);
-            Vector3 out_pos =
-                    Vector3(
-                            x_pos * curved_screen_radius,
-                            (y_percent - 0.5) * mesh_size.y,
-                            z_pos * curved_screen_radius);
-            Vector2 out_uv = Vector2(x_percent, 1 - y_percent);
-            vertices.append(out_pos);
-            uv.append(out_uv);
+    int level = static_cast<int>(level_errors.size()) - 1;
+    for (int i = 0; i < static_cast<int>(level_errors.size()); i++) {
+        if (level_errors[i] <= kMaxTessellationErrorPixels) {
+            level = i;
+            break;
         }
     }
 
-    for (size_t row = 0; row < vertical_resolution - 1; row++) {
-        for (size_t col = 0; col < horizontal_resolution - 1; col++) {
-            uint32_t offset = col + row * horizontal_resolution;
+    if (current_level < 0 || current_level >= static_cast<int>(level_errors.size())
+        || level >= current_level) {
+        return level;
+    }
+
+    // Only switch to a coarser level once it's comfortably within the error bound.
+    for (int i = level; i < current_level; i++) {
+        if (level_errors[i] <= kMaxTessellationErrorPixels * kLevelOfDetailHysteresisRatio) {
+            return i;
+        }
+    }
+    return current_level;
+}
+}  // namespace
+
+static inline String get_base_shader_code(const ShaderVariant &variant) {
+    String render_modes = "";
+    if (variant.render_on_top) {
+        render_modes += kDisableDepthTestRenderMode;
+    }
+    if (variant.cull_front) {
+        render_modes += kCullFrontRenderMode;
+    }
+
+    String uniforms = "";
+    String sampling_code = "";
+    switch (variant.sampling_mode) {
+        case SamplingMode::kIdentity:
+            sampling_code = kIdentitySamplingCode;
+            break;
+        case SamplingMode::kLeftEye:
+            uniforms += kLeftEyeSamplingUniform;
+            sampling_code = kLeftEyeSamplingCode;
+            break;
+        case SamplingMode::kRightEye:
+            uniforms += kRightEyeSamplingUniform;
+            sampling_code = kRightEyeSamplingCode;
+            break;
+        case SamplingMode::kStereo:
+            uniforms += kLeftEyeSamplingUniform;
+            uniforms += kRightEyeSamplingUniform;
+            sampling_code = kStereoSamplingCode;
+            break;
+    }
+    if (variant.gradient) {
+        uniforms += kGradientHeightRatioUniform;
+    }
+
+    String view_mask_code = "";
+    if (variant.view_index == 0) {
+        view_mask_code = kLeftViewMaskCode;
+    } else if (variant.view_index == 1) {
+        view_mask_code = kRightViewMaskCode;
+    }
 
-            /*
-             Our vertex array contains the list of all vertices grouped by rows.
-             For example, for row_count = 2 (= col_count = horizontal_resolution):
-                [(A {index=0}, B {index=1}), (C {index=2}, D {index=3})]
+    String vertex_function = "";
+    if (variant.billboard || variant.per_view_uv) {
+        vertex_function += "void vertex() {\n";
+        if (variant.billboard) {
+            vertex_function += kBillboardVertexCode;
+        }
+        if (variant.per_view_uv) {
+            vertex_function += kPerViewUvVertexCode;
+        }
+        vertex_function += "}\n";
+    }
 
-             To generate the triangles in clockwise winding order, we need the following sequence:
+    Dictionary dict;
+    dict["render_modes"] = render_modes;
+    dict["uniforms"] = uniforms;
+    dict["vertex_function"] = vertex_function;
+    dict["view_mask_code"] = view_mask_code;
+    dict["sampling_code"] = sampling_code;
+    dict["gradient_code"] = variant.gradient ? kGradientCode : "";
+    dict["alpha_code"] = variant.use_alpha ? kAlphaCode : "";
+    return String(kBaseShaderCode).format(dict, "$_");
+}
 
-             C ---- D
-             |\     |
-             |  \   |
-             |    \ |
-             A ---- B
+/// Returns the number of horizontal segments needed for a curved screen of the given width and
+/// radius to deviate from the cylinder by at most the given chord error.
+static inline size_t get_curved_screen_segment_count(float width, float curved_screen_radius,
+                                                     float max_chord_error) {
+    if (width <= 0 || max_chord_error <= 0 || curved_screen_radius <= max_chord_error) {
+        return 1;
+    }
 
-             vertices => [A,C,B], [B,C,D]
-             indices  => [0,2,1], [1,2,3]
+    const float horizontal_angle = 2.0f * std::atan(width * 0.5f / curved_screen_radius);
+    // Inverse of get_chord_error(...).
+    const float segment_angle = 2.0f * std::acos(1.0f - max_chord_error / curved_screen_radius);
+    return Math::max(static_cast<size_t>(1),
+                     static_cast<size_t>(std::ceil(horizontal_angle / segment_angle)));
+}
 
-             ==> First triangle: offset, offset + horizontal_resolution, offset + 1
-             ==> Second triangle: offset + 1, offset + horizontal_resolution, offset + horizontal_resolution + 1
-             */
-            // Add the first triangle
-            indices.append(offset);
-            indices.append(offset + horizontal_resolution);
-            indices.append(offset + 1);
+/// Returns the surface arrays of the given generated surface.
+static inline Array create_surface_array(const SurfaceGeometry &surface) {
+    const int vertex_count = static_cast<int>(surface.get_vertex_count());
+    const int index_count = static_cast<int>(surface.indices.size());
 
-            // Add the second triangle
-            indices.append(offset + 1);
-            indices.append(offset + horizontal_resolution);
-            indices.append(offset + horizontal_resolution + 1);
+    PoolVector3Array vertices = PoolVector3Array();
+    vertices.resize(vertex_count);
+    PoolVector2Array uvs = PoolVector2Array();
+    uvs.resize(vertex_count);
+    PoolIntArray indices = PoolIntArray();
+    indices.resize(index_count);
+    {
+        PoolVector3Array::Write vertices_write = vertices.write();
+        PoolVector2Array::Write uvs_write = uvs.write();
+        for (int i = 0; i < vertex_count; i++) {
+            vertices_write.ptr()[i] = Vector3(surface.positions[i * 3],
+                                              surface.positions[i * 3 + 1],
+                                              surface.positions[i * 3 + 2]);
+            uvs_write.ptr()[i] = Vector2(surface.uvs[i * 2], surface.uvs[i * 2 + 1]);
         }
+
+        PoolIntArray::Write indices_write = indices.write();
+        std::copy(surface.indices.begin(), surface.indices.end(), indices_write.ptr());
     }
 
+    Array arr;
+    arr.resize(Mesh::ARRAY_MAX);
     arr[Mesh::ARRAY_VERTEX] = vertices;
-    arr[Mesh::ARRAY_TEX_UV] = uv;
+    arr[Mesh::ARRAY_TEX_UV] = uvs;
     arr[Mesh::ARRAY_INDEX] = indices;
-
     return arr;
 }
 
+/// Generates a section of a cylinder of the given radius, spanning the given mesh size.
+/// The surface is straight along the y axis, so it only needs two rows of vertices.
+static inline Array create_curved_screen_surface_array(
+        Vector2 mesh_size, float curved_screen_radius, size_t horizontal_segment_count) {
+    return create_surface_array(generate_curved_screen_surface(
+            mesh_size.x, mesh_size.y, curved_screen_radius, horizontal_segment_count));
+}
+
+/// Generates a sphere, or a section of a sphere centered on the -z axis.
+/// @param longitude_range Horizontal angle covered by the surface, in degrees
+/// @param tessellation Distribution of the bands and sectors
 static inline Array create_spherical_surface_array(
-        float size, size_t band_count, size_t sector_count) {
-    float degrees_to_radians = M_PI / 180.0f;
-    float longitude_start = -180.f * degrees_to_radians;
-    float longitude_end = 180.f * degrees_to_radians;
-    float latitude_start = -90.f * degrees_to_radians;
-    float latitude_end = 90.f * degrees_to_radians;
-    band_count = Math::max(static_cast<size_t>(2), band_count);
-    sector_count = Math::max(static_cast<size_t>(3), sector_count);
-
-    const size_t vertices_per_ring = sector_count + 1;
-    const size_t vertices_per_band = band_count + 1;
+        float size, size_t band_count, size_t sector_count, float longitude_range = 360.f,
+        const SphericalTessellation &tessellation = SphericalTessellation()) {
+    return create_surface_array(generate_spherical_surface(size, band_count, sector_count,
+                                                           longitude_range, tessellation));
+}
+
+/// Cube face of an equi-angular cubemap (EAC) frame.
+struct EacFace {
+    // Outward axis of the face.
+    Vector3 center;
+    // Axes of the face image, as seen from inside the cube.
+    Vector3 right;
+    Vector3 up;
+    // Cell of the face in the 3x2 frame layout.
+    int column;
+    int row;
+    // Whether the face image is rotated 90 degrees clockwise in the frame.
+    bool rotated;
+};
+
+/// EAC frame layout. The top row holds the left, front and right faces upright. The bottom row
+/// holds the bottom, back and top faces as seen when facing backward, rotated 90 degrees
+/// clockwise, so that both rows are continuous strips.
+const EacFace kEacFaces[] = {
+        {Vector3(-1, 0, 0), Vector3(0, 0, -1), Vector3(0, 1, 0), 0, 0, false},  // Left
+        {Vector3(0, 0, -1), Vector3(1, 0, 0), Vector3(0, 1, 0), 1, 0, false},   // Front
+        {Vector3(1, 0, 0), Vector3(0, 0, 1), Vector3(0, 1, 0), 2, 0, false},    // Right
+        {Vector3(0, -1, 0), Vector3(-1, 0, 0), Vector3(0, 0, 1), 0, 1, true},   // Bottom
+        {Vector3(0, 0, 1), Vector3(-1, 0, 0), Vector3(0, 1, 0), 1, 1, true},    // Back
+        {Vector3(0, 1, 0), Vector3(-1, 0, 0), Vector3(0, 0, -1), 2, 1, true},   // Top
+};
+const int kEacFaceCount = sizeof(kEacFaces) / sizeof(kEacFaces[0]);
+const int kEacFrameColumns = 3;
+const int kEacFrameRows = 2;
+
+/// Maps the given face image coordinates, in [0, 1] with the y axis pointing up, to the EAC
+/// frame's texture coordinates.
+static inline Vector2 get_eac_frame_uv(const EacFace &face, float x, float y) {
+    if (face.rotated) {
+        return Vector2((face.column + y) / kEacFrameColumns, (face.row + x) / kEacFrameRows);
+    }
+    return Vector2((face.column + x) / kEacFrameColumns, (face.row + 1 - y) / kEacFrameRows);
+}
+
+/// Returns the EAC frame's texture coordinates for the given direction (analytic ray to UV
+/// mapping).
+static inline Vector2 get_eac_uv(const Vector3 &direction) {
+    if (direction == Vector3()) {
+        return Vector2(-1, -1);
+    }
+
+    // Find the face hit by the direction.
+    int face_index = 0;
+    float max_dot = -INFINITY;
+    for (int i = 0; i < kEacFaceCount; i++) {
+        float dot = direction.dot(kEacFaces[i].center);
+        if (dot > max_dot) {
+            max_dot = dot;
+            face_index = i;
+        }
+    }
+
+    // Cube face coordinates in [-1, 1], then equi-angular coordinates in [-1, 1].
+    const EacFace &face = kEacFaces[face_index];
+    float cube_x = direction.dot(face.right) / max_dot;
+    float cube_y = direction.dot(face.up) / max_dot;
+    float eac_x = std::atan(cube_x) * 4.0f / M_PI;
+    float eac_y = std::atan(cube_y) * 4.0f / M_PI;
+    return get_eac_frame_uv(face, (eac_x + 1) * 0.5f, (eac_y + 1) * 0.5f);
+}
+
+/// Generates a cube of the given size, textured with the equi-angular cubemap (EAC) layout.
+/// The vertices are spaced by equal angles so that the linear interpolation of the texture
+/// coordinates matches the EAC mapping.
+static inline Array create_eac_cube_surface_array(float size, size_t face_segment_count) {
+    face_segment_count = Math::max(static_cast<size_t>(1), face_segment_count);
+    const size_t vertices_per_row = face_segment_count + 1;
+    const float half_size = size * 0.5f;
 
     Array arr;
     arr.resize(Mesh::ARRAY_MAX);
@@ -292,49 +501,34 @@ static inline Array create_spherical_surface_array(
     PoolVector2Array uvs = PoolVector2Array();
     PoolIntArray indices = PoolIntArray();
 
-    const float sector_angle =
-            (longitude_end - longitude_start) / static_cast<float>(sector_count);
-    const Vector3 scale = 0.5f * Vector3(size, size, size);
-
-    const float delta_angle =
-            (latitude_end - latitude_start) / static_cast<float>(band_count);
-
-    for (size_t ring = 0; ring < vertices_per_band; ring++) {
-        const float latitude_angle =
-                latitude_start + delta_angle * static_cast<float>(ring);
-        const float ring_radius = cosf(latitude_angle);
-        const float sphere_y = sinf(latitude_angle);
-
-        for (size_t s = 0; s < vertices_per_ring; s++) {
-            const float radians =
-                    longitude_start + sector_angle * static_cast<float>(s);
-            const Vector2 ring_pt = Vector2(cosf(radians), sinf(radians));
-            const Vector3 sphere_pt = Vector3(ring_radius * ring_pt[1], sphere_y,
-                                              ring_radius * -ring_pt[0]);
-            const Vector3 pos = Vector3(scale * sphere_pt);
-
-            const float ts = static_cast<float>(s) / static_cast<float>(sector_count);
-            const float tt =
-                    1.0f - (static_cast<float>(ring) / static_cast<float>(band_count));
-            const Vector2 uv = Vector2(ts, tt);
-
-            vertices.append(pos);
-            uvs.append(uv);
+    for (int face_index = 0; face_index < kEacFaceCount; face_index++) {
+        const EacFace &face = kEacFaces[face_index];
+        const int first_face_vertex = static_cast<int>(vertices.size());
+
+        for (size_t row = 0; row < vertices_per_row; row++) {
+            const float y = static_cast<float>(row) / static_cast<float>(face_segment_count);
+            const float cube_y = std::tan((y * 2 - 1) * M_PI / 4.0f);
+            for (size_t col = 0; col < vertices_per_row; col++) {
+                const float x = static_cast<float>(col) / static_cast<float>(face_segment_count);
+                const float cube_x = std::tan((x * 2 - 1) * M_PI / 4.0f);
+                vertices.append(half_size * (face.center + face.right * cube_x + face.up * cube_y));
+                uvs.append(get_eac_frame_uv(face, x, y));
+            }
         }
-    }
-
-    const int ring_offset = static_cast<int>(vertices_per_ring);
-    for (int band = 0; band < band_count; band++) {
-        const int first_band_vertex = static_cast<int>(band * ring_offset);
-        for (int s = 0; s < sector_count; s++) {
-            const int v = static_cast<int>(first_band_vertex + s);
-            indices.append(v);
-            indices.append(v + 1U);
-            indices.append(v + ring_offset);
 
-            indices.append(v + 1U);
-            indices.append(v + ring_offset + 1U);
-            indices.append(v + ring_offset);
+        // Counter-clockwise when seen from inside the cube, like the spherical surface.
+        for (size_t row = 0; row < face_segment_count; row++) {
+            for (size_t col = 0; col < face_segment_count; col++) {
+                const int v = first_face_vertex + static_cast<int>(row * vertices_per_row + col);
+                const int row_offset = static_cast<int>(vertices_per_row);
+                indices.append(v);
+                indices.append(v + 1);
+                indices.append(v + row_offset);
+
+                indices.append(v + 1);
+                indices.append(v + row_offset + 1);
+                indices.append(v + row_offset);
+            }
         }
     }
 
@@ -344,46 +538,301 @@ static inline Array create_spherical_surface_array(
     return arr;
 }
 
-static inline ArrayMesh* create_array_mesh(ArrayMesh *mesh, int num_vertices, float *vertices,
-                                           float *texture_coords, int draw_mode) {
-    Array mesh_array = Array();
-    mesh_array.resize(Mesh::ARRAY_MAX);
-    PoolVector3Array mesh_verts = PoolVector3Array();
-    PoolVector2Array mesh_uvs = PoolVector2Array();
-    for (int i = 0; i < num_vertices; i++) {
-        int vertex_index = i * 3;
-        int uv_index = i * 2;
-        mesh_verts.append(
-                Vector3(vertices[vertex_index], vertices[vertex_index + 1],
-                        vertices[vertex_index + 2]));
-        mesh_uvs.append(
-                Vector2(texture_coords[uv_index], texture_coords[uv_index + 1]));
+/// Returns the compression flags for the given surface arrays. The positions and texture
+/// coordinates are only compressed if doing so keeps the error under a fraction of a texel at
+/// the given texture resolution.
+/// @param texture_size Texture resolution the error is evaluated against, or 0 to disable the
+/// compression of the positions and texture coordinates
+static inline int64_t get_surface_compress_flags(const Array &arrays, int texture_size) {
+    int64_t compress_flags =
+            Mesh::ARRAY_COMPRESS_DEFAULT & ~(Mesh::ARRAY_COMPRESS_TEX_UV
+                                             | Mesh::ARRAY_COMPRESS_TEX_UV2);
+    if (texture_size <= 0 || arrays.size() != Mesh::ARRAY_MAX
+        || arrays[Mesh::ARRAY_VERTEX].get_type() != Variant::POOL_VECTOR3_ARRAY) {
+        return compress_flags;
     }
-    mesh_array[Mesh::ARRAY_VERTEX] = mesh_verts;
-    mesh_array[Mesh::ARRAY_TEX_UV] = mesh_uvs;
-    int64_t primitive;
+
+    PoolVector3Array positions = arrays[Mesh::ARRAY_VERTEX];
+    PoolVector2Array uvs;
+    if (arrays[Mesh::ARRAY_TEX_UV].get_type() == Variant::POOL_VECTOR2_ARRAY) {
+        uvs = arrays[Mesh::ARRAY_TEX_UV];
+    }
+    PoolVector2Array uvs2;
+    if (arrays[Mesh::ARRAY_TEX_UV2].get_type() == Variant::POOL_VECTOR2_ARRAY) {
+        uvs2 = arrays[Mesh::ARRAY_TEX_UV2];
+    }
+    const int vertex_count = positions.size();
+    if (vertex_count == 0) {
+        return compress_flags;
+    }
+
+    // Vector2 and Vector3 are laid out as plain float components.
+    PoolVector3Array::Read positions_read = positions.read();
+    PoolVector2Array::Read uvs_read = uvs.read();
+    PoolVector2Array::Read uvs2_read = uvs2.read();
+    HalfFloatCompression compression = get_half_float_compression(
+            reinterpret_cast<const float *>(positions_read.ptr()),
+            uvs.size() == vertex_count ? reinterpret_cast<const float *>(uvs_read.ptr()) : nullptr,
+            uvs2.size() == vertex_count ? reinterpret_cast<const float *>(uvs2_read.ptr())
+                                        : nullptr,
+            vertex_count, texture_size);
+
+    if (compression.positions) {
+        compress_flags |= Mesh::ARRAY_COMPRESS_VERTEX;
+    }
+    if (compression.uvs) {
+        compress_flags |= Mesh::ARRAY_COMPRESS_TEX_UV;
+    }
+    if (compression.uvs2) {
+        compress_flags |= Mesh::ARRAY_COMPRESS_TEX_UV2;
+    }
+    return compress_flags;
+}
+
+/// Computes the ray parameters of the two intersections of the given ray with the sphere of the
+/// given radius centered on the origin, in ascending order.
+/// @return false if the ray misses the sphere
+static inline bool get_ray_sphere_intersections(const Vector3 &ray_origin,
+                                                const Vector3 &ray_direction, float radius,
+                                                float *near_t, float *far_t) {
+    float a = ray_direction.dot(ray_direction);
+    float b = 2.0f * ray_origin.dot(ray_direction);
+    float c = ray_origin.dot(ray_origin) - radius * radius;
+    float discriminant = b * b - 4.0f * a * c;
+    if (a <= 0 || discriminant < 0) {
+        return false;
+    }
+
+    float root = std::sqrt(discriminant);
+    *near_t = (-b - root) / (2.0f * a);
+    *far_t = (-b + root) / (2.0f * a);
+    return true;
+}
+
+/// Returns the ray parameter of the first intersection, ahead of the ray origin, of the given
+/// ray with the sphere of the given radius centered on the origin, or a negative value if none.
+/// For a ray starting inside the sphere, this is the exit point.
+static inline float intersect_ray_with_sphere(const Vector3 &ray_origin,
+                                              const Vector3 &ray_direction, float radius) {
+    float near_t;
+    float far_t;
+    if (!get_ray_sphere_intersections(ray_origin, ray_direction, radius, &near_t, &far_t)) {
+        return -1.0f;
+    }
+    return near_t >= 0 ? near_t : far_t;
+}
+
+/// Returns the ray parameter of the intersection of the given ray with the given triangle, on
+/// either of its sides, or a negative value if none (Moller-Trumbore).
+static inline float intersect_ray_with_triangle(const Vector3 &ray_origin,
+                                                const Vector3 &ray_direction, const Vector3 &a,
+                                                const Vector3 &b, const Vector3 &c) {
+    Vector3 edge1 = b - a;
+    Vector3 edge2 = c - a;
+    Vector3 p = ray_direction.cross(edge2);
+    float determinant = edge1.dot(p);
+    // The ray is parallel to the triangle, or the triangle is degenerate.
+    if (std::abs(determinant) < CMP_EPSILON * CMP_EPSILON) {
+        return -1.0f;
+    }
+
+    float inverse_determinant = 1.0f / determinant;
+    Vector3 s = ray_origin - a;
+    float u = s.dot(p) * inverse_determinant;
+    if (u < 0 || u > 1) {
+        return -1.0f;
+    }
+
+    Vector3 q = s.cross(edge1);
+    float v = ray_direction.dot(q) * inverse_determinant;
+    if (v < 0 || u + v > 1) {
+        return -1.0f;
+    }
+    return edge2.dot(q) * inverse_determinant;
+}
+
+/// Returns the ray parameter of the first intersection, ahead of the ray origin, of the given
+/// ray with the surface of the given box, or a negative value if none.
+/// For a ray starting inside the box, this is the exit point.
+static inline float intersect_ray_with_box(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                                           const AABB &box) {
+    float near_t = -INFINITY;
+    float far_t = INFINITY;
+    Vector3 box_end = box.position + box.size;
+    for (int axis = 0; axis < 3; axis++) {
+        if (ray_direction[axis] == 0) {
+            if (ray_origin[axis] < box.position[axis] || ray_origin[axis] > box_end[axis]) {
+                return -1.0f;
+            }
+            continue;
+        }
+
+        float t0 = (box.position[axis] - ray_origin[axis]) / ray_direction[axis];
+        float t1 = (box_end[axis] - ray_origin[axis]) / ray_direction[axis];
+        near_t = std::max(near_t, std::min(t0, t1));
+        far_t = std::min(far_t, std::max(t0, t1));
+    }
+
+    if (near_t > far_t) {
+        return -1.0f;
+    }
+    return near_t >= 0 ? near_t : far_t;
+}
+
+/// Surface built off the Godot thread, and swapped into the projection mesh at the next frame.
+struct SurfaceBuild {
+    int64_t primitive = Mesh::PRIMITIVE_TRIANGLES;
+    // Empty arrays clear the mesh.
+    Array arrays;
+    int64_t compress_flags = Mesh::ARRAY_COMPRESS_DEFAULT;
+    // Triangles of the surface's collision shape. Empty if the surface has no collision shape.
+    PoolVector3Array collision_faces;
+    // BVH of the surface's triangles, used by the analytic collisions. Null if the surface is
+    // intersected some other way.
+    std::shared_ptr<const MeshFile> collision_bvh;
+};
+
+/// Returns the Godot primitive type matching the given GL draw mode.
+static inline int64_t get_primitive_type(int draw_mode) {
     switch (draw_mode) {
         case GL_POINTS:
-            primitive = Mesh::PRIMITIVE_POINTS;
-            break;
+            return Mesh::PRIMITIVE_POINTS;
         case GL_LINES:
-            primitive = Mesh::PRIMITIVE_LINES;
-            break;
+            return Mesh::PRIMITIVE_LINES;
         case GL_TRIANGLES:
-            primitive = Mesh::PRIMITIVE_TRIANGLES;
-            break;
+            return Mesh::PRIMITIVE_TRIANGLES;
         case GL_TRIANGLE_FAN:
-            primitive = Mesh::PRIMITIVE_TRIANGLE_FAN;
-            break;
+            return Mesh::PRIMITIVE_TRIANGLE_FAN;
         case GL_TRIANGLE_STRIP:
-            primitive = Mesh::PRIMITIVE_TRIANGLE_STRIP;
-            break;
+            return Mesh::PRIMITIVE_TRIANGLE_STRIP;
         default:
-            primitive = Mesh::PRIMITIVE_TRIANGLES;
+            return Mesh::PRIMITIVE_TRIANGLES;
+    }
+}
+
+/// Returns the triangles of the given surface, three vertices per triangle, as expected by
+/// ConcavePolygonShape. Matches the faces used by Mesh::create_trimesh_shape().
+static inline PoolVector3Array get_collision_faces(int64_t primitive, const Array &arrays) {
+    PoolVector3Array faces;
+    if (arrays.size() != Mesh::ARRAY_MAX
+        || arrays[Mesh::ARRAY_VERTEX].get_type() != Variant::POOL_VECTOR3_ARRAY) {
+        return faces;
+    }
+
+    PoolVector3Array vertices = arrays[Mesh::ARRAY_VERTEX];
+    PoolIntArray indices;
+    if (arrays[Mesh::ARRAY_INDEX].get_type() == Variant::POOL_INT_ARRAY) {
+        indices = arrays[Mesh::ARRAY_INDEX];
+    }
+    bool indexed = indices.size() > 0;
+    int element_count = indexed ? indices.size() : vertices.size();
+
+    int triangle_count = 0;
+    switch (primitive) {
+        case Mesh::PRIMITIVE_TRIANGLES:
+            triangle_count = element_count / 3;
+            break;
+        case Mesh::PRIMITIVE_TRIANGLE_STRIP:
+        case Mesh::PRIMITIVE_TRIANGLE_FAN:
+            triangle_count = std::max(0, element_count - 2);
             break;
+        default:
+            return faces;
+    }
+
+    faces.resize(triangle_count * 3);
+    int face_count = 0;
+    {
+        PoolVector3Array::Read vertices_read = vertices.read();
+        PoolIntArray::Read indices_read = indices.read();
+        PoolVector3Array::Write faces_write = faces.write();
+        int vertex_count = vertices.size();
+        for (int t = 0; t < triangle_count; t++) {
+            int elements[3];
+            if (primitive == Mesh::PRIMITIVE_TRIANGLES) {
+                elements[0] = t * 3;
+                elements[1] = t * 3 + 1;
+                elements[2] = t * 3 + 2;
+            } else if (primitive == Mesh::PRIMITIVE_TRIANGLE_STRIP) {
+                // Every other strip triangle is flipped to keep a consistent winding.
+                elements[0] = t;
+                elements[1] = t % 2 == 0 ? t + 1 : t + 2;
+                elements[2] = t % 2 == 0 ? t + 2 : t + 1;
+            } else {
+                elements[0] = 0;
+                elements[1] = t + 1;
+                elements[2] = t + 2;
+            }
+
+            bool valid = true;
+            for (int k = 0; k < 3 && valid; k++) {
+                int vertex_index = indexed ? indices_read.ptr()[elements[k]] : elements[k];
+                valid = vertex_index >= 0 && vertex_index < vertex_count;
+                if (valid) {
+                    faces_write.ptr()[face_count * 3 + k] = vertices_read.ptr()[vertex_index];
+                }
+            }
+            if (valid) {
+                face_count++;
+            }
+        }
+    }
+    faces.resize(face_count * 3);
+    return faces;
+}
+
+/// Create the surface arrays for the given vertices and texture coordinates.
+/// If provided, texture_coords2 is stored in the surface's UV2 channel, and indices in its
+/// index array.
+static inline Array create_custom_surface_array(int num_vertices, const float *vertices,
+                                                const float *texture_coords,
+                                                const float *texture_coords2 = nullptr,
+                                                int num_indices = 0,
+                                                const int *indices = nullptr) {
+    // The vertex data is copied in bulk into the pool arrays.
+    static_assert(sizeof(Vector3) == 3 * sizeof(float), "Unexpected Vector3 layout");
+    static_assert(sizeof(Vector2) == 2 * sizeof(float), "Unexpected Vector2 layout");
+
+    Array mesh_array = Array();
+    mesh_array.resize(Mesh::ARRAY_MAX);
+    num_vertices = std::max(0, num_vertices);
+
+    PoolVector3Array mesh_verts = PoolVector3Array();
+    mesh_verts.resize(num_vertices);
+    if (num_vertices > 0) {
+        PoolVector3Array::Write write = mesh_verts.write();
+        memcpy(write.ptr(), vertices, num_vertices * sizeof(Vector3));
+    }
+    mesh_array[Mesh::ARRAY_VERTEX] = mesh_verts;
+
+    PoolVector2Array mesh_uvs = PoolVector2Array();
+    mesh_uvs.resize(num_vertices);
+    if (num_vertices > 0) {
+        PoolVector2Array::Write write = mesh_uvs.write();
+        memcpy(write.ptr(), texture_coords, num_vertices * sizeof(Vector2));
+    }
+    mesh_array[Mesh::ARRAY_TEX_UV] = mesh_uvs;
+
+    if (texture_coords2) {
+        PoolVector2Array mesh_uvs2 = PoolVector2Array();
+        mesh_uvs2.resize(num_vertices);
+        if (num_vertices > 0) {
+            PoolVector2Array::Write write = mesh_uvs2.write();
+            memcpy(write.ptr(), texture_coords2, num_vertices * sizeof(Vector2));
+        }
+        mesh_array[Mesh::ARRAY_TEX_UV2] = mesh_uvs2;
+    }
+
+    if (indices && num_indices > 0) {
+        PoolIntArray mesh_indices = PoolIntArray();
+        mesh_indices.resize(num_indices);
+        {
+            PoolIntArray::Write write = mesh_indices.write();
+            memcpy(write.ptr(), indices, num_indices * sizeof(int));
+        }
+        mesh_array[Mesh::ARRAY_INDEX] = mesh_indices;
     }
-    mesh->add_surface_from_arrays(primitive, mesh_array);
-    return mesh;
+    return mesh_array;
 }
 
 }  // namespace gast
@@ -1,18 +1,25 @@
+#include <core/AABB.hpp>
 #include <gen/ArrayMesh.hpp>
 #include <gen/Mesh.hpp>
+#include <gen/MeshInstance.hpp>
 #include <gen/QuadMesh.hpp>
-#include <gen/Shader.hpp>
 #include <gen/Shape.hpp>
 #include <utils.h>
 
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
 #include "projection_mesh_utils.h"
 #include "rectangular_projection_mesh.h"
 
 namespace gast {
 
 namespace {
-const float kCurvedScreenRadius = 6.0f;
-const size_t kCurvedScreenResolution = 20;
+const float kMinCurveRadius = 0.01f;
+const float kMinMaxChordError = 0.00001f;
+// Maximum number of curved screen levels of detail. Each level halves the segment count of the
+// next finer one.
+const size_t kMaxCurvedScreenLodCount = 4;
+const size_t kMinCurvedScreenSegmentCount = 2;
 const bool kDefaultCurveValue = false;
 const int kMeshIndex = 0;
 const int kMeshCount = 1;
@@ -22,7 +29,10 @@ RectangularProjectionMesh::RectangularProjectionMesh(Vector2 mesh_size, bool is_
         ProjectionMesh(ProjectionMesh::ProjectionMeshType::RECTANGULAR) {
     this->mesh_size = mesh_size;
     this->is_curved = is_curved;
+    this->curve_radius = kDefaultCurveRadius;
+    this->max_chord_error = kDefaultMaxChordError;
     this->gradient_height_ratio = kDefaultGradientHeightRatio;
+    this->curved_lod_level = -1;
 }
 
 RectangularProjectionMesh::RectangularProjectionMesh():
@@ -41,6 +51,10 @@ void RectangularProjectionMesh::_register_methods() {
     register_method("get_size", &RectangularProjectionMesh::get_mesh_size);
     register_method("set_curved", &RectangularProjectionMesh::set_curved);
     register_method("is_curved", &RectangularProjectionMesh::get_curved);
+    register_method("set_curve_radius", &RectangularProjectionMesh::set_curve_radius);
+    register_method("get_curve_radius", &RectangularProjectionMesh::get_curve_radius);
+    register_method("set_max_chord_error", &RectangularProjectionMesh::set_max_chord_error);
+    register_method("get_max_chord_error", &RectangularProjectionMesh::get_max_chord_error);
     register_method("set_gradient_height_ratio",
             &RectangularProjectionMesh::set_gradient_height_ratio);
     register_method("get_gradient_height_ratio",
@@ -52,35 +66,118 @@ void RectangularProjectionMesh::_register_methods() {
     register_property<RectangularProjectionMesh, bool>("curved",
             &RectangularProjectionMesh::set_curved, &RectangularProjectionMesh::get_curved,
             kDefaultCurveValue);
+    register_property<RectangularProjectionMesh, float>("curve_radius",
+            &RectangularProjectionMesh::set_curve_radius,
+            &RectangularProjectionMesh::get_curve_radius, kDefaultCurveRadius);
+    register_property<RectangularProjectionMesh, float>("max_chord_error",
+            &RectangularProjectionMesh::set_max_chord_error,
+            &RectangularProjectionMesh::get_max_chord_error, kDefaultMaxChordError);
     register_property<RectangularProjectionMesh, float>("gradient_height_ratio",
                                        &RectangularProjectionMesh::set_gradient_height_ratio,
                                        &RectangularProjectionMesh::get_gradient_height_ratio,
                                        kDefaultGradientHeightRatio);
 }
 
+Ref<ArrayMesh> RectangularProjectionMesh::get_curved_lod_mesh(int level) {
+    if (curved_lod_meshes[level].is_null()) {
+        size_t segment_count = curved_lod_segment_counts[level];
+        uint64_t key = MeshCache::get_key(
+                "curved_screen",
+                {mesh_size.x, mesh_size.y, curve_radius, static_cast<double>(segment_count)});
+        Array arrays = MeshCache::get_surface_arrays(key, [this, segment_count] {
+            Array arrays = create_curved_screen_surface_array(mesh_size, curve_radius,
+                                                              segment_count);
+            MeshOptimizer::optimize_surface_arrays(arrays);
+            return arrays;
+        });
+
+        ArrayMesh *mesh = ArrayMesh::_new();
+        mesh->add_surface_from_arrays(
+                Mesh::PRIMITIVE_TRIANGLES, arrays, Array(),
+                get_surface_compress_flags(arrays, get_vertex_compression_texture_size()));
+        curved_lod_meshes[level] = Ref<ArrayMesh>(mesh);
+    }
+    return curved_lod_meshes[level];
+}
+
 void RectangularProjectionMesh::update_projection_mesh() {
-    ArrayMesh *mesh = ArrayMesh::_new();
+    // The level of detail meshes are stale.
+    curved_lod_segment_counts.clear();
+    curved_lod_meshes.clear();
+
     if (is_curved) {
-        mesh->add_surface_from_arrays(
-                Mesh::PRIMITIVE_TRIANGLES,
-                create_curved_screen_surface_array(
-                        mesh_size, kCurvedScreenRadius, kCurvedScreenResolution));
-        set_collision_shape(kMeshIndex, mesh->create_trimesh_shape());
+        size_t segment_count = get_curved_screen_segment_count(mesh_size.x, curve_radius,
+                                                               max_chord_error);
+        curved_lod_segment_counts.push_back(segment_count);
+        while (curved_lod_segment_counts.size() < kMaxCurvedScreenLodCount
+               && segment_count > kMinCurvedScreenSegmentCount) {
+            segment_count = std::max(kMinCurvedScreenSegmentCount, (segment_count + 1) / 2);
+            curved_lod_segment_counts.insert(curved_lod_segment_counts.begin(), segment_count);
+        }
+        curved_lod_meshes.resize(curved_lod_segment_counts.size());
+
+        // Start from the finest level, the level of detail pass coarsens it if possible.
+        int finest_level = static_cast<int>(curved_lod_segment_counts.size()) - 1;
+        curved_lod_level = finest_level;
+        set_mesh(kMeshIndex, get_curved_lod_mesh(curved_lod_level));
+        // The collision shape doesn't change with the level of detail to avoid rebuilding it.
+        set_collision_shape(kMeshIndex, get_curved_lod_mesh(finest_level)->create_trimesh_shape());
     } else {
+        ArrayMesh *mesh = ArrayMesh::_new();
         QuadMesh *quad_mesh = QuadMesh::_new();
         quad_mesh->set_size(mesh_size);
-        mesh->add_surface_from_arrays(Mesh::PRIMITIVE_TRIANGLES, quad_mesh->get_mesh_arrays());
+        Array arrays = quad_mesh->get_mesh_arrays();
+        mesh->add_surface_from_arrays(
+                Mesh::PRIMITIVE_TRIANGLES, arrays, Array(),
+                get_surface_compress_flags(arrays, get_vertex_compression_texture_size()));
         set_collision_shape(kMeshIndex, mesh->create_convex_shape());
+        set_mesh(kMeshIndex, mesh);
     }
-    set_mesh(kMeshIndex, mesh);
-
-    Shader *shader = Shader::_new();
-    shader->set_custom_defines(kShaderCustomDefines);
-    shader->set_code(generate_shader_code());
-    set_shader(kMeshIndex, shader);
     update_sampling_transforms();
 }
 
+void RectangularProjectionMesh::update_level_of_detail(const Vector3 &camera_origin,
+                                                       const Vector3 &camera_forward,
+                                                       float focal_length) {
+    if (!is_curved || curved_lod_meshes.empty() || mesh_size.x <= 0 || focal_length <= 0) {
+        return;
+    }
+
+    MeshInstance *mesh_instance = get_mesh_instance(kMeshIndex);
+    if (!mesh_instance || !mesh_instance->is_inside_tree()) {
+        return;
+    }
+
+    // Distance from the camera to the closest point of the mesh bounds.
+    Transform mesh_transform = mesh_instance->get_global_transform();
+    AABB global_aabb = mesh_transform.xform(mesh_instance->get_aabb());
+    Vector3 aabb_end = global_aabb.position + global_aabb.size;
+    Vector3 closest_point = Vector3(
+            CLAMP(camera_origin.x, global_aabb.position.x, aabb_end.x),
+            CLAMP(camera_origin.y, global_aabb.position.y, aabb_end.y),
+            CLAMP(camera_origin.z, global_aabb.position.z, aabb_end.z));
+    float distance = camera_origin.distance_to(closest_point);
+
+    Vector3 scale = mesh_transform.basis.get_scale();
+    float radius = curve_radius * std::max(scale.x, scale.z);
+    float horizontal_angle = 2.0f * std::atan(mesh_size.x * 0.5f / curve_radius);
+
+    std::vector<float> level_errors(curved_lod_segment_counts.size(), INFINITY);
+    if (distance > CMP_EPSILON) {
+        for (size_t i = 0; i < curved_lod_segment_counts.size(); i++) {
+            float segment_angle = horizontal_angle / curved_lod_segment_counts[i];
+            level_errors[i] = get_chord_error(radius, segment_angle) * focal_length / distance;
+        }
+    }
+
+    int level = select_level_of_detail(level_errors, curved_lod_level);
+    if (level == curved_lod_level) {
+        return;
+    }
+    curved_lod_level = level;
+    set_mesh(kMeshIndex, get_curved_lod_mesh(curved_lod_level));
+}
+
 void RectangularProjectionMesh::set_mesh_size(Vector2 size) {
     if (this->mesh_size == size) {
         return;
@@ -94,6 +191,17 @@ inline bool RectangularProjectionMesh::should_use_alpha_shader_code() {
            || (gradient_height_ratio >= kGradientHeightRatioThreshold);
 }
 
+ShaderVariant RectangularProjectionMesh::get_shader_variant(int mesh_index) {
+    ShaderVariant variant = ProjectionMesh::get_shader_variant(mesh_index);
+    variant.gradient = gradient_height_ratio >= kGradientHeightRatioThreshold;
+    variant.use_highp_precision = false;
+    return variant;
+}
+
+bool RectangularProjectionMesh::is_opaque() const {
+    return ProjectionMesh::is_opaque() && gradient_height_ratio < kGradientHeightRatioThreshold;
+}
+
 Vector2 RectangularProjectionMesh::get_relative_collision_point(Vector3 local_collision_point) {
     Vector2 relative_collision_point = kInvalidCoordinate;
 
@@ -114,6 +222,57 @@ Vector2 RectangularProjectionMesh::get_relative_collision_point(Vector3 local_co
     return relative_collision_point;
 }
 
+bool RectangularProjectionMesh::intersects_ray(const Vector3 &ray_origin,
+                                               const Vector3 &ray_direction,
+                                               Vector3 *intersection) {
+    if (mesh_size.x <= 0 || mesh_size.y <= 0) {
+        return false;
+    }
+
+    float t = -1;
+    if (is_curved) {
+        // The curved screen is an arc of a vertical cylinder, whose axis is behind the screen's
+        // center. Only the front side of the cylinder is part of the screen.
+        float horizontal_angle = 2.0f * std::atan(mesh_size.x * 0.5f / curve_radius);
+        Vector3 axis_position = Vector3(0, 0, curve_radius * std::cos(horizontal_angle / 4.0f));
+        Vector3 origin = ray_origin - axis_position;
+        float a = ray_direction.x * ray_direction.x + ray_direction.z * ray_direction.z;
+        float b = 2.0f * (origin.x * ray_direction.x + origin.z * ray_direction.z);
+        float c = origin.x * origin.x + origin.z * origin.z - curve_radius * curve_radius;
+        float discriminant = b * b - 4.0f * a * c;
+        if (a <= 0 || discriminant < 0) {
+            return false;
+        }
+
+        float root = std::sqrt(discriminant);
+        for (float candidate_t : {(-b - root) / (2.0f * a), (-b + root) / (2.0f * a)}) {
+            Vector3 point = origin + ray_direction * candidate_t;
+            float angle = std::atan2(point.x, -point.z);
+            if (candidate_t >= 0 && std::abs(angle) <= horizontal_angle / 2.0f
+                && std::abs(point.y) <= mesh_size.y / 2.0f) {
+                t = candidate_t;
+                break;
+            }
+        }
+    } else {
+        // The flat screen lies in the z = 0 plane.
+        if (ray_direction.z == 0) {
+            return false;
+        }
+        t = -ray_origin.z / ray_direction.z;
+        Vector3 point = ray_origin + ray_direction * t;
+        if (std::abs(point.x) > mesh_size.x / 2.0f || std::abs(point.y) > mesh_size.y / 2.0f) {
+            return false;
+        }
+    }
+
+    if (t < 0) {
+        return false;
+    }
+    *intersection = ray_origin + ray_direction * t;
+    return true;
+}
+
 void RectangularProjectionMesh::set_curved(bool is_curved) {
     if (this->is_curved == is_curved) {
         return;
@@ -122,12 +281,35 @@ void RectangularProjectionMesh::set_curved(bool is_curved) {
     update_projection_mesh();
 }
 
+void RectangularProjectionMesh::set_curve_radius(float radius) {
+    radius = std::max(kMinCurveRadius, radius);
+    if (this->curve_radius == radius) {
+        return;
+    }
+    this->curve_radius = radius;
+    if (is_curved) {
+        update_projection_mesh();
+    }
+}
+
+void RectangularProjectionMesh::set_max_chord_error(float max_chord_error) {
+    max_chord_error = std::max(kMinMaxChordError, max_chord_error);
+    if (this->max_chord_error == max_chord_error) {
+        return;
+    }
+    this->max_chord_error = max_chord_error;
+    if (is_curved) {
+        update_projection_mesh();
+    }
+}
+
 void RectangularProjectionMesh::set_gradient_height_ratio(float ratio) {
     if (this->gradient_height_ratio == ratio) {
         return;
     }
     this->gradient_height_ratio = std::min(1.0f, std::max(0.0f, ratio));
     update_shaders_param(kGastGradientHeightRatioParamName, gradient_height_ratio);
+    update_shader_code();
 }
 
 int RectangularProjectionMesh::get_mesh_count() const {
@@ -143,6 +325,8 @@ void RectangularProjectionMesh::update_properties(ProjectionMesh *projection_mes
                 projection_mesh);
 
         set_gradient_height_ratio(rectangular_projection_mesh->get_gradient_height_ratio());
+        set_curve_radius(rectangular_projection_mesh->get_curve_radius());
+        set_max_chord_error(rectangular_projection_mesh->get_max_chord_error());
         set_curved(rectangular_projection_mesh->is_curved);
         set_mesh_size(rectangular_projection_mesh->get_mesh_size());
     }
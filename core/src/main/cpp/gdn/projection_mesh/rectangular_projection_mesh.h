@@ -1,7 +1,10 @@
 #ifndef RECTANGULAR_PROJECTION_MESH_H
 #define RECTANGULAR_PROJECTION_MESH_H
 
+#include <core/Ref.hpp>
 #include <core/Vector2.hpp>
+#include <gen/ArrayMesh.hpp>
+#include <vector>
 
 #include "projection_mesh.h"
 
@@ -11,6 +14,10 @@ namespace {
 using namespace godot;
 const Vector2 kDefaultMeshSize = Vector2(0.0, 0.0);
 const float kDefaultGradientHeightRatio = 0.0f;
+const float kDefaultCurveRadius = 6.0f;
+// Maximum distance between the curved screen mesh and the cylinder it approximates, in mesh
+// units.
+const float kDefaultMaxChordError = 0.001f;
 }
 
 class RectangularProjectionMesh : public ProjectionMesh {
@@ -37,8 +44,23 @@ public:
         return this->is_curved;
     }
 
+    void set_curve_radius(float radius);
+
+    inline float get_curve_radius() {
+        return curve_radius;
+    }
+
+    void set_max_chord_error(float max_chord_error);
+
+    inline float get_max_chord_error() {
+        return max_chord_error;
+    }
+
     Vector2 get_relative_collision_point(Vector3 local_collision_point) override;
 
+    bool intersects_ray(const Vector3 &ray_origin, const Vector3 &ray_direction,
+                        Vector3 *intersection) override;
+
     inline float get_gradient_height_ratio() {
         return gradient_height_ratio;
     }
@@ -47,17 +69,35 @@ public:
 
     int get_mesh_count() const override;
 
+    bool is_opaque() const override;
+
+    void update_level_of_detail(const Vector3 &camera_origin, const Vector3 &camera_forward,
+                                float focal_length) override;
+
     void update_properties(ProjectionMesh *projection_mesh) override;
 
 protected:
     bool should_use_alpha_shader_code() override;
 
+    ShaderVariant get_shader_variant(int mesh_index) override;
+
     void update_projection_mesh() override;
 
 private:
+    // Returns the curved screen mesh for the given level of detail, generating it on first use.
+    Ref<ArrayMesh> get_curved_lod_mesh(int level);
+
     Vector2 mesh_size;
     bool is_curved;
+    float curve_radius;
+    float max_chord_error;
     float gradient_height_ratio;
+    // Horizontal segment count of each curved screen level of detail, from the coarsest to the
+    // finest. The finest level honors the max chord error.
+    std::vector<size_t> curved_lod_segment_counts;
+    // Curved screen meshes for each level of detail. Regenerated when the mesh is updated.
+    std::vector<Ref<ArrayMesh>> curved_lod_meshes;
+    int curved_lod_level;
 };
 
 }  // namespace gast
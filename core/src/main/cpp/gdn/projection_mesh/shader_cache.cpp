@@ -0,0 +1,31 @@
+#include "shader_cache.h"
+
+#include <core/String.hpp>
+
+namespace gast {
+
+std::map<int, Ref<Shader>> ShaderCache::shaders_;
+
+Ref<Shader> ShaderCache::get_shader(const ShaderVariant &variant) {
+    int key = variant.get_key();
+    auto it = shaders_.find(key);
+    if (it != shaders_.end()) {
+        return it->second;
+    }
+
+    Ref<Shader> shader = Ref<Shader>(Shader::_new());
+    String custom_defines = kShaderCustomDefines;
+    if (variant.use_highp_precision) {
+        custom_defines += kShaderHighpFloatDefines;
+    }
+    shader->set_custom_defines(custom_defines);
+    shader->set_code(get_base_shader_code(variant));
+    shaders_[key] = shader;
+    return shader;
+}
+
+void ShaderCache::clear() {
+    shaders_.clear();
+}
+
+}  // namespace gast
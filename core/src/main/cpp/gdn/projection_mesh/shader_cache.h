@@ -0,0 +1,32 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <core/Ref.hpp>
+#include <gen/Shader.hpp>
+#include <map>
+
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}  // namespace
+
+/// Shares the projection mesh shaders between all the meshes using the same shader variant,
+/// so that each variant is only generated and compiled once.
+class ShaderCache {
+public:
+    /// Returns the shader for the given variant, generating it on first use.
+    static Ref<Shader> get_shader(const ShaderVariant &variant);
+
+    /// Release the cached shaders.
+    static void clear();
+
+private:
+    static std::map<int, Ref<Shader>> shaders_;
+};
+
+}  // namespace gast
+
+#endif // SHADER_CACHE_H
@@ -0,0 +1,111 @@
+#ifndef SPHERICAL_SURFACE_H
+#define SPHERICAL_SURFACE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "surface_geometry.h"
+
+namespace gast {
+
+/// Distribution of the vertices of a spherical surface.
+/// The vertex density varies from (1 + foveation) at the center to (1 - foveation) at the
+/// edges of each axis, with foveation in [0, 1). 0 spaces the vertices uniformly.
+struct SphericalTessellation {
+    // Concentrates the bands near the equator.
+    float latitude_foveation = 0.0f;
+    // Concentrates the sectors near the center longitude.
+    float longitude_foveation = 0.0f;
+    // Longitude with the highest sector density, in radians from the -z axis towards +x.
+    float center_longitude = 0.0f;
+};
+
+/// Returns the angle at the given fraction of the [start, end] range, for a vertex density
+/// proportional to 1 + foveation * cos(frequency * (angle - center)).
+static inline float get_foveated_angle(float fraction, float start, float end, float foveation,
+                                       float frequency, float center) {
+    const float linear_angle = start + fraction * (end - start);
+    if (foveation <= 0 || fraction <= 0 || fraction >= 1) {
+        return linear_angle;
+    }
+
+    // Invert the cumulative distribution of the density with a few Newton iterations.
+    auto cumulative = [&](float angle) {
+        return (angle - start) + foveation / frequency
+                                 * (std::sin(frequency * (angle - center))
+                                    - std::sin(frequency * (start - center)));
+    };
+    const float target = fraction * cumulative(end);
+    float angle = linear_angle;
+    for (int i = 0; i < 8; i++) {
+        float density = 1.0f + foveation * std::cos(frequency * (angle - center));
+        angle = std::min(std::max(angle - (cumulative(angle) - target) / density, start), end);
+    }
+    return angle;
+}
+
+/// Generates a sphere, or a section of a sphere centered on the -z axis.
+/// @param longitude_range Horizontal angle covered by the surface, in degrees
+/// @param tessellation Distribution of the bands and sectors
+static inline SurfaceGeometry generate_spherical_surface(
+        float size, size_t band_count, size_t sector_count, float longitude_range = 360.f,
+        const SphericalTessellation &tessellation = SphericalTessellation()) {
+    float degrees_to_radians = M_PI / 180.0f;
+    float longitude_start = -0.5f * longitude_range * degrees_to_radians;
+    float longitude_end = 0.5f * longitude_range * degrees_to_radians;
+    float latitude_start = -90.f * degrees_to_radians;
+    float latitude_end = 90.f * degrees_to_radians;
+    band_count = std::max(static_cast<size_t>(2), band_count);
+    sector_count = std::max(static_cast<size_t>(3), sector_count);
+
+    const size_t vertices_per_ring = sector_count + 1;
+    const size_t vertices_per_band = band_count + 1;
+
+    SurfaceGeometry surface;
+    surface.positions.reserve(vertices_per_band * vertices_per_ring * 3);
+    surface.uvs.reserve(vertices_per_band * vertices_per_ring * 2);
+    surface.indices.reserve(band_count * sector_count * 6);
+
+    const float scale = 0.5f * size;
+
+    for (size_t ring = 0; ring < vertices_per_band; ring++) {
+        const float latitude_angle = get_foveated_angle(
+                static_cast<float>(ring) / static_cast<float>(band_count), latitude_start,
+                latitude_end, tessellation.latitude_foveation, 2.0f, 0.0f);
+        const float ring_radius = cosf(latitude_angle);
+        const float sphere_y = sinf(latitude_angle);
+
+        for (size_t s = 0; s < vertices_per_ring; s++) {
+            const float radians = get_foveated_angle(
+                    static_cast<float>(s) / static_cast<float>(sector_count), longitude_start,
+                    longitude_end, tessellation.longitude_foveation, 1.0f,
+                    tessellation.center_longitude);
+            surface.positions.push_back(scale * (ring_radius * sinf(radians)));
+            surface.positions.push_back(scale * sphere_y);
+            surface.positions.push_back(scale * (ring_radius * -cosf(radians)));
+
+            surface.uvs.push_back((radians - longitude_start) / (longitude_end - longitude_start));
+            surface.uvs.push_back(1.0f - (latitude_angle - latitude_start)
+                                         / (latitude_end - latitude_start));
+        }
+    }
+
+    const int ring_offset = static_cast<int>(vertices_per_ring);
+    for (size_t band = 0; band < band_count; band++) {
+        const int first_band_vertex = static_cast<int>(band) * ring_offset;
+        for (size_t s = 0; s < sector_count; s++) {
+            const int v = first_band_vertex + static_cast<int>(s);
+            surface.indices.insert(surface.indices.end(), {v, v + 1, v + ring_offset});
+            surface.indices.insert(surface.indices.end(),
+                                   {v + 1, v + ring_offset + 1, v + ring_offset});
+        }
+    }
+
+    return surface;
+}
+
+}  // namespace gast
+
+#endif // SPHERICAL_SURFACE_H
@@ -0,0 +1,560 @@
+#include "spherical_video_parser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <gen/Mesh.hpp>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+#include "utils.h"
+
+namespace gast {
+
+namespace {
+constexpr uint32_t get_box_type(const char (&name)[5]) {
+    return (uint32_t(uint8_t(name[0])) << 24) | (uint32_t(uint8_t(name[1])) << 16)
+           | (uint32_t(uint8_t(name[2])) << 8) | uint32_t(uint8_t(name[3]));
+}
+
+const uint32_t kMoovBox = get_box_type("moov");
+const uint32_t kTrakBox = get_box_type("trak");
+const uint32_t kMdiaBox = get_box_type("mdia");
+const uint32_t kHdlrBox = get_box_type("hdlr");
+const uint32_t kMinfBox = get_box_type("minf");
+const uint32_t kStblBox = get_box_type("stbl");
+const uint32_t kStsdBox = get_box_type("stsd");
+const uint32_t kSt3dBox = get_box_type("st3d");
+const uint32_t kSv3dBox = get_box_type("sv3d");
+const uint32_t kProjBox = get_box_type("proj");
+const uint32_t kPrhdBox = get_box_type("prhd");
+const uint32_t kEquiBox = get_box_type("equi");
+const uint32_t kCbmpBox = get_box_type("cbmp");
+const uint32_t kMshpBox = get_box_type("mshp");
+const uint32_t kMeshBox = get_box_type("mesh");
+const uint32_t kVideoHandler = get_box_type("vide");
+const uint32_t kRawEncoding = get_box_type("raw ");
+const uint32_t kDeflateEncoding = get_box_type("dfl8");
+
+// Version and flags of the full boxes.
+const size_t kFullBoxHeaderSize = 4;
+// Fields of a VisualSampleEntry preceding its child boxes.
+const uint64_t kVisualSampleEntrySize = 78;
+// Bounds on the projection mesh sizes, to reject corrupted files before allocating.
+const uint64_t kMaxMshpBoxSize = 16 * 1024 * 1024;
+const size_t kMaxInflatedMeshSize = 64 * 1024 * 1024;
+// Stereo modes of the 'st3d' box.
+const uint8_t kSt3dTopBottom = 1;
+const uint8_t kSt3dLeftRight = 2;
+// Vertex list index types of the 'mesh' box.
+const uint8_t kTriangles = 0;
+const uint8_t kTriangleStrip = 1;
+const uint8_t kTriangleFan = 2;
+// The counts of the 'mesh' box are 31 bits, preceded by a reserved bit.
+const uint32_t kMeshCountMask = 0x7FFFFFFF;
+
+struct Box {
+    uint32_t type;
+    // Offset of the box's content, after its header.
+    uint64_t content_offset;
+    uint64_t end;
+};
+
+uint32_t read_uint32(const uint8_t *data) {
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8)
+           | uint32_t(data[3]);
+}
+
+// Iterates over the sibling boxes in a range.
+class BoxIterator {
+public:
+    BoxIterator(const std::function<bool(uint64_t, uint8_t *, size_t)> &read, uint64_t begin,
+                uint64_t end) : read_(read), position_(begin), end_(end) {}
+
+    // Returns false once the range is exhausted, or if the next box is malformed.
+    bool next(Box *box) {
+        uint8_t header[16];
+        if (position_ > end_ || end_ - position_ < 8 || !read_(position_, header, 8)) {
+            return false;
+        }
+
+        uint64_t size = read_uint32(header);
+        uint64_t header_size = 8;
+        if (size == 1) {
+            // 64 bits size.
+            if (end_ - position_ < 16 || !read_(position_ + 8, header + 8, 8)) {
+                return false;
+            }
+            size = (uint64_t(read_uint32(header + 8)) << 32) | read_uint32(header + 12);
+            header_size = 16;
+        } else if (size == 0) {
+            // The box extends to the end of its parent.
+            size = end_ - position_;
+        }
+        if (size < header_size || size > end_ - position_) {
+            return false;
+        }
+
+        box->type = read_uint32(header + 4);
+        box->content_offset = position_ + header_size;
+        box->end = position_ + size;
+        position_ += size;
+        return true;
+    }
+
+private:
+    const std::function<bool(uint64_t, uint8_t *, size_t)> &read_;
+    uint64_t position_;
+    uint64_t end_;
+};
+
+bool find_box(const std::function<bool(uint64_t, uint8_t *, size_t)> &read, uint64_t begin,
+              uint64_t end, uint32_t type, Box *box) {
+    BoxIterator iterator(read, begin, end);
+    while (iterator.next(box)) {
+        if (box->type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads the bit fields of the 'mesh' box, most significant bit first.
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t size) : data_(data), bit_size_(uint64_t(size) * 8),
+                                                  bit_position_(0) {}
+
+    bool read(int bit_count, uint32_t *value) {
+        if (bit_count > 32 || uint64_t(bit_count) > get_remaining_bits()) {
+            return false;
+        }
+
+        uint64_t result = 0;
+        while (bit_count > 0) {
+            int bit_offset = static_cast<int>(bit_position_ & 7);
+            int available_bits = 8 - bit_offset;
+            int bits = std::min(available_bits, bit_count);
+            uint32_t byte = data_[bit_position_ >> 3];
+            result = (result << bits) | ((byte >> (available_bits - bits)) & ((1U << bits) - 1));
+            bit_count -= bits;
+            bit_position_ += bits;
+        }
+        *value = static_cast<uint32_t>(result);
+        return true;
+    }
+
+    void align_to_byte() {
+        bit_position_ = std::min(bit_size_, (bit_position_ + 7) & ~uint64_t(7));
+    }
+
+    uint64_t get_remaining_bits() const {
+        return bit_size_ - bit_position_;
+    }
+
+private:
+    const uint8_t *data_;
+    uint64_t bit_size_;
+    uint64_t bit_position_;
+};
+
+int32_t decode_zigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+// Returns the size in bits of the zigzag coded deltas between indices in [0, count), i.e.
+// ceil(log2(count * 2)).
+int get_delta_bit_count(uint32_t count) {
+    int bit_count = 0;
+    while ((uint64_t(1) << bit_count) < uint64_t(count) * 2) {
+        bit_count++;
+    }
+    return bit_count;
+}
+
+// Appends the triangles of the given vertex list to the given triangle list indices.
+bool append_triangles(uint8_t index_type, const std::vector<int> &list,
+                      std::vector<int> *indices) {
+    int count = static_cast<int>(list.size());
+    switch (index_type) {
+        case kTriangles:
+            indices->insert(indices->end(), list.begin(), list.begin() + count / 3 * 3);
+            return true;
+        case kTriangleStrip:
+            // Every other strip triangle is flipped to keep a consistent winding.
+            for (int t = 0; t + 2 < count; t++) {
+                indices->push_back(list[t]);
+                indices->push_back(list[t % 2 == 0 ? t + 1 : t + 2]);
+                indices->push_back(list[t % 2 == 0 ? t + 2 : t + 1]);
+            }
+            return true;
+        case kTriangleFan:
+            for (int t = 0; t + 2 < count; t++) {
+                indices->push_back(list[0]);
+                indices->push_back(list[t + 1]);
+                indices->push_back(list[t + 2]);
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Decodes the content of a 'mesh' box into indexed triangle list surface arrays.
+bool decode_mesh(const uint8_t *data, size_t size, Array *arrays) {
+    BitReader reader(data, size);
+
+    uint32_t coordinate_count;
+    if (!reader.read(32, &coordinate_count)) {
+        return false;
+    }
+    coordinate_count &= kMeshCountMask;
+    if (coordinate_count == 0 || uint64_t(coordinate_count) * 32 > reader.get_remaining_bits()) {
+        return false;
+    }
+    std::vector<float> coordinates(coordinate_count);
+    for (uint32_t i = 0; i < coordinate_count; i++) {
+        uint32_t bits;
+        reader.read(32, &bits);
+        memcpy(&coordinates[i], &bits, sizeof(float));
+    }
+
+    uint32_t vertex_count;
+    if (!reader.read(32, &vertex_count)) {
+        return false;
+    }
+    vertex_count &= kMeshCountMask;
+    int coordinate_bit_count = get_delta_bit_count(coordinate_count);
+    if (vertex_count == 0
+        || uint64_t(vertex_count) * 5 * coordinate_bit_count > reader.get_remaining_bits()) {
+        return false;
+    }
+
+    // The vertices are decoded straight into the surface arrays.
+    PoolVector3Array positions;
+    PoolVector2Array uvs;
+    positions.resize(vertex_count);
+    uvs.resize(vertex_count);
+    {
+        PoolVector3Array::Write positions_write = positions.write();
+        PoolVector2Array::Write uvs_write = uvs.write();
+        // Each of the x, y, z, u and v coordinates is delta coded against the same coordinate
+        // of the previous vertex.
+        int64_t coordinate_indices[5] = {};
+        float values[5];
+        for (uint32_t v = 0; v < vertex_count; v++) {
+            for (int c = 0; c < 5; c++) {
+                uint32_t delta;
+                reader.read(coordinate_bit_count, &delta);
+                coordinate_indices[c] += decode_zigzag(delta);
+                if (coordinate_indices[c] < 0 || coordinate_indices[c] >= coordinate_count) {
+                    return false;
+                }
+                values[c] = coordinates[coordinate_indices[c]];
+            }
+            positions_write.ptr()[v] = Vector3(values[0], values[1], values[2]);
+            uvs_write.ptr()[v] = Vector2(values[3], values[4]);
+        }
+    }
+    reader.align_to_byte();
+
+    uint32_t vertex_list_count;
+    if (!reader.read(32, &vertex_list_count)) {
+        return false;
+    }
+    vertex_list_count &= kMeshCountMask;
+    int vertex_bit_count = get_delta_bit_count(vertex_count);
+    std::vector<int> indices;
+    std::vector<int> list;
+    for (uint32_t l = 0; l < vertex_list_count; l++) {
+        uint32_t texture_id;
+        uint32_t index_type;
+        uint32_t index_count;
+        if (!reader.read(8, &texture_id) || !reader.read(8, &index_type)
+            || !reader.read(32, &index_count)) {
+            return false;
+        }
+        index_count &= kMeshCountMask;
+        if (uint64_t(index_count) * vertex_bit_count > reader.get_remaining_bits()) {
+            return false;
+        }
+
+        list.resize(index_count);
+        int64_t index = 0;
+        for (uint32_t i = 0; i < index_count; i++) {
+            uint32_t delta;
+            reader.read(vertex_bit_count, &delta);
+            index += decode_zigzag(delta);
+            if (index < 0 || index >= vertex_count) {
+                return false;
+            }
+            list[i] = static_cast<int>(index);
+        }
+        reader.align_to_byte();
+
+        // The projection meshes sample a single texture.
+        if (texture_id != 0) {
+            ALOGW("Skipping projection mesh vertex list for texture %u.", texture_id);
+            continue;
+        }
+        if (!append_triangles(static_cast<uint8_t>(index_type), list, &indices)) {
+            ALOGW("Skipping projection mesh vertex list of unknown type %u.", index_type);
+        }
+    }
+    if (indices.empty()) {
+        return false;
+    }
+
+    PoolIntArray mesh_indices;
+    mesh_indices.resize(static_cast<int>(indices.size()));
+    {
+        PoolIntArray::Write write = mesh_indices.write();
+        memcpy(write.ptr(), indices.data(), indices.size() * sizeof(int));
+    }
+
+    arrays->clear();
+    arrays->resize(Mesh::ARRAY_MAX);
+    (*arrays)[Mesh::ARRAY_VERTEX] = positions;
+    (*arrays)[Mesh::ARRAY_TEX_UV] = uvs;
+    (*arrays)[Mesh::ARRAY_INDEX] = mesh_indices;
+    return true;
+}
+
+// Inflates the given raw deflate stream.
+bool inflate_raw(const uint8_t *data, size_t size, std::vector<uint8_t> *output) {
+    z_stream stream = {};
+    // Negative window bits for a raw deflate stream, without zlib header.
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        return false;
+    }
+
+    stream.next_in = const_cast<Bytef *>(data);
+    stream.avail_in = static_cast<uInt>(size);
+    output->resize(std::min(kMaxInflatedMeshSize, std::max(size * 4, size_t(4096))));
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (stream.total_out == output->size()) {
+            if (output->size() >= kMaxInflatedMeshSize) {
+                break;
+            }
+            output->resize(std::min(kMaxInflatedMeshSize, output->size() * 2));
+        }
+        stream.next_out = output->data() + stream.total_out;
+        stream.avail_out = static_cast<uInt>(output->size() - stream.total_out);
+        result = inflate(&stream, Z_NO_FLUSH);
+    }
+    output->resize(stream.total_out);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+// Decodes the content of a 'mshp' box into the metadata's mesh surfaces.
+bool decode_mshp(const uint8_t *data, size_t size, SphericalVideoMetadata *metadata) {
+    // Version and flags, CRC, encoding.
+    if (size < kFullBoxHeaderSize + 8) {
+        return false;
+    }
+    uint32_t encoding = read_uint32(data + kFullBoxHeaderSize + 4);
+    const uint8_t *payload = data + kFullBoxHeaderSize + 8;
+    size_t payload_size = size - kFullBoxHeaderSize - 8;
+
+    std::vector<uint8_t> inflated;
+    if (encoding == kDeflateEncoding) {
+        if (!inflate_raw(payload, payload_size, &inflated)) {
+            ALOGE("Unable to inflate the projection mesh.");
+            return false;
+        }
+        payload = inflated.data();
+        payload_size = inflated.size();
+    } else if (encoding != kRawEncoding) {
+        ALOGE("Unsupported projection mesh encoding %08x.", encoding);
+        return false;
+    }
+
+    // The first mesh is for the left (or mono) view, the optional second one for the right
+    // view.
+    std::function<bool(uint64_t, uint8_t *, size_t)> read =
+            [payload, payload_size](uint64_t offset, uint8_t *buffer, size_t count) {
+                if (offset > payload_size || count > payload_size - offset) {
+                    return false;
+                }
+                memcpy(buffer, payload + offset, count);
+                return true;
+            };
+    BoxIterator iterator(read, 0, payload_size);
+    Box box;
+    Array *mesh_arrays[] = {&metadata->left_mesh_arrays, &metadata->right_mesh_arrays};
+    int mesh_count = 0;
+    while (mesh_count < 2 && iterator.next(&box)) {
+        if (box.type != kMeshBox) {
+            continue;
+        }
+        if (!decode_mesh(payload + box.content_offset, box.end - box.content_offset,
+                         mesh_arrays[mesh_count])) {
+            ALOGE("Invalid projection mesh.");
+            return false;
+        }
+        mesh_count++;
+    }
+    return mesh_count > 0;
+}
+
+bool parse_proj(const std::function<bool(uint64_t, uint8_t *, size_t)> &read, const Box &proj,
+                SphericalVideoMetadata *metadata) {
+    BoxIterator iterator(read, proj.content_offset, proj.end);
+    Box box;
+    while (iterator.next(&box)) {
+        if (box.type == kPrhdBox) {
+            uint8_t pose[kFullBoxHeaderSize + 12];
+            if (box.end - box.content_offset >= sizeof(pose)
+                && read(box.content_offset, pose, sizeof(pose))) {
+                // 16.16 fixed point degrees.
+                metadata->pose_yaw = int32_t(read_uint32(pose + 4)) / 65536.0f;
+                metadata->pose_pitch = int32_t(read_uint32(pose + 8)) / 65536.0f;
+                metadata->pose_roll = int32_t(read_uint32(pose + 12)) / 65536.0f;
+            }
+        } else if (box.type == kEquiBox) {
+            metadata->projection = SphericalProjection::kEquirectangular;
+        } else if (box.type == kCbmpBox) {
+            metadata->projection = SphericalProjection::kCubemap;
+        } else if (box.type == kMshpBox) {
+            uint64_t size = box.end - box.content_offset;
+            if (size > kMaxMshpBoxSize) {
+                ALOGE("Projection mesh too large: %llu bytes.", (unsigned long long) size);
+                continue;
+            }
+            std::vector<uint8_t> mshp(size);
+            if (read(box.content_offset, mshp.data(), mshp.size())
+                && decode_mshp(mshp.data(), mshp.size(), metadata)) {
+                metadata->projection = SphericalProjection::kMesh;
+            }
+        }
+    }
+    return true;
+}
+
+bool parse_sample_entry(const std::function<bool(uint64_t, uint8_t *, size_t)> &read,
+                        const Box &entry, SphericalVideoMetadata *metadata) {
+    if (entry.end - entry.content_offset < kVisualSampleEntrySize) {
+        return false;
+    }
+
+    BoxIterator iterator(read, entry.content_offset + kVisualSampleEntrySize, entry.end);
+    Box box;
+    while (iterator.next(&box)) {
+        if (box.type == kSt3dBox) {
+            uint8_t st3d[kFullBoxHeaderSize + 1];
+            if (box.end - box.content_offset < sizeof(st3d)
+                || !read(box.content_offset, st3d, sizeof(st3d))) {
+                continue;
+            }
+            uint8_t stereo_mode = st3d[kFullBoxHeaderSize];
+            metadata->stereo_mode = stereo_mode == kSt3dTopBottom ? StereoMode::kTopBottom
+                    : stereo_mode == kSt3dLeftRight ? StereoMode::kLeftRight
+                    : StereoMode::kMono;
+        } else if (box.type == kSv3dBox) {
+            Box proj;
+            if (find_box(read, box.content_offset, box.end, kProjBox, &proj)) {
+                parse_proj(read, proj, metadata);
+            }
+        }
+    }
+    return true;
+}
+
+bool is_video_track(const std::function<bool(uint64_t, uint8_t *, size_t)> &read,
+                    const Box &mdia) {
+    // Version and flags, pre-defined, handler type.
+    Box hdlr;
+    uint8_t handler[kFullBoxHeaderSize + 8];
+    return find_box(read, mdia.content_offset, mdia.end, kHdlrBox, &hdlr)
+           && hdlr.end - hdlr.content_offset >= sizeof(handler)
+           && read(hdlr.content_offset, handler, sizeof(handler))
+           && read_uint32(handler + kFullBoxHeaderSize + 4) == kVideoHandler;
+}
+}  // namespace
+
+bool SphericalVideoParser::parse_file(int fd, int64_t offset, int64_t length,
+                                      SphericalVideoMetadata *metadata) {
+    if (fd < 0 || offset < 0) {
+        return false;
+    }
+    if (length < 0) {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size < offset) {
+            return false;
+        }
+        length = file_stat.st_size - offset;
+    }
+
+    // Positional reads, so the descriptor's offset isn't modified.
+    ReadFunction read = [fd, offset, length](uint64_t position, uint8_t *data, size_t size) {
+        if (position > uint64_t(length) || size > uint64_t(length) - position) {
+            return false;
+        }
+        while (size > 0) {
+            ssize_t count = pread64(fd, data, size, offset + position);
+            if (count <= 0) {
+                return false;
+            }
+            data += count;
+            position += count;
+            size -= count;
+        }
+        return true;
+    };
+    return parse(read, length, metadata);
+}
+
+bool SphericalVideoParser::parse_buffer(const uint8_t *data, size_t size,
+                                        SphericalVideoMetadata *metadata) {
+    if (!data) {
+        return false;
+    }
+
+    ReadFunction read = [data, size](uint64_t offset, uint8_t *buffer, size_t count) {
+        if (offset > size || count > size - offset) {
+            return false;
+        }
+        memcpy(buffer, data + offset, count);
+        return true;
+    };
+    return parse(read, size, metadata);
+}
+
+bool SphericalVideoParser::parse(const ReadFunction &read, uint64_t size,
+                                 SphericalVideoMetadata *metadata) {
+    // moov > trak > mdia > minf > stbl > stsd > visual sample entry > st3d / sv3d
+    Box moov;
+    if (!find_box(read, 0, size, kMoovBox, &moov)) {
+        return false;
+    }
+
+    BoxIterator tracks(read, moov.content_offset, moov.end);
+    Box trak;
+    while (tracks.next(&trak)) {
+        Box mdia;
+        Box minf;
+        Box stbl;
+        Box stsd;
+        if (trak.type != kTrakBox
+            || !find_box(read, trak.content_offset, trak.end, kMdiaBox, &mdia)
+            || !is_video_track(read, mdia)
+            || !find_box(read, mdia.content_offset, mdia.end, kMinfBox, &minf)
+            || !find_box(read, minf.content_offset, minf.end, kStblBox, &stbl)
+            || !find_box(read, stbl.content_offset, stbl.end, kStsdBox, &stsd)) {
+            continue;
+        }
+
+        // Skip the version, flags and entry count to the first sample entry.
+        Box entry;
+        BoxIterator entries(read, stsd.content_offset + kFullBoxHeaderSize + 4, stsd.end);
+        if (entries.next(&entry)) {
+            return parse_sample_entry(read, entry, metadata);
+        }
+    }
+    return false;
+}
+
+}  // namespace gast
@@ -0,0 +1,67 @@
+#ifndef SPHERICAL_VIDEO_PARSER_H
+#define SPHERICAL_VIDEO_PARSER_H
+
+#include <core/Array.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "projection_mesh_utils.h"
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}  // namespace
+
+/// Projection declared by a spherical video's 'proj' box.
+enum class SphericalProjection {
+    kNone,
+    kEquirectangular,
+    kCubemap,
+    kMesh,
+};
+
+/// Spherical Video V2 metadata of an MP4 video track.
+struct SphericalVideoMetadata {
+    // From the 'st3d' box. The 'stereo-custom' mode maps to kMono, as the per view texture
+    // coordinates are carried by the meshes.
+    StereoMode stereo_mode = StereoMode::kMono;
+    SphericalProjection projection = SphericalProjection::kNone;
+    // Orientation of the projection, in degrees, from the 'prhd' box.
+    float pose_yaw = 0;
+    float pose_pitch = 0;
+    float pose_roll = 0;
+    // Indexed triangle list surfaces decoded from the 'mshp' box, for the kMesh projection. The
+    // right view's surface is empty when both views share the left (or mono) view's mesh.
+    // The texture coordinates' origin is the bottom left corner.
+    Array left_mesh_arrays;
+    Array right_mesh_arrays;
+};
+
+/// Streaming parser for the Spherical Video V2 boxes ('st3d', 'sv3d', 'proj', 'mshp') of MP4
+/// files. Only the box headers along the path to the first video track's sample entry are
+/// read; the sample tables and media data are skipped.
+class SphericalVideoParser {
+public:
+    /// Parse the metadata of the MP4 file stored in the given range of the given file
+    /// descriptor. The descriptor's offset is left untouched.
+    /// @param length Length of the file, or a negative value to read until the end of the file
+    /// @return true if a video track was found, in which case the metadata is updated
+    static bool parse_file(int fd, int64_t offset, int64_t length,
+                           SphericalVideoMetadata *metadata);
+
+    /// Parse the metadata of the MP4 file stored in the given buffer (e.g: a mapped region).
+    /// @return true if a video track was found, in which case the metadata is updated
+    static bool parse_buffer(const uint8_t *data, size_t size, SphericalVideoMetadata *metadata);
+
+private:
+    // Reads the given number of bytes at the given offset, returns false if out of range.
+    using ReadFunction = std::function<bool(uint64_t offset, uint8_t *data, size_t size)>;
+
+    static bool parse(const ReadFunction &read, uint64_t size, SphericalVideoMetadata *metadata);
+};
+
+}  // namespace gast
+
+#endif // SPHERICAL_VIDEO_PARSER_H
@@ -0,0 +1,24 @@
+#ifndef SURFACE_GEOMETRY_H
+#define SURFACE_GEOMETRY_H
+
+#include <cstddef>
+#include <vector>
+
+namespace gast {
+
+/// Vertex data of a generated surface, laid out as flat arrays.
+struct SurfaceGeometry {
+    // Positions [x1, y1, z1 ... xn, yn, zn].
+    std::vector<float> positions;
+    // Texture coordinates [u1, v1 ... un, vn].
+    std::vector<float> uvs;
+    std::vector<int> indices;
+
+    inline size_t get_vertex_count() const {
+        return positions.size() / 3;
+    }
+};
+
+}  // namespace gast
+
+#endif // SURFACE_GEOMETRY_H
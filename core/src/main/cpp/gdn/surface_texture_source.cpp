@@ -0,0 +1,118 @@
+#include "surface_texture_source.h"
+
+#include <dlfcn.h>
+
+#include "utils.h"
+
+namespace gast {
+
+namespace {
+struct ASurfaceTextureApi {
+    void *(*from_surface_texture)(JNIEnv *env, jobject surface_texture) = nullptr;
+    void (*release)(void *surface_texture) = nullptr;
+    int (*update_tex_image)(void *surface_texture) = nullptr;
+    int64_t (*get_timestamp)(void *surface_texture) = nullptr;
+
+    bool is_available() const {
+        return from_surface_texture && release && update_tex_image && get_timestamp;
+    }
+};
+
+// The ASurfaceTexture api is resolved at runtime, as it's not available on all the supported
+// api levels.
+const ASurfaceTextureApi &get_surface_texture_api() {
+    static const ASurfaceTextureApi api = []() {
+        ASurfaceTextureApi resolved_api;
+        void *library = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+        if (!library) {
+            return resolved_api;
+        }
+
+        resolved_api.from_surface_texture = reinterpret_cast<void *(*)(JNIEnv *, jobject)>(
+                dlsym(library, "ASurfaceTexture_fromSurfaceTexture"));
+        resolved_api.release = reinterpret_cast<void (*)(void *)>(
+                dlsym(library, "ASurfaceTexture_release"));
+        resolved_api.update_tex_image = reinterpret_cast<int (*)(void *)>(
+                dlsym(library, "ASurfaceTexture_updateTexImage"));
+        resolved_api.get_timestamp = reinterpret_cast<int64_t (*)(void *)>(
+                dlsym(library, "ASurfaceTexture_getTimestamp"));
+        if (!resolved_api.is_available()) {
+            ALOGW("ASurfaceTexture api unavailable, falling back to the Java SurfaceTexture.");
+        }
+        return resolved_api;
+    }();
+    return api;
+}
+
+jmethodID update_tex_image_method = nullptr;
+jmethodID get_timestamp_method = nullptr;
+}  // namespace
+
+std::unique_ptr<SurfaceTextureSource> SurfaceTextureSource::create(JNIEnv *env,
+                                                                   jobject surface_texture) {
+    if (!env || !surface_texture) {
+        return nullptr;
+    }
+
+    std::unique_ptr<SurfaceTextureSource> source(new SurfaceTextureSource());
+    const ASurfaceTextureApi &api = get_surface_texture_api();
+    if (api.is_available()) {
+        source->native_surface_texture_ = api.from_surface_texture(env, surface_texture);
+        if (source->native_surface_texture_) {
+            return source;
+        }
+    }
+
+    if (!update_tex_image_method || !get_timestamp_method) {
+        jclass surface_texture_class = env->GetObjectClass(surface_texture);
+        update_tex_image_method = env->GetMethodID(surface_texture_class, "updateTexImage", "()V");
+        get_timestamp_method = env->GetMethodID(surface_texture_class, "getTimestamp", "()J");
+        env->DeleteLocalRef(surface_texture_class);
+        if (!update_tex_image_method || !get_timestamp_method) {
+            ALOGE("Unable to find the SurfaceTexture methods.");
+            return nullptr;
+        }
+    }
+
+    source->java_surface_texture_ = env->NewGlobalRef(surface_texture);
+    return source;
+}
+
+SurfaceTextureSource::~SurfaceTextureSource() {
+    if (native_surface_texture_) {
+        get_surface_texture_api().release(native_surface_texture_);
+        native_surface_texture_ = nullptr;
+    }
+
+    if (java_surface_texture_) {
+        JNIEnv *env = godot::android_api->godot_android_get_env();
+        env->DeleteGlobalRef(java_surface_texture_);
+        java_surface_texture_ = nullptr;
+    }
+}
+
+bool SurfaceTextureSource::update_tex_image() {
+    if (native_surface_texture_) {
+        return get_surface_texture_api().update_tex_image(native_surface_texture_) == 0;
+    }
+
+    JNIEnv *env = godot::android_api->godot_android_get_env();
+    env->CallVoidMethod(java_surface_texture_, update_tex_image_method);
+    if (env->ExceptionCheck()) {
+        // The surface texture was released or abandoned by its producer.
+        env->ExceptionClear();
+        return false;
+    }
+    return true;
+}
+
+int64_t SurfaceTextureSource::get_timestamp() {
+    if (native_surface_texture_) {
+        return get_surface_texture_api().get_timestamp(native_surface_texture_);
+    }
+
+    JNIEnv *env = godot::android_api->godot_android_get_env();
+    return env->CallLongMethod(java_surface_texture_, get_timestamp_method);
+}
+
+}  // namespace gast
@@ -0,0 +1,38 @@
+#ifndef SURFACE_TEXTURE_SOURCE_H
+#define SURFACE_TEXTURE_SOURCE_H
+
+#include <cstdint>
+#include <jni.h>
+#include <memory>
+
+#include "texture_latch_pump.h"
+
+namespace gast {
+
+/// TextureSource backed by an android.graphics.SurfaceTexture.
+///
+/// Uses the NDK ASurfaceTexture api when available (API 28+), and falls back to invoking the
+/// Java SurfaceTexture methods otherwise.
+class SurfaceTextureSource : public TextureSource {
+public:
+    /// @return The texture source, or nullptr if the given surface texture is invalid
+    static std::unique_ptr<SurfaceTextureSource> create(JNIEnv *env, jobject surface_texture);
+
+    ~SurfaceTextureSource() override;
+
+    bool update_tex_image() override;
+
+    int64_t get_timestamp() override;
+
+private:
+    SurfaceTextureSource() = default;
+
+    // Opaque ASurfaceTexture handle, set when the NDK api is available.
+    void *native_surface_texture_ = nullptr;
+    // Global reference to the Java SurfaceTexture, used as a fallback.
+    jobject java_surface_texture_ = nullptr;
+};
+
+}  // namespace gast
+
+#endif // SURFACE_TEXTURE_SOURCE_H
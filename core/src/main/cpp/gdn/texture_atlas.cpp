@@ -0,0 +1,166 @@
+#include "texture_atlas.h"
+
+#include <core/Vector2.hpp>
+
+#include "gdn/gast_node.h"
+#include "utils.h"
+
+namespace gast {
+
+namespace {
+// Empty pixels kept around each region to prevent texture filtering from bleeding the content
+// of neighbouring regions.
+const int kRegionPadding = 2;
+// A shelf taller than this ratio of the requested height is only used when no new shelf can
+// be added.
+const int kMaxShelfHeightRatio = 2;
+}  // namespace
+
+TextureAtlas::TextureAtlas(int width, int height) : width_(width), height_(height) {
+    external_texture_ = Ref<ExternalTexture>(ExternalTexture::_new());
+    external_texture_->set_size(Vector2(width, height));
+}
+
+TextureAtlas::~TextureAtlas() {
+    // Unbind the remaining nodes so they go back to their own texture.
+    while (!node_regions_.empty()) {
+        remove_node(node_regions_.begin()->first);
+    }
+    shelves_.clear();
+}
+
+int TextureAtlas::get_external_texture_id() const {
+    return external_texture_.is_null() ? kInvalidTexId
+                                       : external_texture_->get_external_texture_id();
+}
+
+bool TextureAtlas::add_node(GastNode *gast_node, int width, int height) {
+    if (!gast_node || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    // Release the node's current region first so it can be reused.
+    auto it = node_regions_.find(gast_node);
+    if (it != node_regions_.end()) {
+        release(it->second);
+        node_regions_.erase(it);
+    }
+
+    Rect2 region;
+    if (!allocate(width, height, &region)) {
+        ALOGW("Unable to allocate a %dx%d region in the %dx%d texture atlas.", width, height,
+              width_, height_);
+        if (gast_node->get_texture_atlas() == this) {
+            gast_node->set_texture_atlas(nullptr, Rect2());
+        }
+        return false;
+    }
+
+    node_regions_[gast_node] = region;
+    gast_node->set_texture_atlas(this, Rect2(region.position.x / width_,
+                                             region.position.y / height_,
+                                             region.size.x / width_,
+                                             region.size.y / height_));
+    return true;
+}
+
+void TextureAtlas::remove_node(GastNode *gast_node) {
+    auto it = node_regions_.find(gast_node);
+    if (it == node_regions_.end()) {
+        return;
+    }
+
+    release(it->second);
+    node_regions_.erase(it);
+    if (gast_node->get_texture_atlas() == this) {
+        gast_node->set_texture_atlas(nullptr, Rect2());
+    }
+}
+
+Rect2 TextureAtlas::get_node_region(GastNode *gast_node) const {
+    auto it = node_regions_.find(gast_node);
+    return it == node_regions_.end() ? Rect2() : it->second;
+}
+
+bool TextureAtlas::allocate(int width, int height, Rect2 *region) {
+    int padded_width = width + 2 * kRegionPadding;
+    int padded_height = height + 2 * kRegionPadding;
+    if (padded_width > width_ || padded_height > height_) {
+        return false;
+    }
+
+    // Look for the shortest shelf with a large enough horizontal gap.
+    Shelf *best_shelf = nullptr;
+    size_t best_span_index = 0;
+    int best_x = 0;
+    for (Shelf &shelf : shelves_) {
+        if (shelf.height < padded_height
+            || (best_shelf && shelf.height >= best_shelf->height)) {
+            continue;
+        }
+
+        int x = 0;
+        size_t span_index = 0;
+        for (; span_index < shelf.spans.size(); span_index++) {
+            if (shelf.spans[span_index].first - x >= padded_width) {
+                break;
+            }
+            x = shelf.spans[span_index].second;
+        }
+
+        if (width_ - x >= padded_width) {
+            best_shelf = &shelf;
+            best_span_index = span_index;
+            best_x = x;
+        }
+    }
+
+    // Start a new shelf if no existing one fits, or if the best one would waste too much space.
+    if (!best_shelf || best_shelf->height > padded_height * kMaxShelfHeightRatio) {
+        int shelf_y = shelves_.empty() ? 0 : shelves_.back().y + shelves_.back().height;
+        if (shelf_y + padded_height <= height_) {
+            Shelf shelf;
+            shelf.y = shelf_y;
+            shelf.height = padded_height;
+            shelves_.push_back(shelf);
+
+            best_shelf = &shelves_.back();
+            best_span_index = 0;
+            best_x = 0;
+        }
+    }
+
+    if (!best_shelf) {
+        return false;
+    }
+
+    best_shelf->spans.insert(best_shelf->spans.begin() + best_span_index,
+                             std::make_pair(best_x, best_x + padded_width));
+    *region = Rect2(best_x + kRegionPadding, best_shelf->y + kRegionPadding, width, height);
+    return true;
+}
+
+void TextureAtlas::release(const Rect2 &region) {
+    int x = static_cast<int>(region.position.x) - kRegionPadding;
+    int y = static_cast<int>(region.position.y) - kRegionPadding;
+    for (Shelf &shelf : shelves_) {
+        if (shelf.y != y) {
+            continue;
+        }
+
+        for (auto it = shelf.spans.begin(); it != shelf.spans.end(); it++) {
+            if (it->first == x) {
+                shelf.spans.erase(it);
+                break;
+            }
+        }
+        break;
+    }
+
+    // Reclaim the empty shelves at the end of the atlas.
+    while (!shelves_.empty() && shelves_.back().spans.empty()) {
+        shelves_.pop_back();
+    }
+}
+
+}  // namespace gast
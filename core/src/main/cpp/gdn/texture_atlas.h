@@ -0,0 +1,77 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include <core/Rect2.hpp>
+#include <core/Ref.hpp>
+#include <gen/ExternalTexture.hpp>
+#include <map>
+#include <vector>
+
+namespace gast {
+
+namespace {
+using namespace godot;
+}  // namespace
+
+class GastNode;
+
+/// Shares a single external texture between multiple Gast nodes.
+///
+/// Each node is assigned a sub-region of the texture by a shelf packer, and samples it via its
+/// projection mesh's sampling transforms. This allows many small panels to be updated with a
+/// single texture latch.
+class TextureAtlas {
+public:
+    TextureAtlas(int width, int height);
+
+    ~TextureAtlas();
+
+    inline int get_width() const {
+        return width_;
+    }
+
+    inline int get_height() const {
+        return height_;
+    }
+
+    inline Ref<ExternalTexture> get_external_texture() const {
+        return external_texture_;
+    }
+
+    int get_external_texture_id() const;
+
+    /// Allocate a region of the given size (in pixels) for the given node and bind the node to
+    /// the atlas. The region previously allocated to the node, if any, is released first.
+    /// @return true if the region was allocated
+    bool add_node(GastNode *gast_node, int width, int height);
+
+    /// Release the region allocated to the given node and unbind the node from the atlas.
+    void remove_node(GastNode *gast_node);
+
+    /// Returns the region (in pixels) allocated to the given node, or an empty rect if the node
+    /// is not part of the atlas.
+    Rect2 get_node_region(GastNode *gast_node) const;
+
+private:
+    // Row of regions sharing the same vertical span.
+    struct Shelf {
+        int y = 0;
+        int height = 0;
+        // Horizontal spans [start, end) in use, sorted by start.
+        std::vector<std::pair<int, int>> spans;
+    };
+
+    bool allocate(int width, int height, Rect2 *region);
+
+    void release(const Rect2 &region);
+
+    int width_;
+    int height_;
+    Ref<ExternalTexture> external_texture_;
+    std::vector<Shelf> shelves_;
+    std::map<GastNode *, Rect2> node_regions_;
+};
+
+}  // namespace gast
+
+#endif // TEXTURE_ATLAS_H
@@ -0,0 +1,253 @@
+#include "texture_latch_pump.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+
+namespace gast {
+
+namespace {
+// Frame period assumed until the interval between the rendered frames is measured.
+const int64_t kDefaultFramePeriodNs = 16666667;
+const int64_t kMinFramePeriodNs = 4000000;
+const int64_t kMaxFramePeriodNs = 100000000;
+// Weight of the last measured interval in the smoothed frame period.
+const int64_t kFramePeriodSmoothingDivisor = 8;
+// Frame timestamps further than this from the current time are not in the monotonic clock's
+// time base (e.g: media presentation times), and can't be matched with the display time.
+const int64_t kMaxTimestampDriftNs = 1000000000;
+// While the owner node can't be seen, queued frames are only latched once every this many
+// frames so producers waiting on a free buffer don't stall.
+const int kNonVisibleTextureLatchInterval = 30;
+// Number of rendered frames the frame statistics are computed over.
+const size_t kFrameStatsWindowSize = 256;
+
+bool is_monotonic_timestamp(int64_t timestamp_ns, int64_t now_ns) {
+    return timestamp_ns > 0 && std::llabs(timestamp_ns - now_ns) <= kMaxTimestampDriftNs;
+}
+
+// Returns the given percentile of the given sorted values, using the nearest rank method.
+int64_t get_percentile(const std::vector<int64_t> &sorted_values, float percentile) {
+    auto rank = static_cast<size_t>(std::ceil(percentile * sorted_values.size()));
+    return sorted_values[std::max(rank, static_cast<size_t>(1)) - 1];
+}
+
+float to_milliseconds(int64_t time_ns) {
+    return static_cast<float>(time_ns) / 1000000.0f;
+}
+
+int64_t get_monotonic_time_ns() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+}  // namespace
+
+TextureLatchPump::TextureLatchPump() : frame_period_ns_(kDefaultFramePeriodNs) {}
+
+int64_t TextureLatchPump::register_source(std::unique_ptr<TextureSource> source,
+                                          GastNode *owner) {
+    if (!source) {
+        return 0;
+    }
+
+    std::unique_ptr<SourceEntry> entry(new SourceEntry());
+    entry->source = std::move(source);
+    entry->owner = owner;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t handle = next_handle_++;
+    sources_[handle] = std::move(entry);
+    return handle;
+}
+
+void TextureLatchPump::unregister_source(int64_t handle) {
+    std::unique_ptr<SourceEntry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sources_.find(handle);
+        if (it == sources_.end()) {
+            return;
+        }
+        entry = std::move(it->second);
+        sources_.erase(it);
+    }
+    // The source is released outside of the lock, as it may call into the JVM.
+}
+
+void TextureLatchPump::on_frame_available(int64_t handle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sources_.find(handle);
+    if (it != sources_.end()) {
+        it->second->queued_frame_count++;
+    }
+}
+
+void TextureLatchPump::latch_frames() {
+    latch_frames(get_monotonic_time_ns());
+}
+
+void TextureLatchPump::latch_frames(int64_t now_ns) {
+    update_frame_period(now_ns);
+    // The frames latched now are displayed once the current frame is rendered.
+    int64_t display_time_ns = now_ns + frame_period_ns_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &it : sources_) {
+        SourceEntry *entry = it.second.get();
+        if (entry->queued_frame_count.load() <= 0) {
+            continue;
+        }
+
+        FrameRecord record;
+        if (entry->owner && !is_texture_owner_visible(entry->owner)
+            && ++entry->throttled_frame_count < kNonVisibleTextureLatchInterval) {
+            record.skipped = true;
+        } else {
+            entry->throttled_frame_count = 0;
+            latch_source_frames(entry, display_time_ns, &record);
+        }
+        entry->add_frame_record(record);
+    }
+}
+
+void TextureLatchPump::clear_owner(const GastNode *owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &it : sources_) {
+        if (it.second->owner == owner) {
+            it.second->owner = nullptr;
+        }
+    }
+}
+
+void TextureLatchPump::clear_owners() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &it : sources_) {
+        it.second->owner = nullptr;
+    }
+}
+
+void TextureLatchPump::latch_source_frames(SourceEntry *entry, int64_t display_time_ns,
+                                           FrameRecord *record) {
+    // The queued frames can only be inspected once latched, so the frames are latched oldest
+    // first until one is due at or after the display time, within half a frame period. Frames
+    // due later remain queued.
+    int64_t half_frame_period_ns = frame_period_ns_ / 2;
+    int latched_frame_count = 0;
+    while (entry->queued_frame_count.load() > 0) {
+        if (!entry->source->update_tex_image()) {
+            entry->queued_frame_count = 0;
+            break;
+        }
+        entry->queued_frame_count--;
+        latched_frame_count++;
+
+        int64_t timestamp_ns = entry->source->get_timestamp();
+        record->timestamp_ns = timestamp_ns;
+        if (!is_monotonic_timestamp(timestamp_ns, display_time_ns)) {
+            // The frame can't be matched with the display time, so only the newest frame is
+            // kept.
+            continue;
+        }
+
+        if (timestamp_ns + half_frame_period_ns >= display_time_ns) {
+            break;
+        }
+    }
+
+    record->latched_frame_count = latched_frame_count;
+    record->latch_time_ns = get_monotonic_time_ns();
+}
+
+void TextureLatchPump::update_frame_period(int64_t now_ns) {
+    if (last_latch_time_ns_ > 0) {
+        int64_t interval_ns = now_ns - last_latch_time_ns_;
+        if (interval_ns >= kMinFramePeriodNs && interval_ns <= kMaxFramePeriodNs) {
+            frame_period_ns_ += (interval_ns - frame_period_ns_) / kFramePeriodSmoothingDivisor;
+        }
+    }
+    last_latch_time_ns_ = now_ns;
+}
+
+void TextureLatchPump::SourceEntry::add_frame_record(const FrameRecord &record) {
+    if (record.skipped) {
+        total_skipped_latch_count++;
+    } else if (record.latched_frame_count > 0) {
+        total_latched_frame_count += record.latched_frame_count;
+        total_dropped_frame_count += record.latched_frame_count - 1;
+    }
+
+    if (frame_records.size() < kFrameStatsWindowSize) {
+        frame_records.push_back(record);
+    } else {
+        frame_records[next_frame_record] = record;
+    }
+    next_frame_record = (next_frame_record + 1) % kFrameStatsWindowSize;
+}
+
+bool TextureLatchPump::get_frame_stats(const GastNode *owner, TextureFrameStats *stats) {
+    if (!owner || !stats) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(sources_.begin(), sources_.end(), [owner](const auto &source) {
+        return source.second->owner == owner;
+    });
+    if (it == sources_.end()) {
+        return false;
+    }
+
+    const SourceEntry &entry = *it->second;
+    std::vector<int64_t> latencies;
+    latencies.reserve(entry.frame_records.size());
+    int latched_frame_count = 0;
+    int dropped_frame_count = 0;
+    int skipped_frame_count = 0;
+    for (const FrameRecord &record : entry.frame_records) {
+        if (record.skipped) {
+            skipped_frame_count++;
+            continue;
+        }
+        if (record.latched_frame_count == 0) {
+            continue;
+        }
+
+        latched_frame_count += record.latched_frame_count;
+        dropped_frame_count += record.latched_frame_count - 1;
+        if (is_monotonic_timestamp(record.timestamp_ns, record.latch_time_ns)) {
+            latencies.push_back(record.latch_time_ns - record.timestamp_ns);
+        }
+    }
+
+    *stats = TextureFrameStats();
+    stats->latency_sample_count = static_cast<int>(latencies.size());
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats->latency_p50_ms = to_milliseconds(get_percentile(latencies, 0.50f));
+        stats->latency_p95_ms = to_milliseconds(get_percentile(latencies, 0.95f));
+        stats->latency_p99_ms = to_milliseconds(get_percentile(latencies, 0.99f));
+    }
+    if (latched_frame_count > 0) {
+        stats->drop_rate = static_cast<float>(dropped_frame_count) / latched_frame_count;
+    }
+    if (!entry.frame_records.empty()) {
+        stats->skip_rate =
+                static_cast<float>(skipped_frame_count) / entry.frame_records.size();
+    }
+    stats->latched_frame_count = entry.total_latched_frame_count;
+    stats->dropped_frame_count = entry.total_dropped_frame_count;
+    stats->skipped_latch_count = entry.total_skipped_latch_count;
+    return true;
+}
+
+void TextureLatchPump::clear() {
+    std::map<int64_t, std::unique_ptr<SourceEntry>> sources;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sources.swap(sources_);
+    }
+}
+
+}  // namespace gast
@@ -0,0 +1,145 @@
+#ifndef TEXTURE_LATCH_PUMP_H
+#define TEXTURE_LATCH_PUMP_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gast {
+
+class GastNode;
+
+/// Returns true if the given node, displaying the texture of a latched source, can be seen.
+/// Defined alongside GastNode.
+bool is_texture_owner_visible(const GastNode *owner);
+
+/// Producer of the frames of an external texture.
+///
+/// Frames are queued by the producer and latched into the texture one at a time, oldest first.
+class TextureSource {
+public:
+    virtual ~TextureSource() = default;
+
+    /// Latch the oldest queued frame into the texture. Must be invoked on the render thread.
+    /// @return false if the latch failed
+    virtual bool update_tex_image() = 0;
+
+    /// Returns the timestamp of the latched frame, in nanoseconds, or 0 if the producer didn't
+    /// set one.
+    virtual int64_t get_timestamp() = 0;
+};
+
+/// Rolling statistics of the frames latched from a texture source, over its last rendered frames.
+struct TextureFrameStats {
+    // Number of displayed frames the latency percentiles are computed from. Frames without a
+    // monotonic producer timestamp are not counted.
+    int latency_sample_count = 0;
+    // Delay between the producer timestamp of the displayed frames and their latch, in
+    // milliseconds. Negative if the frames are latched ahead of their timestamp.
+    float latency_p50_ms = 0;
+    float latency_p95_ms = 0;
+    float latency_p99_ms = 0;
+    // Ratio of the latched frames dropped in favor of a newer frame.
+    float drop_rate = 0;
+    // Ratio of the rendered frames, with frames queued, for which the latches were skipped
+    // because the owner node couldn't be seen.
+    float skip_rate = 0;
+    // Totals since the source was registered.
+    int64_t latched_frame_count = 0;
+    int64_t dropped_frame_count = 0;
+    int64_t skipped_latch_count = 0;
+};
+
+/// Latches the frames of the registered texture sources once per rendered frame.
+///
+/// Rather than latching every queued frame, the pump picks for each source the newest frame whose
+/// timestamp is due by the predicted display time, and drops the older ones. The frames due
+/// later are left queued for the next rendered frames.
+class TextureLatchPump {
+public:
+    TextureLatchPump();
+
+    /// Register the given texture source.
+    /// @param owner Node displaying the source's texture, used to throttle the latches while
+    /// the node can't be seen. nullptr if the texture is shared.
+    /// @return Handle of the registered source
+    int64_t register_source(std::unique_ptr<TextureSource> source, GastNode *owner);
+
+    /// Unregister and release the texture source with the given handle.
+    void unregister_source(int64_t handle);
+
+    /// Notify the pump a new frame was queued into the texture source with the given handle.
+    /// Thread safe, usually invoked on the producer's thread.
+    void on_frame_available(int64_t handle);
+
+    /// Latch the frames due for the upcoming display. Must be invoked once per rendered frame,
+    /// on the render thread.
+    void latch_frames();
+
+    /// Latch the frames due for the display following the given time, on the monotonic clock.
+    void latch_frames(int64_t now_ns);
+
+    /// Detach the texture sources from the given node, which is being destroyed. Their frames
+    /// are then latched as if their texture was shared.
+    void clear_owner(const GastNode *owner);
+
+    /// Detach the texture sources from all their nodes, e.g: when Gast is shut down before the
+    /// nodes are destroyed.
+    void clear_owners();
+
+    /// Unregister and release all the texture sources.
+    void clear();
+
+    /// Returns the frame statistics of the texture source owned by the given node. The shared
+    /// texture sources (e.g: texture atlases) have no owner, so their stats aren't reported.
+    /// @return false if the node doesn't own a registered texture source
+    bool get_frame_stats(const GastNode *owner, TextureFrameStats *stats);
+
+private:
+    // Outcome of a rendered frame for a source with queued frames.
+    struct FrameRecord {
+        // Producer timestamp of the frame left latched, 0 if none.
+        int64_t timestamp_ns = 0;
+        int64_t latch_time_ns = 0;
+        int latched_frame_count = 0;
+        bool skipped = false;
+    };
+
+    struct SourceEntry {
+        std::unique_ptr<TextureSource> source;
+        // Cleared when the node is destroyed.
+        const GastNode *owner = nullptr;
+        std::atomic<int> queued_frame_count{0};
+        // Number of consecutive rendered frames for which the latches were throttled.
+        int throttled_frame_count = 0;
+
+        // Ring buffer of the last frame records.
+        std::vector<FrameRecord> frame_records;
+        size_t next_frame_record = 0;
+        int64_t total_latched_frame_count = 0;
+        int64_t total_dropped_frame_count = 0;
+        int64_t total_skipped_latch_count = 0;
+
+        void add_frame_record(const FrameRecord &record);
+    };
+
+    // Latch the frames due by the given display time into the given source's texture.
+    void latch_source_frames(SourceEntry *entry, int64_t display_time_ns, FrameRecord *record);
+
+    void update_frame_period(int64_t now_ns);
+
+    std::mutex mutex_;
+    std::map<int64_t, std::unique_ptr<SourceEntry>> sources_;
+    int64_t next_handle_ = 1;
+
+    int64_t last_latch_time_ns_ = 0;
+    // Smoothed interval between rendered frames.
+    int64_t frame_period_ns_ = 0;
+};
+
+}  // namespace gast
+
+#endif // TEXTURE_LATCH_PUMP_H
@@ -1,5 +1,7 @@
 #include <jni.h>
+#include <string>
 #include "gast_manager.h"
+#include "gdn/projection_mesh/mesh_cache.h"
 #include "utils.h"
 
 // Current class and package names assumed for the Java side.
@@ -33,10 +35,35 @@ JNI_METHOD(setInputActionsToMonitor)(JNIEnv *env, jobject, jobjectArray input_ac
     }
 }
 
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetSinglePointerInputEnabled)(JNIEnv *, jobject, jboolean enabled) {
+    GastManager::get_singleton_instance()->set_single_pointer_input_enabled(enabled);
+}
+
 JNIEXPORT void JNICALL
 JNI_METHOD(nativeUpdateNodeVisibility)(JNIEnv *env, jobject, jstring node_path, jboolean visible) {
     GastManager::get_singleton_instance()->update_node_visibility(jstring_to_string(env, node_path),
                                                                   visible);
 }
 
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetTexturePixelBudget)(JNIEnv *, jobject, jlong pixel_budget) {
+    GastManager::get_singleton_instance()->set_texture_pixel_budget(pixel_budget);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetMeshCacheDirectory)(JNIEnv *env, jobject, jstring directory) {
+    // Converted without godot::String, as this may be invoked before the GDNative library is
+    // initialized.
+    std::string cache_directory;
+    if (directory) {
+        const char *directory_utf8 = env->GetStringUTFChars(directory, nullptr);
+        if (directory_utf8) {
+            cache_directory = directory_utf8;
+            env->ReleaseStringUTFChars(directory, directory_utf8);
+        }
+    }
+    MeshCache::set_directory(cache_directory);
+}
+
 }
@@ -119,6 +119,40 @@ JNI_METHOD(setGazeTracking)(JNIEnv *, jobject, jlong node_pointer, jboolean gaze
     gast_node->set_gaze_tracking(gaze_tracking);
 }
 
+JNIEXPORT jint JNICALL
+JNI_METHOD(nativeGetGazeFollowMode)(JNIEnv *, jobject, jlong node_pointer) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL_V(gast_node, GastNode::GazeFollowMode::STRICT);
+    return gast_node->get_gaze_follow_mode();
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetGazeFollowMode)(JNIEnv *, jobject, jlong node_pointer, jint mode) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL(gast_node);
+    if (mode != GastNode::GazeFollowMode::STRICT && mode != GastNode::GazeFollowMode::LAZY) {
+        ALOGE("Invalid gaze follow mode %d", mode);
+        return;
+    }
+    gast_node->set_gaze_follow_mode(static_cast<GastNode::GazeFollowMode>(mode));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(setGazeFollowDeadZone)(JNIEnv *, jobject, jlong node_pointer,
+                                  jfloat dead_zone_degrees) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL(gast_node);
+    gast_node->set_gaze_follow_dead_zone(dead_zone_degrees);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(setGazeFollowSmoothingTime)(JNIEnv *, jobject, jlong node_pointer,
+                                       jfloat smoothing_time) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL(gast_node);
+    gast_node->set_gaze_follow_smoothing_time(smoothing_time);
+}
+
 JNIEXPORT jboolean JNICALL JNI_METHOD(isRenderOnTop)(JNIEnv *, jobject, jlong node_pointer) {
     GastNode *gast_node = from_pointer(node_pointer);
     ERR_FAIL_NULL_V(gast_node, kDefaultRenderOnTop);
@@ -195,6 +229,51 @@ JNI_METHOD(updateGastNodeLocalRotation)(JNIEnv *, jobject, jlong node_pointer,
     gast_node->set_rotation_degrees(Vector3(x_rotation, y_rotation, z_rotation));
 }
 
+JNIEXPORT void JNICALL
+JNI_METHOD(setTextureSizeTracking)(JNIEnv *, jobject, jlong node_pointer, jboolean enable) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL(gast_node);
+    gast_node->set_texture_size_tracking(enable);
+}
+
+JNIEXPORT jintArray JNICALL
+JNI_METHOD(nativeGetRecommendedTextureSize)(JNIEnv *env, jobject, jlong node_pointer) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL_V(gast_node, nullptr);
+
+    Vector2 size = gast_node->get_recommended_texture_size();
+    jint values[2] = {static_cast<jint>(size.x), static_cast<jint>(size.y)};
+    jintArray result = env->NewIntArray(2);
+    env->SetIntArrayRegion(result, 0, 2, values);
+    return result;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+JNI_METHOD(nativeGetFrameStats)(JNIEnv *env, jobject, jlong node_pointer) {
+    GastNode *gast_node = from_pointer(node_pointer);
+    ERR_FAIL_NULL_V(gast_node, nullptr);
+
+    TextureFrameStats stats;
+    if (!GastManager::get_singleton_instance()->get_texture_latch_pump().get_frame_stats(
+            gast_node, &stats)) {
+        return nullptr;
+    }
+
+    // Mirrors the order of the GastNode.FrameStats properties.
+    jdouble values[9] = {static_cast<jdouble>(stats.latency_sample_count),
+                         stats.latency_p50_ms,
+                         stats.latency_p95_ms,
+                         stats.latency_p99_ms,
+                         stats.drop_rate,
+                         stats.skip_rate,
+                         static_cast<jdouble>(stats.latched_frame_count),
+                         static_cast<jdouble>(stats.dropped_frame_count),
+                         static_cast<jdouble>(stats.skipped_latch_count)};
+    jdoubleArray result = env->NewDoubleArray(9);
+    env->SetDoubleArrayRegion(result, 0, 9, values);
+    return result;
+}
+
 JNIEXPORT jlong JNICALL
 JNI_METHOD(nativeGetProjectionMesh)(JNIEnv *, jobject, jlong node_pointer) {
     GastNode *gast_node = from_pointer(node_pointer);
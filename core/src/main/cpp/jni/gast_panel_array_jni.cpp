@@ -0,0 +1,151 @@
+#include <jni.h>
+#include <core/Defs.hpp>
+#include <core/Rect2.hpp>
+#include <core/Transform.hpp>
+#include <core/Vector2.hpp>
+#include "gdn/gast_panel_array.h"
+#include "gast_manager.h"
+#include "utils.h"
+
+// Current class and package names assumed for the Java side.
+#undef JNI_PACKAGE_NAME
+#define JNI_PACKAGE_NAME org_godotengine_plugin_gast
+
+#undef JNI_CLASS_NAME
+#define JNI_CLASS_NAME GastPanelArray
+
+namespace {
+using namespace gast;
+using namespace godot;
+
+inline GastPanelArray *from_pointer(jlong panel_array_pointer) {
+    return reinterpret_cast<GastPanelArray *>(panel_array_pointer);
+}
+
+inline jlong to_pointer(GastPanelArray *panel_array) {
+    return reinterpret_cast<intptr_t>(panel_array);
+}
+
+}  // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+JNI_METHOD(nativeCreatePanelArray)(JNIEnv *env, jobject, jstring parent_node_path) {
+    return to_pointer(GastManager::get_singleton_instance()->create_panel_array(
+            jstring_to_string(env, parent_node_path)));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeReleasePanelArray)(JNIEnv *, jobject, jlong panel_array_pointer) {
+    GastManager::get_singleton_instance()->release_panel_array(from_pointer(panel_array_pointer));
+}
+
+JNIEXPORT jint JNICALL
+JNI_METHOD(nativeGetTextureId)(JNIEnv *, jobject, jlong panel_array_pointer) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL_V(panel_array, kInvalidTexId);
+    return panel_array->get_external_texture_id();
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetTextureSize)(JNIEnv *, jobject, jlong panel_array_pointer, jint width,
+                                 jint height) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_texture_size(Vector2(width, height));
+}
+
+JNIEXPORT jstring JNICALL
+JNI_METHOD(nativeGetNodePath)(JNIEnv *env, jobject, jlong panel_array_pointer) {
+    String node_path = String("");
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    if (panel_array && panel_array->is_inside_tree()) {
+        node_path = panel_array->get_path();
+    }
+
+    return string_to_jstring(env, node_path);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetPanelCount)(JNIEnv *, jobject, jlong panel_array_pointer, jint count) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_panel_count(count);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetPanelSize)(JNIEnv *, jobject, jlong panel_array_pointer, jfloat width,
+                               jfloat height) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_panel_size(Vector2(width, height));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetPanelTransform)(JNIEnv *, jobject, jlong panel_array_pointer, jint index,
+                                    jfloat x_translation, jfloat y_translation,
+                                    jfloat z_translation, jfloat x_rotation, jfloat y_rotation,
+                                    jfloat z_rotation, jfloat scale) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+
+    Basis basis = Basis(Vector3(Math::deg2rad(x_rotation), Math::deg2rad(y_rotation),
+                                Math::deg2rad(z_rotation)));
+    basis.scale(Vector3(scale, scale, scale));
+    panel_array->set_panel_transform(
+            index, Transform(basis, Vector3(x_translation, y_translation, z_translation)));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetPanelPositions)(JNIEnv *env, jobject, jlong panel_array_pointer,
+                                    jfloatArray positions) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+
+    jsize positions_length = env->GetArrayLength(positions);
+    jfloat *positions_jfloat = env->GetFloatArrayElements(positions, nullptr);
+    panel_array->set_panel_positions(positions_jfloat, positions_length / 3);
+    env->ReleaseFloatArrayElements(positions, positions_jfloat, JNI_ABORT);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetPanelTextureRegion)(JNIEnv *, jobject, jlong panel_array_pointer,
+                                        jint index, jfloat x, jfloat y, jfloat width,
+                                        jfloat height) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_panel_texture_region(index, Rect2(x, y, width, height));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetAlpha)(JNIEnv *, jobject, jlong panel_array_pointer, jfloat alpha) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_alpha(alpha);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetHasTransparency)(JNIEnv *, jobject, jlong panel_array_pointer,
+                                     jboolean has_transparency) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_has_transparency(has_transparency);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetCollidable)(JNIEnv *, jobject, jlong panel_array_pointer,
+                                jboolean collidable) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_collidable(collidable);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetVisible)(JNIEnv *, jobject, jlong panel_array_pointer, jboolean visible) {
+    GastPanelArray *panel_array = from_pointer(panel_array_pointer);
+    ERR_FAIL_NULL(panel_array);
+    panel_array->set_visible(visible);
+}
+
+}
@@ -1,7 +1,9 @@
 #include <jni.h>
+#include <algorithm>
 
 #include "gdn/projection_mesh/custom_projection_mesh.h"
 #include "gdn/projection_mesh/projection_mesh_utils.h"
+#include "gdn/projection_mesh/spherical_video_parser.h"
 #include "utils.h"
 
 // Current class and package names assumed for the Java side.
@@ -19,34 +21,213 @@ inline CustomProjectionMesh *from_pointer(jlong custom_projection_mesh_pointer)
     return reinterpret_cast<CustomProjectionMesh *>(custom_projection_mesh_pointer);
 }
 
+// Returns true if all the indices of the given mesh data reference one of its vertices.
+bool are_valid_indices(const CustomMeshData &mesh_data) {
+    for (int i = 0; i < mesh_data.num_indices; i++) {
+        if (mesh_data.indices[i] < 0 || mesh_data.indices[i] >= mesh_data.num_vertices) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns the address of the given direct buffer if it holds at least the given number of
+// elements, nullptr otherwise.
+template<typename T>
+const T *get_direct_buffer_data(JNIEnv *env, jobject buffer, jint element_count) {
+    if (!buffer || element_count < 0) {
+        return nullptr;
+    }
+
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (!address || capacity < element_count) {
+        return nullptr;
+    }
+    return static_cast<const T *>(address);
+}
+
+// Maps the given direct buffers to the mesh data of one view. The index buffer is optional.
+bool get_custom_mesh_data(JNIEnv *env, jint num_vertices, jobject vertices,
+                          jobject texture_coords, jint num_indices, jobject indices,
+                          jint draw_mode, CustomMeshData *mesh_data) {
+    mesh_data->num_vertices = num_vertices;
+    mesh_data->vertices = get_direct_buffer_data<float>(env, vertices, num_vertices * 3);
+    mesh_data->texture_coords = get_direct_buffer_data<float>(env, texture_coords,
+                                                              num_vertices * 2);
+    mesh_data->draw_mode = draw_mode;
+    if (!mesh_data->vertices || !mesh_data->texture_coords) {
+        return false;
+    }
+
+    if (indices && num_indices > 0) {
+        const int *index_data = get_direct_buffer_data<int>(env, indices, num_indices);
+        if (!index_data) {
+            return false;
+        }
+        mesh_data->num_indices = num_indices;
+        mesh_data->indices = index_data;
+    }
+    return are_valid_indices(*mesh_data);
+}
+
 }  // namespace
 
 extern "C" {
 
 JNIEXPORT void JNICALL JNI_METHOD(nativeSetCustomMesh)(
         JNIEnv *env, jobject, jlong mesh_pointer, jfloatArray vertices_left,
-        jfloatArray texture_coords_left, jint draw_mode_int_left,
-        jfloatArray vertices_right, jfloatArray texture_coords_right,
+        jfloatArray texture_coords_left, jintArray indices_left, jint draw_mode_int_left,
+        jfloatArray vertices_right, jfloatArray texture_coords_right, jintArray indices_right,
         jint draw_mode_int_right, jint mesh_stereo_mode_int, jboolean uv_origin_is_bottom_left) {
     CustomProjectionMesh *projection_mesh = from_pointer(mesh_pointer);
     ERR_FAIL_NULL(projection_mesh);
 
     jfloat *vertices_left_jfloat = env->GetFloatArrayElements(vertices_left, nullptr);
     jfloat *texture_coords_left_jfloat = env->GetFloatArrayElements(texture_coords_left, nullptr);
+    jint *indices_left_jint =
+            indices_left ? env->GetIntArrayElements(indices_left, nullptr) : nullptr;
     jfloat *vertices_right_jfloat = env->GetFloatArrayElements(vertices_right, nullptr);
     jfloat *texture_coords_right_jfloat = env->GetFloatArrayElements(texture_coords_right, nullptr);
+    jint *indices_right_jint =
+            indices_right ? env->GetIntArrayElements(indices_right, nullptr) : nullptr;
+
+    CustomMeshData left_mesh_data;
+    left_mesh_data.num_vertices = env->GetArrayLength(vertices_left) / 3;
+    left_mesh_data.vertices = vertices_left_jfloat;
+    left_mesh_data.texture_coords = texture_coords_left_jfloat;
+    left_mesh_data.num_indices = indices_left ? env->GetArrayLength(indices_left) : 0;
+    left_mesh_data.indices = indices_left_jint;
+    left_mesh_data.draw_mode = draw_mode_int_left;
+
+    CustomMeshData right_mesh_data;
+    right_mesh_data.num_vertices = env->GetArrayLength(vertices_right) / 3;
+    right_mesh_data.vertices = vertices_right_jfloat;
+    right_mesh_data.texture_coords = texture_coords_right_jfloat;
+    right_mesh_data.num_indices = indices_right ? env->GetArrayLength(indices_right) : 0;
+    right_mesh_data.indices = indices_right_jint;
+    right_mesh_data.draw_mode = draw_mode_int_right;
+
+    if (are_valid_indices(left_mesh_data) && are_valid_indices(right_mesh_data)) {
+        projection_mesh->set_custom_mesh(left_mesh_data, right_mesh_data, mesh_stereo_mode_int,
+                                         uv_origin_is_bottom_left);
+    } else {
+        ALOGE("Invalid custom mesh indices.");
+    }
+
+    // The arrays are only read, skip copying them back.
+    env->ReleaseFloatArrayElements(vertices_left, vertices_left_jfloat, JNI_ABORT);
+    env->ReleaseFloatArrayElements(texture_coords_left, texture_coords_left_jfloat, JNI_ABORT);
+    if (indices_left) {
+        env->ReleaseIntArrayElements(indices_left, indices_left_jint, JNI_ABORT);
+    }
+    env->ReleaseFloatArrayElements(vertices_right, vertices_right_jfloat, JNI_ABORT);
+    env->ReleaseFloatArrayElements(texture_coords_right, texture_coords_right_jfloat, JNI_ABORT);
+    if (indices_right) {
+        env->ReleaseIntArrayElements(indices_right, indices_right_jint, JNI_ABORT);
+    }
+}
+
+JNIEXPORT void JNICALL JNI_METHOD(nativeSetCustomMeshBuffers)(
+        JNIEnv *env, jobject, jlong mesh_pointer, jint num_vertices_left, jobject vertices_left,
+        jobject texture_coords_left, jint num_indices_left, jobject indices_left,
+        jint draw_mode_int_left, jint num_vertices_right, jobject vertices_right,
+        jobject texture_coords_right, jint num_indices_right, jobject indices_right,
+        jint draw_mode_int_right, jint mesh_stereo_mode_int, jboolean uv_origin_is_bottom_left) {
+    CustomProjectionMesh *projection_mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(projection_mesh);
+
+    CustomMeshData left_mesh_data;
+    CustomMeshData right_mesh_data;
+    if (!get_custom_mesh_data(env, num_vertices_left, vertices_left, texture_coords_left,
+                              num_indices_left, indices_left, draw_mode_int_left,
+                              &left_mesh_data)
+        || !get_custom_mesh_data(env, num_vertices_right, vertices_right, texture_coords_right,
+                                 num_indices_right, indices_right, draw_mode_int_right,
+                                 &right_mesh_data)) {
+        ALOGE("Invalid custom mesh buffers.");
+        return;
+    }
 
-    projection_mesh->set_custom_mesh(env->GetArrayLength(vertices_left) / 3U, vertices_left_jfloat,
-                                     texture_coords_left_jfloat, draw_mode_int_left,
-                                     env->GetArrayLength(vertices_right) / 3U,
-                                     vertices_right_jfloat, texture_coords_right_jfloat,
-                                     draw_mode_int_right, mesh_stereo_mode_int,
+    // The direct buffers are read in place, there's nothing to release.
+    projection_mesh->set_custom_mesh(left_mesh_data, right_mesh_data, mesh_stereo_mode_int,
                                      uv_origin_is_bottom_left);
+}
+
+JNIEXPORT jboolean JNICALL JNI_METHOD(nativeSetCustomMeshFiles)(
+        JNIEnv *env, jobject, jlong mesh_pointer, jstring mesh_file_path_left,
+        jstring mesh_file_path_right, jint mesh_stereo_mode_int,
+        jboolean uv_origin_is_bottom_left) {
+    CustomProjectionMesh *projection_mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL_V(projection_mesh, false);
+
+    return projection_mesh->set_custom_mesh_files(jstring_to_string(env, mesh_file_path_left),
+                                                  jstring_to_string(env, mesh_file_path_right),
+                                                  mesh_stereo_mode_int,
+                                                  uv_origin_is_bottom_left);
+}
+
+JNIEXPORT jboolean JNICALL JNI_METHOD(nativeSetCustomMeshFromVideo)(
+        JNIEnv *, jobject, jlong mesh_pointer, jint fd, jlong offset, jlong length) {
+    CustomProjectionMesh *projection_mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL_V(projection_mesh, false);
+
+    SphericalVideoMetadata metadata;
+    if (!SphericalVideoParser::parse_file(fd, offset, length, &metadata)) {
+        return false;
+    }
+    return projection_mesh->set_spherical_video_mesh(metadata);
+}
+
+JNIEXPORT jboolean JNICALL JNI_METHOD(nativeSetCustomMeshFromVideoBuffer)(
+        JNIEnv *env, jobject, jlong mesh_pointer, jobject buffer, jint size) {
+    CustomProjectionMesh *projection_mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL_V(projection_mesh, false);
+
+    const auto *data = get_direct_buffer_data<uint8_t>(env, buffer, size);
+    if (!data) {
+        ALOGE("Invalid spherical video buffer.");
+        return false;
+    }
+
+    SphericalVideoMetadata metadata;
+    if (!SphericalVideoParser::parse_buffer(data, size, &metadata)) {
+        return false;
+    }
+    return projection_mesh->set_spherical_video_mesh(metadata);
+}
+
+JNIEXPORT jboolean JNICALL JNI_METHOD(nativeWriteMeshFile)(
+        JNIEnv *env, jclass, jstring mesh_file_path, jfloatArray vertices,
+        jfloatArray texture_coords, jintArray indices, jint draw_mode_int) {
+    jfloat *vertices_jfloat = env->GetFloatArrayElements(vertices, nullptr);
+    jfloat *texture_coords_jfloat = env->GetFloatArrayElements(texture_coords, nullptr);
+    jint *indices_jint = indices ? env->GetIntArrayElements(indices, nullptr) : nullptr;
+
+    CustomMeshData mesh_data;
+    mesh_data.num_vertices = std::min(env->GetArrayLength(vertices) / 3,
+                                      env->GetArrayLength(texture_coords) / 2);
+    mesh_data.vertices = vertices_jfloat;
+    mesh_data.texture_coords = texture_coords_jfloat;
+    mesh_data.num_indices = indices ? env->GetArrayLength(indices) : 0;
+    mesh_data.indices = indices_jint;
+    mesh_data.draw_mode = draw_mode_int;
+
+    bool written = false;
+    if (are_valid_indices(mesh_data)) {
+        written = CustomProjectionMesh::write_mesh_file(jstring_to_string(env, mesh_file_path),
+                                                        mesh_data);
+    } else {
+        ALOGE("Invalid custom mesh indices.");
+    }
 
-    env->ReleaseFloatArrayElements(vertices_left, vertices_left_jfloat, 0);
-    env->ReleaseFloatArrayElements(texture_coords_left, texture_coords_left_jfloat, 0);
-    env->ReleaseFloatArrayElements(vertices_right, vertices_right_jfloat, 0);
-    env->ReleaseFloatArrayElements(texture_coords_right, texture_coords_right_jfloat, 0);
+    // The arrays are only read, skip copying them back.
+    env->ReleaseFloatArrayElements(vertices, vertices_jfloat, JNI_ABORT);
+    env->ReleaseFloatArrayElements(texture_coords, texture_coords_jfloat, JNI_ABORT);
+    if (indices) {
+        env->ReleaseIntArrayElements(indices, indices_jint, JNI_ABORT);
+    }
+    return written;
 }
 
 }
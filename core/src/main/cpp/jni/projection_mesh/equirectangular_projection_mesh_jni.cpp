@@ -0,0 +1,34 @@
+#include <jni.h>
+
+#include "gdn/projection_mesh/equirectangular_projection_mesh.h"
+#include "utils.h"
+
+// Current class and package names assumed for the Java side.
+#undef JNI_PACKAGE_NAME
+#define JNI_PACKAGE_NAME org_godotengine_plugin_gast_projectionmesh
+
+#undef JNI_CLASS_NAME
+#define JNI_CLASS_NAME EquirectangularProjectionMesh
+
+namespace {
+using namespace gast;
+using namespace godot;
+
+inline EquirectangularProjectionMesh *from_pointer(jlong equirectangular_projection_mesh_pointer) {
+    return reinterpret_cast<EquirectangularProjectionMesh *>(
+            equirectangular_projection_mesh_pointer);
+}
+
+}  // namespace
+
+extern "C" {
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetFoveatedTessellation)(JNIEnv *, jobject, jlong mesh_pointer,
+                                          jboolean enable) {
+    EquirectangularProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_foveated_tessellation(enable);
+}
+
+}
@@ -0,0 +1,33 @@
+#include <jni.h>
+
+#include "gdn/projection_mesh/hemisphere_projection_mesh.h"
+#include "utils.h"
+
+// Current class and package names assumed for the Java side.
+#undef JNI_PACKAGE_NAME
+#define JNI_PACKAGE_NAME org_godotengine_plugin_gast_projectionmesh
+
+#undef JNI_CLASS_NAME
+#define JNI_CLASS_NAME HemisphereProjectionMesh
+
+namespace {
+using namespace gast;
+using namespace godot;
+
+inline HemisphereProjectionMesh *from_pointer(jlong hemisphere_projection_mesh_pointer) {
+    return reinterpret_cast<HemisphereProjectionMesh *>(hemisphere_projection_mesh_pointer);
+}
+
+}  // namespace
+
+extern "C" {
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetResolution)(JNIEnv *, jobject, jlong mesh_pointer, jint band_count,
+                                jint sector_count) {
+    HemisphereProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_resolution(band_count, sector_count);
+}
+
+}
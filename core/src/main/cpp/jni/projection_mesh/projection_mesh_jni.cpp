@@ -34,10 +34,16 @@ JNIEXPORT jboolean JNICALL JNI_METHOD(isGazeTracking)(JNIEnv *, jobject, jlong m
 }
 
 JNIEXPORT void JNICALL
-JNI_METHOD(setGazeTracking)(JNIEnv *, jobject, jlong mesh_pointer, jboolean gaze_tracking) {
+JNI_METHOD(setGazeTracking)(JNIEnv *, jobject, jlong mesh_pointer, jlong node_pointer,
+                            jboolean gaze_tracking) {
     ProjectionMesh *mesh = from_pointer(mesh_pointer);
     ERR_FAIL_NULL(mesh);
     mesh->set_gaze_tracking(gaze_tracking);
+
+    auto *gast_node = reinterpret_cast<GastNode *>(node_pointer);
+    if (gast_node && gast_node->get_projection_mesh() == mesh) {
+        gast_node->on_gaze_tracking_updated();
+    }
 }
 
 JNIEXPORT jboolean JNICALL JNI_METHOD(isRenderOnTop)(JNIEnv *, jobject, jlong mesh_pointer) {
@@ -74,4 +80,26 @@ JNI_METHOD(setStereoMode)(JNIEnv *, jobject, jlong mesh_pointer, jint stereo_mod
     mesh->set_stereo_mode(static_cast<StereoMode>(stereo_mode));
 }
 
+JNIEXPORT void JNICALL
+JNI_METHOD(setVertexCompressionTextureSize)(JNIEnv *, jobject, jlong mesh_pointer,
+                                            jint texture_size) {
+    ProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_vertex_compression_texture_size(texture_size);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(setAsyncMeshBuild)(JNIEnv *, jobject, jlong mesh_pointer, jboolean enable) {
+    ProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_async_mesh_build(enable);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(setCollisionMode)(JNIEnv *, jobject, jlong mesh_pointer, jint mode) {
+    ProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_collision_mode(mode);
+}
+
 }
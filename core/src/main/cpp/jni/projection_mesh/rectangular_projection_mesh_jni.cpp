@@ -36,6 +36,21 @@ JNI_METHOD(nativeSetCurved)(JNIEnv *, jobject, jlong mesh_pointer, jboolean curv
     mesh->set_curved(curved);
 }
 
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetCurveRadius)(JNIEnv *, jobject, jlong mesh_pointer, jfloat radius) {
+    RectangularProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_curve_radius(radius);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeSetMaxChordError)(JNIEnv *, jobject, jlong mesh_pointer,
+                                   jfloat max_chord_error) {
+    RectangularProjectionMesh *mesh = from_pointer(mesh_pointer);
+    ERR_FAIL_NULL(mesh);
+    mesh->set_max_chord_error(max_chord_error);
+}
+
 JNIEXPORT jfloat JNICALL JNI_METHOD(getGradientHeightRatio)(JNIEnv *, jobject, jlong mesh_pointer) {
     RectangularProjectionMesh *mesh = from_pointer(mesh_pointer);
     ERR_FAIL_NULL_V(mesh, kDefaultGradientHeightRatio);
@@ -0,0 +1,86 @@
+#include <jni.h>
+#include <core/Defs.hpp>
+#include <core/Rect2.hpp>
+#include "gdn/gast_node.h"
+#include "gdn/texture_atlas.h"
+#include "utils.h"
+
+// Current class and package names assumed for the Java side.
+#undef JNI_PACKAGE_NAME
+#define JNI_PACKAGE_NAME org_godotengine_plugin_gast
+
+#undef JNI_CLASS_NAME
+#define JNI_CLASS_NAME GastTextureAtlas
+
+namespace {
+using namespace gast;
+using namespace godot;
+
+inline TextureAtlas *from_pointer(jlong texture_atlas_pointer) {
+    return reinterpret_cast<TextureAtlas *>(texture_atlas_pointer);
+}
+
+inline jlong to_pointer(TextureAtlas *texture_atlas) {
+    return reinterpret_cast<intptr_t>(texture_atlas);
+}
+
+inline GastNode *node_from_pointer(jlong gast_node_pointer) {
+    return reinterpret_cast<GastNode *>(gast_node_pointer);
+}
+
+}  // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+JNI_METHOD(nativeCreateTextureAtlas)(JNIEnv *, jobject, jint width, jint height) {
+    if (width <= 0 || height <= 0) {
+        ALOGE("Invalid texture atlas size %dx%d", width, height);
+        return 0;
+    }
+    return to_pointer(new TextureAtlas(width, height));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeReleaseTextureAtlas)(JNIEnv *, jobject, jlong atlas_pointer) {
+    delete from_pointer(atlas_pointer);
+}
+
+JNIEXPORT jint JNICALL
+JNI_METHOD(nativeGetTextureId)(JNIEnv *, jobject, jlong atlas_pointer) {
+    TextureAtlas *texture_atlas = from_pointer(atlas_pointer);
+    ERR_FAIL_NULL_V(texture_atlas, kInvalidTexId);
+    return texture_atlas->get_external_texture_id();
+}
+
+JNIEXPORT jintArray JNICALL
+JNI_METHOD(nativeAddNode)(JNIEnv *env, jobject, jlong atlas_pointer, jlong node_pointer,
+                          jint width, jint height) {
+    TextureAtlas *texture_atlas = from_pointer(atlas_pointer);
+    ERR_FAIL_NULL_V(texture_atlas, nullptr);
+
+    GastNode *gast_node = node_from_pointer(node_pointer);
+    ERR_FAIL_NULL_V(gast_node, nullptr);
+
+    if (!texture_atlas->add_node(gast_node, width, height)) {
+        return nullptr;
+    }
+
+    Rect2 region = texture_atlas->get_node_region(gast_node);
+    jint region_values[4] = {static_cast<jint>(region.position.x),
+                             static_cast<jint>(region.position.y),
+                             static_cast<jint>(region.size.x),
+                             static_cast<jint>(region.size.y)};
+    jintArray result = env->NewIntArray(4);
+    env->SetIntArrayRegion(result, 0, 4, region_values);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeRemoveNode)(JNIEnv *, jobject, jlong atlas_pointer, jlong node_pointer) {
+    TextureAtlas *texture_atlas = from_pointer(atlas_pointer);
+    ERR_FAIL_NULL(texture_atlas);
+    texture_atlas->remove_node(node_from_pointer(node_pointer));
+}
+
+}
@@ -0,0 +1,43 @@
+#include <jni.h>
+#include "gdn/gast_node.h"
+#include "gdn/surface_texture_source.h"
+#include "gast_manager.h"
+#include "utils.h"
+
+// Current class and package names assumed for the Java side.
+#undef JNI_PACKAGE_NAME
+#define JNI_PACKAGE_NAME org_godotengine_plugin_gast
+
+#undef JNI_CLASS_NAME
+#define JNI_CLASS_NAME GastTextureSource
+
+using namespace gast;
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+JNI_METHOD(nativeRegisterTextureSource)(JNIEnv *env, jobject, jobject surface_texture,
+                                        jlong owner_node_pointer) {
+    std::unique_ptr<SurfaceTextureSource> source =
+            SurfaceTextureSource::create(env, surface_texture);
+    if (!source) {
+        return 0;
+    }
+
+    return GastManager::get_singleton_instance()->get_texture_latch_pump().register_source(
+            std::move(source), reinterpret_cast<GastNode *>(owner_node_pointer));
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeUnregisterTextureSource)(JNIEnv *, jobject, jlong source_handle) {
+    GastManager::get_singleton_instance()->get_texture_latch_pump().unregister_source(
+            source_handle);
+}
+
+JNIEXPORT void JNICALL
+JNI_METHOD(nativeOnFrameAvailable)(JNIEnv *, jobject, jlong source_handle) {
+    GastManager::get_singleton_instance()->get_texture_latch_pump().on_frame_available(
+            source_handle);
+}
+
+}
@@ -15,11 +15,13 @@ import org.godotengine.plugin.gast.input.GastInputListener
 import org.godotengine.plugin.gast.input.HoverEventData
 import org.godotengine.plugin.gast.input.InputDispatcher
 import org.godotengine.plugin.gast.input.InputEventData
+import org.godotengine.plugin.gast.input.MultiPointerEventData
 import org.godotengine.plugin.gast.input.PressEventData
 import org.godotengine.plugin.gast.input.ReleaseEventData
 import org.godotengine.plugin.gast.input.ScrollEventData
 import org.godotengine.plugin.gast.input.action.GastActionListener
 import org.godotengine.plugin.gast.input.action.InputActionDispatcher
+import java.io.File
 import java.util.ArrayDeque
 import java.util.Queue
 import java.util.concurrent.ConcurrentHashMap
@@ -41,6 +43,8 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
     }
 
     private val gastRenderListeners = ConcurrentLinkedQueue<GastRenderListener>()
+    private val gastNodes = ConcurrentHashMap<Long, GastNode>()
+    private val gastPanelArrays = ConcurrentHashMap<Long, GastPanelArray>()
     private val gastInputListeners = ConcurrentLinkedQueue<GastInputListener>()
 
     private val gastActionListenersPerActions = ConcurrentHashMap<String, ArrayDeque<GastActionListener>>()
@@ -55,6 +59,7 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
 
     companion object {
         private val TAG = GastManager::class.java.simpleName
+        private const val MESH_CACHE_DIRECTORY_NAME = "gast_mesh_cache"
     }
 
     override fun onGodotMainLoopStarted() {
@@ -63,6 +68,7 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
         initialized.set(true)
 
         updateMonitoredInputActions()
+        updateSinglePointerInputEnabled()
     }
 
     override fun onMainCreate(activity: Activity): View? {
@@ -110,6 +116,57 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
         gastRenderListeners -= listener
     }
 
+    internal fun registerGastNode(nodePointer: Long, gastNode: GastNode) {
+        gastNodes[nodePointer] = gastNode
+    }
+
+    internal fun unregisterGastNode(nodePointer: Long) {
+        gastNodes.remove(nodePointer)
+    }
+
+    internal fun registerGastPanelArray(panelArrayPointer: Long, panelArray: GastPanelArray) {
+        gastPanelArrays[panelArrayPointer] = panelArray
+    }
+
+    internal fun unregisterGastPanelArray(panelArrayPointer: Long) {
+        gastPanelArrays.remove(panelArrayPointer)
+    }
+
+    /**
+     * Update the total number of texture pixels shared by the [GastNode]s with automatic texture
+     * sizing enabled.
+     *
+     * @see GastNode.setAutoTextureSize
+     */
+    fun setTexturePixelBudget(pixelBudget: Long) {
+        if (initialized.get()) {
+            runOnRenderThread {
+                nativeSetTexturePixelBudget(pixelBudget)
+            }
+        }
+    }
+
+    /**
+     * Enable or disable the on-disk cache of the generated projection meshes (spheres and curved
+     * screens), so they're loaded from the app's cache directory instead of being recomputed on
+     * the following starts.
+     *
+     * Disabled by default. Should be enabled before the [GastNode]s are created.
+     */
+    fun setMeshCacheEnabled(enable: Boolean) {
+        var cacheDirectory = ""
+        val appCacheDirectory = activity?.cacheDir
+        if (enable && appCacheDirectory != null) {
+            val directory = File(appCacheDirectory, MESH_CACHE_DIRECTORY_NAME)
+            if (directory.isDirectory || directory.mkdirs()) {
+                cacheDirectory = directory.absolutePath
+            } else {
+                Log.w(TAG, "Unable to create the mesh cache directory.")
+            }
+        }
+        nativeSetMeshCacheDirectory(cacheDirectory)
+    }
+
     /**
      * Register a [GastActionListener] instance to be notified of input action related events.
      */
@@ -152,6 +209,7 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
      */
     fun registerGastInputListener(listener: GastInputListener) {
         gastInputListeners += listener
+        updateSinglePointerInputEnabled()
     }
 
     /**
@@ -159,6 +217,7 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
      */
     fun unregisterGastInputListener(listener: GastInputListener) {
         gastInputListeners -= listener
+        updateSinglePointerInputEnabled()
     }
 
     /**
@@ -177,6 +236,15 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
         }
     }
 
+    private fun updateSinglePointerInputEnabled() {
+        if (initialized.get()) {
+            // Skip the single pointer events in the native code when no listener handles them
+            nativeSetSinglePointerInputEnabled(
+                gastInputListeners.any { it.isSinglePointerInputEnabled() }
+            )
+        }
+    }
+
     private inline fun dispatchInputEvent(
         listeners: Queue<GastInputListener>?,
         eventDataProvider : () -> InputEventData
@@ -220,6 +288,20 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
 
     private external fun setInputActionsToMonitor(inputActions: Array<String>)
 
+    private external fun nativeSetSinglePointerInputEnabled(enabled: Boolean)
+
+    private external fun nativeSetTexturePixelBudget(pixelBudget: Long)
+
+    private external fun nativeSetMeshCacheDirectory(directory: String)
+
+    private fun onRenderRecommendedTextureSizeUpdate(nodePointer: Long, width: Int, height: Int) {
+        gastNodes[nodePointer]?.onRenderRecommendedTextureSizeUpdate(width, height)
+    }
+
+    private fun onRenderVisibilityStateUpdate(nodePointer: Long, visibilityState: Int) {
+        gastNodes[nodePointer]?.onRenderVisibilityStateUpdate(visibilityState)
+    }
+
     private fun onRenderInputAction(action: String, pressStateIndex: Int, strength: Float) {
         val pressState = GastActionListener.InputPressState.fromIndex(pressStateIndex)
         if (pressState == GastActionListener.InputPressState.INVALID) {
@@ -287,4 +369,89 @@ class GastManager(godot: Godot) : GodotPlugin(godot) {
         }
     }
 
+    private fun onRenderMultiPointerInput(
+        nodePath: String,
+        pointerIndices: IntArray,
+        pointerIds: Array<String>,
+        pointerStates: IntArray,
+        pointerCoordinates: FloatArray
+    ) {
+        dispatchInputEvent(gastInputListeners) {
+            val pointers = pointerIndices.indices.map {
+                GastInputListener.Pointer(
+                    pointerIndices[it],
+                    pointerIds[it],
+                    GastInputListener.PointerState.fromIndex(pointerStates[it]),
+                    pointerCoordinates[it * 2],
+                    pointerCoordinates[it * 2 + 1]
+                )
+            }
+            MultiPointerEventData(nodePath, pointers)
+        }
+    }
+
+    private fun onRenderPanelInputHover(
+        panelArrayPointer: Long,
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float
+    ) {
+        gastPanelArrays[panelArrayPointer]?.onRenderInputHover(
+            panelIndex,
+            pointerId,
+            xPercent,
+            yPercent
+        )
+    }
+
+    private fun onRenderPanelInputPress(
+        panelArrayPointer: Long,
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float
+    ) {
+        gastPanelArrays[panelArrayPointer]?.onRenderInputPress(
+            panelIndex,
+            pointerId,
+            xPercent,
+            yPercent
+        )
+    }
+
+    private fun onRenderPanelInputRelease(
+        panelArrayPointer: Long,
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float
+    ) {
+        gastPanelArrays[panelArrayPointer]?.onRenderInputRelease(
+            panelIndex,
+            pointerId,
+            xPercent,
+            yPercent
+        )
+    }
+
+    private fun onRenderPanelInputScroll(
+        panelArrayPointer: Long,
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float,
+        horizontalDelta: Float,
+        verticalDelta: Float
+    ) {
+        gastPanelArrays[panelArrayPointer]?.onRenderInputScroll(
+            panelIndex,
+            pointerId,
+            xPercent,
+            yPercent,
+            horizontalDelta,
+            verticalDelta
+        )
+    }
+
 }
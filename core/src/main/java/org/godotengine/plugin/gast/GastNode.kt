@@ -3,17 +3,20 @@ package org.godotengine.plugin.gast
 import android.graphics.Canvas
 import android.graphics.Color
 import android.graphics.PorterDuff
+import android.graphics.Rect
 import android.graphics.SurfaceTexture
 import android.os.Build
 import android.text.TextUtils
+import android.util.Size
 import android.view.Surface
 import androidx.annotation.RequiresApi
 import org.godotengine.plugin.gast.projectionmesh.CustomProjectionMesh
+import org.godotengine.plugin.gast.projectionmesh.EacProjectionMesh
 import org.godotengine.plugin.gast.projectionmesh.EquirectangularProjectionMesh
+import org.godotengine.plugin.gast.projectionmesh.HemisphereProjectionMesh
 import org.godotengine.plugin.gast.projectionmesh.ProjectionMesh
 import org.godotengine.plugin.gast.projectionmesh.RectangularProjectionMesh
 import java.util.BitSet
-import java.util.concurrent.atomic.AtomicInteger
 
 /**
  * @constructor Create a Gast node with the given parent node and set it up.
@@ -25,15 +28,55 @@ class GastNode @JvmOverloads constructor(
     private val gastManager: GastManager,
     private var parentNodePath: String = "",
     emptyParent: Boolean = false
-) : SurfaceTexture.OnFrameAvailableListener, GastRenderListener {
-
-    private val updateTextureImageCounter = AtomicInteger()
+) {
 
     private var surfaceTexture: SurfaceTexture? = null
+    private var textureSource: GastTextureSource? = null
     private var surface: Surface? = null
     private var surfaceCanvas: Canvas? = null
     private var surfaceCanvasRefCount = 0
 
+    // Size of the content drawn into the surface, as requested via [setSurfaceTextureSize].
+    private var contentWidth = 0
+    private var contentHeight = 0
+
+    // Size of the surface texture buffers. Differs from the content size when automatic texture
+    // sizing is enabled.
+    @Volatile
+    private var bufferWidth = 0
+    @Volatile
+    private var bufferHeight = 0
+
+    @Volatile
+    private var autoTextureSize = false
+    @Volatile
+    private var recommendedTextureSize: Size? = null
+
+    /**
+     * Invoked when the size of the surface texture buffers is updated.
+     */
+    var onSurfaceTextureSizeChanged: Runnable? = null
+
+    @Volatile
+    private var textureAtlas: GastTextureAtlas? = null
+    // Region of the texture atlas allocated to this node.
+    @Volatile
+    private var textureAtlasRegion: Rect? = null
+
+    /**
+     * Invoked when the content drawn into the surface is lost and must be redrawn (e.g: the node
+     * moved to a new texture atlas region).
+     */
+    var onSurfaceContentInvalidated: Runnable? = null
+
+    @Volatile
+    private var visibilityState = VisibilityState.HIDDEN
+
+    /**
+     * Invoked on the render thread when the node's [VisibilityState] is updated.
+     */
+    var onVisibilityStateChanged: Runnable? = null
+
     private var nodePointer: Long
     val nodePath get() = nativeGetNodePath(nodePointer)
 
@@ -44,6 +87,50 @@ class GastNode @JvmOverloads constructor(
         RECTANGULAR,
         EQUIRECTANGULAR,
         MESH,
+        EAC,
+        HEMISPHERE_180,
+    }
+
+    // Mirrors enum GazeFollowMode in src/main/cpp/gdn/gast_node.h
+    enum class GazeFollowMode {
+        /**
+         * The node is re-positioned every frame to exactly follow the user's gaze.
+         */
+        STRICT,
+
+        /**
+         * The node only moves when the user's gaze leaves the angular dead zone around it, and
+         * then smoothly settles back to the center of the gaze.
+         */
+        LAZY,
+    }
+
+    // Mirrors enum VisibilityState in src/main/cpp/gdn/gast_node.h
+    enum class VisibilityState {
+        /**
+         * The node is potentially visible on screen.
+         */
+        VISIBLE,
+
+        /**
+         * The node is hidden, or not part of the scene tree.
+         */
+        HIDDEN,
+
+        /**
+         * The node's bounds are outside of the camera's frustum.
+         */
+        OUT_OF_FRUSTUM,
+
+        /**
+         * The node is fully covered by an opaque node rendered on top.
+         */
+        OCCLUDED,
+
+        /**
+         * The node's alpha is too low for its content to be seen.
+         */
+        TRANSPARENT,
     }
 
     init {
@@ -57,7 +144,7 @@ class GastNode @JvmOverloads constructor(
             throw IllegalStateException("Unable to initialize node texture.")
         }
 
-        gastManager.registerGastRenderListener(this)
+        gastManager.registerGastNode(nodePointer, this)
     }
 
     fun getProjectionMesh() : ProjectionMesh {
@@ -78,6 +165,11 @@ class GastNode @JvmOverloads constructor(
             ProjectionMeshType.MESH -> {
                 projectionMeshPool[meshPointer] = CustomProjectionMesh(meshPointer, nodePointer)
             }
+            ProjectionMeshType.EAC ->
+                projectionMeshPool[meshPointer] = EacProjectionMesh(meshPointer, nodePointer)
+            ProjectionMeshType.HEMISPHERE_180 ->
+                projectionMeshPool[meshPointer] =
+                    HemisphereProjectionMesh(meshPointer, nodePointer)
         }
 
         return projectionMeshPool.getValue(meshPointer)
@@ -116,7 +208,11 @@ class GastNode @JvmOverloads constructor(
             return
         }
 
-        gastManager.unregisterGastRenderListener(this)
+        gastManager.unregisterGastNode(nodePointer)
+
+        textureAtlas?.removeNode(this, nodePointer)
+        textureAtlas = null
+        textureAtlasRegion = null
 
         unbindSurface()
         unbindAndReleaseGastNode(nodePointer)
@@ -135,8 +231,9 @@ class GastNode @JvmOverloads constructor(
                 throw IllegalStateException("Unable to initialize node texture.")
             }
 
-            surfaceTexture = SurfaceTexture(texId)
-            surfaceTexture?.setOnFrameAvailableListener(this)
+            val texture = SurfaceTexture(texId)
+            surfaceTexture = texture
+            textureSource = GastTextureSource(texture, nodePointer)
         }
 
         if (surface == null) {
@@ -155,10 +252,16 @@ class GastNode @JvmOverloads constructor(
             surface = null
         }
 
+        textureSource?.release()
+        textureSource = null
+
         if (surfaceTexture != null) {
             surfaceTexture?.release()
             surfaceTexture = null
         }
+
+        bufferWidth = 0
+        bufferHeight = 0
     }
 
     fun isReleased() = nodePointer == INVALID_NODE_POINTER
@@ -176,8 +279,208 @@ class GastNode @JvmOverloads constructor(
      * @throws IllegalStateException if a [Surface] is not bound to this [GastNode] node.
      */
     fun setSurfaceTextureSize(width: Int, height: Int) {
-        surfaceTexture?.setDefaultBufferSize(width, height)
-            ?: throw IllegalStateException("No Surface object bound to this node.")
+        if (surfaceTexture == null) {
+            throw IllegalStateException("No Surface object bound to this node.")
+        }
+
+        contentWidth = width
+        contentHeight = height
+        updateSurfaceTextureBufferSize()
+        updateTextureAtlasRegion()
+    }
+
+    /**
+     * Draw this node's content into a region of the given shared [GastTextureAtlas] instead of
+     * its own surface. Pass null to go back to the node's own surface.
+     *
+     * The region is sized using the size passed to [setSurfaceTextureSize]. Automatic texture
+     * sizing (see [setAutoTextureSize]) doesn't apply while the node uses a texture atlas.
+     */
+    fun setTextureAtlas(atlas: GastTextureAtlas?) {
+        checkIfReleased()
+        val previousAtlas = textureAtlas
+        if (previousAtlas == atlas) {
+            return
+        }
+
+        textureAtlas = atlas
+        textureAtlasRegion = null
+        gastManager.runOnRenderThread {
+            if (!isReleased()) {
+                previousAtlas?.removeNode(this, nodePointer)
+            }
+        }
+        updateTextureAtlasRegion()
+        onSurfaceContentInvalidated?.run()
+    }
+
+    /**
+     * Returns the region of the texture atlas allocated to this node, or null if none is
+     * available.
+     */
+    fun getTextureAtlasRegion(): Rect? = textureAtlasRegion?.let { Rect(it) }
+
+    private fun updateTextureAtlasRegion() {
+        val atlas = textureAtlas ?: return
+        val width = contentWidth
+        val height = contentHeight
+        if (width <= 0 || height <= 0) {
+            return
+        }
+
+        val region = textureAtlasRegion
+        if (region != null && region.width() == width && region.height() == height) {
+            return
+        }
+
+        gastManager.runOnRenderThread {
+            if (isReleased() || textureAtlas != atlas) {
+                return@runOnRenderThread
+            }
+
+            textureAtlasRegion = atlas.addNode(this, nodePointer, width, height)
+            onSurfaceContentInvalidated?.run()
+        }
+    }
+
+    internal fun onTextureAtlasReleased(atlas: GastTextureAtlas) {
+        if (textureAtlas != atlas) {
+            return
+        }
+
+        textureAtlas = null
+        textureAtlasRegion = null
+        onSurfaceContentInvalidated?.run()
+    }
+
+    /**
+     * Enable or disable automatic texture sizing for this [GastNode] node.
+     *
+     * When enabled, the surface texture buffers are sized based on how large the node appears on
+     * screen (within the pixel budget set via [GastManager.setTexturePixelBudget]) instead of the
+     * size passed to [setSurfaceTextureSize]. Content drawn via [lockSurfaceCanvas] is scaled
+     * to match.
+     */
+    fun setAutoTextureSize(enable: Boolean) {
+        checkIfReleased()
+        if (autoTextureSize == enable) {
+            return
+        }
+
+        autoTextureSize = enable
+        recommendedTextureSize = null
+        gastManager.runOnRenderThread {
+            if (!isReleased()) {
+                setTextureSizeTracking(nodePointer, enable)
+            }
+        }
+        updateSurfaceTextureBufferSize()
+    }
+
+    private external fun setTextureSizeTracking(nodePointer: Long, enable: Boolean)
+
+    /**
+     * Returns the texture size recommended for this node based on its on-screen size, or null if
+     * none is available.
+     *
+     * Recommendations are only computed when automatic texture sizing is enabled.
+     */
+    fun getRecommendedTextureSize(): Size? = recommendedTextureSize
+
+    internal fun onRenderRecommendedTextureSizeUpdate(width: Int, height: Int) {
+        recommendedTextureSize = Size(width, height)
+        updateSurfaceTextureBufferSize()
+    }
+
+    /**
+     * Returns the node's [VisibilityState], as computed on the last rendered frame.
+     *
+     * Texture updates are throttled while the node is not [VisibilityState.VISIBLE], so producers
+     * should pause or slow down their rendering.
+     */
+    fun getVisibilityState() = visibilityState
+
+    /**
+     * Rolling statistics of the frames latched into the node's surface texture, over the last
+     * rendered frames.
+     *
+     * @property latencySampleCount Number of displayed frames the latency percentiles are
+     * computed from. Frames without a monotonic producer timestamp are not counted
+     * @property latencyP50Ms Median delay between the producer timestamp of the displayed frames
+     * and their latch, in milliseconds. Negative if the frames are latched ahead of their timestamp
+     * @property latencyP95Ms 95th percentile of the delay, in milliseconds
+     * @property latencyP99Ms 99th percentile of the delay, in milliseconds
+     * @property dropRate Ratio of the latched frames dropped in favor of a newer frame
+     * @property skipRate Ratio of the rendered frames for which the latches were skipped because
+     * the node couldn't be seen
+     * @property latchedFrameCount Total number of latched frames
+     * @property droppedFrameCount Total number of dropped frames
+     * @property skippedLatchCount Total number of rendered frames with skipped latches
+     */
+    data class FrameStats(
+        val latencySampleCount: Int,
+        val latencyP50Ms: Float,
+        val latencyP95Ms: Float,
+        val latencyP99Ms: Float,
+        val dropRate: Float,
+        val skipRate: Float,
+        val latchedFrameCount: Long,
+        val droppedFrameCount: Long,
+        val skippedLatchCount: Long
+    )
+
+    /**
+     * Returns the [FrameStats] of the node's surface texture, or null if no surface is bound.
+     *
+     * The frames of a [GastTextureAtlas] are shared by all of its nodes and are not attributed
+     * to any of them, so the nodes rendering from an atlas have no stats.
+     */
+    fun getFrameStats(): FrameStats? {
+        checkIfReleased()
+        val stats = nativeGetFrameStats(nodePointer) ?: return null
+        return FrameStats(
+            stats[0].toInt(),
+            stats[1].toFloat(),
+            stats[2].toFloat(),
+            stats[3].toFloat(),
+            stats[4].toFloat(),
+            stats[5].toFloat(),
+            stats[6].toLong(),
+            stats[7].toLong(),
+            stats[8].toLong()
+        )
+    }
+
+    private external fun nativeGetFrameStats(nodePointer: Long): DoubleArray?
+
+    internal fun onRenderVisibilityStateUpdate(visibilityStateIndex: Int) {
+        visibilityState = VisibilityState.values()[visibilityStateIndex]
+        onVisibilityStateChanged?.run()
+    }
+
+    @Synchronized
+    private fun updateSurfaceTextureBufferSize() {
+        val texture = surfaceTexture ?: return
+
+        val recommendedSize = recommendedTextureSize
+        val width: Int
+        val height: Int
+        if (autoTextureSize && recommendedSize != null) {
+            width = recommendedSize.width
+            height = recommendedSize.height
+        } else {
+            width = contentWidth
+            height = contentHeight
+        }
+
+        if (width <= 0 || height <= 0 || (width == bufferWidth && height == bufferHeight)) {
+            return
+        }
+
+        texture.setDefaultBufferSize(width, height)
+        bufferWidth = width
+        bufferHeight = height
+        onSurfaceTextureSizeChanged?.run()
     }
 
     /**
@@ -193,6 +496,12 @@ class GastNode @JvmOverloads constructor(
         val boundSurface =
             surface ?: throw IllegalStateException("No Surface object bound to this node.")
 
+        val atlas = textureAtlas
+        if (atlas != null) {
+            val region = textureAtlasRegion ?: return null
+            return atlas.lockCanvas(this, region)
+        }
+
         if (!boundSurface.isValid) {
             return null
         }
@@ -204,6 +513,15 @@ class GastNode @JvmOverloads constructor(
 
             surfaceCanvas = boundSurface.lockCanvas(null)
             surfaceCanvas?.drawColor(Color.TRANSPARENT, PorterDuff.Mode.CLEAR)
+
+            // Scale the content to fit the surface texture buffers.
+            if (contentWidth > 0 && contentHeight > 0 &&
+                (bufferWidth != contentWidth || bufferHeight != contentHeight)) {
+                surfaceCanvas?.scale(
+                    bufferWidth.toFloat() / contentWidth,
+                    bufferHeight.toFloat() / contentHeight
+                )
+            }
         }
         surfaceCanvasRefCount++
         return surfaceCanvas
@@ -219,6 +537,12 @@ class GastNode @JvmOverloads constructor(
         val boundSurface =
             surface ?: throw IllegalStateException("No Surface object bound to this node.")
 
+        val atlas = textureAtlas
+        if (atlas != null) {
+            atlas.unlockCanvas(this)
+            return
+        }
+
         if (surfaceCanvas == null || surfaceCanvasRefCount == 0) {
             return
         }
@@ -332,6 +656,45 @@ class GastNode @JvmOverloads constructor(
 
     private external fun setGazeTracking(nodePointer: Long, gaze_tracking: Boolean)
 
+    fun getGazeFollowMode(): GazeFollowMode {
+        checkIfReleased()
+        return GazeFollowMode.values()[nativeGetGazeFollowMode(nodePointer)]
+    }
+
+    private external fun nativeGetGazeFollowMode(nodePointer: Long): Int
+
+    /**
+     * Specifies how the node follows the user's gaze when gaze tracking is enabled.
+     * Defaults to [GazeFollowMode.STRICT].
+     */
+    fun setGazeFollowMode(mode: GazeFollowMode) {
+        checkIfReleased()
+        nativeSetGazeFollowMode(nodePointer, mode.ordinal)
+    }
+
+    private external fun nativeSetGazeFollowMode(nodePointer: Long, mode: Int)
+
+    /**
+     * Update the angular dead zone (in degrees) used by the [GazeFollowMode.LAZY] follow mode.
+     */
+    fun setGazeFollowDeadZone(deadZoneDegrees: Float) {
+        checkIfReleased()
+        setGazeFollowDeadZone(nodePointer, deadZoneDegrees)
+    }
+
+    private external fun setGazeFollowDeadZone(nodePointer: Long, deadZoneDegrees: Float)
+
+    /**
+     * Update the approximate time (in seconds) the node takes to settle back to the center of the
+     * gaze when using the [GazeFollowMode.LAZY] follow mode.
+     */
+    fun setGazeFollowSmoothingTime(smoothingTime: Float) {
+        checkIfReleased()
+        setGazeFollowSmoothingTime(nodePointer, smoothingTime)
+    }
+
+    private external fun setGazeFollowSmoothingTime(nodePointer: Long, smoothingTime: Float)
+
     fun isRenderOnTop(): Boolean {
         checkIfReleased()
         return isRenderOnTop(nodePointer)
@@ -463,16 +826,4 @@ class GastNode @JvmOverloads constructor(
     )
 
     private external fun nativeGetNodePath(nodePointer: Long): String
-
-    override fun onFrameAvailable(surfaceTexture: SurfaceTexture) {
-        updateTextureImageCounter.incrementAndGet()
-    }
-
-    override fun onRenderDrawFrame() {
-        var counter = updateTextureImageCounter.get()
-        while (counter > 0) {
-            surfaceTexture?.updateTexImage()
-            counter = updateTextureImageCounter.decrementAndGet()
-        }
-    }
 }
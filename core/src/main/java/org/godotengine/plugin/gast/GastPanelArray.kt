@@ -0,0 +1,376 @@
+package org.godotengine.plugin.gast
+
+import android.graphics.Canvas
+import android.graphics.Rect
+import android.graphics.SurfaceTexture
+import android.os.Handler
+import android.os.Looper
+import android.view.Surface
+import java.util.concurrent.ConcurrentLinkedQueue
+
+/**
+ * Array of identically shaped flat panels, rendered with a single draw call.
+ *
+ * The panels share the array's texture (e.g: an atlas of thumbnails), each sampling its own region
+ * of it (see [setPanelTextureRegion]). This is cheaper than a [GastNode] per panel for large
+ * grids and carousels, at the cost of a common size and texture for all the panels.
+ *
+ * Must be created and released on the render thread.
+ *
+ * @constructor Create a panel array as a child of the given parent node.
+ * @property parentNodePath Path to the parent node. The parent node must exist
+ * @property textureWidth Width of the shared texture, in pixels
+ * @property textureHeight Height of the shared texture, in pixels
+ */
+class GastPanelArray(
+    private val gastManager: GastManager,
+    parentNodePath: String,
+    val textureWidth: Int,
+    val textureHeight: Int
+) {
+
+    /**
+     * Listener for the ray cast input events targeting the panels.
+     *
+     * The callbacks are invoked on the main thread.
+     */
+    interface InputListener {
+        fun onPanelInputHover(panelIndex: Int, pointerId: String, xPercent: Float, yPercent: Float)
+
+        fun onPanelInputPress(panelIndex: Int, pointerId: String, xPercent: Float, yPercent: Float)
+
+        fun onPanelInputRelease(
+            panelIndex: Int,
+            pointerId: String,
+            xPercent: Float,
+            yPercent: Float
+        )
+
+        fun onPanelInputScroll(
+            panelIndex: Int,
+            pointerId: String,
+            xPercent: Float,
+            yPercent: Float,
+            horizontalDelta: Float,
+            verticalDelta: Float
+        )
+    }
+
+    private val inputListeners = ConcurrentLinkedQueue<InputListener>()
+    private val mainThreadHandler = Handler(Looper.getMainLooper())
+
+    private var panelArrayPointer: Long
+    private val surfaceTexture: SurfaceTexture
+    private val textureSource: GastTextureSource
+    private val surface: Surface
+
+    private var surfaceCanvas: Canvas? = null
+    private var surfaceCanvasRefCount = 0
+
+    val nodePath get() = nativeGetNodePath(panelArrayPointer)
+
+    companion object {
+        private const val INVALID_TEX_ID = 0
+        private const val INVALID_PANEL_ARRAY_POINTER = 0L
+    }
+
+    init {
+        panelArrayPointer = nativeCreatePanelArray(parentNodePath)
+        if (panelArrayPointer == INVALID_PANEL_ARRAY_POINTER) {
+            throw IllegalStateException("Unable to initialize panel array")
+        }
+
+        val texId = nativeGetTextureId(panelArrayPointer)
+        if (texId == INVALID_TEX_ID) {
+            nativeReleasePanelArray(panelArrayPointer)
+            throw IllegalStateException("Unable to initialize panel array texture.")
+        }
+
+        nativeSetTextureSize(panelArrayPointer, textureWidth, textureHeight)
+        surfaceTexture = SurfaceTexture(texId)
+        surfaceTexture.setDefaultBufferSize(textureWidth, textureHeight)
+        textureSource = GastTextureSource(surfaceTexture)
+        surface = Surface(surfaceTexture)
+
+        gastManager.registerGastPanelArray(panelArrayPointer, this)
+    }
+
+    fun isReleased() = panelArrayPointer == INVALID_PANEL_ARRAY_POINTER
+
+    private fun checkIfReleased() {
+        if (isReleased()) {
+            throw IllegalStateException("Panel array is released.")
+        }
+    }
+
+    /**
+     * Release the [GastPanelArray].
+     *
+     * The panel array is no longer usable after this method is invoked.
+     */
+    fun release() {
+        if (isReleased()) {
+            return
+        }
+
+        gastManager.unregisterGastPanelArray(panelArrayPointer)
+        inputListeners.clear()
+
+        surface.release()
+        textureSource.release()
+        surfaceTexture.release()
+        nativeReleasePanelArray(panelArrayPointer)
+        panelArrayPointer = INVALID_PANEL_ARRAY_POINTER
+    }
+
+    fun registerInputListener(listener: InputListener) {
+        inputListeners += listener
+    }
+
+    fun unregisterInputListener(listener: InputListener) {
+        inputListeners -= listener
+    }
+
+    /**
+     * Gets a [Canvas] for drawing into the shared texture.
+     *
+     * @param dirty Region of the texture to redraw, or null to redraw the whole texture
+     */
+    fun lockCanvas(dirty: Rect? = null): Canvas? {
+        if (isReleased() || !surface.isValid) {
+            return null
+        }
+
+        if (surfaceCanvas == null) {
+            if (surfaceCanvasRefCount != 0) {
+                throw IllegalStateException("Invalid surface canvas state.")
+            }
+            surfaceCanvas = surface.lockCanvas(dirty)
+        }
+
+        surfaceCanvasRefCount++
+        return surfaceCanvas
+    }
+
+    /**
+     * Post the new contents and release the [Canvas] previously locked via [lockCanvas].
+     */
+    fun unlockCanvas() {
+        val canvas = surfaceCanvas
+        if (canvas == null || surfaceCanvasRefCount == 0) {
+            return
+        }
+
+        surfaceCanvasRefCount--
+        if (surfaceCanvasRefCount == 0) {
+            surface.unlockCanvasAndPost(canvas)
+            surfaceCanvas = null
+        }
+    }
+
+    /**
+     * Set the number of panels. The new panels are placed at the array's origin and sample the
+     * whole texture.
+     */
+    fun setPanelCount(count: Int) {
+        checkIfReleased()
+        nativeSetPanelCount(panelArrayPointer, count)
+    }
+
+    /**
+     * Set the size of the panels, in the array's local space.
+     */
+    fun setPanelSize(width: Float, height: Float) {
+        checkIfReleased()
+        nativeSetPanelSize(panelArrayPointer, width, height)
+    }
+
+    /**
+     * Set the transform of the given panel, relative to the array.
+     *
+     * @param xRotation Rotation around the x axis, in degrees
+     * @param yRotation Rotation around the y axis, in degrees
+     * @param zRotation Rotation around the z axis, in degrees
+     */
+    @JvmOverloads
+    fun setPanelTransform(
+        index: Int,
+        xTranslation: Float,
+        yTranslation: Float,
+        zTranslation: Float,
+        xRotation: Float = 0f,
+        yRotation: Float = 0f,
+        zRotation: Float = 0f,
+        scale: Float = 1f
+    ) {
+        checkIfReleased()
+        nativeSetPanelTransform(
+            panelArrayPointer,
+            index,
+            xTranslation,
+            yTranslation,
+            zTranslation,
+            xRotation,
+            yRotation,
+            zRotation,
+            scale
+        )
+    }
+
+    /**
+     * Move the first panels to the given positions at once, keeping their orientation.
+     *
+     * @param positions Panel positions [x1, y1, z1 ... xn, yn, zn], relative to the array
+     */
+    fun setPanelPositions(positions: FloatArray) {
+        checkIfReleased()
+        nativeSetPanelPositions(panelArrayPointer, positions)
+    }
+
+    /**
+     * Set the region of the shared texture sampled by the given panel.
+     *
+     * @param region Texture region, in pixels
+     */
+    fun setPanelTextureRegion(index: Int, region: Rect) {
+        checkIfReleased()
+        nativeSetPanelTextureRegion(
+            panelArrayPointer,
+            index,
+            region.left.toFloat() / textureWidth,
+            region.top.toFloat() / textureHeight,
+            region.width().toFloat() / textureWidth,
+            region.height().toFloat() / textureHeight
+        )
+    }
+
+    fun setAlpha(alpha: Float) {
+        checkIfReleased()
+        nativeSetAlpha(panelArrayPointer, alpha)
+    }
+
+    fun setHasTransparency(hasTransparency: Boolean) {
+        checkIfReleased()
+        nativeSetHasTransparency(panelArrayPointer, hasTransparency)
+    }
+
+    /**
+     * Toggle whether the panels are targeted by the ray casts.
+     */
+    fun setCollidable(collidable: Boolean) {
+        checkIfReleased()
+        nativeSetCollidable(panelArrayPointer, collidable)
+    }
+
+    fun setVisible(visible: Boolean) {
+        checkIfReleased()
+        nativeSetVisible(panelArrayPointer, visible)
+    }
+
+    internal fun onRenderInputHover(
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float
+    ) {
+        dispatchInputEvent { it.onPanelInputHover(panelIndex, pointerId, xPercent, yPercent) }
+    }
+
+    internal fun onRenderInputPress(
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float
+    ) {
+        dispatchInputEvent { it.onPanelInputPress(panelIndex, pointerId, xPercent, yPercent) }
+    }
+
+    internal fun onRenderInputRelease(
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float
+    ) {
+        dispatchInputEvent { it.onPanelInputRelease(panelIndex, pointerId, xPercent, yPercent) }
+    }
+
+    internal fun onRenderInputScroll(
+        panelIndex: Int,
+        pointerId: String,
+        xPercent: Float,
+        yPercent: Float,
+        horizontalDelta: Float,
+        verticalDelta: Float
+    ) {
+        dispatchInputEvent {
+            it.onPanelInputScroll(
+                panelIndex,
+                pointerId,
+                xPercent,
+                yPercent,
+                horizontalDelta,
+                verticalDelta
+            )
+        }
+    }
+
+    private fun dispatchInputEvent(event: (InputListener) -> Unit) {
+        if (inputListeners.isEmpty()) {
+            return
+        }
+
+        mainThreadHandler.post {
+            for (listener in inputListeners) {
+                event(listener)
+            }
+        }
+    }
+
+    private external fun nativeCreatePanelArray(parentNodePath: String): Long
+
+    private external fun nativeReleasePanelArray(panelArrayPointer: Long)
+
+    private external fun nativeGetTextureId(panelArrayPointer: Long): Int
+
+    private external fun nativeSetTextureSize(panelArrayPointer: Long, width: Int, height: Int)
+
+    private external fun nativeGetNodePath(panelArrayPointer: Long): String
+
+    private external fun nativeSetPanelCount(panelArrayPointer: Long, count: Int)
+
+    private external fun nativeSetPanelSize(panelArrayPointer: Long, width: Float, height: Float)
+
+    private external fun nativeSetPanelTransform(
+        panelArrayPointer: Long,
+        index: Int,
+        xTranslation: Float,
+        yTranslation: Float,
+        zTranslation: Float,
+        xRotation: Float,
+        yRotation: Float,
+        zRotation: Float,
+        scale: Float
+    )
+
+    private external fun nativeSetPanelPositions(panelArrayPointer: Long, positions: FloatArray)
+
+    private external fun nativeSetPanelTextureRegion(
+        panelArrayPointer: Long,
+        index: Int,
+        x: Float,
+        y: Float,
+        width: Float,
+        height: Float
+    )
+
+    private external fun nativeSetAlpha(panelArrayPointer: Long, alpha: Float)
+
+    private external fun nativeSetHasTransparency(
+        panelArrayPointer: Long,
+        hasTransparency: Boolean
+    )
+
+    private external fun nativeSetCollidable(panelArrayPointer: Long, collidable: Boolean)
+
+    private external fun nativeSetVisible(panelArrayPointer: Long, visible: Boolean)
+}
@@ -0,0 +1,199 @@
+package org.godotengine.plugin.gast
+
+import android.graphics.Canvas
+import android.graphics.Color
+import android.graphics.PorterDuff
+import android.graphics.Rect
+import android.graphics.SurfaceTexture
+import android.view.Surface
+import java.util.Collections
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * Texture shared by multiple [GastNode]s.
+ *
+ * Each node added to the atlas (see [GastNode.setTextureAtlas]) is assigned a sub-region of the
+ * atlas texture, and draws into it via [GastNode.lockSurfaceCanvas]. All the nodes are updated
+ * with a single texture latch per frame, which reduces the latching and state change overhead of
+ * dense UIs made of many small panels.
+ *
+ * Must be created and released on the render thread.
+ *
+ * @property width Width of the atlas texture, in pixels
+ * @property height Height of the atlas texture, in pixels
+ */
+class GastTextureAtlas(
+    private val gastManager: GastManager,
+    val width: Int,
+    val height: Int
+) {
+
+    private val nodes = Collections.newSetFromMap(ConcurrentHashMap<GastNode, Boolean>())
+
+    private var atlasPointer: Long
+    private val surfaceTexture: SurfaceTexture
+    private val textureSource: GastTextureSource
+    private val surface: Surface
+
+    private var surfaceCanvas: Canvas? = null
+    private var surfaceCanvasOwner: GastNode? = null
+    private var surfaceCanvasRefCount = 0
+
+    companion object {
+        private const val INVALID_TEX_ID = 0
+        private const val INVALID_ATLAS_POINTER = 0L
+    }
+
+    init {
+        atlasPointer = nativeCreateTextureAtlas(width, height)
+        if (atlasPointer == INVALID_ATLAS_POINTER) {
+            throw IllegalStateException("Unable to initialize texture atlas")
+        }
+
+        val texId = nativeGetTextureId(atlasPointer)
+        if (texId == INVALID_TEX_ID) {
+            nativeReleaseTextureAtlas(atlasPointer)
+            throw IllegalStateException("Unable to initialize texture atlas texture.")
+        }
+
+        surfaceTexture = SurfaceTexture(texId)
+        surfaceTexture.setDefaultBufferSize(width, height)
+        textureSource = GastTextureSource(surfaceTexture)
+        surface = Surface(surfaceTexture)
+    }
+
+    fun isReleased() = atlasPointer == INVALID_ATLAS_POINTER
+
+    /**
+     * Release the [GastTextureAtlas].
+     *
+     * The nodes still using the atlas go back to sampling their own texture. The atlas is no
+     * longer usable after this method is invoked.
+     */
+    fun release() {
+        if (isReleased()) {
+            return
+        }
+
+        for (node in nodes) {
+            node.onTextureAtlasReleased(this)
+        }
+        nodes.clear()
+
+        surface.release()
+        textureSource.release()
+        surfaceTexture.release()
+        nativeReleaseTextureAtlas(atlasPointer)
+        atlasPointer = INVALID_ATLAS_POINTER
+    }
+
+    /**
+     * Allocate a region of the given size for the given node.
+     *
+     * Invoked on the render thread.
+     * @return The allocated region, or null if the atlas is full
+     */
+    internal fun addNode(node: GastNode, nodePointer: Long, width: Int, height: Int): Rect? {
+        if (isReleased()) {
+            return null
+        }
+
+        val region = nativeAddNode(atlasPointer, nodePointer, width, height)
+        if (region == null) {
+            nodes -= node
+            return null
+        }
+
+        nodes += node
+        return Rect(region[0], region[1], region[0] + region[2], region[1] + region[3])
+    }
+
+    /**
+     * Release the region allocated to the given node.
+     *
+     * Invoked on the render thread.
+     */
+    internal fun removeNode(node: GastNode, nodePointer: Long) {
+        nodes -= node
+        if (!isReleased()) {
+            nativeRemoveNode(atlasPointer, nodePointer)
+        }
+    }
+
+    /**
+     * Gets a [Canvas] for drawing into the given region of the atlas surface.
+     *
+     * Only one node can draw into the atlas surface at a time.
+     */
+    internal fun lockCanvas(node: GastNode, region: Rect): Canvas? {
+        if (isReleased() || !surface.isValid) {
+            return null
+        }
+
+        if (surfaceCanvas == null) {
+            if (surfaceCanvasRefCount != 0) {
+                throw IllegalStateException("Invalid surface canvas state.")
+            }
+
+            // The content outside of the dirty region is preserved, unless the surface expands
+            // the dirty region (e.g: no previous buffer is available). In which case, the other
+            // nodes need to redraw their content.
+            val dirty = Rect(region)
+            val canvas = surface.lockCanvas(dirty)
+            if (dirty != region) {
+                canvas.drawColor(Color.TRANSPARENT, PorterDuff.Mode.CLEAR)
+                for (atlasNode in nodes) {
+                    if (atlasNode != node) {
+                        atlasNode.onSurfaceContentInvalidated?.run()
+                    }
+                }
+            }
+
+            canvas.save()
+            canvas.clipRect(region)
+            canvas.drawColor(Color.TRANSPARENT, PorterDuff.Mode.CLEAR)
+            canvas.translate(region.left.toFloat(), region.top.toFloat())
+
+            surfaceCanvas = canvas
+            surfaceCanvasOwner = node
+        } else if (surfaceCanvasOwner != node) {
+            throw IllegalStateException("The atlas surface is locked by another node.")
+        }
+
+        surfaceCanvasRefCount++
+        return surfaceCanvas
+    }
+
+    /**
+     * Post the new contents and release the [Canvas] previously locked by the given node.
+     */
+    internal fun unlockCanvas(node: GastNode) {
+        val canvas = surfaceCanvas
+        if (canvas == null || surfaceCanvasOwner != node || surfaceCanvasRefCount == 0) {
+            return
+        }
+
+        surfaceCanvasRefCount--
+        if (surfaceCanvasRefCount == 0) {
+            canvas.restore()
+            surface.unlockCanvasAndPost(canvas)
+            surfaceCanvas = null
+            surfaceCanvasOwner = null
+        }
+    }
+
+    private external fun nativeCreateTextureAtlas(width: Int, height: Int): Long
+
+    private external fun nativeReleaseTextureAtlas(atlasPointer: Long)
+
+    private external fun nativeGetTextureId(atlasPointer: Long): Int
+
+    private external fun nativeAddNode(
+        atlasPointer: Long,
+        nodePointer: Long,
+        width: Int,
+        height: Int
+    ): IntArray?
+
+    private external fun nativeRemoveNode(atlasPointer: Long, nodePointer: Long)
+}
@@ -0,0 +1,63 @@
+package org.godotengine.plugin.gast
+
+import android.graphics.SurfaceTexture
+
+/**
+ * Hands the frames of a [SurfaceTexture] over to the native texture latch pump.
+ *
+ * The pump latches the frames on the render thread, once per rendered frame, and only keeps the
+ * frame best matching the display time when several are queued.
+ *
+ * @param surfaceTexture Surface texture attached to the render thread's GL context
+ * @param ownerNodePointer Pointer to the native Gast node displaying the texture, used to
+ * throttle the latches while the node can't be seen. 0 if the texture is shared
+ */
+internal class GastTextureSource(
+    surfaceTexture: SurfaceTexture,
+    ownerNodePointer: Long = 0L
+) : SurfaceTexture.OnFrameAvailableListener {
+
+    companion object {
+        private const val INVALID_SOURCE_HANDLE = 0L
+    }
+
+    @Volatile
+    private var sourceHandle = nativeRegisterTextureSource(surfaceTexture, ownerNodePointer)
+
+    init {
+        if (sourceHandle == INVALID_SOURCE_HANDLE) {
+            throw IllegalStateException("Unable to register texture source.")
+        }
+        surfaceTexture.setOnFrameAvailableListener(this)
+    }
+
+    /**
+     * Stop latching the surface texture's frames. Must be invoked before the surface texture is
+     * released.
+     */
+    fun release() {
+        val handle = sourceHandle
+        if (handle == INVALID_SOURCE_HANDLE) {
+            return
+        }
+
+        sourceHandle = INVALID_SOURCE_HANDLE
+        nativeUnregisterTextureSource(handle)
+    }
+
+    override fun onFrameAvailable(surfaceTexture: SurfaceTexture) {
+        val handle = sourceHandle
+        if (handle != INVALID_SOURCE_HANDLE) {
+            nativeOnFrameAvailable(handle)
+        }
+    }
+
+    private external fun nativeRegisterTextureSource(
+        surfaceTexture: SurfaceTexture,
+        ownerNodePointer: Long
+    ): Long
+
+    private external fun nativeUnregisterTextureSource(sourceHandle: Long)
+
+    private external fun nativeOnFrameAvailable(sourceHandle: Long)
+}
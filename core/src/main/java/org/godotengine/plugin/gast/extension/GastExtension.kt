@@ -76,4 +76,10 @@ abstract class GastExtension(godot: Godot) : GodotPlugin(godot), GastActionListe
         verticalDelta: Float
     ) {
     }
+
+    override fun onMainMultiPointerInput(
+        nodePath: String,
+        pointers: List<GastInputListener.Pointer>
+    ) {
+    }
 }
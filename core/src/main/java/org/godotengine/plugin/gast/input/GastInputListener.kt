@@ -5,6 +5,61 @@ package org.godotengine.plugin.gast.input
  */
 interface GastInputListener {
 
+    /**
+     * State of a pointer within a multi-pointer input event.
+     */
+    enum class PointerState(private val index: Int) {
+        /**
+         * The pointer hovers the node.
+         */
+        HOVER(0),
+
+        /**
+         * The pointer started pressing the node during this input tick.
+         */
+        JUST_PRESSED(1),
+
+        /**
+         * The pointer is pressing the node.
+         */
+        PRESSED(2),
+
+        /**
+         * The pointer stopped pressing the node during this input tick.
+         */
+        JUST_RELEASED(3),
+
+        /**
+         * The pointer no longer targets the node. Its index is released after this event.
+         */
+        EXITED(4);
+
+        companion object {
+            internal fun fromIndex(index: Int): PointerState = when (index) {
+                JUST_PRESSED.index -> JUST_PRESSED
+                PRESSED.index -> PRESSED
+                JUST_RELEASED.index -> JUST_RELEASED
+                EXITED.index -> EXITED
+                else -> HOVER
+            }
+        }
+    }
+
+    /**
+     * Pointer targeting a node, as reported by a multi-pointer input event.
+     *
+     * @property index Index of the pointer among the node's pointers. Stable while the pointer
+     * targets the node, and reused once the pointer leaves
+     * @property pointerId Id of the ray cast driving the pointer
+     */
+    data class Pointer(
+        val index: Int,
+        val pointerId: String,
+        val state: PointerState,
+        val xPercent: Float,
+        val yPercent: Float
+    )
+
     /**
      * Callback for hover input events.
      *
@@ -39,4 +94,24 @@ interface GastInputListener {
         horizontalDelta: Float,
         verticalDelta: Float
     )
+
+    /**
+     * Callback for multi-pointer input events.
+     *
+     * The pointers of all the ray casts targeting a node are aggregated into a single event per
+     * input tick, with each pointer's press transitions, so they can be combined into multi-touch
+     * gestures (e.g: pinch to zoom). The single pointer callbacks are still invoked, unless
+     * disabled by [isSinglePointerInputEnabled].
+     *
+     * This is invoked on the main thread.
+     */
+    fun onMainMultiPointerInput(nodePath: String, pointers: List<Pointer>) {}
+
+    /**
+     * Whether [onMainInputHover], [onMainInputPress] and [onMainInputRelease] should be invoked.
+     *
+     * The listeners handling their pointers through [onMainMultiPointerInput] can opt out of them.
+     * The native code stops dispatching them once no registered listener requires them.
+     */
+    fun isSinglePointerInputEnabled() = true
 }
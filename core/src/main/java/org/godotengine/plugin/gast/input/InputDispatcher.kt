@@ -42,6 +42,10 @@ internal class InputDispatcher private constructor() : Runnable {
             is HoverEventData -> {
                 val hoverEventData = eventData as HoverEventData
                 for (listener in gastInputListeners) {
+                    if (!listener.isSinglePointerInputEnabled()) {
+                        continue
+                    }
+
                     listener.onMainInputHover(
                         hoverEventData.nodePath,
                         hoverEventData.pointerId,
@@ -54,6 +58,10 @@ internal class InputDispatcher private constructor() : Runnable {
             is PressEventData -> {
                 val pressEventData = eventData as PressEventData
                 for (listener in gastInputListeners) {
+                    if (!listener.isSinglePointerInputEnabled()) {
+                        continue
+                    }
+
                     listener.onMainInputPress(
                         pressEventData.nodePath,
                         pressEventData.pointerId,
@@ -66,6 +74,10 @@ internal class InputDispatcher private constructor() : Runnable {
             is ReleaseEventData -> {
                 val releaseEventData = eventData as ReleaseEventData
                 for (listener in gastInputListeners) {
+                    if (!listener.isSinglePointerInputEnabled()) {
+                        continue
+                    }
+
                     listener.onMainInputRelease(
                         releaseEventData.nodePath,
                         releaseEventData.pointerId,
@@ -88,6 +100,16 @@ internal class InputDispatcher private constructor() : Runnable {
                     )
                 }
             }
+
+            is MultiPointerEventData -> {
+                val multiPointerEventData = eventData as MultiPointerEventData
+                for (listener in gastInputListeners) {
+                    listener.onMainMultiPointerInput(
+                        multiPointerEventData.nodePath,
+                        multiPointerEventData.pointers
+                    )
+                }
+            }
         }
 
         releaseInputDispatcher(this)
@@ -1,32 +1,34 @@
 package org.godotengine.plugin.gast.input
 
-internal sealed class InputEventData(
-    val nodePath: String,
+internal sealed class InputEventData(val nodePath: String)
+
+internal sealed class PointerEventData(
+    nodePath: String,
     val pointerId: String,
     val xPercent: Float,
     val yPercent: Float
-)
+) : InputEventData(nodePath)
 
 internal class HoverEventData(
     nodePath: String,
     pointerId: String,
     xPercent: Float,
     yPercent: Float
-) : InputEventData(nodePath, pointerId, xPercent, yPercent)
+) : PointerEventData(nodePath, pointerId, xPercent, yPercent)
 
 internal class PressEventData(
     nodePath: String,
     pointerId: String,
     xPercent: Float,
     yPercent: Float
-) : InputEventData(nodePath, pointerId, xPercent, yPercent)
+) : PointerEventData(nodePath, pointerId, xPercent, yPercent)
 
 internal class ReleaseEventData(
     nodePath: String,
     pointerId: String,
     xPercent: Float,
     yPercent: Float
-) : InputEventData(nodePath, pointerId, xPercent, yPercent)
+) : PointerEventData(nodePath, pointerId, xPercent, yPercent)
 
 internal class ScrollEventData(
     nodePath: String,
@@ -35,4 +37,9 @@ internal class ScrollEventData(
     yPercent: Float,
     val horizontalDelta: Float,
     val verticalDelta: Float
-) : InputEventData(nodePath, pointerId, xPercent, yPercent)
+) : PointerEventData(nodePath, pointerId, xPercent, yPercent)
+
+internal class MultiPointerEventData(
+    nodePath: String,
+    val pointers: List<GastInputListener.Pointer>
+) : InputEventData(nodePath)
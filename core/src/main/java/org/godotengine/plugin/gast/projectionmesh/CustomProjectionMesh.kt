@@ -1,7 +1,47 @@
 package org.godotengine.plugin.gast.projectionmesh
 
+import android.content.res.AssetFileDescriptor
+import android.os.ParcelFileDescriptor
+import java.nio.Buffer
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
+import java.nio.IntBuffer
+
 class CustomProjectionMesh(meshPointer: Long, nodePointer : Long) : ProjectionMesh(meshPointer, nodePointer) {
 
+    companion object {
+        /**
+         * Write the provided mesh to a GAST mesh file, to be loaded with [setCustomMeshFiles].
+         *
+         * The mesh is processed (merged vertices, optimized triangle order, bounds and bounding
+         * volume hierarchy) once when writing the file, instead of every time it's loaded.
+         * Requires the Godot engine to be initialized.
+         *
+         * @param path Absolute path of the mesh file
+         * @param vertices Vertex positions in 3D space [x1, y1, z1 ... xn, yn, zn]
+         * @param textureCoords Texture sampling coords [u1, v1, u2, v2 ... un, vn]
+         * @param indices Optional indices of the vertices forming the primitives
+         * @param glDrawMode GL mesh primitive
+         * @return true if the mesh file was written
+         */
+        @JvmStatic
+        fun writeMeshFile(path: String,
+                          vertices: FloatArray,
+                          textureCoords: FloatArray,
+                          indices: IntArray?,
+                          glDrawMode: Int): Boolean {
+            return nativeWriteMeshFile(path, vertices, textureCoords, indices, glDrawMode)
+        }
+
+        @JvmStatic
+        private external fun nativeWriteMeshFile(path: String,
+                                                 vertices: FloatArray,
+                                                 textureCoords: FloatArray,
+                                                 indices: IntArray?,
+                                                 glDrawMode: Int): Boolean
+    }
+
     /**
      * Set provided mesh as the current projection mesh.
      *
@@ -26,14 +66,60 @@ class CustomProjectionMesh(meshPointer: Long, nodePointer : Long) : ProjectionMe
                       glDrawModeRight: Int?,
                       stereoMode: Int,
                       uvOriginIsBottomLeft: Boolean) {
+        setCustomMesh(
+            vertices,
+            textureCoords,
+            null,
+            glDrawMode,
+            verticesRight,
+            textureCoordsRight,
+            null,
+            glDrawModeRight,
+            stereoMode,
+            uvOriginIsBottomLeft)
+    }
+
+    /**
+     * Set provided indexed mesh as the current projection mesh.
+     *
+     * Meshes provided without indices have their identical vertices merged, so the vertices
+     * shared by their primitives are only processed once.
+     *
+     * If either verticesRight, textureCoordsRight, or glDrawModeRight are null, the left eye mesh
+     * will be used for the right eye as well.
+     *
+     * @param vertices Left eye vertex positions in 3D space [x1, y1, z1 ... xn, yn, zn]
+     * @param textureCoords Left eye texture sampling coords [u1, v1, u2, v2 ... un, vn]
+     * @param indices Optional left eye indices of the vertices forming the primitives
+     * @param glDrawMode Left eye GL mesh primitive
+     * @param verticesRight Right eye vertex positions in 3D space [x1, y1, z1 ... xn, yn, zn]
+     * @param textureCoordsRight Right eye texture sampling coords [u1, v1, u2, v2 ... un, vn]
+     * @param indicesRight Optional right eye indices of the vertices forming the primitives
+     * @param glDrawModeRight Right eye GL mesh primitive
+     * @param stereoMode int representation of stereo mode, matches the
+     * com.google.android.exoplayer2.C.StereoMode constants
+     * @param uvOriginIsBottomLeft Whether the origin in mesh space is bottom left or top left
+     */
+    fun setCustomMesh(vertices: FloatArray,
+                      textureCoords: FloatArray,
+                      indices: IntArray?,
+                      glDrawMode: Int,
+                      verticesRight: FloatArray?,
+                      textureCoordsRight: FloatArray?,
+                      indicesRight: IntArray?,
+                      glDrawModeRight: Int?,
+                      stereoMode: Int,
+                      uvOriginIsBottomLeft: Boolean) {
         if (verticesRight == null || textureCoordsRight == null || glDrawModeRight == null) {
             nativeSetCustomMesh(
                 meshPointer,
                 vertices,
                 textureCoords,
+                indices,
                 glDrawMode,
                 vertices,
                 textureCoords,
+                indices,
                 glDrawMode,
                 stereoMode,
                 uvOriginIsBottomLeft)
@@ -42,22 +128,223 @@ class CustomProjectionMesh(meshPointer: Long, nodePointer : Long) : ProjectionMe
                 meshPointer,
                 vertices,
                 textureCoords,
+                indices,
                 glDrawMode,
                 verticesRight,
                 textureCoordsRight,
+                indicesRight,
                 glDrawModeRight,
                 stereoMode,
                 uvOriginIsBottomLeft)
         }
     }
 
+    /**
+     * Set provided mesh as the current projection mesh, reading the vertex data in place from
+     * direct buffers.
+     *
+     * The buffers must be direct and in native byte order. The data between their position and
+     * limit is used, and is only read during the call.
+     *
+     * If either verticesRight, textureCoordsRight, or glDrawModeRight are null, the left eye mesh
+     * will be used for the right eye as well.
+     *
+     * @param vertices Left eye vertex positions in 3D space [x1, y1, z1 ... xn, yn, zn]
+     * @param textureCoords Left eye texture sampling coords [u1, v1, u2, v2 ... un, vn]
+     * @param indices Optional left eye indices of the vertices forming the primitives
+     * @param glDrawMode Left eye GL mesh primitive
+     * @param verticesRight Right eye vertex positions in 3D space [x1, y1, z1 ... xn, yn, zn]
+     * @param textureCoordsRight Right eye texture sampling coords [u1, v1, u2, v2 ... un, vn]
+     * @param indicesRight Optional right eye indices of the vertices forming the primitives
+     * @param glDrawModeRight Right eye GL mesh primitive
+     * @param stereoMode int representation of stereo mode, matches the
+     * com.google.android.exoplayer2.C.StereoMode constants
+     * @param uvOriginIsBottomLeft Whether the origin in mesh space is bottom left or top left
+     */
+    fun setCustomMesh(vertices: FloatBuffer,
+                      textureCoords: FloatBuffer,
+                      indices: IntBuffer?,
+                      glDrawMode: Int,
+                      verticesRight: FloatBuffer?,
+                      textureCoordsRight: FloatBuffer?,
+                      indicesRight: IntBuffer?,
+                      glDrawModeRight: Int?,
+                      stereoMode: Int,
+                      uvOriginIsBottomLeft: Boolean) {
+        checkDirectBuffer(vertices, vertices.order())
+        checkDirectBuffer(textureCoords, textureCoords.order())
+        indices?.let { checkDirectBuffer(it, it.order()) }
+
+        val leftVertices = vertices.slice()
+        val leftTextureCoords = textureCoords.slice()
+        val leftIndices = indices?.slice()
+        if (verticesRight == null || textureCoordsRight == null || glDrawModeRight == null) {
+            nativeSetCustomMeshBuffers(
+                meshPointer,
+                leftVertices.remaining() / 3,
+                leftVertices,
+                leftTextureCoords,
+                leftIndices?.remaining() ?: 0,
+                leftIndices,
+                glDrawMode,
+                leftVertices.remaining() / 3,
+                leftVertices,
+                leftTextureCoords,
+                leftIndices?.remaining() ?: 0,
+                leftIndices,
+                glDrawMode,
+                stereoMode,
+                uvOriginIsBottomLeft)
+        } else {
+            checkDirectBuffer(verticesRight, verticesRight.order())
+            checkDirectBuffer(textureCoordsRight, textureCoordsRight.order())
+            indicesRight?.let { checkDirectBuffer(it, it.order()) }
+
+            val rightVertices = verticesRight.slice()
+            val rightTextureCoords = textureCoordsRight.slice()
+            val rightIndices = indicesRight?.slice()
+            nativeSetCustomMeshBuffers(
+                meshPointer,
+                leftVertices.remaining() / 3,
+                leftVertices,
+                leftTextureCoords,
+                leftIndices?.remaining() ?: 0,
+                leftIndices,
+                glDrawMode,
+                rightVertices.remaining() / 3,
+                rightVertices,
+                rightTextureCoords,
+                rightIndices?.remaining() ?: 0,
+                rightIndices,
+                glDrawModeRight,
+                stereoMode,
+                uvOriginIsBottomLeft)
+        }
+    }
+
+    /**
+     * Set the meshes stored in the provided GAST mesh files (see [writeMeshFile]) as the current
+     * projection mesh.
+     *
+     * The files are memory-mapped, and the mesh is created straight from the mapped pages
+     * without further processing.
+     *
+     * @param meshFile Absolute path of the left eye mesh file
+     * @param meshFileRight Absolute path of the right eye mesh file, or null to use the left eye
+     * mesh for the right eye as well
+     * @param stereoMode int representation of stereo mode, matches the
+     * com.google.android.exoplayer2.C.StereoMode constants
+     * @param uvOriginIsBottomLeft Whether the origin in mesh space is bottom left or top left
+     * @return true if the mesh files are valid
+     */
+    fun setCustomMeshFiles(meshFile: String,
+                           meshFileRight: String?,
+                           stereoMode: Int,
+                           uvOriginIsBottomLeft: Boolean): Boolean {
+        return nativeSetCustomMeshFiles(
+            meshPointer,
+            meshFile,
+            meshFileRight,
+            stereoMode,
+            uvOriginIsBottomLeft)
+    }
+
+    /**
+     * Set the projection mesh stored in the Spherical Video V2 metadata ('sv3d' / 'mshp' boxes)
+     * of the provided MP4 video as the current projection mesh. The stereo mode and texture
+     * coordinates origin are configured from the video's metadata.
+     *
+     * Only the boxes leading to the video track's metadata are read, the media data is skipped.
+     * The file descriptor's offset is left untouched.
+     *
+     * @param fileDescriptor File descriptor of the MP4 video
+     * @return true if the video has a mesh projection
+     */
+    fun setCustomMeshFromVideo(fileDescriptor: ParcelFileDescriptor): Boolean {
+        return nativeSetCustomMeshFromVideo(meshPointer, fileDescriptor.fd, 0, -1)
+    }
+
+    /**
+     * Same as [setCustomMeshFromVideo], for a video stored in a region of a file (e.g: an
+     * uncompressed asset).
+     *
+     * @param fileDescriptor Asset file descriptor of the MP4 video
+     * @return true if the video has a mesh projection
+     */
+    fun setCustomMeshFromVideo(fileDescriptor: AssetFileDescriptor): Boolean {
+        val length = if (fileDescriptor.declaredLength == AssetFileDescriptor.UNKNOWN_LENGTH) {
+            -1
+        } else {
+            fileDescriptor.declaredLength
+        }
+        return nativeSetCustomMeshFromVideo(
+            meshPointer,
+            fileDescriptor.parcelFileDescriptor.fd,
+            fileDescriptor.startOffset,
+            length)
+    }
+
+    /**
+     * Same as [setCustomMeshFromVideo], for a video stored in a direct buffer (e.g: a
+     * [java.nio.MappedByteBuffer]). The data between the buffer's position and limit is used.
+     *
+     * @param video Direct buffer holding the MP4 video
+     * @return true if the video has a mesh projection
+     */
+    fun setCustomMeshFromVideo(video: ByteBuffer): Boolean {
+        if (!video.isDirect) {
+            throw IllegalArgumentException("The video buffer must be direct.")
+        }
+        val data = video.slice()
+        return nativeSetCustomMeshFromVideoBuffer(meshPointer, data, data.remaining())
+    }
+
+    private fun checkDirectBuffer(buffer: Buffer, order: ByteOrder) {
+        if (!buffer.isDirect || order != ByteOrder.nativeOrder()) {
+            throw IllegalArgumentException("The mesh buffers must be direct and in native byte order.")
+        }
+    }
+
     private external fun nativeSetCustomMesh(meshPointer: Long,
                                              vertices: FloatArray,
                                              textureCoords: FloatArray,
+                                             indices: IntArray?,
                                              glDrawMode: Int,
                                              verticesRight: FloatArray,
                                              textureCoordsRight: FloatArray,
+                                             indicesRight: IntArray?,
                                              glDrawModeRight: Int,
                                              stereoMode: Int,
                                              uvOriginIsBottomLeft: Boolean)
+
+    private external fun nativeSetCustomMeshBuffers(meshPointer: Long,
+                                                    numVertices: Int,
+                                                    vertices: FloatBuffer,
+                                                    textureCoords: FloatBuffer,
+                                                    numIndices: Int,
+                                                    indices: IntBuffer?,
+                                                    glDrawMode: Int,
+                                                    numVerticesRight: Int,
+                                                    verticesRight: FloatBuffer,
+                                                    textureCoordsRight: FloatBuffer,
+                                                    numIndicesRight: Int,
+                                                    indicesRight: IntBuffer?,
+                                                    glDrawModeRight: Int,
+                                                    stereoMode: Int,
+                                                    uvOriginIsBottomLeft: Boolean)
+
+    private external fun nativeSetCustomMeshFiles(meshPointer: Long,
+                                                  meshFile: String,
+                                                  meshFileRight: String?,
+                                                  stereoMode: Int,
+                                                  uvOriginIsBottomLeft: Boolean): Boolean
+
+    private external fun nativeSetCustomMeshFromVideo(meshPointer: Long,
+                                                      fd: Int,
+                                                      offset: Long,
+                                                      length: Long): Boolean
+
+    private external fun nativeSetCustomMeshFromVideoBuffer(meshPointer: Long,
+                                                            video: ByteBuffer,
+                                                            size: Int): Boolean
 }
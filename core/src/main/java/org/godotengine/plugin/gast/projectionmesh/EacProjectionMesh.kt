@@ -0,0 +1,7 @@
+package org.godotengine.plugin.gast.projectionmesh
+
+/**
+ * Cube mesh textured with the equi-angular cubemap (EAC) layout.
+ */
+class EacProjectionMesh(meshPointer: Long, nodePointer : Long)
+    : ProjectionMesh(meshPointer, nodePointer)
@@ -1,4 +1,17 @@
 package org.godotengine.plugin.gast.projectionmesh
 
 class EquirectangularProjectionMesh(meshPointer: Long, nodePointer : Long)
-    : ProjectionMesh(meshPointer, nodePointer)
+    : ProjectionMesh(meshPointer, nodePointer) {
+
+    /**
+     * Enable or disable the foveated tessellation of the sphere mesh.
+     *
+     * When enabled, the vertices are concentrated near the equator and the current view
+     * direction, for the same triangle count.
+     */
+    fun setFoveatedTessellation(enable: Boolean) {
+        nativeSetFoveatedTessellation(meshPointer, enable)
+    }
+
+    private external fun nativeSetFoveatedTessellation(meshPointer: Long, enable: Boolean)
+}
@@ -0,0 +1,20 @@
+package org.godotengine.plugin.gast.projectionmesh
+
+/**
+ * Front half of a sphere, for 180 degrees (VR180) content. Defaults to side by side stereo.
+ */
+class HemisphereProjectionMesh(meshPointer: Long, nodePointer : Long)
+    : ProjectionMesh(meshPointer, nodePointer) {
+
+    /**
+     * Set the resolution of the hemisphere mesh.
+     *
+     * @param bandCount Number of horizontal bands, from the bottom to the top
+     * @param sectorCount Number of vertical sectors, from the left to the right
+     */
+    fun setResolution(bandCount: Int, sectorCount: Int) {
+        nativeSetResolution(meshPointer, bandCount, sectorCount)
+    }
+
+    private external fun nativeSetResolution(meshPointer: Long, bandCount: Int, sectorCount: Int)
+}
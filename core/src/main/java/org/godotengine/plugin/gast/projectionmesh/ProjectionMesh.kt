@@ -2,6 +2,32 @@ package org.godotengine.plugin.gast.projectionmesh
 
 sealed class ProjectionMesh(protected val meshPointer : Long, protected val nodePointer : Long) {
 
+    // Mirrors enum CollisionMode in src/main/cpp/gdn/projection_mesh/projection_mesh.h
+    enum class CollisionMode {
+        /**
+         * The collision shape is made of the mesh's triangles.
+         */
+        TRIMESH,
+
+        /**
+         * The collision shape is the convex hull of the mesh.
+         */
+        CONVEX_HULL,
+
+        /**
+         * The collision shape is a sphere bounding the mesh.
+         */
+        BOUNDING_SPHERE,
+
+        /**
+         * No collision shape is used; the input rays are intersected with the mesh's exact
+         * analytic surface (plane, cylinder, sphere or cube). Custom meshes are intersected with
+         * the BVH of their triangles instead, or with their bounding sphere if they aren't made of
+         * a triangle list.
+         */
+        ANALYTIC,
+    }
+
     fun isGazeTracking(): Boolean {
         return isGazeTracking(meshPointer)
     }
@@ -9,10 +35,10 @@ sealed class ProjectionMesh(protected val meshPointer : Long, protected val node
     private external fun isGazeTracking(meshPointer: Long): Boolean
 
     fun setGazeTracking(gazeTracking: Boolean) {
-        setGazeTracking(meshPointer, gazeTracking)
+        setGazeTracking(meshPointer, nodePointer, gazeTracking)
     }
 
-    private external fun setGazeTracking(meshPointer: Long, gazeTracking: Boolean)
+    private external fun setGazeTracking(meshPointer: Long, nodePointer: Long, gazeTracking: Boolean)
 
     fun isRenderOnTop(): Boolean {
         return isRenderOnTop(meshPointer)
@@ -48,4 +74,43 @@ sealed class ProjectionMesh(protected val meshPointer : Long, protected val node
     }
 
     private external fun setStereoMode(meshPointer: Long, stereoMode: Int)
+
+    /**
+     * Set the texture resolution used to decide whether the mesh vertices can be stored in
+     * compressed (half-float) formats. The compression is only used where its error stays
+     * under half a texel at this resolution.
+     *
+     * @param textureSize Texture resolution, or 0 to disable the compression
+     */
+    fun setVertexCompressionTextureSize(textureSize: Int) {
+        setVertexCompressionTextureSize(meshPointer, textureSize)
+    }
+
+    private external fun setVertexCompressionTextureSize(meshPointer: Long, textureSize: Int)
+
+    /**
+     * Enable or disable building the mesh on a worker thread.
+     *
+     * When enabled, the mesh updates (e.g: [CustomProjectionMesh.setCustomMesh]) return
+     * immediately, and the current mesh keeps rendering until the new one is swapped in at the
+     * next frame boundary. The GastLoader 'projection_mesh_ready' signal is emitted once the new
+     * mesh is in place.
+     */
+    fun setAsyncMeshBuild(enable: Boolean) {
+        setAsyncMeshBuild(meshPointer, enable)
+    }
+
+    private external fun setAsyncMeshBuild(meshPointer: Long, enable: Boolean)
+
+    /**
+     * Update the shape used to detect the input rays collisions with the mesh.
+     *
+     * Defaults to [CollisionMode.TRIMESH]. The cheaper proxies are recommended for meshes with
+     * large vertex counts.
+     */
+    fun setCollisionMode(mode: CollisionMode) {
+        setCollisionMode(meshPointer, mode.ordinal)
+    }
+
+    private external fun setCollisionMode(meshPointer: Long, mode: Int)
 }
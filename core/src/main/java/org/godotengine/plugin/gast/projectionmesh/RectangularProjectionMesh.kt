@@ -15,6 +15,25 @@ class RectangularProjectionMesh(meshPointer: Long, nodePointer : Long)
 
     private external fun nativeSetCurved(meshPointer: Long, curved: Boolean)
 
+    /**
+     * Set the radius of the cylinder the curved mesh is wrapped around.
+     */
+    fun setCurveRadius(radius: Float) {
+        nativeSetCurveRadius(meshPointer, radius)
+    }
+
+    private external fun nativeSetCurveRadius(meshPointer: Long, radius: Float)
+
+    /**
+     * Set the maximum distance between the curved mesh and its cylinder. Smaller values
+     * produce a smoother, but denser, mesh.
+     */
+    fun setMaxChordError(maxChordError: Float) {
+        nativeSetMaxChordError(meshPointer, maxChordError)
+    }
+
+    private external fun nativeSetMaxChordError(meshPointer: Long, maxChordError: Float)
+
     fun getGradientHeightRatio(): Float {
         return getGradientHeightRatio(meshPointer)
     }
@@ -69,6 +69,9 @@ class GastFrameLayout(
         this.gastManager = gastManager
         this.gastNode = gastNode
         gastNode.bindSurface()
+        gastNode.onSurfaceTextureSizeChanged = Runnable { postInvalidate() }
+        gastNode.onVisibilityStateChanged = Runnable { postInvalidate() }
+        gastNode.onSurfaceContentInvalidated = Runnable { postInvalidate() }
 
         gastManager.registerGastInputListener(inputHandler)
         viewTreeObserver.addOnPreDrawListener(onPreDrawListener)
@@ -81,6 +84,9 @@ class GastFrameLayout(
         Log.d(TAG, "Shutting down GastFrameLayout...")
         viewTreeObserver.removeOnPreDrawListener(onPreDrawListener)
         gastManager?.unregisterGastInputListener(inputHandler)
+        gastNode?.onSurfaceTextureSizeChanged = null
+        gastNode?.onVisibilityStateChanged = null
+        gastNode?.onSurfaceContentInvalidated = null
         this.gastNode = null
         textureHeight = MIN_TEXTURE_DIMENSION
         textureWidth = MIN_TEXTURE_DIMENSION
@@ -114,17 +120,34 @@ class GastFrameLayout(
     override fun draw(canvas: Canvas) {
         updateTextureSizeIfNeeded()
         updateGastNodeProperties()
+        if (isSurfaceRenderingPaused()) {
+            return
+        }
+
         val surfaceCanvas = gastNode?.lockSurfaceCanvas() ?: canvas
         super.draw(surfaceCanvas)
         gastNode?.unlockSurfaceCanvas()
     }
 
     override fun dispatchDraw(canvas: Canvas) {
+        if (isSurfaceRenderingPaused()) {
+            return
+        }
+
         val surfaceCanvas = gastNode?.lockSurfaceCanvas() ?: canvas
         super.dispatchDraw(surfaceCanvas)
         gastNode?.unlockSurfaceCanvas()
     }
 
+    /**
+     * Rendering into the node's surface is paused while the node can't be seen. The view is
+     * redrawn once the node becomes visible again.
+     */
+    private fun isSurfaceRenderingPaused(): Boolean {
+        val visibilityState = gastNode?.getVisibilityState() ?: return false
+        return visibilityState != GastNode.VisibilityState.VISIBLE
+    }
+
     override fun onSizeChanged(width: Int, height: Int, oldWidth: Int, oldHeight: Int) {
         super.onSizeChanged(width, height, oldWidth, oldHeight)
         Log.d(TAG, "On size changed: $width, $height, $oldWidth, $oldHeight")
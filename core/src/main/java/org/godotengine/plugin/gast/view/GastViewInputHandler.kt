@@ -3,7 +3,6 @@ package org.godotengine.plugin.gast.view
 import android.os.SystemClock
 import android.view.InputDevice
 import android.view.MotionEvent
-import androidx.collection.ArraySet
 import org.godotengine.plugin.gast.input.GastInputListener
 import kotlin.math.max
 import kotlin.math.min
@@ -32,42 +31,54 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
     }
 
     /**
-     * Keep tracks of whether each pointer is in the HOVER state.
+     * Indices of the pointers in the HOVER state.
      */
-    private val hoverEnteredSet = HashSet<String>()
+    private val hoverEnteredSet = HashSet<Int>()
 
     /**
-     * Keep tracks of whether an ACTION_DOWN gesture has occurred for each pointer.
+     * Latest state of the pointers taking part in the ongoing touch gesture, keyed by index in
+     * ascending order.
      */
-    private val onDownSet = HashSet<String>()
+    private val downPointers = sortedMapOf<Int, GastInputListener.Pointer>()
 
-    private val pointerIdsTracker = ArraySet<String>(5)
+    /**
+     * Time of the ACTION_DOWN event starting the ongoing touch gesture.
+     */
+    private var gestureDownTime = 0L
+
+    /**
+     * Indices of the pointers targeting the node, keyed by pointer id.
+     */
+    private val pointerIndicesById = HashMap<String, Int>()
 
     private fun getScrollByDelta(delta: Float) =
         max(-SCROLL_SPEED_LIMIT, min(SCROLL_SPEED_LIMIT, SCROLL_SENSITIVITY * delta))
 
     private fun obtainMotionEvent(
-        pointerId: String,
+        pointers: List<GastInputListener.Pointer>,
+        downTime: Long,
         eventTime: Long,
         action: Int,
-        source: Int,
-        xCoord: Float = 0F,
-        yCoord: Float = 0F
+        source: Int
     ): MotionEvent {
-        val pointerProperties = arrayOf(MotionEvent.PointerProperties().apply {
-            this.id = getMotionEventPointerId(pointerId)
-        })
-        val pointerCoords = arrayOf(MotionEvent.PointerCoords().apply {
-            this.x = xCoord
-            this.y = yCoord
-            this.pressure = 1.0f
-            this.size = 1.0f
-        })
+        val pointerProperties = Array(pointers.size) {
+            MotionEvent.PointerProperties().apply {
+                this.id = pointers[it].index
+            }
+        }
+        val pointerCoords = Array(pointers.size) {
+            MotionEvent.PointerCoords().apply {
+                this.x = pointers[it].xPercent * gastView.width
+                this.y = pointers[it].yPercent * gastView.height
+                this.pressure = 1.0f
+                this.size = 1.0f
+            }
+        }
         return MotionEvent.obtain(
-            eventTime,
+            downTime,
             eventTime,
             action,
-            1,
+            pointers.size,
             pointerProperties,
             pointerCoords,
             0,
@@ -82,7 +93,7 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
     }
 
     private fun obtainScrollEvent(
-        pointerId: String,
+        pointerIndex: Int,
         eventTime: Long,
         xCoord: Float,
         yCoord: Float,
@@ -90,7 +101,7 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
         scrollByY: Float
     ): MotionEvent {
         val pointerProperties = arrayOf(MotionEvent.PointerProperties().apply {
-            this.id = getMotionEventPointerId(pointerId)
+            this.id = pointerIndex
         })
         val pointerCoords = arrayOf(MotionEvent.PointerCoords().apply {
             this.setAxisValue(MotionEvent.AXIS_X, xCoord)
@@ -116,64 +127,15 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
         )
     }
 
+    override fun isSinglePointerInputEnabled() = false
+
     override fun onMainInputHover(
         nodePath: String,
         pointerId: String,
         xPercent: Float,
         yPercent: Float
     ) {
-        if (nodePath.isBlank() || nodePath != gastView.gastNode?.nodePath) {
-            return
-        }
-
-        val eventTime = SystemClock.uptimeMillis()
-
-        // xPercent and yPercent being less than 0 indicates this is no longer being looked at.
-        if (!onDownSet.contains(pointerId) && xPercent < 0 && yPercent < 0) {
-            if (hoverEnteredSet.contains(pointerId)) {
-                val motionEvent = obtainMotionEvent(
-                    pointerId,
-                    eventTime,
-                    MotionEvent.ACTION_HOVER_EXIT,
-                    HOVER_INPUT_SOURCE
-                )
-                gastView.dispatchGenericMotionEvent(motionEvent)
-                hoverEnteredSet.remove(pointerId)
-                motionEvent.recycle()
-            }
-        } else {
-            val xCoord = xPercent * gastView.width
-            val yCoord = yPercent * gastView.height
-            if (onDownSet.contains(pointerId)) {
-                // Send a ACTION_MOVE event.
-                val motionEvent = obtainMotionEvent(
-                    pointerId,
-                    eventTime,
-                    MotionEvent.ACTION_MOVE,
-                    InputDevice.SOURCE_TOUCHSCREEN,
-                    xCoord,
-                    yCoord
-                )
-                gastView.dispatchTouchEvent(motionEvent)
-                motionEvent.recycle()
-            } else {
-                // Send a hover event.
-                val action =
-                    if (hoverEnteredSet.contains(pointerId)) MotionEvent.ACTION_HOVER_MOVE else MotionEvent.ACTION_HOVER_ENTER
-                val motionEvent =
-                    obtainMotionEvent(
-                        pointerId,
-                        eventTime,
-                        action,
-                        HOVER_INPUT_SOURCE,
-                        xCoord,
-                        yCoord
-                    )
-                gastView.dispatchGenericMotionEvent(motionEvent)
-                hoverEnteredSet.add(pointerId)
-                motionEvent.recycle()
-            }
-        }
+        // Disabled by isSinglePointerInputEnabled, handled by onMainMultiPointerInput.
     }
 
     override fun onMainInputPress(
@@ -182,41 +144,7 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
         xPercent: Float,
         yPercent: Float
     ) {
-        if (nodePath.isBlank() || nodePath != gastView.gastNode?.nodePath) {
-            return
-        }
-
-        val eventTime = SystemClock.uptimeMillis()
-        val xCoord = xPercent * gastView.width
-        val yCoord = yPercent * gastView.height
-
-        if (hoverEnteredSet.contains(pointerId)) {
-            // Complete the hover motion event.
-            val motionEvent = obtainMotionEvent(
-                pointerId,
-                eventTime,
-                MotionEvent.ACTION_HOVER_EXIT,
-                HOVER_INPUT_SOURCE,
-                xCoord,
-                yCoord
-            )
-            gastView.dispatchGenericMotionEvent(motionEvent)
-            hoverEnteredSet.remove(pointerId)
-            motionEvent.recycle()
-        }
-
-        // Send a ACTION_DOWN motion event.
-        val motionEvent = obtainMotionEvent(
-            pointerId,
-            eventTime,
-            MotionEvent.ACTION_DOWN,
-            InputDevice.SOURCE_TOUCHSCREEN,
-            xCoord,
-            yCoord
-        )
-        gastView.dispatchTouchEvent(motionEvent)
-        onDownSet.add(pointerId)
-        motionEvent.recycle()
+        // Disabled by isSinglePointerInputEnabled, handled by onMainMultiPointerInput.
     }
 
     override fun onMainInputRelease(
@@ -224,33 +152,146 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
         pointerId: String,
         xPercent: Float,
         yPercent: Float
+    ) {
+        // Disabled by isSinglePointerInputEnabled, handled by onMainMultiPointerInput.
+    }
+
+    override fun onMainMultiPointerInput(
+        nodePath: String,
+        pointers: List<GastInputListener.Pointer>
     ) {
         if (nodePath.isBlank() || nodePath != gastView.gastNode?.nodePath) {
             return
         }
 
-        if (!onDownSet.contains(pointerId)) {
-            return
+        for (pointer in pointers) {
+            if (pointer.state == GastInputListener.PointerState.EXITED) {
+                pointerIndicesById.remove(pointer.pointerId)
+            } else {
+                pointerIndicesById[pointer.pointerId] = pointer.index
+            }
         }
 
         val eventTime = SystemClock.uptimeMillis()
-        val xCoord = xPercent * gastView.width
-        val yCoord = yPercent * gastView.height
+        dispatchHoverEvents(pointers, eventTime)
+        dispatchTouchEvents(pointers, eventTime)
+    }
+
+    private fun dispatchHoverEvents(pointers: List<GastInputListener.Pointer>, eventTime: Long) {
+        for (pointer in pointers) {
+            val action = when (pointer.state) {
+                GastInputListener.PointerState.HOVER ->
+                    if (hoverEnteredSet.contains(pointer.index)) {
+                        MotionEvent.ACTION_HOVER_MOVE
+                    } else {
+                        MotionEvent.ACTION_HOVER_ENTER
+                    }
 
-        // Send a ACTION_UP motion event to complete the gesture.
+                // Complete the hover motion event.
+                GastInputListener.PointerState.JUST_PRESSED,
+                GastInputListener.PointerState.EXITED ->
+                    if (hoverEnteredSet.contains(pointer.index)) {
+                        MotionEvent.ACTION_HOVER_EXIT
+                    } else {
+                        continue
+                    }
+
+                else -> continue
+            }
+
+            val motionEvent =
+                obtainMotionEvent(listOf(pointer), eventTime, eventTime, action, HOVER_INPUT_SOURCE)
+            gastView.dispatchGenericMotionEvent(motionEvent)
+            if (action == MotionEvent.ACTION_HOVER_EXIT) {
+                hoverEnteredSet.remove(pointer.index)
+            } else {
+                hoverEnteredSet.add(pointer.index)
+            }
+            motionEvent.recycle()
+        }
+    }
+
+    /**
+     * Combine the pressing pointers into a single touch gesture, so the view sees the presses of
+     * multiple ray casts as a multi-touch gesture (e.g: pinch to zoom).
+     */
+    private fun dispatchTouchEvents(pointers: List<GastInputListener.Pointer>, eventTime: Long) {
+        val pointersByIndex = pointers.associateBy { it.index }
+
+        // Every pointer targeting the node is reported, so the missing ones are stale. They're
+        // lifted at their last known coordinates, so the view doesn't wait for their release.
+        for (index in downPointers.keys.filter { it !in pointersByIndex }) {
+            dispatchTouchUp(index, eventTime)
+        }
+
+        // Move the pointers of the ongoing gesture to their latest coordinates.
+        if (downPointers.isNotEmpty()) {
+            for (index in downPointers.keys) {
+                downPointers[index] = pointersByIndex.getValue(index)
+            }
+            dispatchTouchEvent(downPointers.values.toList(), eventTime, MotionEvent.ACTION_MOVE)
+        }
+
+        for (pointer in pointers) {
+            if (pointer.state == GastInputListener.PointerState.JUST_RELEASED &&
+                downPointers.containsKey(pointer.index)) {
+                dispatchTouchUp(pointer.index, eventTime)
+            }
+        }
+
+        for (pointer in pointers) {
+            if (pointer.state != GastInputListener.PointerState.JUST_PRESSED ||
+                downPointers.containsKey(pointer.index)) {
+                continue
+            }
+
+            downPointers[pointer.index] = pointer
+            val action = if (downPointers.size == 1) {
+                gestureDownTime = eventTime
+                MotionEvent.ACTION_DOWN
+            } else {
+                getPointerAction(
+                    MotionEvent.ACTION_POINTER_DOWN,
+                    downPointers.headMap(pointer.index).size
+                )
+            }
+            dispatchTouchEvent(downPointers.values.toList(), eventTime, action)
+        }
+    }
+
+    /**
+     * Lift the down pointer with the given index, completing the touch gesture if it's the last
+     * one.
+     */
+    private fun dispatchTouchUp(index: Int, eventTime: Long) {
+        val action = if (downPointers.size == 1) {
+            MotionEvent.ACTION_UP
+        } else {
+            getPointerAction(MotionEvent.ACTION_POINTER_UP, downPointers.headMap(index).size)
+        }
+        dispatchTouchEvent(downPointers.values.toList(), eventTime, action)
+        downPointers.remove(index)
+    }
+
+    private fun dispatchTouchEvent(
+        downPointers: List<GastInputListener.Pointer>,
+        eventTime: Long,
+        action: Int
+    ) {
         val motionEvent = obtainMotionEvent(
-            pointerId,
+            downPointers,
+            gestureDownTime,
             eventTime,
-            MotionEvent.ACTION_UP,
-            InputDevice.SOURCE_TOUCHSCREEN,
-            xCoord,
-            yCoord
+            action,
+            InputDevice.SOURCE_TOUCHSCREEN
         )
         gastView.dispatchTouchEvent(motionEvent)
-        onDownSet.remove(pointerId)
         motionEvent.recycle()
     }
 
+    private fun getPointerAction(action: Int, pointerIndex: Int) =
+        action or (pointerIndex shl MotionEvent.ACTION_POINTER_INDEX_SHIFT)
+
     override fun onMainInputScroll(
         nodePath: String,
         pointerId: String,
@@ -270,14 +311,28 @@ internal class GastViewInputHandler(private val gastView: GastFrameLayout) : Gas
         val scrollByX = getScrollByDelta(horizontalDelta)
         val scrollByY = getScrollByDelta(verticalDelta)
 
-        val motionEvent =
-            obtainScrollEvent(pointerId, eventTime, xCoord, yCoord, scrollByX, scrollByY)
+        val motionEvent = obtainScrollEvent(
+            getPointerIndex(pointerId),
+            eventTime,
+            xCoord,
+            yCoord,
+            scrollByX,
+            scrollByY
+        )
         gastView.dispatchGenericMotionEvent(motionEvent)
         motionEvent.recycle()
     }
 
-    private fun getMotionEventPointerId(godotPointerId: String): Int {
-        pointerIdsTracker.add(godotPointerId)
-        return pointerIdsTracker.indexOf(godotPointerId)
+    /**
+     * Returns the index of the given pointer, matching the [GastInputListener.Pointer.index] of its
+     * multi-pointer input events.
+     */
+    private fun getPointerIndex(pointerId: String): Int {
+        return pointerIndicesById.getOrPut(pointerId) {
+            // The scroll events of a pointer starting to target the node precede its first
+            // multi-pointer input event, so the index is picked the same way as the native code:
+            // the smallest one not taken by the node's other pointers.
+            generateSequence(0) { it + 1 }.first { it !in pointerIndicesById.values }
+        }
     }
 }
@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "gdn/projection_mesh/curved_screen_surface.h"
+#include "gdn/projection_mesh/mesh_indexing.h"
+#include "gdn/projection_mesh/spherical_surface.h"
+
+using namespace gast;
+
+namespace {
+
+int failure_count = 0;
+
+void check(bool condition, const char *description) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", description);
+        failure_count++;
+    }
+}
+
+/// Runs the vertex cache and vertex fetch optimizations of MeshOptimizer on the given surface.
+/// @return The ACMR before and after the optimization
+std::pair<float, float> optimize(const SurfaceGeometry &surface, const char *name) {
+    const int vertex_count = static_cast<int>(surface.get_vertex_count());
+    const int index_count = static_cast<int>(surface.indices.size());
+    std::vector<int> indices = optimize_vertex_cache(surface.indices.data(), index_count,
+                                                     vertex_count);
+    std::vector<int> new_to_old = optimize_vertex_fetch(indices, vertex_count);
+
+    // The optimized surface must draw the same triangles, with the same winding.
+    std::vector<std::array<int, 3>> input_triangles;
+    std::vector<std::array<int, 3>> optimized_triangles;
+    for (int i = 0; i + 2 < index_count; i += 3) {
+        input_triangles.push_back({surface.indices[i], surface.indices[i + 1],
+                                   surface.indices[i + 2]});
+        optimized_triangles.push_back({new_to_old[indices[i]], new_to_old[indices[i + 1]],
+                                       new_to_old[indices[i + 2]]});
+    }
+    std::sort(input_triangles.begin(), input_triangles.end());
+    std::sort(optimized_triangles.begin(), optimized_triangles.end());
+    check(static_cast<int>(indices.size()) == index_count
+          && static_cast<int>(new_to_old.size()) == vertex_count
+          && optimized_triangles == input_triangles, name);
+
+    const float before = compute_acmr(surface.indices.data(), index_count);
+    const float after = compute_acmr(indices.data(), index_count);
+    printf("%s: %d vertices, %d triangles, ACMR %.3f -> %.3f\n", name, vertex_count,
+           index_count / 3, before, after);
+    return {before, after};
+}
+
+/// Returns a non-indexed GL_TRIANGLES grid of quads centered on the origin, as loaded from the
+/// custom meshes. The vertices on the y axis of every other quad use -0 for their x coordinate.
+SurfaceGeometry generate_triangles_grid(int columns, int rows) {
+    SurfaceGeometry grid;
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < columns; col++) {
+            const int corners[6][2] = {{0, 0}, {0, 1}, {1, 0}, {1, 0}, {0, 1}, {1, 1}};
+            for (const int *corner : corners) {
+                const int x = col + corner[0] - columns / 2;
+                const int y = row + corner[1];
+                const bool negative_zero = x == 0 && (row + col) % 2 == 0;
+                grid.positions.insert(grid.positions.end(),
+                                      {negative_zero ? -0.0f : static_cast<float>(x),
+                                       static_cast<float>(y), 0.0f});
+                grid.uvs.insert(grid.uvs.end(),
+                                {static_cast<float>(col + corner[0]) / columns,
+                                 1.0f - static_cast<float>(y) / rows});
+            }
+        }
+    }
+    return grid;
+}
+
+}  // namespace
+
+int main() {
+    // Levels of detail of the equirectangular projection mesh.
+    for (size_t segment_count : {20, 40, 80}) {
+        char name[64];
+        snprintf(name, sizeof(name), "sphere %zux%zu", segment_count, segment_count);
+        std::pair<float, float> acmr =
+                optimize(generate_spherical_surface(1.0f, segment_count, segment_count), name);
+        check(acmr.second < acmr.first, name);
+    }
+
+    // Default hemisphere projection mesh.
+    std::pair<float, float> hemisphere_acmr =
+            optimize(generate_spherical_surface(1.0f, 80, 40, 180.0f), "hemisphere 80x40");
+    check(hemisphere_acmr.second < hemisphere_acmr.first, "hemisphere ACMR");
+
+    // The curved screen is a single strip of quads, already in cache order.
+    std::pair<float, float> curved_screen_acmr =
+            optimize(generate_curved_screen_surface(2.0f, 1.0f, 6.0f, 64), "curved screen 64");
+    check(curved_screen_acmr.second == curved_screen_acmr.first, "curved screen ACMR");
+
+    // Welding of the non-indexed custom meshes.
+    const int columns = 16;
+    const int rows = 8;
+    const SurfaceGeometry grid = generate_triangles_grid(columns, rows);
+    const int vertex_count = static_cast<int>(grid.get_vertex_count());
+    std::vector<int> welded_indices;
+    std::vector<int> new_to_old = weld_vertices(grid.positions.data(), grid.uvs.data(), nullptr,
+                                                vertex_count, welded_indices);
+    const int welded_count = static_cast<int>(new_to_old.size());
+    const float weld_ratio = static_cast<float>(welded_count) / vertex_count;
+    printf("grid %dx%d: welded %d -> %d vertices (%.1f%%)\n", columns, rows, vertex_count,
+           welded_count, weld_ratio * 100.0f);
+    check(vertex_count == columns * rows * 6, "vertex count of the grid");
+    // Both zeros weld together, so only the grid's corners remain.
+    check(welded_count == (columns + 1) * (rows + 1), "welded vertex count of the grid");
+    check(std::abs(weld_ratio - 153.0f / 768.0f) < 1e-6f, "weld ratio of the grid");
+
+    // The welded vertices referenced by the indices must reproduce the input vertices.
+    bool same_vertices = static_cast<int>(welded_indices.size()) == vertex_count;
+    for (int i = 0; same_vertices && i < vertex_count; i++) {
+        const int index = welded_indices[i];
+        same_vertices = index >= 0 && index < welded_count;
+        const int source = same_vertices ? new_to_old[index] : 0;
+        for (int axis = 0; same_vertices && axis < 3; axis++) {
+            same_vertices = grid.positions[source * 3 + axis] == grid.positions[i * 3 + axis];
+        }
+        for (int axis = 0; same_vertices && axis < 2; axis++) {
+            same_vertices = grid.uvs[source * 2 + axis] == grid.uvs[i * 2 + axis];
+        }
+    }
+    check(same_vertices, "welded grid vertices");
+
+    // The texture coordinates keep apart the vertices sharing a position (the second and fifth
+    // vertices of the quad).
+    SurfaceGeometry seam = generate_triangles_grid(1, 1);
+    seam.uvs[2] = 0.5f;
+    new_to_old = weld_vertices(seam.positions.data(), seam.uvs.data(), nullptr, 6,
+                               welded_indices);
+    check(new_to_old.size() == 5, "welded vertex count with a uv seam");
+
+    return failure_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
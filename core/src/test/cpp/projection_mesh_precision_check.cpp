@@ -0,0 +1,63 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "gdn/projection_mesh/half_float_compression.h"
+#include "gdn/projection_mesh/spherical_surface.h"
+
+using namespace gast;
+
+namespace {
+
+int failure_count = 0;
+
+void check(bool condition, const char *description) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", description);
+        failure_count++;
+    }
+}
+
+}  // namespace
+
+int main() {
+    // Highest resolution sphere used by the equirectangular projection mesh.
+    const SurfaceGeometry sphere = generate_spherical_surface(1.0f, 80, 80);
+    const size_t vertex_count = sphere.get_vertex_count();
+    check(vertex_count == 81 * 81, "vertex count of the 80 segments sphere");
+
+    const float uv_error_4096 = get_half_float_uv_error(sphere.uvs.data(), vertex_count, 4096);
+    const float uv_error_8192 = get_half_float_uv_error(sphere.uvs.data(), vertex_count, 8192);
+    const float position_error_4096 =
+            get_half_float_position_error(sphere.positions.data(), vertex_count, 4096);
+    const float position_error_8192 =
+            get_half_float_position_error(sphere.positions.data(), vertex_count, 8192);
+    printf("Max half-float uv error: %f texels at 4096, %f texels at 8192\n", uv_error_4096,
+           uv_error_8192);
+    printf("Max half-float position error: %f texels at 4096, %f texels at 8192\n",
+           position_error_4096, position_error_8192);
+
+    // Half floats in [0.5, 1) are spaced by 2^-11, so the rounding error of the texture coordinates
+    // reaches 0.8 texel at 4096 and doubles with the resolution.
+    check(std::abs(uv_error_4096 - 0.8003f) < 1e-3f, "uv error at 4096");
+    check(std::abs(uv_error_8192 - 1.6006f) < 1e-3f, "uv error at 8192");
+    check(std::abs(position_error_4096 - 0.4998f) < 1e-3f, "position error at 4096");
+    check(std::abs(position_error_8192 - 0.9995f) < 1e-3f, "position error at 8192");
+
+    const HalfFloatCompression compression_4096 = get_half_float_compression(
+            sphere.positions.data(), sphere.uvs.data(), nullptr, vertex_count, 4096);
+    check(compression_4096.positions, "compressed positions at 4096");
+    check(!compression_4096.uvs, "uncompressed uvs at 4096");
+    check(!compression_4096.uvs2, "no uvs2 to compress at 4096");
+
+    const HalfFloatCompression compression_8192 = get_half_float_compression(
+            sphere.positions.data(), sphere.uvs.data(), nullptr, vertex_count, 8192);
+    check(!compression_8192.positions, "uncompressed positions at 8192");
+    check(!compression_8192.uvs, "uncompressed uvs at 8192");
+
+    const HalfFloatCompression disabled = get_half_float_compression(
+            sphere.positions.data(), sphere.uvs.data(), nullptr, vertex_count, 0);
+    check(!disabled.positions && !disabled.uvs, "compression disabled for a 0 texture size");
+
+    return failure_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,243 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <memory>
+
+#include "gdn/texture_latch_pump.h"
+
+namespace gast {
+
+// The host checks have no GastNode, the fake owners' visibility is set by the checks.
+bool owner_visible = true;
+// Fake owner already destroyed, which must no longer be dereferenced.
+const GastNode *destroyed_owner = nullptr;
+bool destroyed_owner_accessed = false;
+
+bool is_texture_owner_visible(const GastNode *owner) {
+    if (owner == destroyed_owner) {
+        destroyed_owner_accessed = true;
+    }
+    return owner_visible;
+}
+
+}  // namespace gast
+
+using namespace gast;
+
+namespace {
+
+const int64_t kFramePeriodNs = 16666667;
+
+int failure_count = 0;
+
+void check(bool condition, const char *description) {
+    if (!condition) {
+        fprintf(stderr, "FAILED: %s\n", description);
+        failure_count++;
+    }
+}
+
+int64_t get_monotonic_time_ns() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/// TextureSource whose frames are queued in memory with the given timestamps.
+class CpuTextureSource : public TextureSource {
+public:
+    CpuTextureSource(TextureLatchPump *pump, int latch_failure_count = 0) :
+            pump_(pump), latch_failure_count_(latch_failure_count) {}
+
+    void queue_frame(int64_t timestamp_ns) {
+        queued_timestamps_.push_back(timestamp_ns);
+        pump_->on_frame_available(handle_);
+    }
+
+    bool update_tex_image() override {
+        if (queued_timestamps_.empty() || latch_failure_count_-- > 0) {
+            return false;
+        }
+        latched_timestamp_ = queued_timestamps_.front();
+        queued_timestamps_.pop_front();
+        latch_count_++;
+        return true;
+    }
+
+    int64_t get_timestamp() override {
+        return latched_timestamp_;
+    }
+
+    void set_handle(int64_t handle) {
+        handle_ = handle;
+    }
+
+    int get_latch_count() const {
+        return latch_count_;
+    }
+
+    size_t get_queued_frame_count() const {
+        return queued_timestamps_.size();
+    }
+
+    int64_t get_latched_timestamp() const {
+        return latched_timestamp_;
+    }
+
+private:
+    TextureLatchPump *pump_;
+    int latch_failure_count_;
+    int64_t handle_ = 0;
+    std::deque<int64_t> queued_timestamps_;
+    int64_t latched_timestamp_ = 0;
+    int latch_count_ = 0;
+};
+
+// Registers a new CpuTextureSource, still owned by the pump.
+CpuTextureSource *register_cpu_source(TextureLatchPump *pump, const GastNode *owner = nullptr) {
+    auto *source = new CpuTextureSource(pump);
+    int64_t handle = pump->register_source(std::unique_ptr<TextureSource>(source),
+                                           const_cast<GastNode *>(owner));
+    source->set_handle(handle);
+    return source;
+}
+
+void check_stale_frames(int64_t now_ns) {
+    TextureLatchPump pump;
+    CpuTextureSource *source = register_cpu_source(&pump);
+    source->queue_frame(now_ns - 3 * kFramePeriodNs);
+    source->queue_frame(now_ns - 2 * kFramePeriodNs);
+    source->queue_frame(now_ns - kFramePeriodNs);
+
+    pump.latch_frames(now_ns);
+    check(source->get_latch_count() == 3, "stale frames are all latched");
+    check(source->get_latched_timestamp() == now_ns - kFramePeriodNs,
+          "the newest stale frame is kept");
+}
+
+void check_on_time_frames(int64_t now_ns) {
+    TextureLatchPump pump;
+    CpuTextureSource *source = register_cpu_source(&pump);
+    source->queue_frame(now_ns - kFramePeriodNs);
+    source->queue_frame(now_ns + kFramePeriodNs);
+    source->queue_frame(now_ns + 2 * kFramePeriodNs);
+
+    pump.latch_frames(now_ns);
+    check(source->get_latch_count() == 2, "latching stops at the frame due for the display");
+    check(source->get_latched_timestamp() == now_ns + kFramePeriodNs,
+          "the frame due for the display is kept");
+    check(source->get_queued_frame_count() == 1, "the next frame stays queued");
+
+    pump.latch_frames(now_ns + kFramePeriodNs);
+    check(source->get_latch_count() == 3, "the next frame is latched on the next display");
+}
+
+void check_future_frames(int64_t now_ns) {
+    TextureLatchPump pump;
+    CpuTextureSource *source = register_cpu_source(&pump);
+    source->queue_frame(now_ns + 3 * kFramePeriodNs);
+    source->queue_frame(now_ns + 4 * kFramePeriodNs);
+
+    // A frame can only be inspected once latched, so the first future frame is shown early.
+    pump.latch_frames(now_ns);
+    check(source->get_latch_count() == 1, "a single future frame is latched");
+    check(source->get_queued_frame_count() == 1, "the later future frame stays queued");
+}
+
+void check_non_monotonic_frames(int64_t now_ns) {
+    TextureLatchPump pump;
+    CpuTextureSource *source = register_cpu_source(&pump);
+    // Media presentation times, unrelated to the monotonic clock.
+    const int64_t presentation_time_ns = 5000000;
+    source->queue_frame(presentation_time_ns);
+    source->queue_frame(presentation_time_ns + kFramePeriodNs);
+    source->queue_frame(presentation_time_ns + 2 * kFramePeriodNs);
+
+    pump.latch_frames(now_ns);
+    check(source->get_latch_count() == 3, "non-monotonic frames are all latched");
+    check(source->get_latched_timestamp() == presentation_time_ns + 2 * kFramePeriodNs,
+          "the newest non-monotonic frame is kept");
+}
+
+void check_failed_latch(int64_t now_ns) {
+    TextureLatchPump pump;
+    auto *source = new CpuTextureSource(&pump, 1);
+    source->set_handle(pump.register_source(std::unique_ptr<TextureSource>(source), nullptr));
+    source->queue_frame(now_ns - kFramePeriodNs);
+    source->queue_frame(now_ns);
+
+    pump.latch_frames(now_ns);
+    check(source->get_latch_count() == 0, "a failed latch stops the latches");
+    pump.latch_frames(now_ns + kFramePeriodNs);
+    check(source->get_latch_count() == 0, "the queue is reset after a failed latch");
+}
+
+void check_owner(int64_t now_ns) {
+    TextureLatchPump pump;
+    int fake_node = 0;
+    const auto *owner = reinterpret_cast<const GastNode *>(&fake_node);
+    CpuTextureSource *source = register_cpu_source(&pump, owner);
+
+    owner_visible = false;
+    source->queue_frame(now_ns);
+    pump.latch_frames(now_ns);
+    check(source->get_latch_count() == 0, "the latches are throttled while the owner is hidden");
+
+    TextureFrameStats stats;
+    check(pump.get_frame_stats(owner, &stats), "the owner has frame stats");
+    check(stats.skipped_latch_count == 1, "the throttled latch is counted");
+
+    // The destroyed owner is no longer dereferenced, and the latches resume.
+    pump.clear_owner(owner);
+    pump.latch_frames(now_ns + kFramePeriodNs);
+    check(source->get_latch_count() == 1, "the latches resume once the owner is cleared");
+    check(!pump.get_frame_stats(owner, &stats), "the cleared owner has no frame stats");
+    owner_visible = true;
+}
+
+void check_teardown_order(int64_t now_ns) {
+    TextureLatchPump pump;
+    int fake_nodes[2] = {};
+    const auto *first_owner = reinterpret_cast<const GastNode *>(&fake_nodes[0]);
+    const auto *second_owner = reinterpret_cast<const GastNode *>(&fake_nodes[1]);
+    CpuTextureSource *first_source = register_cpu_source(&pump, first_owner);
+    CpuTextureSource *second_source = register_cpu_source(&pump, second_owner);
+
+    // Gast is shut down first, then the nodes are destroyed without reaching the pump, while
+    // their texture sources stay registered from the Java side.
+    pump.clear_owners();
+    destroyed_owner = first_owner;
+    owner_visible = false;
+    first_source->queue_frame(now_ns);
+    second_source->queue_frame(now_ns);
+    pump.latch_frames(now_ns);
+    check(!destroyed_owner_accessed, "the destroyed owner isn't dereferenced after the shutdown");
+    check(first_source->get_latch_count() == 1 && second_source->get_latch_count() == 1,
+          "the sources are latched as shared after the shutdown");
+
+    TextureFrameStats stats;
+    check(!pump.get_frame_stats(first_owner, &stats) && !pump.get_frame_stats(second_owner, &stats),
+          "the detached owners have no frame stats");
+
+    // A late frame notification for a source released with the pump is ignored.
+    pump.clear();
+    pump.on_frame_available(1);
+    pump.latch_frames(now_ns + kFramePeriodNs);
+    destroyed_owner = nullptr;
+    owner_visible = true;
+}
+
+}  // namespace
+
+int main() {
+    int64_t now_ns = get_monotonic_time_ns();
+    check_stale_frames(now_ns);
+    check_on_time_frames(now_ns);
+    check_future_frames(now_ns);
+    check_non_monotonic_frames(now_ns);
+    check_failed_latch(now_ns);
+    check_owner(now_ns);
+    check_teardown_order(now_ns);
+    return failure_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,6 +14,16 @@ const DOWN_SCROLL_SUFFIX = "_down_scroll"
 const X_AXIS = 0
 const Y_AXIS = 1
 
+# Joints of the hand nodes fed to the GAST hand gesture recognizer, in the order it expects:
+# wrist, thumb tip, index knuckle, index tip and ring tip.
+const HAND_GESTURE_JOINTS = [
+	"Wrist",
+	"Wrist/ThumbMetacarpal/ThumbProximal/ThumbDistal/ThumbTip",
+	"Wrist/IndexMetacarpal/IndexProximal",
+	"Wrist/IndexMetacarpal/IndexProximal/IndexIntermediate/IndexDistal/IndexTip",
+	"Wrist/RingMetacarpal/RingProximal/RingIntermediate/RingDistal/RingTip"
+]
+
 enum ControllerButtons {
 	VR_BUTTON_BY = 1,
 	VR_GRIP = 2,
@@ -32,6 +42,8 @@ enum FingerButtons {
 }
 
 var current_joystick_id = -1
+var hand_nodes : Spatial = null
+var hand_pose_updated = false
 
 onready var back_button_action = "back_button_action"
 onready var menu_button_action = "menu_button_action"
@@ -40,8 +52,15 @@ onready var left_scroll_action = _get_ray_cast_name() + LEFT_SCROLL_SUFFIX
 onready var right_scroll_action = _get_ray_cast_name() + RIGHT_SCROLL_SUFFIX
 onready var up_scroll_action = _get_ray_cast_name() + UP_SCROLL_SUFFIX
 onready var down_scroll_action = _get_ray_cast_name() + DOWN_SCROLL_SUFFIX
+onready var ray_cast = get_node(_get_ray_cast_name())
+onready var main = get_node("/root/Main")
 
 func _ready():
+	if controller_id == LEFT_HAND_ID:
+		hand_nodes = get_node("../LeftHandNodes")
+	elif controller_id == RIGHT_HAND_ID:
+		hand_nodes = get_node("../RightHandNodes")
+
 	if !InputMap.has_action(back_button_action):
 		InputMap.add_action(back_button_action, 0.0)
 
@@ -77,6 +96,30 @@ func _process(delta):
 			_unload_input_map(current_joystick_id)
 			current_joystick_id = -1
 
+	if hand_nodes:
+		_update_hand_pose()
+
+# Feed the hand joints to GAST, which aims the hand's ray cast and drives its click and scroll
+# input from the recognized pinches.
+func _update_hand_pose():
+	if !main.gast:
+		return
+
+	if !get_is_active() or !hand_nodes.is_visible_in_tree():
+		_clear_hand_pose()
+		return
+
+	var joint_positions = PoolVector3Array()
+	for joint in HAND_GESTURE_JOINTS:
+		joint_positions.append(hand_nodes.get_node(joint).global_transform.origin)
+	main.gast.update_hand_pose(ray_cast.get_path(), joint_positions, global_transform)
+	hand_pose_updated = true
+
+func _clear_hand_pose():
+	if hand_pose_updated:
+		main.gast.clear_hand_pose(ray_cast.get_path())
+		hand_pose_updated = false
+
 func _get_ray_cast_name():
 	if controller_id == LEFT_TOUCH_CONTROLLER_ID:
 		return "TouchLeftRayCast"
@@ -206,12 +249,5 @@ func _update_hand_input_map(joystick_id: int, add: bool):
 	else:
 		InputMap.action_erase_event(menu_button_action, menu_click_event)
 
-
-	# Click event
-	var index_finger_click_event = InputEventJoypadButton.new()
-	index_finger_click_event.button_index = FingerButtons.INDEX_PINCH
-	index_finger_click_event.device = joystick_id
-	if add:
-		InputMap.action_add_event(click_action, index_finger_click_event)
-	else:
-		InputMap.action_erase_event(click_action, index_finger_click_event)
+	# The click and scroll input of the hands is driven by the pinches recognized by GAST from
+	# the hand joints (see _update_hand_pose), rather than by the runtime's pinch buttons.
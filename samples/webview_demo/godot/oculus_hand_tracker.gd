@@ -16,6 +16,10 @@ enum FINGER_PINCH {
 const LEFT_RAYCAST_NAME = "LeftHandRayCast"
 const RIGHT_RAYCAST_NAME = "RightHandRayCast"
 
+# Bones of the hand model fed to the GAST hand gesture recognizer, in the order it expects:
+# wrist, thumb tip, index knuckle, index tip and ring tip.
+const GESTURE_JOINT_BONES = [0, 5, 6, 9, 17]
+
 var hand_skel : Skeleton = null
 
 # Oculus mobile APIs available at runtime.
@@ -42,6 +46,7 @@ Quat(-0.081241, -0.013242, 0.560496, 0.824056), Quat(0.00276, 0.037404, 0.637818
 
 onready var hand_model : Spatial = $HandModel
 onready var hand_pointer : Spatial = $HandModel/HandPointer
+onready var main = get_node("/root/Main")
 
 func _ready():
 	_initialize_hands()
@@ -56,6 +61,7 @@ func _ready():
 func _process(delta_t):
 	_update_hand_model(hand_model, hand_skel);
 	_update_hand_pointer(hand_pointer)
+	_update_hand_gestures()
 
 	# If we are on desktop or don't have hand tracking we set a debug pose on the left hand
 	if (controller_id == LEFT_TRACKER_ID && !ovr_hand_tracking):
@@ -74,44 +80,39 @@ func _get_tracker_label():
 	return "Oculus Tracked Left Hand" if controller_id == LEFT_TRACKER_ID else "Oculus Tracked Right Hand"
 
 
-func _on_tracker_enabled():
-	print("Loading input map for " + _get_tracker_label() + " with device id: " + str(get_joystick_id()))
-	_load_tracked_hand_input_map()
-
-
 func _on_tracker_disabled():
-	print("Clearing input map for " + _get_tracker_label() + " with device id: " + str(get_joystick_id()))
-	_clear_tracked_hand_input_map()
-
-
-func _load_tracked_hand_input_map():
-	# Clear the map first
-	_clear_tracked_hand_input_map()
-	
-	var raycast_name = _get_controller_raycast_name()
-	
-	# Load the click action
-	var click_action = raycast_name + "_click"
-	InputMap.add_action(click_action, 0.0)
-	
-	var button_click = InputEventJoypadButton.new()
-	button_click.device = get_joystick_id()
-	button_click.button_index = FINGER_PINCH.INDEX_PINCH
-	InputMap.action_add_event(click_action, button_click)
-
-
-func _clear_tracked_hand_input_map():
-	var raycast_name = _get_controller_raycast_name()
-	
-	# Clear the click action
-	if (InputMap.has_action(raycast_name + "_click")):
-		InputMap.erase_action(raycast_name + "_click")
+	_clear_hand_gestures()
 
 
 func _get_controller_raycast_name():
 	return LEFT_RAYCAST_NAME if (controller_id == LEFT_TRACKER_ID) else RIGHT_RAYCAST_NAME
 
 
+func _get_controller_raycast():
+	return hand_pointer.get_node(_get_controller_raycast_name())
+
+
+# The pinches are recognized natively by GAST from the hand joints, and drive the press, release
+# and scroll input of the hand's ray cast directly.
+func _update_hand_gestures():
+	if (!main.gast):
+		return
+
+	if (!hand_model.visible || !hand_pointer.visible):
+		_clear_hand_gestures()
+		return
+
+	var joint_positions = PoolVector3Array()
+	for bone in GESTURE_JOINT_BONES:
+		joint_positions.append(hand_skel.global_transform.xform(hand_skel.get_bone_global_pose(bone).origin))
+	main.gast.update_hand_pose(_get_controller_raycast().get_path(), joint_positions, hand_pointer.global_transform)
+
+
+func _clear_hand_gestures():
+	if (main.gast):
+		main.gast.clear_hand_pose(_get_controller_raycast().get_path())
+
+
 # The rotations we get from the OVR sdk are absolute and not relative
 # to the rest pose we have in the model; so we clear them here to be
 # able to use set pose